@@ -1,6 +1,7 @@
 #pragma once
 
 #include "events.hpp"
+#include "job_system.hpp"
 #include "window.hpp"
 
 #include "utils/non_copyable.hpp"
@@ -19,15 +20,16 @@ public:
     /**
      * @brief Creates the application.
      * @param name Application name
-     * @param width Window initial width
-     * @param height Window initial height
+     * @param width Window initial width (or render size when headless)
+     * @param height Window initial height (or render size when headless)
+     * @param headless Renders offscreen, without creating any window
      */
-    Application(const char* name, int width, int height);
+    Application(const char* name, int width, int height, bool headless = false);
 
     /**
      * @brief Destroys the application.
      */
-    ~Application();
+    virtual ~Application();
 
     /**
      * @brief Returns the created application instance.
@@ -40,19 +42,42 @@ public:
     static const char* GetName() { return s_Name; }
 
     /**
-     * @brief Returns the application window.
+     * @brief Returns whether the application runs without any window or not.
+     */
+    static bool IsHeadless() { return s_Application->m_window == nullptr; }
+
+    /**
+     * @brief Returns the application window. Must not be called when the
+     * application is headless.
      */
     static Window& GetWindow() { return *s_Application->m_window; }
 
+    /**
+     * @brief Returns the application job system.
+     */
+    static JobSystem& GetJobSystem() { return *s_Application->m_jobSystem; }
+
     /**
      * @brief Returns the application renderer.
      */
     static vk::VulkanRenderer& GetRenderer() { return *s_Application->m_renderer; }
 
+    /**
+     * @brief Returns whether the application is still running or not.
+     */
+    bool is_running() const;
+
     /**
      * @brief Runs the application.
+     * @param nb_frames Number of frames to render before returning. If 0, runs
+     * until the window is closed or quit() is called.
+     */
+    void run(uint64_t nb_frames = 0);
+
+    /**
+     * @brief Requests the application to stop after the current frame.
      */
-    void run();
+    void quit() { m_quitRequested = true; }
 
     /**
      * @brief Resize event handler.
@@ -60,12 +85,22 @@ public:
      */
     void resize_event(const ResizeEvent& event);
 
+protected:
+    /**
+     * @brief Called once per frame, before rendering (the resources loaded
+     * asynchronously are finalized).
+     */
+    virtual void update() {}
+
 private:
     static Application* s_Application;
     static const char* s_Name;
 
+    std::unique_ptr<JobSystem> m_jobSystem;
     std::unique_ptr<Window> m_window;
     std::unique_ptr<vk::VulkanRenderer> m_renderer;
+
+    bool m_quitRequested = false;
 };
 
 } // namespace core
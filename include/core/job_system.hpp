@@ -0,0 +1,159 @@
+#pragma once
+
+#include "utils/non_copyable.hpp"
+#include "utils/work_stealing_deque.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace jdl
+{
+namespace core
+{
+
+class JobSystem;
+
+// Scheduled job (defined by the job system)
+struct Job;
+
+/**
+ * @brief Counts the unfinished jobs attached to it. Jobs can be waited for
+ * through their counter, or scheduled to start once a counter reaches zero,
+ * which allows to build task graphs.
+ */
+class JobCounter : private NonCopyable<JobCounter>
+{
+public:
+    JobCounter() = default;
+    ~JobCounter() = default;
+
+    /**
+     * @brief Returns whether all the attached jobs are finished or not.
+     */
+    bool is_done() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> m_value = 0;
+
+    // Jobs started when the counter reaches zero
+    std::mutex m_mutex;
+    std::vector<Job*> m_continuations;
+
+    // First exception thrown by an attached job, rethrown by wait()
+    std::exception_ptr m_exception;
+};
+
+/**
+ * @brief Job system running small jobs on one worker thread per core. Each
+ * thread owns a lock-free work-stealing deque: it runs its own jobs in LIFO
+ * order (hot caches) and steals the oldest jobs of the other threads when it
+ * has nothing to do. Threads waiting for a counter run jobs in the meantime
+ * instead of blocking.
+ * 
+ * The thread creating the job system is registered as thread 0, the workers
+ * are the threads 1 to N. Other threads can submit jobs and wait for them,
+ * but do not run jobs.
+ */
+class JobSystem : private NonCopyable<JobSystem>
+{
+public:
+    using JobFunction = std::function<void()>;
+    using RangeFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+    static constexpr uint32_t s_InvalidThreadIndex = UINT32_MAX;
+
+    /**
+     * @brief Creates the job system and starts its workers.
+     * @param nb_workers Number of worker threads (0: one per core, minus the
+     * calling thread).
+     */
+    explicit JobSystem(uint32_t nb_workers = 0);
+
+    /**
+     * @brief Stops the workers. All the jobs must be finished.
+     */
+    ~JobSystem();
+
+    /**
+     * @brief Returns the job system instance.
+     */
+    static JobSystem& Get() { return *s_JobSystem; }
+
+    /**
+     * @brief Returns the index of the calling thread (0: creating thread,
+     * 1 to N: workers), or s_InvalidThreadIndex for the other threads.
+     */
+    static uint32_t GetThreadIndex();
+
+    /**
+     * @brief Returns the number of threads running jobs (workers + creating thread).
+     */
+    uint32_t get_nb_threads() const { return static_cast<uint32_t>(m_queues.size()); }
+
+    /**
+     * @brief Schedules a job.
+     * @param function Job function.
+     * @param counter Optional counter, incremented now and decremented once
+     * the job is finished.
+     */
+    void run(JobFunction function, JobCounter* counter = nullptr);
+
+    /**
+     * @brief Schedules a job once all the jobs of a counter are finished.
+     * @param dependency Counter to wait for.
+     * @param function Job function.
+     * @param counter Optional counter of the job.
+     */
+    void run_after(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+
+    /**
+     * @brief Waits for all the jobs of a counter, running other jobs
+     * meanwhile. Rethrows the first exception thrown by these jobs.
+     * @param counter Counter to wait for.
+     */
+    void wait(JobCounter& counter);
+
+    /**
+     * @brief Calls function on [0, count) split into batches run in
+     * parallel, and waits for all of them.
+     * @param count Number of elements.
+     * @param batch_size Number of elements per job (0: automatic).
+     * @param function Function processing the [begin, end) range.
+     */
+    void parallel_for(uint32_t count, uint32_t batch_size, const RangeFunction& function);
+
+private:
+    static JobSystem* s_JobSystem;
+
+    // One deque per thread running jobs (index 0: creating thread)
+    std::vector<std::unique_ptr<utils::WorkStealingDeque<Job*>>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    // Jobs submitted by the other threads, or when a deque is full
+    std::mutex m_injectedMutex;
+    std::vector<Job*> m_injectedJobs;
+    std::atomic<uint32_t> m_nbInjectedJobs = 0;
+
+    // Sleeping workers are woken up when jobs are submitted
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+    std::atomic<int64_t> m_nbPendingJobs = 0;
+    std::atomic<uint32_t> m_nbSleepingWorkers = 0;
+    std::atomic<bool> m_stop = false;
+
+    void submit(Job* job);
+    Job* find_job(uint32_t thread_index);
+    void execute(Job* job);
+    void finish(JobCounter& counter);
+    void worker_loop(uint32_t thread_index);
+};
+
+} // namespace core
+} // namespace jdl
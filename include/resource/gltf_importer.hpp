@@ -0,0 +1,107 @@
+#pragma once
+
+#include "gltf_reader.hpp"
+#include "mesh.hpp"
+#include "resource_handle.hpp"
+
+#include "core/job_system.hpp"
+
+#include <atomic>
+#include <chrono>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+enum class ImportState
+{
+	// Document being parsed by a job
+	eParsing,
+	// Primitives being decoded by jobs, meshes appearing progressively
+	eDecoding,
+	// All the primitives decoded (some meshes may still be loading)
+	eDone,
+	// Invalid file
+	eFailed
+};
+
+/**
+ * @brief Imports a glTF scene progressively, without blocking the calling
+ * thread: the document is parsed by a job, then every primitive is decoded by
+ * its own job and immediately handed to the resource manager as a Mesh
+ * (CreateAsync()), so the meshes become ready one after the other, as the
+ * resource manager finalizes them, while the rest of the scene is still
+ * being decoded.
+ *
+ * The document tables (nodes, materials...) can be read once the state is
+ * eDecoding, the mesh of a primitive once get_mesh() returns a valid handle.
+ */
+class GltfImporter : private NonCopyable<GltfImporter>
+{
+public:
+	/**
+	 * @brief Starts importing a glTF file.
+	 * @param path .gltf or .glb file path.
+	 * @param full_precision Full precision vertex layout instead of the
+	 * compact one.
+	 */
+	GltfImporter(const std::string& path, bool full_precision = false);
+
+	/**
+	 * @brief Waits for the import jobs. The created meshes stay in the
+	 * resource manager.
+	 */
+	~GltfImporter();
+
+	/**
+	 * @brief Returns the import state.
+	 */
+	ImportState get_state() const { return m_state.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Returns the document tables. The state must be eDecoding or eDone.
+	 */
+	const GltfReader& get_reader() const { return m_reader; }
+
+	/**
+	 * @brief Returns the number of decoded primitives (including the failed
+	 * ones).
+	 */
+	uint32_t get_nb_decoded() const { return m_nbDecoded.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Returns the mesh of a primitive, invalid until the primitive is
+	 * decoded (or if it failed). The mesh must be ready before being drawn.
+	 * @param primitive Primitive index (see GltfReader::get_primitives()).
+	 */
+	Handle<Mesh> get_mesh(uint32_t primitive) const
+	{
+		ImportState state = get_state();
+		if (state != ImportState::eDecoding && state != ImportState::eDone) {
+			return {};
+		}
+		return Handle<Mesh>::FromValue(m_meshes[primitive].load(std::memory_order_acquire));
+	}
+
+private:
+	std::string m_path;
+	bool m_fullPrecision = false;
+	GltfReader m_reader;
+
+	std::atomic<ImportState> m_state = ImportState::eParsing;
+	std::atomic<uint32_t> m_nbDecoded = 0;
+	std::atomic<uint32_t> m_nbFailed = 0;
+	// Mesh handle value of each primitive (0 until decoded)
+	std::unique_ptr<std::atomic<uint32_t>[]> m_meshes;
+
+	std::chrono::steady_clock::time_point m_startTime;
+	core::JobCounter m_jobs;
+
+	void parse();
+	void decode(uint32_t primitive);
+};
+
+} // namespace resource
+} // namespace jdl
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "vertex_layout.hpp"
+
+#include "utils/mapped_file.hpp"
+
+#include <span>
+#include <string_view>
+
+
+namespace jdl
+{
+
+namespace utils
+{
+class JsonReader;
+} // namespace utils
+
+namespace resource
+{
+
+static constexpr uint32_t s_GltfInvalidIndex = UINT32_MAX;
+
+enum class GltfAlphaMode
+{
+	eOpaque,
+	eMask,
+	eBlend
+};
+
+struct GltfTextureRef
+{
+	// Index in GltfReader::get_images()
+	uint32_t image = s_GltfInvalidIndex;
+	uint32_t texcoord = 0;
+
+	bool is_valid() const { return image != s_GltfInvalidIndex; }
+};
+
+/**
+ * @brief Metallic-roughness material of a glTF file (core properties only).
+ */
+struct GltfMaterial
+{
+	std::string name;
+	std::array<float, 4> base_color_factor { 1.0f, 1.0f, 1.0f, 1.0f };
+	float metallic_factor = 1.0f;
+	float roughness_factor = 1.0f;
+	std::array<float, 3> emissive_factor {};
+	float normal_scale = 1.0f;
+	float occlusion_strength = 1.0f;
+	GltfAlphaMode alpha_mode = GltfAlphaMode::eOpaque;
+	float alpha_cutoff = 0.5f;
+	bool double_sided = false;
+
+	GltfTextureRef base_color_texture;
+	GltfTextureRef metallic_roughness_texture;
+	GltfTextureRef normal_texture;
+	GltfTextureRef occlusion_texture;
+	GltfTextureRef emissive_texture;
+};
+
+/**
+ * @brief Image of a glTF file, not decoded: either an external file, or
+ * bytes embedded in a buffer.
+ */
+struct GltfImage
+{
+	std::string name;
+	// Resolved path of an external image (empty if embedded)
+	std::string path;
+	std::string mime_type;
+	// Embedded bytes, valid as long as the reader
+	std::span<const std::byte> data;
+};
+
+/**
+ * @brief Triangles of a mesh drawn with a single material.
+ */
+struct GltfPrimitive
+{
+	// Accessor of each vertex attribute (s_GltfInvalidIndex if missing)
+	std::array<uint32_t, VertexLayout::s_NbAttributes> attributes;
+	uint32_t indices = s_GltfInvalidIndex;
+	uint32_t material = s_GltfInvalidIndex;
+	// Topology (glTF enumeration: 4 triangles, 5 strip, 6 fan)
+	uint32_t mode = 4;
+
+	GltfPrimitive() { attributes.fill(s_GltfInvalidIndex); }
+};
+
+struct GltfMesh
+{
+	std::string name;
+	// Range in GltfReader::get_primitives()
+	uint32_t first_primitive = 0;
+	uint32_t nb_primitives = 0;
+};
+
+/**
+ * @brief Node of the glTF hierarchy.
+ */
+struct GltfNode
+{
+	std::string name;
+	uint32_t parent = s_GltfInvalidIndex;
+	std::vector<uint32_t> children;
+	uint32_t mesh = s_GltfInvalidIndex;
+	// Column-major local and world transforms
+	std::array<float, 16> local_transform;
+	std::array<float, 16> world_transform;
+};
+
+/**
+ * @brief glTF 2.0 reader, for .gltf (with external or embedded buffers) and
+ * .glb files.
+ *
+ * The JSON document is parsed in a single pass by a pull parser, straight
+ * into the compact tables below: no DOM is built. Binary buffers are memory
+ * mapped and never copied (except base64 embedded buffers), and the geometry
+ * is only decoded on request, by decode_primitive(), which can run on any
+ * number of threads at the same time.
+ *
+ * Sparse accessors, morph targets and skins are not supported.
+ */
+class GltfReader : private NonCopyable<GltfReader>
+{
+public:
+	GltfReader() = default;
+	~GltfReader() = default;
+
+	/**
+	 * @brief Opens a glTF file, parses its document and maps its buffers.
+	 * @param path .gltf or .glb file path.
+	 * @return Whether the file is valid or not.
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * @brief Decodes the vertices and indices of a primitive into triangle
+	 * lists. Thread-safe.
+	 * @param primitive Primitive index.
+	 * @param vertices Receives the vertices.
+	 * @param indices Receives the triangle list indices.
+	 * @return Whether the primitive has been decoded or not.
+	 */
+	bool decode_primitive(uint32_t primitive, VertexData& vertices, std::vector<uint32_t>& indices) const;
+
+	/**
+	 * @brief Returns the file path.
+	 */
+	const std::string& get_path() const { return m_path; }
+
+	const std::vector<GltfMesh>& get_meshes() const { return m_meshes; }
+	const std::vector<GltfPrimitive>& get_primitives() const { return m_primitives; }
+	const std::vector<GltfMaterial>& get_materials() const { return m_materials; }
+	const std::vector<GltfImage>& get_images() const { return m_images; }
+	const std::vector<GltfNode>& get_nodes() const { return m_nodes; }
+
+	/**
+	 * @brief Returns the root nodes of the default scene (all the nodes
+	 * without parent if the file has no scene).
+	 */
+	const std::vector<uint32_t>& get_root_nodes() const { return m_rootNodes; }
+
+private:
+	struct Buffer
+	{
+		std::unique_ptr<utils::MappedFile> file;
+		// Decoded base64 data URI
+		std::vector<std::byte> embedded;
+		std::span<const std::byte> data;
+		// Declared size (byteLength)
+		uint64_t size = 0;
+	};
+
+	struct BufferView
+	{
+		uint32_t buffer = s_GltfInvalidIndex;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		uint32_t stride = 0;
+	};
+
+	struct Accessor
+	{
+		uint32_t view = s_GltfInvalidIndex;
+		uint64_t offset = 0;
+		uint32_t count = 0;
+		uint32_t component_type = 0;
+		uint32_t nb_components = 0;
+		bool normalized = false;
+		bool sparse = false;
+	};
+
+	struct Scene
+	{
+		std::vector<uint32_t> nodes;
+	};
+
+	std::string m_path;
+	std::string m_directory;
+	utils::MappedFile m_file;
+	// Binary chunk of a .glb file
+	std::span<const std::byte> m_glbChunk;
+
+	std::vector<Buffer> m_buffers;
+	// Decoded base64 data URIs of the images
+	std::vector<std::vector<std::byte>> m_embeddedImages;
+	std::vector<BufferView> m_views;
+	std::vector<Accessor> m_accessors;
+	// Image of each texture (samplers are ignored)
+	std::vector<uint32_t> m_textureImages;
+	std::vector<Scene> m_scenes;
+	uint32_t m_defaultScene = 0;
+
+	std::vector<GltfMesh> m_meshes;
+	std::vector<GltfPrimitive> m_primitives;
+	std::vector<GltfMaterial> m_materials;
+	std::vector<GltfImage> m_images;
+	std::vector<GltfNode> m_nodes;
+	std::vector<uint32_t> m_rootNodes;
+
+	bool parse_document(std::string_view json);
+	bool read_buffers(utils::JsonReader& reader, std::vector<std::string>& uris);
+	bool read_buffer_views(utils::JsonReader& reader);
+	bool read_accessors(utils::JsonReader& reader);
+	bool read_meshes(utils::JsonReader& reader);
+	bool read_primitive(utils::JsonReader& reader, GltfPrimitive& primitive);
+	bool read_materials(utils::JsonReader& reader);
+	bool read_texture_ref(utils::JsonReader& reader, GltfTextureRef& texture, float* scale);
+	bool read_textures(utils::JsonReader& reader);
+	bool read_images(utils::JsonReader& reader, std::vector<std::string>& uris, std::vector<uint32_t>& views);
+	bool read_nodes(utils::JsonReader& reader);
+	bool read_scenes(utils::JsonReader& reader);
+
+	bool load_buffers(const std::vector<std::string>& uris);
+	bool load_images(const std::vector<std::string>& uris, const std::vector<uint32_t>& views);
+	bool resolve();
+
+	bool read_accessor(uint32_t index, std::vector<float>& values, uint32_t& nb_components) const;
+	bool read_indices(uint32_t index, std::vector<uint32_t>& values) const;
+	const std::byte* get_element(const Accessor& accessor, uint32_t element, uint32_t element_size) const;
+};
+
+} // namespace resource
+} // namespace jdl
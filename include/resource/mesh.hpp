@@ -0,0 +1,168 @@
+#pragma once
+
+#include "mesh_file.hpp"
+#include "resource.hpp"
+
+#include "vk/vulkan_buffer.hpp"
+#include "vk/vulkan_uploader.hpp"
+
+
+namespace jdl
+{
+
+namespace vk
+{
+class VulkanCommandBuffer;
+} // namespace vk
+
+namespace resource
+{
+
+/**
+ * @brief Transform of the positions read by the vertex shaders to object
+ * space: position * scale + offset (identity if not quantized).
+ */
+struct PositionDequantization
+{
+	std::array<float, 4> scale { 1.0f, 1.0f, 1.0f, 1.0f };
+	std::array<float, 4> offset {};
+};
+
+class Mesh : public Resource
+{
+public:
+	/**
+	 * @brief Creates the mesh from full precision vertices. The vertices are
+	 * encoded once the mesh is loaded, and uploaded to device local buffers
+	 * once it is finalized by the resource manager.
+	 * @param name Mesh name.
+	 * @param vertices Vertices.
+	 * @param indices Triangle list indices, stored on 16 bits if all the
+	 * vertices can be addressed.
+	 * @param layout Vertex layout of the GPU buffers.
+	 */
+	Mesh(
+		const std::string& name,
+		VertexData vertices,
+		std::vector<uint32_t> indices,
+		const VertexLayout& layout = VertexLayout::Compact()
+	);
+
+	/**
+	 * @brief Creates the mesh from a cooked mesh file (see MeshFile). The file
+	 * is mapped once the mesh is loaded, and its blobs are copied as is into
+	 * the device local buffers once it is finalized.
+	 * @param name Mesh name.
+	 * @param path Mesh file path (.jmesh).
+	 */
+	Mesh(const std::string& name, const std::string& path);
+
+	/**
+	 * @brief Returns the mesh file path (empty if created from vertices).
+	 */
+	const std::string& get_path() const { return m_path; }
+
+	/**
+	 * @brief Returns the vertex layout.
+	 */
+	const VertexLayout& get_layout() const { return m_layout; }
+
+	/**
+	 * @brief Returns the bounds of the vertices (quantization range of the
+	 * eSnorm16x4 positions).
+	 */
+	const MeshBounds& get_bounds() const { return m_bounds; }
+
+	/**
+	 * @brief Returns the transform of the positions to object space
+	 * (eSnorm16x4 positions are relative to the bounds).
+	 */
+	PositionDequantization get_position_dequantization() const;
+
+	/**
+	 * @brief Returns the number of vertices.
+	 */
+	uint32_t get_nb_vertices() const { return m_nbVertices; }
+
+	/**
+	 * @brief Returns the number of indices.
+	 */
+	uint32_t get_nb_indices() const { return m_nbIndices; }
+
+	/**
+	 * @brief Returns the index type (16-bit or 32-bit indices).
+	 */
+	VkIndexType get_index_type() const { return m_indexType; }
+
+	/**
+	 * @brief Returns the vertex buffer of a stream.
+	 * @param stream Stream index (see VertexLayout::get_nb_streams()).
+	 */
+	VkBuffer get_vertex_buffer(uint32_t stream) const {
+		return m_vertexBuffers[stream] != nullptr ? m_vertexBuffers[stream]->get() : VK_NULL_HANDLE;
+	}
+
+	/**
+	 * @brief Returns the index buffer.
+	 */
+	VkBuffer get_index_buffer() const {
+		return m_indexBuffer != nullptr ? m_indexBuffer->get() : VK_NULL_HANDLE;
+	}
+
+	/**
+	 * @brief Returns the token of the buffer uploads: the mesh can be drawn
+	 * once it is complete.
+	 */
+	vk::UploadToken get_upload_token() const { return m_uploadToken; }
+
+	/**
+	 * @brief Returns whether the mesh can be drawn: finalized and uploaded.
+	 */
+	bool is_drawable() const;
+
+	/**
+	 * @brief Records the binding of the vertex streams and of the index buffer.
+	 * @param command_buffer Command buffer.
+	 */
+	void bind(vk::VulkanCommandBuffer& command_buffer) const;
+
+	/**
+	 * @brief Records an indexed draw of the whole mesh (bind() must have been
+	 * called).
+	 * @param command_buffer Command buffer.
+	 * @param nb_instances The number of instances to draw.
+	 * @param first_instance The index of the first instance.
+	 */
+	void draw(
+		vk::VulkanCommandBuffer& command_buffer,
+		uint32_t nb_instances = 1,
+		uint32_t first_instance = 0
+	) const;
+
+private:
+	VertexLayout m_layout;
+	MeshBounds m_bounds;
+	uint32_t m_nbVertices = 0;
+	uint32_t m_nbIndices = 0;
+	VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+
+	// Source data, until load()
+	std::string m_path;
+	VertexData m_vertices;
+	std::vector<uint32_t> m_indices;
+
+	// Encoded data (or mapped file), between load() and finalize()
+	EncodedMesh m_encoded;
+	MeshFile m_file;
+
+	std::array<std::unique_ptr<vk::VulkanBuffer>, VertexLayout::s_MaxStreams> m_vertexBuffers;
+	std::unique_ptr<vk::VulkanBuffer> m_indexBuffer;
+	vk::UploadToken m_uploadToken;
+
+	bool load() final;
+	bool finalize() final;
+	void clear_resource() final;
+};
+
+} // namespace resource
+} // namespace jdl
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "vertex_layout.hpp"
+
+#include "utils/mapped_file.hpp"
+
+#include <span>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+/**
+ * @brief Vertices and indices encoded in their GPU layout, ready to be
+ * copied into buffers as is.
+ */
+struct EncodedMesh
+{
+	VertexLayout layout;
+	MeshBounds bounds;
+	uint32_t nb_vertices = 0;
+	uint32_t nb_indices = 0;
+	// Largest index value
+	uint32_t max_index = 0;
+	VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+
+	std::array<std::vector<uint8_t>, VertexLayout::s_MaxStreams> streams;
+	std::vector<uint8_t> indices;
+};
+
+/**
+ * @brief Validates and encodes a mesh. Indices are stored on 16 bits if all
+ * the vertices can be addressed.
+ * @param name Mesh name (error messages).
+ * @param vertices Full precision vertices.
+ * @param indices Triangle list indices.
+ * @param layout Vertex layout.
+ * @param mesh Receives the encoded mesh.
+ * @return Whether the mesh is valid or not.
+ */
+bool encode_mesh(
+	const std::string& name,
+	const VertexData& vertices,
+	const std::vector<uint32_t>& indices,
+	const VertexLayout& layout,
+	EncodedMesh& mesh
+);
+
+/**
+ * @brief Writes an encoded mesh to a binary mesh file (see MeshFile).
+ * @param path File path, overwritten.
+ * @param mesh Encoded mesh.
+ * @return Whether the file has been written or not.
+ */
+bool write_mesh_file(const std::string& path, const EncodedMesh& mesh);
+
+/**
+ * @brief Binary mesh file (.jmesh), produced offline by the mesh cooker.
+ *
+ * A fixed-size header followed by the blobs of the vertex streams and of the
+ * indices, each one stored exactly as the GPU reads it and aligned on
+ * s_BlobAlignment. The file is memory mapped: opening it only validates the
+ * header (counts, blob ranges and index range), and the blobs are copied
+ * straight from the mapping into staging memory.
+ *
+ * Little-endian, bumping s_Version invalidates the cooked files.
+ */
+class MeshFile : private NonCopyable<MeshFile>
+{
+public:
+	static constexpr uint32_t s_Magic = 0x4853454d; // "MESH"
+	static constexpr uint32_t s_Version = 2;
+	static constexpr uint64_t s_BlobAlignment = 64;
+	static constexpr const char* s_Extension = ".jmesh";
+
+	struct Blob
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		// VertexFormat of each attribute, VertexStreams
+		uint8_t formats[VertexLayout::s_NbAttributes];
+		uint8_t streams;
+		// Size of an index in bytes (2 or 4)
+		uint8_t index_size;
+		uint8_t padding[2];
+		uint32_t nb_vertices;
+		uint32_t nb_indices;
+		// Largest index value, checked against nb_vertices without reading
+		// the indices
+		uint32_t max_index;
+		float center[3];
+		float extent[3];
+		Blob stream_blobs[VertexLayout::s_MaxStreams];
+		Blob index_blob;
+	};
+
+	MeshFile() = default;
+	~MeshFile() = default;
+
+	/**
+	 * @brief Maps a mesh file and validates its header.
+	 * @param path File path.
+	 * @return Whether the file is a valid mesh file or not.
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * @brief Unmaps the file.
+	 */
+	void close() { m_file.close(); }
+
+	/**
+	 * @brief Returns the vertex layout.
+	 */
+	const VertexLayout& get_layout() const { return m_layout; }
+
+	/**
+	 * @brief Returns the bounds of the vertices.
+	 */
+	const MeshBounds& get_bounds() const { return m_bounds; }
+
+	/**
+	 * @brief Returns the number of vertices.
+	 */
+	uint32_t get_nb_vertices() const { return m_header.nb_vertices; }
+
+	/**
+	 * @brief Returns the number of indices.
+	 */
+	uint32_t get_nb_indices() const { return m_header.nb_indices; }
+
+	/**
+	 * @brief Returns the index type.
+	 */
+	VkIndexType get_index_type() const {
+		return m_header.index_size == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
+
+	/**
+	 * @brief Returns the mapped bytes of a vertex stream.
+	 * @param stream Stream index (see VertexLayout::get_nb_streams()).
+	 */
+	std::span<const std::byte> get_stream(uint32_t stream) const {
+		return get_blob(m_header.stream_blobs[stream]);
+	}
+
+	/**
+	 * @brief Returns the mapped bytes of the indices.
+	 */
+	std::span<const std::byte> get_indices() const { return get_blob(m_header.index_blob); }
+
+private:
+	utils::MappedFile m_file;
+	Header m_header {};
+	VertexLayout m_layout;
+	MeshBounds m_bounds;
+
+	std::span<const std::byte> get_blob(const Blob& blob) const {
+		return { m_file.get_data() + blob.offset, static_cast<size_t>(blob.size) };
+	}
+};
+
+} // namespace resource
+} // namespace jdl
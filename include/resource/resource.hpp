@@ -2,28 +2,79 @@
 
 #include "core/object.hpp"
 
+#include <atomic>
+
 
 namespace jdl
 {
 namespace resource
 {
 
+template<class R> class ResourcePool;
+
+enum class LoadState
+{
+	// Created, not loaded yet
+	eUnloaded,
+	// Waiting for a loader thread
+	eQueued,
+	// Being loaded/decoded by a loader thread
+	eLoading,
+	// Loaded, waiting to be finalized on the main thread
+	eFinalizing,
+	// Ready to be used
+	eReady,
+	// Failed to load or to finalize
+	eFailed
+};
+
 class Resource : public core::Object
 {
+	friend class ResourceLoader;
 	friend class ResourceManager;
+	template<class R> friend class ResourcePool;
 
 public:
 	// Base destructor
-	~Resource() { clear_resource(); }
+	virtual ~Resource() = default;
+
+	/**
+	 * @brief Returns the load state of the resource.
+	 */
+	LoadState get_load_state() const { return m_loadState.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Returns whether the resource is loaded and finalized or not.
+	 */
+	bool is_ready() const { return get_load_state() == LoadState::eReady; }
 
 protected:
 	// Base constructor
 	Resource(const std::string& name) : core::Object(name) {}
 
+	/**
+	 * @brief Loads and decodes the resource data (file I/O, parsing...).
+	 * May run on a loader thread: must not create any GPU object.
+	 * @return Whether the data has been loaded or not.
+	 */
+	virtual bool load() { return true; }
+
+	/**
+	 * @brief Creates the GPU objects from the loaded data. Always runs on
+	 * the main thread, at a safe point of the frame.
+	 * @return Whether the resource has been finalized or not.
+	 */
+	virtual bool finalize() { return true; }
+
 	/**
 	 * @brief Clears the resource data. Must be reimplemented if necessary.
 	 */
 	virtual void clear_resource() {}
+
+private:
+	std::atomic<LoadState> m_loadState = LoadState::eUnloaded;
+
+	void set_load_state(LoadState state) { m_loadState.store(state, std::memory_order_release); }
 };
 
 } // namespace resource
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "utils/hash.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+/**
+ * @brief 32-bit generational handle of a resource of type R: a slot index in
+ * the pool of R, and the generation of the slot when the resource was
+ * created. Once the resource is removed the slot generation changes, so the
+ * handle is detected as stale instead of pointing to another resource.
+ */
+template<class R>
+class Handle
+{
+public:
+	static constexpr uint32_t s_IndexBits = 20;
+	static constexpr uint32_t s_GenerationBits = 32 - s_IndexBits;
+	static constexpr uint32_t s_MaxIndex = (1u << s_IndexBits) - 1;
+	static constexpr uint32_t s_MaxGeneration = (1u << s_GenerationBits) - 1;
+
+	// Invalid handle (generations start at 1)
+	constexpr Handle() = default;
+
+	constexpr Handle(uint32_t index, uint32_t generation)
+		: m_value((generation << s_IndexBits) | (index & s_MaxIndex))
+	{}
+
+	static constexpr Handle FromValue(uint32_t value)
+	{
+		Handle handle;
+		handle.m_value = value;
+		return handle;
+	}
+
+	constexpr uint32_t get_index() const { return m_value & s_MaxIndex; }
+	constexpr uint32_t get_generation() const { return m_value >> s_IndexBits; }
+	constexpr uint32_t get_value() const { return m_value; }
+
+	constexpr bool is_valid() const { return m_value != 0; }
+	constexpr bool operator==(const Handle&) const = default;
+
+private:
+	uint32_t m_value = 0;
+};
+
+/**
+ * @brief Precomputed hash of a resource name, used to look resources up by
+ * name. Hashing a literal is done at compile time.
+ */
+struct NameHash
+{
+	uint64_t value = 0;
+
+	constexpr NameHash(std::string_view name) : value(utils::fnv1a_64_chars(name)) {}
+	constexpr NameHash(const char* name) : NameHash(std::string_view(name)) {}
+	NameHash(const std::string& name) : NameHash(std::string_view(name)) {}
+
+	constexpr bool operator==(const NameHash&) const = default;
+};
+
+} // namespace resource
+} // namespace jdl
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "resource.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+/**
+ * @brief Loads resources on background I/O threads. Loaded resources wait
+ * in a queue until finalize() creates their GPU objects on the main thread.
+ */
+class ResourceLoader : private NonCopyable<ResourceLoader>
+{
+public:
+	/**
+	 * @brief Starts the loader threads.
+	 * @param nb_threads Number of I/O threads.
+	 */
+	explicit ResourceLoader(uint32_t nb_threads = 2);
+
+	/**
+	 * @brief Drops the queued resources, waits for the ones being loaded and
+	 * stops the threads.
+	 */
+	~ResourceLoader();
+
+	/**
+	 * @brief Queues a resource to be loaded.
+	 * @param resource Resource to load (must stay alive until loaded or cancelled).
+	 */
+	void enqueue(Resource* resource);
+
+	/**
+	 * @brief Removes a resource from the loader, waiting for it if it is
+	 * being loaded or finalized. Its state is left to eUnloaded if it is not
+	 * finalized.
+	 * @param resource Resource to cancel.
+	 */
+	void cancel(Resource* resource);
+
+	/**
+	 * @brief Finalizes the loaded resources. Main thread only. A resource
+	 * whose finalization fails or throws is marked eFailed.
+	 * @param budget_ms Time budget: stops once exceeded (at least one
+	 * resource is finalized).
+	 * @return The number of finalized resources.
+	 */
+	uint32_t finalize(double budget_ms);
+
+	/**
+	 * @brief Waits for the queued resources to be loaded, then finalizes
+	 * all of them. Main thread only.
+	 */
+	void wait_all();
+
+	/**
+	 * @brief Returns the number of resources queued, being loaded or waiting
+	 * to be finalized.
+	 */
+	uint32_t get_nb_pending() const;
+
+private:
+	std::vector<std::thread> m_threads;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_workCondition;
+	std::condition_variable m_loadedCondition;
+
+	std::deque<Resource*> m_queue;
+	std::vector<Resource*> m_loading;
+	std::deque<Resource*> m_loaded;
+	// Resource being finalized by the main thread
+	Resource* m_finalizing = nullptr;
+
+	bool m_stop = false;
+
+	void thread_loop();
+};
+
+} // namespace resource
+} // namespace jdl
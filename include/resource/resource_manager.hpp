@@ -1,10 +1,17 @@
 #pragma once
 
 #include "resource.hpp"
+#include "resource_handle.hpp"
+#include "resource_loader.hpp"
+#include "resource_pool.hpp"
 
-#include <any>
-#include <typeindex>
-#include <unordered_map>
+#include "utils/epoch_manager.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 
 namespace jdl
@@ -12,46 +19,143 @@ namespace jdl
 namespace resource
 {
 
+/**
+ * @brief Process-wide resource storage. Resources can be created, looked up
+ * and removed from any thread.
+ * 
+ * A removed resource is destroyed by a later Update(), once no reader can
+ * reference it: the main thread may use the pointers it gets until its next
+ * Update() call, other threads must hold a Pin() guard while using them.
+ */
 class ResourceManager
 {
 public:
 	/**
-	 * @brief Creates a resource of type R and stores it in the manager.
+	 * @brief Pins the resources: the pointers returned while the guard is
+	 * alive stay valid until it is destroyed, even if the resources are
+	 * removed meanwhile. Never blocks.
+	 */
+	static utils::EpochGuard Pin()
+	{
+		return Get().m_epochs.pin();
+	}
+
+	/**
+	 * @brief Creates a resource of type R and stores it in the manager. The
+	 * resource is loaded and finalized before returning.
 	 * @param name	Desired resource name. If the name is already in use, a numeric
 	 *				suffix is appended until a unique name is found.
 	 * @param args	Arguments forwarded to the resource constructor.
-	 * @return Pointer to the created resource.
+	 * @return Handle of the created resource.
+	 */
+	template<class R, typename... Args>
+	static Handle<R> Create(const std::string& name, Args&&... args)
+	{
+		auto& pool = Get().get_pool<R>();
+		Handle<R> handle = pool.emplace(name, std::forward<Args>(args)...);
+		LoadNow(pool.get(handle));
+		return handle;
+	}
+
+	/**
+	 * @brief Creates a resource of type R and stores it in the manager. The
+	 * handle is returned right away and the resource is loaded on a background
+	 * thread, its GPU objects are created by a later Update() call. It must not
+	 * be used before its state is LoadState::eReady.
+	 * @param name	Desired resource name (made unique as in Create()).
+	 * @param args	Arguments forwarded to the resource constructor.
+	 * @return Handle of the created (not loaded yet) resource.
 	 */
 	template<class R, typename... Args>
-	static R* Create(const std::string& name, Args&&... args)
+	static Handle<R> CreateAsync(const std::string& name, Args&&... args)
+	{
+		auto& manager = Get();
+		auto& pool = manager.get_pool<R>();
+		Handle<R> handle = pool.emplace(name, std::forward<Args>(args)...);
+		manager.get_loader().enqueue(pool.get(handle));
+
+		return handle;
+	}
+
+	/**
+	 * @brief Finalizes the asynchronously loaded resources and destroys the
+	 * removed resources which are not referenced anymore. Must be called
+	 * from the main thread, at a point where GPU objects can be created.
+	 * @param budget_ms Time budget (at least one resource is finalized).
+	 * @return The number of resources which became ready.
+	 */
+	static uint32_t Update(double budget_ms = 2.0)
 	{
-		auto& bucket = Get().get_bucket<R>();
+		auto& manager = Get();
+
+		ResourceLoader* loader = manager.m_loader.load(std::memory_order_acquire);
+		uint32_t nb_ready = loader != nullptr ? loader->finalize(budget_ms) : 0;
 
-		// Find a valid resource name
-		std::string valid_name = name;
-		size_t index = 1;
+		manager.m_epochs.try_advance();
+		for (auto& pool : manager.m_pools)
+		{
+			ResourcePoolBase* base = pool.load(std::memory_order_acquire);
+			if (base != nullptr) {
+				base->collect();
+			}
+		}
+		return nb_ready;
+	}
 
-		while (bucket.get(valid_name) != nullptr) {
-			valid_name = name + std::to_string(index++);
+	/**
+	 * @brief Waits for all the asynchronous loads and finalizes them.
+	 */
+	static void WaitAll()
+	{
+		ResourceLoader* loader = Get().m_loader.load(std::memory_order_acquire);
+		if (loader != nullptr) {
+			loader->wait_all();
 		}
+	}
 
-		auto resource = std::make_unique<R>(valid_name, std::forward<Args>(args)...);
-		bucket.resources[valid_name] = std::move(resource);
+	/**
+	 * @brief Returns the number of resources being loaded asynchronously.
+	 */
+	static uint32_t GetNbPending()
+	{
+		ResourceLoader* loader = Get().m_loader.load(std::memory_order_acquire);
+		return loader != nullptr ? loader->get_nb_pending() : 0;
+	}
 
-		return static_cast<R*>(bucket.get(valid_name));
+	/**
+	 * @brief Returns a resource by handle.
+	 * @param	handle Resource handle.
+	 * @return	Pointer to the resource, or nullptr if the handle is stale
+	 *			(resource removed).
+	 */
+	template<class R>
+	static R* Get(Handle<R> handle)
+	{
+		return Get().get_pool<R>().get(handle);
 	}
 
 	/**
 	 * @brief Returns a resource of type R by name.
-	 * @param	name Resource name.
+	 * @param	name Resource name (hashed at compile time for literals).
 	 * @return	Pointer to the resource, or nullptr if no resource with that name
 	 *			exists.
 	 */
 	template<class R>
-	static R* Get(const std::string& name)
+	static R* Get(NameHash name)
+	{
+		auto& pool = Get().get_pool<R>();
+		return pool.get(pool.find(name));
+	}
+
+	/**
+	 * @brief Returns the handle of a resource of type R by name.
+	 * @param	name Resource name.
+	 * @return	The handle, invalid if no resource with that name exists.
+	 */
+	template<class R>
+	static Handle<R> GetHandle(NameHash name)
 	{
-		auto& bucket = Get().get_bucket<R>();
-		return dynamic_cast<R*>(bucket.get(name));
+		return Get().get_pool<R>().find(name);
 	}
 
 	/**
@@ -61,77 +165,150 @@ public:
 	template<class R>
 	static std::vector<R*> GetAll()
 	{
+		auto& pool = Get().get_pool<R>();
+
 		std::vector<R*> resources;
-		for (const auto& [name, resource] : Get().get_bucket<R>().resources) {
-			resources.push_back(static_cast<R*>(resource.get()));
-		}
+		pool.for_each([&resources](R* resource) { resources.push_back(resource); });
 		return resources;
 	}
 
+	/**
+	 * @brief Removes a resource by handle. Its handles become stale right
+	 * away, it is destroyed once no thread references it anymore.
+	 * @param handle Resource handle.
+	 */
+	template<class R>
+	static void Remove(Handle<R> handle)
+	{
+		auto& manager = Get();
+		auto& pool = manager.get_pool<R>();
+		auto guard = manager.m_epochs.pin();
+
+		// The loader must not use the resource anymore
+		R* resource = pool.get(handle);
+		ResourceLoader* loader = manager.m_loader.load(std::memory_order_acquire);
+		if (resource != nullptr && loader != nullptr) {
+			loader->cancel(resource);
+		}
+		pool.remove(handle);
+	}
+
 	/**
 	 * @brief Removes a resource of type R by name.
 	 * @param name Resource name.
 	 */
 	template<class R>
-	static void Remove(const std::string& name)
+	static void Remove(NameHash name)
 	{
-		auto& bucket = Get().get_bucket<R>();
-		bucket.remove(name);
+		Remove(GetHandle<R>(name));
 	}
 
 	/**
-	 * @brief Removes and clears all resources managed by every type bucket.
+	 * @brief Removes and clears all resources of every type. No other thread
+	 * may use the manager meanwhile (shutdown).
 	 */
 	static void Clear()
 	{
-		for (auto& [type, bucket] : Get().m_buckets) {
-			bucket.clear();
+		auto& manager = Get();
+
+		// Stops the pending loads first
+		delete manager.m_loader.exchange(nullptr, std::memory_order_acq_rel);
+
+		for (auto& pool : manager.m_pools)
+		{
+			ResourcePoolBase* base = pool.load(std::memory_order_acquire);
+			if (base != nullptr) {
+				base->clear();
+			}
 		}
-		Get().m_buckets.clear();
 	}
 
 private:
+	static constexpr uint32_t s_MaxResourceTypes = 64;
+
+	ResourceManager() = default;
+	~ResourceManager()
+	{
+		delete m_loader.load();
+		for (auto& pool : m_pools) {
+			delete pool.load();
+		}
+	}
+
 	static ResourceManager& Get()
 	{
 		static ResourceManager s_Manager;
 		return s_Manager;
 	}
 
-	struct Bucket
+	utils::EpochManager m_epochs;
+
+	// One pool per resource type, indexed by TypeId<R>() (never reallocated)
+	std::array<std::atomic<ResourcePoolBase*>, s_MaxResourceTypes> m_pools{};
+
+	// Asynchronous loader (created by the first asynchronous load)
+	std::atomic<ResourceLoader*> m_loader = nullptr;
+
+	// Guards the creation of the pools and of the loader
+	std::mutex m_mutex;
+
+	static uint32_t NextTypeId()
 	{
-		std::unordered_map<std::string, std::unique_ptr<Resource>> resources;
+		static std::atomic<uint32_t> s_NextTypeId = 0;
+		return s_NextTypeId.fetch_add(1, std::memory_order_relaxed);
+	}
 
-		Resource* get(const std::string& name) const
-		{
-			auto it = resources.find(name);
-			return it != resources.end() ? it->second.get() : nullptr;
+	// Dense per-type index, without RTTI
+	template<class R>
+	static uint32_t TypeId()
+	{
+		static const uint32_t s_TypeId = NextTypeId();
+		return s_TypeId;
+	}
+
+	template<class R>
+	ResourcePool<R>& get_pool()
+	{
+		uint32_t type_id = TypeId<R>();
+		if (type_id >= s_MaxResourceTypes) {
+			JDL_FATAL("Too many resource types ({})", type_id + 1);
 		}
 
-		void remove(const std::string& name)
+		auto& pool = m_pools[type_id];
+		ResourcePoolBase* base = pool.load(std::memory_order_acquire);
+		if (base == nullptr)
 		{
-			auto it = resources.find(name);
-			if (it != resources.end())
+			std::lock_guard lock(m_mutex);
+			base = pool.load(std::memory_order_relaxed);
+			if (base == nullptr)
 			{
-				it->second->clear_resource();
-				resources.erase(it);
+				base = new ResourcePool<R>(m_epochs);
+				pool.store(base, std::memory_order_release);
 			}
 		}
+		return static_cast<ResourcePool<R>&>(*base);
+	}
 
-		void clear()
+	ResourceLoader& get_loader()
+	{
+		ResourceLoader* loader = m_loader.load(std::memory_order_acquire);
+		if (loader == nullptr)
 		{
-			for (const auto& [name, resource] : resources) {
-				resource->clear_resource();
+			std::lock_guard lock(m_mutex);
+			loader = m_loader.load(std::memory_order_relaxed);
+			if (loader == nullptr)
+			{
+				loader = new ResourceLoader();
+				m_loader.store(loader, std::memory_order_release);
 			}
-			resources.clear();
 		}
-	};
-	std::unordered_map<std::type_index, Bucket> m_buckets;
+		return *loader;
+	}
 
-	template<class R>
-	Bucket& get_bucket()
+	static void LoadNow(Resource* resource)
 	{
-		auto resource_type = std::type_index(typeid(R));
-		return m_buckets[resource_type];
+		bool ready = resource->load() && resource->finalize();
+		resource->set_load_state(ready ? LoadState::eReady : LoadState::eFailed);
 	}
 };
 
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "resource.hpp"
+#include "resource_handle.hpp"
+
+#include "utils/epoch_manager.hpp"
+#include "utils/logger.hpp"
+#include "utils/non_copyable.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+// Type-erased pool, so that the manager can update the pools of every type
+class ResourcePoolBase : private NonCopyable<ResourcePoolBase>
+{
+public:
+	virtual ~ResourcePoolBase() = default;
+
+	/**
+	 * @brief Destroys the removed resources which no reader can reference
+	 * anymore.
+	 * @return The number of destroyed resources.
+	 */
+	virtual uint32_t collect() = 0;
+
+	/**
+	 * @brief Clears and destroys all the resources of the pool, removed or
+	 * not. No other thread may use the pool meanwhile.
+	 */
+	virtual void clear() = 0;
+
+protected:
+	ResourcePoolBase() = default;
+};
+
+/**
+ * @brief Thread-safe storage of the resources of type R. Resources live in
+ * fixed-size chunks of contiguous slots, so they never move (pointers stay
+ * valid) and removed slots are reused. A dense array of the live slots makes
+ * iteration as fast as a vector, and a name index maps the precomputed name
+ * hashes to the handles.
+ * 
+ * Handle lookups are lock-free (chunk table and slot generations are
+ * atomics), name lookups take a shared lock on one of the name index shards,
+ * and writers are serialized per pool. A removed resource is unlinked right
+ * away but only destroyed by collect(), once the epoch manager guarantees
+ * that no pinned reader can still hold it.
+ */
+template<class R>
+class ResourcePool : public ResourcePoolBase
+{
+public:
+	explicit ResourcePool(utils::EpochManager& epochs)
+		: m_epochs(epochs)
+		, m_chunks(std::make_unique<std::atomic<Chunk*>[]>(s_MaxChunks))
+	{}
+
+	~ResourcePool()
+	{
+		clear();
+		for (uint32_t i = 0; i < s_MaxChunks; ++i) {
+			delete m_chunks[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Constructs a resource in a free slot.
+	 * @param name Desired resource name, a numeric suffix is appended until
+	 *             the name is unused.
+	 * @param args Arguments forwarded to the resource constructor.
+	 * @return The resource handle.
+	 */
+	template<typename... Args>
+	Handle<R> emplace(const std::string& name, Args&&... args)
+	{
+		std::lock_guard lock(m_mutex);
+
+		std::string unique_name = make_unique_name(name);
+		uint32_t index = allocate_slot();
+		Slot& slot = get_slot(index);
+		new (slot.data) R(unique_name, std::forward<Args>(args)...);
+
+		m_densePositions[index] = static_cast<uint32_t>(m_dense.size());
+		m_dense.push_back(index);
+
+		// Publishes the resource to the name lookups
+		Handle<R> handle(index, slot.generation.load(std::memory_order_relaxed));
+		NameShard& shard = get_name_shard(NameHash(unique_name).value);
+		{
+			std::unique_lock name_lock(shard.mutex);
+			shard.handles[NameHash(unique_name).value] = handle.get_value();
+		}
+		return handle;
+	}
+
+	/**
+	 * @brief Unlinks a resource: its handles become stale right away, it is
+	 * destroyed by a later collect() and its slot reused.
+	 * @param handle Resource handle (ignored if stale).
+	 */
+	void remove(Handle<R> handle)
+	{
+		std::lock_guard lock(m_mutex);
+
+		R* resource = get(handle);
+		if (resource == nullptr) {
+			return;
+		}
+		uint32_t index = handle.get_index();
+
+		// Invalidates the handles of the slot (generation 0 is never used)
+		uint32_t generation = handle.get_generation() + 1;
+		get_slot(index).generation.store(
+			generation > Handle<R>::s_MaxGeneration ? 1 : generation,
+			std::memory_order_release
+		);
+
+		uint64_t name_hash = NameHash(resource->get_name()).value;
+		NameShard& shard = get_name_shard(name_hash);
+		{
+			std::unique_lock name_lock(shard.mutex);
+			shard.handles.erase(name_hash);
+		}
+
+		// Swap-removes the slot from the dense array
+		uint32_t position = m_densePositions[index];
+		m_dense[position] = m_dense.back();
+		m_densePositions[m_dense[position]] = position;
+		m_dense.pop_back();
+		m_densePositions[index] = UINT32_MAX;
+
+		// Tagged after unlinking: readers pinned later cannot find it
+		m_retired.push_back({index, m_epochs.get_epoch()});
+	}
+
+	/**
+	 * @brief Returns the resource of a handle, or nullptr if the handle is
+	 * stale. Lock-free.
+	 */
+	R* get(Handle<R> handle) const
+	{
+		uint32_t index = handle.get_index();
+		if (!handle.is_valid() || index >= m_nbSlots.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+
+		const Slot& slot = get_slot(index);
+		if (slot.generation.load(std::memory_order_acquire) != handle.get_generation()) {
+			return nullptr;
+		}
+		return get_object(index);
+	}
+
+	/**
+	 * @brief Returns the handle of a resource by name (invalid if not found).
+	 */
+	Handle<R> find(NameHash name) const
+	{
+		const NameShard& shard = get_name_shard(name.value);
+		std::shared_lock lock(shard.mutex);
+
+		auto it = shard.handles.find(name.value);
+		if (it == shard.handles.end()) {
+			return {};
+		}
+		return Handle<R>::FromValue(it->second);
+	}
+
+	/**
+	 * @brief Returns the number of live resources.
+	 */
+	uint32_t get_size() const
+	{
+		std::lock_guard lock(m_mutex);
+		return static_cast<uint32_t>(m_dense.size());
+	}
+
+	/**
+	 * @brief Calls function on every live resource, in dense order. Writers
+	 * of the pool are blocked meanwhile.
+	 */
+	template<typename F>
+	void for_each(F&& function) const
+	{
+		std::lock_guard lock(m_mutex);
+		for (uint32_t index : m_dense) {
+			function(get_object(index));
+		}
+	}
+
+	uint32_t collect() final
+	{
+		std::lock_guard lock(m_mutex);
+
+		uint32_t nb_destroyed = 0;
+		for (size_t i = 0; i < m_retired.size();)
+		{
+			if (!m_epochs.is_reclaimable(m_retired[i].epoch)) {
+				++i;
+				continue;
+			}
+			destroy(m_retired[i].index);
+			m_retired[i] = m_retired.back();
+			m_retired.pop_back();
+			++nb_destroyed;
+		}
+		return nb_destroyed;
+	}
+
+	void clear() final
+	{
+		std::lock_guard lock(m_mutex);
+
+		for (uint32_t index : m_dense)
+		{
+			Slot& slot = get_slot(index);
+			uint32_t generation = slot.generation.load(std::memory_order_relaxed) + 1;
+			slot.generation.store(generation > Handle<R>::s_MaxGeneration ? 1 : generation);
+			m_densePositions[index] = UINT32_MAX;
+			destroy(index);
+		}
+		m_dense.clear();
+
+		for (const Retired& retired : m_retired) {
+			destroy(retired.index);
+		}
+		m_retired.clear();
+
+		for (NameShard& shard : m_nameShards)
+		{
+			std::unique_lock name_lock(shard.mutex);
+			shard.handles.clear();
+		}
+		m_nextSuffixes.clear();
+	}
+
+private:
+	static constexpr uint32_t s_ChunkSize = 256;
+	static constexpr uint32_t s_MaxChunks = (Handle<R>::s_MaxIndex + 1) / s_ChunkSize;
+	static constexpr uint32_t s_NbNameShards = 16;
+
+	struct Slot
+	{
+		std::atomic<uint32_t> generation = 1;
+		alignas(R) std::byte data[sizeof(R)];
+	};
+	using Chunk = std::array<Slot, s_ChunkSize>;
+
+	struct alignas(64) NameShard
+	{
+		mutable std::shared_mutex mutex;
+		// Name hash -> handle value
+		std::unordered_map<uint64_t, uint32_t, std::identity> handles;
+	};
+
+	struct Retired
+	{
+		uint32_t index;
+		uint64_t epoch;
+	};
+
+	utils::EpochManager& m_epochs;
+
+	// Chunk table, never reallocated so that readers need no lock
+	std::unique_ptr<std::atomic<Chunk*>[]> m_chunks;
+	std::atomic<uint32_t> m_nbSlots = 0;
+
+	std::array<NameShard, s_NbNameShards> m_nameShards;
+
+	// Writers state
+	mutable std::mutex m_mutex;
+	std::vector<uint32_t> m_densePositions;	// Per slot, UINT32_MAX if not live
+	std::vector<uint32_t> m_dense;			// Slots of the live resources
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<Retired> m_retired;
+
+	// Name hash -> last numeric suffix used to make the name unique
+	std::unordered_map<uint64_t, uint32_t, std::identity> m_nextSuffixes;
+
+	Slot& get_slot(uint32_t index) const
+	{
+		Chunk* chunk = m_chunks[index / s_ChunkSize].load(std::memory_order_acquire);
+		return (*chunk)[index % s_ChunkSize];
+	}
+
+	R* get_object(uint32_t index) const
+	{
+		return std::launder(reinterpret_cast<R*>(get_slot(index).data));
+	}
+
+	NameShard& get_name_shard(uint64_t name_hash) { return m_nameShards[name_hash % s_NbNameShards]; }
+	const NameShard& get_name_shard(uint64_t name_hash) const { return m_nameShards[name_hash % s_NbNameShards]; }
+
+	bool is_name_used(uint64_t name_hash) const
+	{
+		const NameShard& shard = get_name_shard(name_hash);
+		std::shared_lock lock(shard.mutex);
+		return shard.handles.find(name_hash) != shard.handles.end();
+	}
+
+	// Writers lock held
+	std::string make_unique_name(const std::string& name)
+	{
+		uint64_t name_hash = NameHash(name).value;
+		if (!is_name_used(name_hash)) {
+			return name;
+		}
+
+		// Resumes from the last suffix used for this name
+		uint32_t& suffix = m_nextSuffixes[name_hash];
+		std::string unique_name;
+		do {
+			unique_name = name + std::to_string(++suffix);
+		} while (is_name_used(NameHash(unique_name).value));
+
+		return unique_name;
+	}
+
+	// Writers lock held
+	uint32_t allocate_slot()
+	{
+		if (!m_freeSlots.empty())
+		{
+			uint32_t index = m_freeSlots.back();
+			m_freeSlots.pop_back();
+			return index;
+		}
+
+		uint32_t index = m_nbSlots.load(std::memory_order_relaxed);
+		if (index > Handle<R>::s_MaxIndex) {
+			JDL_FATAL("Too many resources in a pool ({})", index);
+		}
+		if (index % s_ChunkSize == 0) {
+			m_chunks[index / s_ChunkSize].store(new Chunk(), std::memory_order_release);
+		}
+		m_densePositions.push_back(UINT32_MAX);
+		m_nbSlots.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	// Writers lock held, the slot must be unlinked
+	void destroy(uint32_t index)
+	{
+		R* resource = get_object(index);
+		static_cast<Resource*>(resource)->clear_resource();
+		resource->~R();
+		m_freeSlots.push_back(index);
+	}
+};
+
+} // namespace resource
+} // namespace jdl
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "resource.hpp"
+#include "shader_reflection.hpp"
+
+#include "utils/mapped_file.hpp"
 
 
 namespace jdl
@@ -12,7 +15,8 @@ class Shader : public Resource
 {
 public:
 	/**
-	 * @brief Creates the shader.
+	 * @brief Creates the shader. The module is created once the shader is
+	 * loaded and finalized by the resource manager.
 	 * @param name Shader name
 	 * @param path Shader path (SPIR-V format)
 	 */
@@ -23,6 +27,18 @@ public:
 	 */
 	const std::string& get_path() const { return m_path; }
 
+	/**
+	 * @brief Returns the hash of the SPIR-V code. Shaders with identical code
+	 * have the same hash (and share the same module), so it can be used as a
+	 * cache key for anything derived from the code.
+	 */
+	uint64_t get_hash() const { return m_hash; }
+
+	/**
+	 * @brief Returns the interface of the shader (entry points, bindings...).
+	 */
+	const ShaderReflection& get_reflection() const { return m_reflection; }
+
 	/**
 	 * @brief Returns the shader Vulkan module.
 	 */
@@ -34,17 +50,38 @@ public:
 	bool is_valid() const { return m_module != VK_NULL_HANDLE; }
 
 	/**
-	 * @brief Reloads the shader.
+	 * @brief Acquires a module for the current content of the shader file,
+	 * without touching the module in use. May run on any thread.
+	 * @param hash Receives the hash of the new code.
+	 * @param reflection Receives the interface of the new code.
+	 * @return The new module, or VK_NULL_HANDLE if the file could not be read
+	 * or compiled. It must be given to swap_module() or released from the
+	 * shader module cache.
 	 */
-	void reload();
+	VkShaderModule create_module_from_file(uint64_t& hash, ShaderReflection& reflection) const;
+
+	/**
+	 * @brief Replaces the shader module. Must be called by the render thread,
+	 * at a frame boundary.
+	 * @param module New module (owned by the shader from now on).
+	 * @param hash Hash of the new code.
+	 * @return The previous module, to be released from the shader module
+	 * cache once no frame in flight uses it anymore.
+	 */
+	VkShaderModule swap_module(VkShaderModule module, uint64_t hash);
 
 private:
-	VK_ATTR(VkDevice, m_device);
 	VK_ATTR(VkShaderModule, m_module);
 
 	std::string m_path;
+	uint64_t m_hash = 0;
+	ShaderReflection m_reflection;
+
+	// Mapped SPIR-V file, between load() and finalize()
+	utils::MappedFile m_file;
 
-	void create_shader();
+	bool load() final;
+	bool finalize() final;
 	void clear_resource() final;
 };
 
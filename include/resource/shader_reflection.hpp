@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+struct ShaderEntryPoint
+{
+	std::string name;
+	VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+
+	bool operator==(const ShaderEntryPoint&) const = default;
+};
+
+struct ShaderBinding
+{
+	uint32_t set = 0;
+	uint32_t binding = 0;
+	VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	// Number of descriptors (0 for runtime-sized arrays)
+	uint32_t count = 1;
+	// Stages of the entry points using the binding
+	VkShaderStageFlags stages = 0;
+	std::string name;
+
+	bool operator==(const ShaderBinding&) const = default;
+};
+
+struct ShaderPushConstantRange
+{
+	uint32_t offset = 0;
+	uint32_t size = 0;
+	VkShaderStageFlags stages = 0;
+
+	bool operator==(const ShaderPushConstantRange&) const = default;
+};
+
+struct ShaderVertexInput
+{
+	uint32_t location = 0;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	std::string name;
+
+	bool operator==(const ShaderVertexInput&) const = default;
+};
+
+/**
+ * @brief Interface of a SPIR-V module, extracted by a built-in parser: entry
+ * points, descriptor bindings, push constant ranges and vertex inputs.
+ * 
+ * Resources are attributed to the entry points listing them in their
+ * interface (SPIR-V 1.4+). With older modules, which only list their inputs
+ * and outputs, they are attributed to every entry point.
+ */
+struct ShaderReflection
+{
+	std::vector<ShaderEntryPoint> entry_points;
+	// Sorted by set and binding
+	std::vector<ShaderBinding> bindings;
+	std::vector<ShaderPushConstantRange> push_constants;
+	// Inputs of the vertex entry point, sorted by location
+	std::vector<ShaderVertexInput> vertex_inputs;
+
+	/**
+	 * @brief Parses a SPIR-V module.
+	 * @param code SPIR-V code.
+	 * @param size Code size in bytes.
+	 * @return Whether the module has been parsed or not (invalid code).
+	 */
+	bool reflect(const void* code, size_t size);
+
+	/**
+	 * @brief Returns the first entry point of a stage, or nullptr if the
+	 * module has none.
+	 */
+	const ShaderEntryPoint* find_entry_point(VkShaderStageFlagBits stage) const;
+
+	/**
+	 * @brief Returns the entry point with this name, or nullptr if the
+	 * module has none.
+	 */
+	const ShaderEntryPoint* find_entry_point(const std::string& name) const;
+
+	bool operator==(const ShaderReflection&) const = default;
+};
+
+} // namespace resource
+} // namespace jdl
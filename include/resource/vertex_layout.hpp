@@ -0,0 +1,234 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace jdl
+{
+
+namespace vk
+{
+struct PipelineDesc;
+} // namespace vk
+
+namespace resource
+{
+
+// Vertex attributes, the shader input location of each one is its value
+enum class VertexAttribute
+{
+	ePosition,
+	eNormal,
+	eTangent,
+	eTexCoord,
+	eColor,
+	eCount
+};
+
+enum class VertexFormat
+{
+	// Attribute not stored
+	eNone,
+	// 32-bit floats
+	eFloat32x2,
+	eFloat32x3,
+	eFloat32x4,
+	// Half floats (texture coordinates)
+	eFloat16x2,
+	// Position normalized in the mesh bounds (see MeshBounds), w = 1
+	eSnorm16x4,
+	// Octahedral-encoded unit vector (normals), or unit vector and
+	// handedness (tangents, the sign of y stores the sign of w)
+	eOctSnorm16x2,
+	// Normalized 8-bit color
+	eUnorm8x4
+};
+
+enum class VertexStreams
+{
+	// All the attributes in a single stream
+	eInterleaved,
+	// Positions in stream 0, the other attributes in stream 1 (position-only
+	// passes such as depth or shadows only fetch stream 0)
+	eSplitPositions
+};
+
+struct VertexData;
+
+/**
+ * @brief Describes how the vertices of a mesh are stored: the format of each
+ * attribute, and how the attributes are spread over the vertex streams (one
+ * vertex buffer binding per stream). The pipeline vertex input is derived
+ * from it (see fill_pipeline_desc()).
+ */
+struct VertexLayout
+{
+	static constexpr size_t s_NbAttributes = static_cast<size_t>(VertexAttribute::eCount);
+	static constexpr uint32_t s_MaxStreams = 2;
+
+	std::array<VertexFormat, s_NbAttributes> formats {};
+	VertexStreams streams = VertexStreams::eInterleaved;
+
+	bool operator==(const VertexLayout&) const = default;
+
+	/**
+	 * @brief Returns the full precision layout: 32-bit float attributes, in
+	 * a single stream.
+	 * @param has_tangents Whether the tangents are stored or not.
+	 * @param has_colors Whether the colors are stored or not.
+	 */
+	static VertexLayout Full(bool has_tangents = false, bool has_colors = false);
+
+	/**
+	 * @brief Returns the compact layout: snorm16 positions, octahedral
+	 * normals/tangents and half float texture coordinates, with positions in
+	 * their own stream. About half the size of the full layout.
+	 * @param has_tangents Whether the tangents are stored or not.
+	 * @param has_colors Whether the colors are stored or not.
+	 */
+	static VertexLayout Compact(bool has_tangents = false, bool has_colors = false);
+
+	/**
+	 * @brief Returns the compact or full layout storing exactly the
+	 * attributes present in some vertices.
+	 * @param data Vertices.
+	 * @param full_precision Full layout instead of the compact one.
+	 */
+	static VertexLayout ForData(const VertexData& data, bool full_precision = false);
+
+	/**
+	 * @brief Returns the size of a vertex format in bytes.
+	 */
+	static uint32_t GetFormatSize(VertexFormat format);
+
+	/**
+	 * @brief Returns the Vulkan format of a vertex format.
+	 */
+	static VkFormat GetVkFormat(VertexFormat format);
+
+	/**
+	 * @brief Returns the format of an attribute (eNone if not stored).
+	 */
+	VertexFormat get_format(VertexAttribute attribute) const {
+		return formats[static_cast<size_t>(attribute)];
+	}
+
+	/**
+	 * @brief Sets the format of an attribute.
+	 * @param attribute Vertex attribute.
+	 * @param format Attribute format (eNone to remove it).
+	 * @return The layout, to chain the calls.
+	 */
+	VertexLayout& set_format(VertexAttribute attribute, VertexFormat format) {
+		formats[static_cast<size_t>(attribute)] = format;
+		return *this;
+	}
+
+	/**
+	 * @brief Returns whether an attribute is stored or not.
+	 */
+	bool has(VertexAttribute attribute) const {
+		return get_format(attribute) != VertexFormat::eNone;
+	}
+
+	/**
+	 * @brief Returns the number of vertex streams.
+	 */
+	uint32_t get_nb_streams() const {
+		return streams == VertexStreams::eInterleaved ? 1 : 2;
+	}
+
+	/**
+	 * @brief Returns the stream storing an attribute.
+	 */
+	uint32_t get_stream(VertexAttribute attribute) const {
+		return streams == VertexStreams::eSplitPositions && attribute != VertexAttribute::ePosition ? 1 : 0;
+	}
+
+	/**
+	 * @brief Returns the offset of an attribute in a vertex of its stream.
+	 */
+	uint32_t get_offset(VertexAttribute attribute) const;
+
+	/**
+	 * @brief Returns the size of a vertex in a stream in bytes.
+	 */
+	uint32_t get_stride(uint32_t stream) const;
+
+	/**
+	 * @brief Returns the size of a vertex over all the streams in bytes.
+	 */
+	uint32_t get_vertex_size() const;
+
+	/**
+	 * @brief Returns whether the layout is valid (positions stored, no empty
+	 * stream, valid format for each attribute) or not.
+	 */
+	bool is_valid() const;
+
+	/**
+	 * @brief Fills the vertex bindings and attributes of a pipeline
+	 * description. If the description has a vertex shader, only the
+	 * attributes read by the shader are declared.
+	 * @param desc Pipeline description.
+	 */
+	void fill_pipeline_desc(vk::PipelineDesc& desc) const;
+
+	/**
+	 * @brief Returns the hash of the layout.
+	 */
+	uint64_t hash() const;
+};
+
+/**
+ * @brief Axis-aligned bounds of a mesh. Quantized positions (eSnorm16x4) are
+ * stored relative to them: position = center + extent * quantized.
+ */
+struct MeshBounds
+{
+	std::array<float, 3> center {};
+	std::array<float, 3> extent {};
+};
+
+/**
+ * @brief Full precision vertices, one array per attribute (empty if the
+ * attribute is missing), converted to a vertex layout by encode_vertices().
+ */
+struct VertexData
+{
+	std::vector<float> positions;	// 3 floats per vertex
+	std::vector<float> normals;		// 3 floats per vertex
+	std::vector<float> tangents;	// 4 floats per vertex (w: handedness)
+	std::vector<float> texcoords;	// 2 floats per vertex
+	std::vector<float> colors;		// 4 floats per vertex
+
+	/**
+	 * @brief Returns the number of vertices.
+	 */
+	size_t get_nb_vertices() const { return positions.size() / 3; }
+
+	/**
+	 * @brief Computes the bounds of the positions.
+	 */
+	MeshBounds compute_bounds() const;
+};
+
+/**
+ * @brief Encodes vertices into the streams of a layout. Attributes missing
+ * from the data are filled with defaults.
+ * @param data Full precision vertices.
+ * @param layout Vertex layout.
+ * @param bounds Bounds used to quantize the positions.
+ * @param streams Receives the bytes of each stream.
+ */
+void encode_vertices(
+	const VertexData& data,
+	const VertexLayout& layout,
+	const MeshBounds& bounds,
+	std::array<std::vector<uint8_t>, VertexLayout::s_MaxStreams>& streams
+);
+
+} // namespace resource
+} // namespace jdl
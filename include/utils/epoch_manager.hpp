@@ -0,0 +1,90 @@
+#pragma once
+
+#include "non_copyable.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+class EpochManager;
+
+/**
+ * @brief Pins the current epoch while alive: objects retired from now on are
+ * not reclaimed before the guard is destroyed.
+ */
+class [[nodiscard]] EpochGuard : private NonCopyable<EpochGuard>
+{
+public:
+    ~EpochGuard();
+
+private:
+    friend class EpochManager;
+
+    EpochGuard(EpochManager& manager, uint32_t shard, uint32_t parity);
+
+    EpochManager& m_manager;
+    uint32_t m_shard;
+    uint32_t m_parity;
+};
+
+/**
+ * @brief Epoch-based reclamation. Readers pin the current epoch, writers
+ * unlink objects and retire them with the epoch of the removal, and the
+ * objects are reclaimed once the global epoch moved two steps ahead: no
+ * reader can still reference them.
+ * 
+ * Pinning only touches a per-thread-group counter (no lock, no wait on
+ * writers), so readers never block.
+ */
+class EpochManager : private NonCopyable<EpochManager>
+{
+public:
+    EpochManager() = default;
+
+    /**
+     * @brief Pins the current epoch (reader side). Guards may be nested.
+     */
+    EpochGuard pin();
+
+    /**
+     * @brief Returns the current epoch, to tag an unlinked object.
+     */
+    uint64_t get_epoch() const { return m_epoch.load(std::memory_order_seq_cst); }
+
+    /**
+     * @brief Advances the epoch if no reader is pinned in the previous one.
+     * @return The current epoch.
+     */
+    uint64_t try_advance();
+
+    /**
+     * @brief Returns whether an object retired at retire_epoch can be
+     * reclaimed or not.
+     */
+    bool is_reclaimable(uint64_t retire_epoch) const { return retire_epoch + 2 <= get_epoch(); }
+
+private:
+    friend class EpochGuard;
+
+    static constexpr uint32_t s_NbShards = 16;
+
+    // Readers pinned per epoch parity, spread over cache lines
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint32_t>, 2> readers{};
+    };
+    std::array<Shard, s_NbShards> m_shards;
+
+    alignas(64) std::atomic<uint64_t> m_epoch = 0;
+
+    void unpin(uint32_t shard, uint32_t parity);
+};
+
+} // namespace utils
+} // namespace jdl
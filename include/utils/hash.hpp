@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+static constexpr uint64_t s_Fnv1aOffsetBasis = 0xcbf29ce484222325ull;
+static constexpr uint64_t s_Fnv1aPrime = 0x100000001b3ull;
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of a byte range. The result is
+ * stable across runs and platforms, so it can be stored on disk.
+ * @param data Bytes to hash.
+ * @param size Number of bytes.
+ * @param seed Previous hash, to hash several ranges in sequence.
+ */
+inline uint64_t fnv1a_64(const void* data, size_t size, uint64_t seed = s_Fnv1aOffsetBasis)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= s_Fnv1aPrime;
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of the characters of a string, at
+ * compile time when possible. Same result as fnv1a_64(data, size).
+ * @param value String to hash.
+ */
+constexpr uint64_t fnv1a_64_chars(std::string_view value, uint64_t seed = s_Fnv1aOffsetBasis)
+{
+    uint64_t hash = seed;
+    for (char c : value)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= s_Fnv1aPrime;
+    }
+    return hash;
+}
+
+/**
+ * @brief Hashes a scalar value (integer, float or enum) with FNV-1a.
+ * @param value Value to hash.
+ * @param seed Previous hash, to hash several values in sequence.
+ */
+template<typename T>
+    requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+inline uint64_t fnv1a_64(T value, uint64_t seed)
+{
+    return fnv1a_64(&value, sizeof(value), seed);
+}
+
+/**
+ * @brief Hashes a string with FNV-1a. The size is hashed first, so that
+ * consecutive strings cannot collide by moving characters between them.
+ * @param value String to hash.
+ * @param seed Previous hash, to hash several values in sequence.
+ */
+inline uint64_t fnv1a_64(std::string_view value, uint64_t seed)
+{
+    seed = fnv1a_64(value.size(), seed);
+    return fnv1a_64(value.data(), value.size(), seed);
+}
+
+} // namespace utils
+} // namespace jdl
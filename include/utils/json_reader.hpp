@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+/**
+ * @brief Pull JSON parser: the caller walks the document value by value and
+ * decodes each one straight into its own structures, nothing is stored in
+ * between (no DOM). Unwanted values are skipped with skip().
+ *
+ * Errors are sticky: once a value is malformed every call fails, so a whole
+ * parse can be checked once at the end with has_error().
+ *
+ * Typical object walk:
+ *     reader.begin_object();
+ *     std::string_view key;
+ *     while (reader.next_member(key)) {
+ *         if (key == "name") reader.read_string(name);
+ *         else reader.skip();
+ *     }
+ */
+class JsonReader
+{
+public:
+    enum class Type
+    {
+        eNull,
+        eBool,
+        eNumber,
+        eString,
+        eArray,
+        eObject,
+        eInvalid
+    };
+
+    /**
+     * @brief Creates the reader.
+     * @param text JSON text, must outlive the reader.
+     */
+    explicit JsonReader(std::string_view text) : m_text(text) {}
+
+    /**
+     * @brief Returns the type of the next value, without consuming it.
+     */
+    Type peek();
+
+    /**
+     * @brief Consumes the opening brace of an object.
+     * @return Whether the next value is an object or not.
+     */
+    bool begin_object();
+
+    /**
+     * @brief Moves to the next member of the current object.
+     * @param key Receives the raw key (escape sequences are not decoded).
+     * @return Whether a member has been found (its value must be read or
+     * skipped next), false at the end of the object.
+     */
+    bool next_member(std::string_view& key);
+
+    /**
+     * @brief Consumes the opening bracket of an array.
+     * @return Whether the next value is an array or not.
+     */
+    bool begin_array();
+
+    /**
+     * @brief Moves to the next element of the current array.
+     * @return Whether an element has been found (it must be read or skipped
+     * next), false at the end of the array.
+     */
+    bool next_element();
+
+    /**
+     * @brief Reads a number.
+     */
+    bool read_number(double& value);
+
+    /**
+     * @brief Reads a number as a float.
+     */
+    bool read_float(float& value);
+
+    /**
+     * @brief Reads a non-negative integer fitting on 32 bits.
+     */
+    bool read_uint(uint32_t& value);
+
+    /**
+     * @brief Reads a non-negative integer fitting on 64 bits.
+     */
+    bool read_uint64(uint64_t& value);
+
+    /**
+     * @brief Reads a boolean.
+     */
+    bool read_bool(bool& value);
+
+    /**
+     * @brief Reads a string, decoding its escape sequences (UTF-8 output).
+     */
+    bool read_string(std::string& value);
+
+    /**
+     * @brief Reads a string without decoding it, for values known to have no
+     * escape sequence (enumerations, base64 data...).
+     */
+    bool read_raw_string(std::string_view& value);
+
+    /**
+     * @brief Reads up to max_count numbers from an array of numbers.
+     * @param values Receives the numbers.
+     * @param max_count Capacity of values, the extra numbers are an error.
+     * @return The number of values read (0 on error).
+     */
+    size_t read_floats(float* values, size_t max_count);
+
+    /**
+     * @brief Skips the next value (including all its children).
+     */
+    bool skip();
+
+    /**
+     * @brief Returns whether a malformed value has been met or not.
+     */
+    bool has_error() const { return m_error; }
+
+    /**
+     * @brief Returns the current offset in the text (error messages).
+     */
+    size_t get_offset() const { return m_offset; }
+
+    /**
+     * @brief Returns whether the whole text has been consumed (trailing
+     * whitespaces allowed).
+     */
+    bool is_end();
+
+private:
+    std::string_view m_text;
+    size_t m_offset = 0;
+    bool m_error = false;
+
+    // Whether the next member/element is the first of its container
+    bool m_first = false;
+
+    char peek_char();
+    bool consume(char c);
+    bool fail();
+    bool next_item(char closing);
+    bool scan_string(std::string_view& value);
+};
+
+} // namespace utils
+} // namespace jdl
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "non_copyable.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+/**
+ * @brief Read-only memory mapping of a whole file. The content is paged in
+ * by the OS on access, without any copy into a user buffer (read into a
+ * buffer on the platforms without mmap).
+ */
+class MappedFile : private NonCopyable<MappedFile>
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    /**
+     * @brief Maps a file, unmapping the previous one.
+     * @param path File path.
+     * @return Whether the file has been mapped or not.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    /**
+     * @brief Returns the file content (nullptr if empty or not mapped).
+     */
+    const std::byte* get_data() const { return m_data; }
+
+    /**
+     * @brief Returns the file size in bytes.
+     */
+    size_t get_size() const { return m_size; }
+
+private:
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+
+    // Content of the file when it cannot be mapped
+    std::vector<std::byte> m_buffer;
+};
+
+} // namespace utils
+} // namespace jdl
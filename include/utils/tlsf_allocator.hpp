@@ -0,0 +1,125 @@
+#pragma once
+
+#include "non_copyable.hpp"
+
+#include <array>
+#include <cstdint>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+/**
+ * @brief Two-Level Segregated Fit allocator managing offsets in a linear
+ * range (it never touches the memory itself). Allocations and frees run in
+ * constant time, and free neighbours are merged immediately to keep the
+ * fragmentation low.
+ */
+class TlsfAllocator : private NonCopyable<TlsfAllocator>
+{
+public:
+    static constexpr uint32_t s_InvalidNode = UINT32_MAX;
+
+    struct Allocation
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        // Node to give back to free()
+        uint32_t node = s_InvalidNode;
+
+        bool is_valid() const { return node != s_InvalidNode; }
+    };
+
+    /**
+     * @brief Creates the allocator.
+     * @param size Size of the managed range.
+     */
+    explicit TlsfAllocator(uint64_t size);
+
+    /**
+     * @brief Allocates a range.
+     * @param size Size of the range.
+     * @param alignment Alignment of the range offset (power of 2).
+     * @return The allocated range, invalid if there is not enough space.
+     */
+    Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+    /**
+     * @brief Frees a range.
+     * @param node The node of the allocated range.
+     */
+    void free(uint32_t node);
+
+    /**
+     * @brief Returns the size of the managed range.
+     */
+    uint64_t get_size() const { return m_size; }
+
+    /**
+     * @brief Returns the number of allocated bytes.
+     */
+    uint64_t get_used_size() const { return m_usedSize; }
+
+    /**
+     * @brief Returns the number of allocated ranges.
+     */
+    uint32_t get_nb_allocations() const { return m_nbAllocations; }
+
+    /**
+     * @brief Returns the size of the largest free range.
+     */
+    uint64_t get_largest_free_size() const;
+
+    /**
+     * @brief Returns whether no range is allocated or not.
+     */
+    bool is_empty() const { return m_nbAllocations == 0; }
+
+private:
+    // Second level: each first level range is split in 2^s_SecondLevelLog2 lists
+    static constexpr uint32_t s_SecondLevelLog2 = 4;
+    static constexpr uint32_t s_SecondLevelCount = 1u << s_SecondLevelLog2;
+    static constexpr uint32_t s_FirstLevelCount = 64 - s_SecondLevelLog2 + 1;
+
+    struct Node
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        // Physical neighbours
+        uint32_t prev_physical = s_InvalidNode;
+        uint32_t next_physical = s_InvalidNode;
+        // Free list links (free nodes only)
+        uint32_t prev_free = s_InvalidNode;
+        uint32_t next_free = s_InvalidNode;
+        bool used = false;
+    };
+
+    uint64_t m_size = 0;
+    uint64_t m_usedSize = 0;
+    uint32_t m_nbAllocations = 0;
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_unusedNodes;
+
+    uint64_t m_firstLevelBitmap = 0;
+    std::array<uint32_t, s_FirstLevelCount> m_secondLevelBitmaps {};
+    std::array<std::array<uint32_t, s_SecondLevelCount>, s_FirstLevelCount> m_freeLists;
+
+    static void MappingInsert(uint64_t size, uint32_t& fl, uint32_t& sl);
+    static void MappingSearch(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+    uint32_t create_node();
+    void release_node(uint32_t node);
+
+    void insert_free_node(uint32_t node);
+    void remove_free_node(uint32_t node);
+    uint32_t find_free_node(uint64_t size) const;
+
+    uint32_t split_node(uint32_t node, uint64_t size);
+    void merge_with_next(uint32_t node);
+};
+
+} // namespace utils
+} // namespace jdl
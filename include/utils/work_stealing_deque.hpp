@@ -0,0 +1,128 @@
+#pragma once
+
+#include "non_copyable.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+/**
+ * @brief Bounded lock-free work-stealing deque (Chase-Lev, with the memory
+ * orderings of Lê et al. 2013). The owner thread pushes and pops at the
+ * bottom, any other thread steals from the top.
+ * 
+ * @tparam T Element type, trivially copyable (typically a pointer).
+ */
+template<typename T>
+class WorkStealingDeque : private NonCopyable<WorkStealingDeque<T>>
+{
+public:
+    /**
+     * @brief Creates the deque.
+     * @param capacity Maximum number of elements, rounded up to a power of two.
+     */
+    explicit WorkStealingDeque(uint32_t capacity = 4096)
+    {
+        uint32_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        m_mask = rounded - 1;
+        m_buffer = std::make_unique<std::atomic<T>[]>(rounded);
+    }
+
+    /**
+     * @brief Pushes an element at the bottom. Owner thread only.
+     * @return false if the deque is full.
+     */
+    bool push(T value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top > static_cast<int64_t>(m_mask)) {
+            return false;
+        }
+
+        m_buffer[bottom & m_mask].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Pops the most recently pushed element. Owner thread only.
+     * @return false if the deque is empty.
+     */
+    bool pop(T& value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = m_buffer[bottom & m_mask].load(std::memory_order_relaxed);
+        if (top != bottom) {
+            return true;
+        }
+
+        // Last element: races with the thieves
+        bool won = m_top.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+        );
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    /**
+     * @brief Steals the least recently pushed element. Any thread.
+     * @return false if the deque is empty or the steal lost a race.
+     */
+    bool steal(T& value)
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return false;
+        }
+
+        value = m_buffer[top & m_mask].load(std::memory_order_relaxed);
+        return m_top.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+        );
+    }
+
+    /**
+     * @brief Returns an estimation of the number of elements.
+     */
+    uint32_t get_size() const
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<uint32_t>(bottom - top) : 0;
+    }
+
+private:
+    // Separate cache lines: the owner writes bottom, the thieves write top
+    alignas(64) std::atomic<int64_t> m_top = 0;
+    alignas(64) std::atomic<int64_t> m_bottom = 0;
+    alignas(64) std::unique_ptr<std::atomic<T>[]> m_buffer;
+    uint64_t m_mask = 0;
+};
+
+} // namespace utils
+} // namespace jdl
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "utils/non_copyable.hpp"
+#include "utils/tlsf_allocator.hpp"
+
+#include <array>
+#include <mutex>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+enum class MemoryUsage
+{
+	// Device local memory, not accessible from the host
+	eGpuOnly,
+	// Host visible memory written by the host (staging, per-frame data)
+	eCpuToGpu,
+	// Host visible memory read by the host (readbacks), cached if possible
+	eGpuToCpu
+};
+
+struct VulkanAllocation
+{
+	VK_ATTR(VkDeviceMemory, memory);
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	uint32_t memory_type = UINT32_MAX;
+	// Persistently mapped pointer (host visible memory only)
+	void* mapped_data = nullptr;
+
+	// Owning block (UINT32_MAX for dedicated allocations) and TLSF node
+	uint32_t block = UINT32_MAX;
+	uint32_t node = UINT32_MAX;
+
+	bool is_valid() const { return memory != VK_NULL_HANDLE; }
+	bool is_dedicated() const { return block == UINT32_MAX; }
+};
+
+struct MemoryHeapStats
+{
+	VkDeviceSize heap_size = 0;
+	VkMemoryHeapFlags flags = 0;
+
+	// Device memory allocated from the driver (blocks + dedicated allocations)
+	VkDeviceSize reserved_bytes = 0;
+	// Memory used by the allocations
+	VkDeviceSize used_bytes = 0;
+
+	uint32_t nb_blocks = 0;
+	uint32_t nb_allocations = 0;
+	uint32_t nb_dedicated_allocations = 0;
+};
+
+/**
+ * @brief Device memory allocator. Large memory blocks are allocated for each
+ * memory type and sub-allocated with a TLSF allocator, so that the number of
+ * driver allocations stays far below maxMemoryAllocationCount. Large
+ * resources, and the ones the driver wants alone in their memory, get their
+ * own dedicated allocation. Thread-safe.
+ */
+class VulkanAllocator : private NonCopyable<VulkanAllocator>
+{
+public:
+	static constexpr VkDeviceSize s_DefaultBlockSize = 64ull * 1024 * 1024;
+
+	/**
+	 * @brief Creates the allocator.
+	 * @param block_size Size of the memory blocks (smaller on small heaps).
+	 */
+	VulkanAllocator(VkDeviceSize block_size = s_DefaultBlockSize);
+
+	/**
+	 * @brief Frees all the memory blocks.
+	 */
+	~VulkanAllocator();
+
+	/**
+	 * @brief Allocates device memory which is not bound to a single resource
+	 * (e.g. aliased by several images). Use allocate_buffer() or
+	 * allocate_image() otherwise.
+	 * @param requirements Memory requirements of the resource.
+	 * @param usage Intended memory usage.
+	 * @param linear Whether the resource is a buffer or a linear image.
+	 * Linear and optimal resources never share a block, which makes
+	 * bufferImageGranularity irrelevant.
+	 * @param dedicated Forces a dedicated allocation.
+	 * @return The allocation, invalid if the memory is exhausted.
+	 */
+	VulkanAllocation allocate(
+		const VkMemoryRequirements& requirements,
+		MemoryUsage usage,
+		bool linear,
+		bool dedicated = false
+	);
+
+	/**
+	 * @brief Allocates the memory of a buffer. Buffers requiring or preferring
+	 * a dedicated allocation (VkMemoryDedicatedRequirements) always get one.
+	 * @param buffer The buffer.
+	 * @param usage Intended memory usage.
+	 * @param dedicated Forces a dedicated allocation.
+	 * @return The allocation, invalid if the memory is exhausted.
+	 */
+	VulkanAllocation allocate_buffer(VkBuffer buffer, MemoryUsage usage, bool dedicated = false);
+
+	/**
+	 * @brief Allocates the memory of an optimal tiling image. Images requiring
+	 * or preferring a dedicated allocation (VkMemoryDedicatedRequirements)
+	 * always get one.
+	 * @param image The image.
+	 * @param usage Intended memory usage.
+	 * @param dedicated Forces a dedicated allocation.
+	 * @return The allocation, invalid if the memory is exhausted.
+	 */
+	VulkanAllocation allocate_image(VkImage image, MemoryUsage usage, bool dedicated = false);
+
+	/**
+	 * @brief Frees an allocation and resets it.
+	 * @param allocation The allocation to free.
+	 */
+	void free(VulkanAllocation& allocation);
+
+	/**
+	 * @brief Returns the usage statistics of each memory heap.
+	 */
+	std::vector<MemoryHeapStats> get_heap_stats() const;
+
+	/**
+	 * @brief Logs the usage statistics of each memory heap.
+	 */
+	void log_stats() const;
+
+private:
+	struct MemoryBlock
+	{
+		VK_ATTR(VkDeviceMemory, memory);
+		void* mapped_data = nullptr;
+		uint32_t memory_type = UINT32_MAX;
+		bool linear = false;
+		std::unique_ptr<utils::TlsfAllocator> tlsf;
+	};
+
+	struct DedicatedStats
+	{
+		VkDeviceSize bytes = 0;
+		uint32_t count = 0;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+	VkPhysicalDeviceMemoryProperties m_memoryProperties {};
+	VkDeviceSize m_blockSize = 0;
+
+	mutable std::mutex m_mutex;
+
+	// Blocks (nullptr once freed, the slot is reused)
+	std::vector<std::unique_ptr<MemoryBlock>> m_blocks;
+	std::array<DedicatedStats, VK_MAX_MEMORY_TYPES> m_dedicatedStats {};
+
+	uint32_t find_memory_type(uint32_t type_bits, MemoryUsage usage) const;
+	VkDeviceSize get_block_size(uint32_t memory_type) const;
+
+	VkDeviceMemory allocate_memory(
+		uint32_t memory_type,
+		VkDeviceSize size,
+		void** mapped_data,
+		const VkMemoryDedicatedAllocateInfo* dedicated_info = nullptr
+	);
+	void free_memory(VkDeviceMemory memory, void* mapped_data);
+
+	VulkanAllocation do_allocate(
+		const VkMemoryRequirements& requirements,
+		MemoryUsage usage,
+		bool linear,
+		bool dedicated,
+		const VkMemoryDedicatedAllocateInfo* dedicated_info
+	);
+	VulkanAllocation allocate_dedicated(
+		uint32_t memory_type,
+		VkDeviceSize size,
+		const VkMemoryDedicatedAllocateInfo* dedicated_info = nullptr
+	);
+	VulkanAllocation allocate_from_blocks(
+		uint32_t memory_type,
+		const VkMemoryRequirements& requirements,
+		bool linear
+	);
+};
+
+} // namespace vk
+} // namespace jdl
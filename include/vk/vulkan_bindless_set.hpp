@@ -0,0 +1,188 @@
+#pragma once
+
+#include "vulkan_layout_cache.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+class VulkanCommandBuffer;
+
+enum class BindlessType
+{
+	eTexture,		// VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+	eSampler,		// VK_DESCRIPTOR_TYPE_SAMPLER
+	eStorageBuffer	// VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+};
+
+/**
+ * @brief Global descriptor set holding every texture, sampler and storage
+ * buffer in unbounded arrays (one binding per type, see BindlessType).
+ * Resources are registered once and addressed by their index: shaders receive
+ * the indices through push constants and index the arrays, so the set is
+ * bound once per pipeline layout instead of being rewritten per draw.
+ *
+ * The set uses update-after-bind and partially bound bindings: registrations
+ * are visible to the next submissions even if the set is already bound, and
+ * unused slots may hold nothing. A released index is only reused once the
+ * frames that may access it are finished (see update()). Thread-safe.
+ */
+class VulkanBindlessSet : private NonCopyable<VulkanBindlessSet>
+{
+public:
+	// Set index reserved for the bindless set in the shaders
+	static constexpr uint32_t s_Set = 0;
+	static constexpr uint32_t s_InvalidIndex = UINT32_MAX;
+
+	VulkanBindlessSet();
+	~VulkanBindlessSet();
+
+	/**
+	 * @brief Returns the binding of the array holding a type of resource.
+	 */
+	static constexpr uint32_t GetBinding(BindlessType type) {
+		return static_cast<uint32_t>(type);
+	}
+
+	/**
+	 * @brief Registers a sampled image.
+	 * @param view Image view.
+	 * @param layout Layout of the image when accessed by the shaders.
+	 * @return The texture index, or s_InvalidIndex if the array is full.
+	 */
+	uint32_t register_texture(
+		VkImageView view,
+		VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	);
+
+	/**
+	 * @brief Registers a sampler.
+	 * @param sampler Sampler.
+	 * @return The sampler index, or s_InvalidIndex if the array is full.
+	 */
+	uint32_t register_sampler(VkSampler sampler);
+
+	/**
+	 * @brief Registers a storage buffer range.
+	 * @param buffer Buffer (created with VK_BUFFER_USAGE_STORAGE_BUFFER_BIT).
+	 * @param offset Range offset.
+	 * @param range Range size.
+	 * @return The buffer index, or s_InvalidIndex if the array is full.
+	 */
+	uint32_t register_storage_buffer(
+		VkBuffer buffer,
+		VkDeviceSize offset = 0,
+		VkDeviceSize range = VK_WHOLE_SIZE
+	);
+
+	/**
+	 * @brief Releases an index. The resource must not be accessed through it
+	 * by the next recorded frames, but may still be used by the frames in
+	 * flight: the index is reused once they are finished.
+	 * @param type Type of the resource.
+	 * @param index Index returned by the registration (ignored if invalid).
+	 */
+	void unregister(BindlessType type, uint32_t index);
+
+	/**
+	 * @brief Recycles the indices which are not used by the GPU anymore. Must
+	 * be called once per frame, after waiting for the frame fence.
+	 * @param frame Number of the frame about to be recorded.
+	 * @param nb_frames_in_flight Number of frames in flight.
+	 */
+	void update(uint64_t frame, uint32_t nb_frames_in_flight);
+
+	/**
+	 * @brief Binds the set. Pipeline layouts sharing the same push constant
+	 * ranges are compatible for the set: it stays bound across pipeline
+	 * switches and only has to be rebound when the ranges change.
+	 * @param command_buffer Command buffer.
+	 * @param bind_point Graphics or compute.
+	 * @param layout Pipeline layout using the bindless set (see s_Set).
+	 */
+	void bind(
+		VulkanCommandBuffer& command_buffer,
+		VkPipelineBindPoint bind_point,
+		VkPipelineLayout layout
+	) const;
+
+	/**
+	 * @brief Returns the description of the set layout, used by every
+	 * pipeline layout accessing the set.
+	 */
+	const DescriptorSetLayoutDesc& get_layout_desc() const { return m_layoutDesc; }
+
+	/**
+	 * @brief Returns the set layout.
+	 */
+	VkDescriptorSetLayout get_layout() const { return m_layout; }
+
+	/**
+	 * @brief Returns the descriptor set.
+	 */
+	VkDescriptorSet get_set() const { return m_set; }
+
+	/**
+	 * @brief Returns the number of slots of a type of resource.
+	 */
+	uint32_t get_capacity(BindlessType type) const;
+
+	/**
+	 * @brief Returns the number of registered resources of a type.
+	 */
+	uint32_t get_nb_registered(BindlessType type) const;
+
+private:
+	static constexpr size_t s_NbTypes = 3;
+
+	struct RetiredIndex
+	{
+		uint32_t index;
+		uint64_t frame;
+	};
+
+	struct Table
+	{
+		VkDescriptorType descriptor_type;
+		uint32_t capacity = 0;
+		// Indices below have been handed out at least once
+		uint32_t next_index = 0;
+		uint32_t nb_registered = 0;
+		std::vector<uint32_t> free_indices;
+		std::deque<RetiredIndex> retired;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+	VK_ATTR(VkDescriptorPool, m_pool);
+	VK_ATTR(VkDescriptorSetLayout, m_layout);
+	VK_ATTR(VkDescriptorSet, m_set);
+
+	DescriptorSetLayoutDesc m_layoutDesc;
+
+	mutable std::mutex m_mutex;
+	std::array<Table, s_NbTypes> m_tables;
+	// Frame passed to the last update()
+	uint64_t m_frame = 0;
+
+	void create_layout();
+	void create_set();
+
+	// Allocates an index and writes its descriptor
+	uint32_t register_descriptor(
+		BindlessType type,
+		const VkDescriptorImageInfo* image_info,
+		const VkDescriptorBufferInfo* buffer_info
+	);
+};
+
+} // namespace vk
+} // namespace jdl
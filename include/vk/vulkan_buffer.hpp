@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vulkan_allocator.hpp"
+
+#include "utils/non_copyable.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+class VulkanBuffer : private NonCopyable<VulkanBuffer>
+{
+public:
+	/**
+	 * @brief Creates the buffer and allocates its memory.
+	 * @param size Buffer size in bytes.
+	 * @param usage Buffer usage flags.
+	 * @param memory_usage Intended memory usage.
+	 * @param dedicated Forces a dedicated memory allocation.
+	 */
+	VulkanBuffer(
+		VkDeviceSize size,
+		VkBufferUsageFlags usage,
+		MemoryUsage memory_usage,
+		bool dedicated = false
+	);
+
+	/**
+	 * @brief Destroys the buffer and frees its memory. The buffer must not be
+	 * in use by the GPU anymore.
+	 */
+	~VulkanBuffer();
+
+	/**
+	 * @brief Returns the Vulkan buffer handle.
+	 */
+	VkBuffer get() const { return m_buffer; }
+
+	/**
+	 * @brief Returns the buffer size in bytes.
+	 */
+	VkDeviceSize get_size() const { return m_size; }
+
+	/**
+	 * @brief Returns the buffer usage flags.
+	 */
+	VkBufferUsageFlags get_usage() const { return m_usage; }
+
+	/**
+	 * @brief Returns the buffer memory allocation.
+	 */
+	const VulkanAllocation& get_allocation() const { return m_allocation; }
+
+	/**
+	 * @brief Returns whether the buffer memory is host visible or not.
+	 */
+	bool is_mapped() const { return m_allocation.mapped_data != nullptr; }
+
+	/**
+	 * @brief Returns the host pointer of the buffer memory.
+	 * @return The mapped memory, or nullptr if the memory is not host visible
+	 */
+	void* get_mapped_data() const { return m_allocation.mapped_data; }
+
+	/**
+	 * @brief Copies host data into the buffer. The memory must be host visible.
+	 * @param data Source data.
+	 * @param size Number of bytes to copy.
+	 * @param offset Destination offset in the buffer.
+	 */
+	void write(const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+
+private:
+	VK_ATTR(VkDevice, m_device);
+	VK_ATTR(VkBuffer, m_buffer);
+
+	VkDeviceSize m_size = 0;
+	VkBufferUsageFlags m_usage = 0;
+
+	VulkanAllocation m_allocation;
+};
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "vulkan_command_buffer.hpp"
+
+#include "utils/non_copyable.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Owns one transient command pool for each frame in flight. Command
+ * buffers are handed out freely during a frame and are all recycled at once
+ * by resetting the frame pool when the frame fence has been signaled.
+ * Must be used by a single thread at a time.
+ */
+class VulkanCommandAllocator : private NonCopyable<VulkanCommandAllocator>
+{
+public:
+	/**
+	 * @brief Creates the command allocator.
+	 * @param queue_family_index Queue family of the allocated command buffers.
+	 * @param nb_frames Number of frames in flight.
+	 */
+	VulkanCommandAllocator(uint32_t queue_family_index, uint32_t nb_frames);
+
+	~VulkanCommandAllocator();
+
+	/**
+	 * @brief Resets the frame command pool: all the command buffers previously
+	 * allocated for this frame become available again. The frame must not be
+	 * in use by the GPU anymore.
+	 * @param frame_index Index of the frame in flight.
+	 */
+	void begin_frame(uint32_t frame_index);
+
+	/**
+	 * @brief Returns a command buffer from the current frame pool, ready to
+	 * be recorded. It remains valid until the next begin_frame() call on the
+	 * same frame.
+	 * @param level Primary or secondary command buffer.
+	 */
+	VulkanCommandBuffer* allocate(
+		VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY
+	);
+
+private:
+	struct FramePool
+	{
+		VK_ATTR(VkCommandPool, pool);
+		std::vector<std::unique_ptr<VulkanCommandBuffer>> primaries;
+		std::vector<std::unique_ptr<VulkanCommandBuffer>> secondaries;
+		size_t nb_used_primaries = 0;
+		size_t nb_used_secondaries = 0;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+
+	std::vector<FramePool> m_frames;
+	uint32_t m_currentFrame = 0;
+};
+
+} // namespace vk
+} // namespace jdl
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "vulkan_resource_tracker.hpp"
+
 #include "utils/non_copyable.hpp"
 
 
@@ -15,8 +17,17 @@ public:
 	 * @brief Creates the command buffer wrapper.
 	 * @param command_pool	The command pool with which the command buffer will
 	 *						be allocated.
+	 * @param level			Primary or secondary command buffer.
+	 * @param resettable	Whether the command buffer is reset individually
+	 *						in begin() (requires a pool created with
+	 *						VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT),
+	 *						or reset along with its whole pool.
 	 */
-	VulkanCommandBuffer(VkCommandPool command_pool);
+	VulkanCommandBuffer(
+		VkCommandPool command_pool,
+		VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		bool resettable = true
+	);
 
 	~VulkanCommandBuffer();
 
@@ -30,11 +41,31 @@ public:
 	 */
 	void begin();
 
+	/**
+	 * @brief Starts recording a secondary command buffer, executed inside a
+	 * dynamic rendering pass.
+	 * @param rendering_info Attachment formats of the rendering pass.
+	 * @param pipeline_statistics Statistics counted by the pipeline statistics
+	 * query active in the primary command buffer, if any (requires the
+	 * inheritedQueries device feature).
+	 */
+	void begin_secondary(
+		const VkCommandBufferInheritanceRenderingInfo& rendering_info,
+		VkQueryPipelineStatisticFlags pipeline_statistics = 0
+	);
+
 	/**
 	 * @brief Returns whether the command buffer is recording or not.
 	 */
 	bool is_recording() const { return m_recording; }
 
+	/**
+	 * @brief Returns whether the commands are recorded inside a rendering
+	 * pass (between begin_rendering() and end_rendering(), or in a secondary
+	 * command buffer) or not.
+	 */
+	bool is_rendering() const { return m_rendering; }
+
 	/**
 	 * @brief Stops recording the command buffer.
 	 */
@@ -56,39 +87,265 @@ public:
 		VkFence fence = VK_NULL_HANDLE
 	);
 
+	/**
+	 * @brief Submits the command buffer with synchronization2, which allows
+	 * to wait for and signal timeline semaphores.
+	 * @param queue The queue which will execute the command buffer.
+	 * @param wait_semaphores The semaphores (and values) to wait before
+	 * starting the execution.
+	 * @param signal_semaphores The semaphores (and values) to signal after
+	 * the execution.
+	 * @param fence The fence to signal after the execution.
+	 */
+	void submit2(
+		VkQueue queue,
+		const std::vector<VkSemaphoreSubmitInfo>& wait_semaphores = {},
+		const std::vector<VkSemaphoreSubmitInfo>& signal_semaphores = {},
+		VkFence fence = VK_NULL_HANDLE
+	);
+
 	/**
 	 * @brief Explicitly deallocates the command buffer.
 	 */
 	void destroy();
 
 	/**
-	 * @brief Records the command allowing to change an image layout.
-	 * @param image Image to be updated.
-	 * @param old_layout Old image layout.
-	 * @param new_layout New image layout.
+	 * @brief Records the execution of secondary command buffers, in order.
+	 * @param command_buffers The secondary command buffers.
+	 */
+	void execute_commands(const std::vector<VulkanCommandBuffer*>& command_buffers);
+
+	/**
+	 * @brief Declares the current state of image subresources (e.g. their
+	 * state at the end of a previous submission), without barrier.
+	 * @param image Vulkan image.
+	 * @param range Subresource range (explicit level and layer counts).
+	 * @param state Current state.
+	 */
+	void set_image_state(VkImage image, const VkImageSubresourceRange& range, const ResourceState& state) {
+		m_resourceTracker.set_image_state(image, range, state);
+	}
+
+	/**
+	 * @brief Declares the current state of a buffer, without barrier.
+	 * @param buffer Vulkan buffer.
+	 * @param state Current state.
+	 */
+	void set_buffer_state(VkBuffer buffer, const ResourceState& state) {
+		m_resourceTracker.set_buffer_state(buffer, state);
+	}
+
+	/**
+	 * @brief Requests image subresources to be used in a new state. The
+	 * previous layout and accesses are tracked by the command buffer, and the
+	 * barrier (if needed) is recorded with the other pending ones before the
+	 * next command. Must not be called while rendering: barriers cannot be
+	 * recorded inside a rendering pass.
+	 * @param image Vulkan image.
+	 * @param range Subresource range (explicit level and layer counts).
+	 * @param state Requested layout, stages and accesses.
+	 */
+	void transition_image(VkImage image, const VkImageSubresourceRange& range, const ResourceState& state);
+
+	/**
+	 * @brief Requests a buffer to be used in a new state. The barrier (if
+	 * needed) is recorded with the other pending ones before the next command.
+	 * Must not be called while rendering.
+	 * @param buffer Vulkan buffer.
+	 * @param state Requested stages and accesses.
+	 */
+	void transition_buffer(VkBuffer buffer, const ResourceState& state);
+
+	/**
+	 * @brief Records the pending barriers, batched in a single dependency.
+	 * Called by the commands recorded outside of rendering passes (transfers,
+	 * dispatches, begin_rendering()): the draws expect the barriers to be
+	 * recorded already.
+	 */
+	void flush_barriers();
+
+	/**
+	 * @brief Returns the resource state tracker.
+	 */
+	const VulkanResourceTracker& get_resource_tracker() const { return m_resourceTracker; }
+
+	/**
+	 * @brief Records a global memory barrier.
 	 * @param src_access_mask Source access mask.
 	 * @param dst_access_mask Destination access mask.
 	 * @param src_stage_mask Source pipeline stage mask.
 	 * @param dst_stage_mask Destination pipeline stage mask.
-	 * @param aspect_mask Image aspect mask.
 	 */
-	void transition_image_layout(
-		VkImage image,
-		VkImageLayout old_layout,
-		VkImageLayout new_layout,
+	void memory_barrier(
 		VkAccessFlags2 src_access_mask,
 		VkAccessFlags2 dst_access_mask,
 		VkPipelineStageFlags2 src_stage_mask,
-		VkPipelineStageFlags2 dst_stage_mask,
-		VkImageAspectFlags aspect_mask
+		VkPipelineStageFlags2 dst_stage_mask
+	);
+
+	/**
+	 * @brief Records a pipeline barrier made of buffer and image barriers.
+	 * @param buffer_barriers Buffer memory barriers.
+	 * @param image_barriers Image memory barriers.
+	 */
+	void pipeline_barrier(
+		const std::vector<VkBufferMemoryBarrier2>& buffer_barriers,
+		const std::vector<VkImageMemoryBarrier2>& image_barriers
+	);
+
+	/**
+	 * @brief Records the command allowing to copy a buffer range.
+	 * @param src Source buffer.
+	 * @param src_offset Source offset.
+	 * @param dst Destination buffer.
+	 * @param dst_offset Destination offset.
+	 * @param size Number of bytes to copy.
+	 */
+	void copy_buffer(
+		VkBuffer src,
+		VkDeviceSize src_offset,
+		VkBuffer dst,
+		VkDeviceSize dst_offset,
+		VkDeviceSize size
+	);
+
+	/**
+	 * @brief Records the command allowing to fill a buffer range with a
+	 * 32-bit value.
+	 * @param buffer Destination buffer.
+	 * @param offset Range offset (multiple of 4).
+	 * @param size Range size (multiple of 4, or VK_WHOLE_SIZE).
+	 * @param value Value written in each 32-bit word.
+	 */
+	void fill_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value);
+
+	/**
+	 * @brief Records the command allowing to copy tightly packed texels from
+	 * a buffer into the first mip level of an image.
+	 * @param buffer Source buffer.
+	 * @param offset Source offset.
+	 * @param image Destination image (in the TRANSFER_DST_OPTIMAL layout).
+	 * @param extent Destination image extent.
+	 * @param aspect_mask Destination image aspect.
+	 * @param nb_layers Number of array layers to copy.
+	 */
+	void copy_buffer_to_image(
+		VkBuffer buffer,
+		VkDeviceSize offset,
+		VkImage image,
+		VkExtent3D extent,
+		VkImageAspectFlags aspect_mask,
+		uint32_t nb_layers = 1
 	);
 
+	/**
+	 * @brief Records the command allowing to copy a whole 2D color image into
+	 * a buffer (tightly packed).
+	 * @param image Source image.
+	 * @param layout Source image layout.
+	 * @param extent Source image extent.
+	 * @param buffer Destination buffer.
+	 */
+	void copy_image_to_buffer(
+		VkImage image,
+		VkImageLayout layout,
+		VkExtent2D extent,
+		VkBuffer buffer
+	);
+
+	/**
+	 * @brief Starts dynamic rendering.
+	 * @param rendering_info Rendering attachments and area.
+	 */
+	void begin_rendering(const VkRenderingInfo& rendering_info);
+
+	/**
+	 * @brief Ends dynamic rendering.
+	 */
+	void end_rendering();
+
 	/**
 	 * @brief Records the command allowing to bind the graphics pipeline.
 	 * @param pipeline Graphics pipeline object.
 	 */
 	void bind_graphics_pipeline(VkPipeline pipeline);
 
+	/**
+	 * @brief Records the command allowing to bind a compute pipeline.
+	 * @param pipeline Compute pipeline object.
+	 */
+	void bind_compute_pipeline(VkPipeline pipeline);
+
+	/**
+	 * @brief Records the command allowing to bind descriptor sets.
+	 * @param bind_point Graphics or compute.
+	 * @param layout Pipeline layout the sets are compatible with.
+	 * @param first_set Index of the first set to bind.
+	 * @param sets Descriptor sets, bound to consecutive indices.
+	 * @param dynamic_offsets Offsets of the dynamic descriptors, in order.
+	 */
+	void bind_descriptor_sets(
+		VkPipelineBindPoint bind_point,
+		VkPipelineLayout layout,
+		uint32_t first_set,
+		const std::vector<VkDescriptorSet>& sets,
+		const std::vector<uint32_t>& dynamic_offsets = {}
+	);
+
+	/**
+	 * @brief Records the command allowing to update push constants.
+	 * @param layout Pipeline layout declaring the push constant range.
+	 * @param stages Stages accessing the range.
+	 * @param offset Range offset.
+	 * @param size Range size.
+	 * @param data Range content.
+	 */
+	void push_constants(
+		VkPipelineLayout layout,
+		VkShaderStageFlags stages,
+		uint32_t offset,
+		uint32_t size,
+		const void* data
+	);
+
+	/**
+	 * @brief Records the command allowing to update push constants from a
+	 * structure (e.g. the bindless indices of a draw).
+	 * @param layout Pipeline layout declaring the push constant range.
+	 * @param stages Stages accessing the range.
+	 * @param data Range content.
+	 * @param offset Range offset.
+	 */
+	template<class T>
+	void push_constants(
+		VkPipelineLayout layout,
+		VkShaderStageFlags stages,
+		const T& data,
+		uint32_t offset = 0
+	) {
+		push_constants(layout, stages, offset, sizeof(T), &data);
+	}
+
+	/**
+	 * @brief Records the command allowing to bind vertex buffers.
+	 * @param first_binding Binding of the first buffer.
+	 * @param buffers Vertex buffers, bound to consecutive bindings.
+	 * @param offsets Offset in each buffer (0 for all the buffers if empty).
+	 */
+	void bind_vertex_buffers(
+		uint32_t first_binding,
+		const std::vector<VkBuffer>& buffers,
+		const std::vector<VkDeviceSize>& offsets = {}
+	);
+
+	/**
+	 * @brief Records the command allowing to bind an index buffer.
+	 * @param buffer Index buffer.
+	 * @param offset Offset of the first index in the buffer.
+	 * @param index_type 16-bit or 32-bit indices.
+	 */
+	void bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type);
+
 	/**
 	 * @brief Records the command allowing to set the viewport.
 	 * @param offset Viewport top-left corner.
@@ -124,12 +381,76 @@ public:
 		uint32_t first_instance = 0
 	);
 
+	/**
+	 * @brief Records the command allowing to draw indexed vertices.
+	 * @param nb_indices The number of indices to draw.
+	 * @param nb_instances The number of instances to draw.
+	 * @param first_index The index of the first index.
+	 * @param vertex_offset The value added to each index.
+	 * @param first_instance The index of the first instance.
+	 */
+	void draw_indexed(
+		uint32_t nb_indices,
+		uint32_t nb_instances = 1,
+		uint32_t first_index = 0,
+		int32_t vertex_offset = 0,
+		uint32_t first_instance = 0
+	);
+
+	/**
+	 * @brief Records the command allowing to draw indexed vertices with
+	 * parameters read from a buffer (VkDrawIndexedIndirectCommand).
+	 * @param buffer Buffer holding the draw commands.
+	 * @param offset Offset of the first command.
+	 * @param nb_draws The number of commands.
+	 * @param stride Distance between two commands.
+	 */
+	void draw_indexed_indirect(
+		VkBuffer buffer,
+		VkDeviceSize offset,
+		uint32_t nb_draws,
+		uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)
+	);
+
+	/**
+	 * @brief Records the command allowing to draw indexed vertices with
+	 * parameters read from a buffer, the number of commands being read from
+	 * another buffer (e.g. written by a culling shader).
+	 * @param buffer Buffer holding the draw commands.
+	 * @param offset Offset of the first command.
+	 * @param count_buffer Buffer holding the number of commands.
+	 * @param count_offset Offset of the 32-bit number of commands.
+	 * @param max_draws Maximum number of commands.
+	 * @param stride Distance between two commands.
+	 */
+	void draw_indexed_indirect_count(
+		VkBuffer buffer,
+		VkDeviceSize offset,
+		VkBuffer count_buffer,
+		VkDeviceSize count_offset,
+		uint32_t max_draws,
+		uint32_t stride = sizeof(VkDrawIndexedIndirectCommand)
+	);
+
+	/**
+	 * @brief Records the command allowing to dispatch compute work groups.
+	 * @param x, y, z The number of work groups in each dimension.
+	 */
+	void dispatch(uint32_t x, uint32_t y = 1, uint32_t z = 1);
+
 private:
 	VK_ATTR(VkDevice, m_device);
 	VK_ATTR(VkCommandPool, m_commandPool);
 	VK_ATTR(VkCommandBuffer, m_commandBuffer);
 
+	bool m_resettable = true;
 	bool m_recording = false;
+	bool m_rendering = false;
+
+	// Tracked state of the resources used by the command buffer
+	VulkanResourceTracker m_resourceTracker;
+
+	void check_no_pending_barriers(const char* command) const;
 };
 
 } // namespace vk
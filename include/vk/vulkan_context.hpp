@@ -1,9 +1,15 @@
 #pragma once
 
+#include "vulkan_allocator.hpp"
+#include "vulkan_bindless_set.hpp"
 #include "vulkan_device.hpp"
 #include "vulkan_instance.hpp"
-#include "vulkan_pipeline.hpp"
+#include "vulkan_layout_cache.hpp"
+#include "vulkan_pipeline_library.hpp"
+#include "vulkan_retire_queue.hpp"
+#include "vulkan_shader_module_cache.hpp"
 #include "vulkan_swapchain.hpp"
+#include "vulkan_uploader.hpp"
 
 
 namespace jdl
@@ -11,19 +17,44 @@ namespace jdl
 namespace vk
 {
 
+struct VulkanContextSettings
+{
+    // Skips the window surface and the swapchain (offscreen rendering only)
+    bool headless = false;
+    // Color format of the render targets when running headless
+    VkFormat headless_format = VK_FORMAT_R8G8B8A8_UNORM;
+    // Depth format of the render targets
+    VkFormat depth_format = VK_FORMAT_D32_SFLOAT;
+    // Pipeline cache file (not persisted if empty)
+    std::string pipeline_cache_path = "pipeline_cache.bin";
+};
+
 class VulkanContext
 {
 public:
     /**
      * @brief Inits the Vulkan context. Must be called only once.
+     * @param settings Context settings.
      */
-    static void Init() { s_Context.do_init(); }
+    static void Init(const VulkanContextSettings& settings = {}) {
+        s_Context.do_init(settings);
+    }
 
     /**
      * @brief Destroys the Vulkan context. Must be called only once.
      */
     static void Destroy() { s_Context.do_destroy(); }
 
+    /**
+     * @brief Returns the context settings.
+     */
+    static const VulkanContextSettings& GetSettings() { return s_Context.m_settings; }
+
+    /**
+     * @brief Returns whether the context renders without any window or not.
+     */
+    static bool IsHeadless() { return s_Context.m_settings.headless; }
+
     /**
      * @brief Returns the Vulkan instance object.
      */
@@ -40,37 +71,98 @@ public:
     static VulkanDevice& GetDevice() { return *s_Context.m_device; }
 
     /**
-     * @brief Returns the Vulkan swapchain object.
+     * @brief Returns the device memory allocator.
+     */
+    static VulkanAllocator& GetAllocator() { return *s_Context.m_allocator; }
+
+    /**
+     * @brief Returns the upload scheduler.
+     */
+    static VulkanUploader& GetUploader() { return *s_Context.m_uploader; }
+
+    /**
+     * @brief Returns the queue of the buffers waiting for the frames in flight.
+     */
+    static VulkanRetireQueue& GetRetireQueue() { return *s_Context.m_retireQueue; }
+
+    /**
+     * @brief Returns the shader module cache.
+     */
+    static VulkanShaderModuleCache& GetShaderModuleCache() { return *s_Context.m_shaderModuleCache; }
+
+    /**
+     * @brief Returns the Vulkan swapchain object. Must not be called when the
+     * context is headless.
      */
     static VulkanSwapchain& GetSwapchain() { return *s_Context.m_swapchain; }
 
+    /**
+     * @brief Returns the color format of the render targets.
+     */
+    static VkFormat GetColorFormat();
+
+    /**
+     * @brief Returns the depth format of the render targets.
+     */
+    static VkFormat GetDepthFormat() { return s_Context.m_settings.depth_format; }
+
     /**
      * @brief Recreates the swapchain.
      */
     static void RecreateSwapchain();
 
     /**
-     * @brief Returns the Vulkan pipeline object.
+     * @brief Returns the descriptor set and pipeline layout cache.
+     */
+    static VulkanLayoutCache& GetLayoutCache() { return *s_Context.m_layoutCache; }
+
+    /**
+     * @brief Returns the global bindless descriptor set.
+     */
+    static VulkanBindlessSet& GetBindlessSet() { return *s_Context.m_bindlessSet; }
+
+    /**
+     * @brief Returns the pipeline library.
+     */
+    static VulkanPipelineLibrary& GetPipelineLibrary() { return *s_Context.m_pipelineLibrary; }
+
+    /**
+     * @brief Returns the default pipeline object.
      */
     static VulkanPipeline& GetPipeline() { return *s_Context.m_pipeline; }
 
 private:
     static VulkanContext s_Context;
 
+    VulkanContextSettings m_settings;
+
     std::unique_ptr<VulkanInstance> m_instance;
     std::unique_ptr<VulkanDevice> m_device;
+    std::unique_ptr<VulkanAllocator> m_allocator;
+    std::unique_ptr<VulkanUploader> m_uploader;
+    std::unique_ptr<VulkanRetireQueue> m_retireQueue;
+    std::unique_ptr<VulkanShaderModuleCache> m_shaderModuleCache;
     std::unique_ptr<VulkanSwapchain> m_swapchain;
-    std::unique_ptr<VulkanPipeline> m_pipeline;
+    std::unique_ptr<VulkanLayoutCache> m_layoutCache;
+    std::unique_ptr<VulkanBindlessSet> m_bindlessSet;
+    std::unique_ptr<VulkanPipelineLibrary> m_pipelineLibrary;
+    VulkanPipeline* m_pipeline = nullptr;
 
     VK_ATTR(VkSurfaceKHR, m_windowSurface);
 
-    void do_init();
+    void do_init(const VulkanContextSettings& settings);
     void do_destroy();
 
     void create_instance();
     void create_window_surface();
     void create_device();
+    void create_allocator();
+    void create_uploader();
+    void create_retire_queue();
+    void create_shader_module_cache();
     void create_swapchain();
+    void create_layout_cache();
+    void create_bindless_set();
     void create_default_resources();
     void create_pipeline();
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "vulkan_pipeline_cache.hpp"
+
 #include "utils/non_copyable.hpp"
 
 #include <set>
@@ -14,6 +16,8 @@ struct QueueFamilyIndices
 {
 	uint32_t graphics = UINT32_MAX;
 	uint32_t present = UINT32_MAX;
+	// Dedicated transfer family if any, the graphics family otherwise
+	uint32_t transfer = UINT32_MAX;
 
 	/**
 	 * @brief Returns whether all the required queue family indices have been
@@ -27,7 +31,7 @@ struct QueueFamilyIndices
 	 * @brief Returns the unique queue family indices.
 	 */
 	std::set<uint32_t> get_unique_indices() const {
-		return std::set<uint32_t>{graphics, present};
+		return std::set<uint32_t>{graphics, present, transfer};
 	}
 };
 
@@ -44,10 +48,32 @@ public:
 		return m_physicalDevice;
 	}
 
+	/**
+	 * @brief Returns the properties of the selected physical device.
+	 */
+	const VkPhysicalDeviceProperties& get_properties() const {
+		return m_properties;
+	}
+
+	/**
+	 * @brief Returns the Vulkan 1.2 properties of the selected physical
+	 * device (descriptor indexing limits among others).
+	 */
+	const VkPhysicalDeviceVulkan12Properties& get_vulkan12_properties() const {
+		return m_vulkan12Properties;
+	}
+
+	/**
+	 * @brief Returns the core features enabled on the logical device.
+	 */
+	const VkPhysicalDeviceFeatures& get_enabled_features() const {
+		return m_enabledFeatures;
+	}
+
 	/**
 	 * @brief Returns the name of the selected physical device.
 	 */
-	std::string get_device_name() const;
+	std::string get_device_name() const { return m_properties.deviceName; }
 
 	/**
 	 * @brief Returns the selected queue family indices.
@@ -71,11 +97,48 @@ public:
 	 */
 	VkQueue get_present_queue() const { return m_presentQueue; }
 
+	/**
+	 * @brief Returns the transfer queue handle (the graphics queue if the
+	 * device has no dedicated transfer queue).
+	 */
+	VkQueue get_transfer_queue() const { return m_transferQueue; }
+
+	/**
+	 * @brief Returns whether the transfer queue belongs to another family
+	 * than the graphics queue or not.
+	 */
+	bool has_dedicated_transfer_queue() const {
+		return m_queueFamilyIndices.transfer != m_queueFamilyIndices.graphics;
+	}
+
 	/**
 	 * @brief Returns the command pool for the graphics queue.
 	 */
 	VkCommandPool get_graphics_command_pool() const { return m_graphicsPool; }
 
+	/**
+	 * @brief Returns the pipeline cache used by all the pipeline creations.
+	 */
+	VkPipelineCache get_pipeline_cache() const { return m_pipelineCache->get(); }
+
+	/**
+	 * @brief Returns the memory types and heaps of the selected physical device.
+	 */
+	const VkPhysicalDeviceMemoryProperties& get_memory_properties() const {
+		return m_memoryProperties;
+	}
+
+	/**
+	 * @brief Returns the index of a memory type matching the requirements.
+	 * @param type_bits Bitmask of the allowed memory types.
+	 * @param properties Required memory properties.
+	 * @return The memory type index, or UINT32_MAX if no memory type matches.
+	 */
+	uint32_t find_memory_type(
+		uint32_t type_bits,
+		VkMemoryPropertyFlags properties
+	) const;
+
 	/**
 	 * @brief Waits for the device to be in idle state.
 	 */
@@ -86,15 +149,23 @@ private:
 	VK_ATTR(VkDevice, m_device);
 
 	QueueFamilyIndices m_queueFamilyIndices;
+	VkPhysicalDeviceProperties m_properties {};
+	VkPhysicalDeviceVulkan12Properties m_vulkan12Properties {};
+	VkPhysicalDeviceMemoryProperties m_memoryProperties {};
+	VkPhysicalDeviceFeatures m_enabledFeatures {};
 
 	VK_ATTR(VkQueue, m_graphicsQueue);
 	VK_ATTR(VkQueue, m_presentQueue);
+	VK_ATTR(VkQueue, m_transferQueue);
 
 	VK_ATTR(VkCommandPool, m_graphicsPool);
 
+	std::unique_ptr<VulkanPipelineCache> m_pipelineCache;
+
 	void select_physical_device();
 	void create_device();
 	void create_command_pool();
+	void create_pipeline_cache();
 };
 
 } // namespace vk
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "vulkan_frame_ring.hpp"
+#include "vulkan_pipeline.hpp"
+
+#include "resource/mesh.hpp"
+#include "resource/resource_handle.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <array>
+#include <mutex>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Draw submitted to the draw queue.
+ */
+struct DrawSubmission
+{
+	// Pass recording the draw (see VulkanDrawQueue::record())
+	uint32_t pass = 0;
+	VulkanPipeline* pipeline = nullptr;
+	// Identifier of the resources bound for the draw (0: none)
+	uint32_t material = 0;
+	resource::Handle<resource::Mesh> mesh;
+
+	// Column-major world transform (affine), read by the shaders as an
+	// instance of the draw
+	std::array<float, 16> transform {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+
+	// View depth (positive), draws with the same state are sorted front to
+	// back
+	float depth = 0.0f;
+};
+
+// Counters of the sorted draws of a frame
+struct DrawQueueStats
+{
+	uint32_t nb_submissions = 0;
+	// Instanced draws after merging the submissions
+	uint32_t nb_draws = 0;
+	uint32_t nb_pipeline_binds = 0;
+	uint32_t nb_descriptor_binds = 0;
+};
+
+/**
+ * @brief Collects the draws of a frame and records them in an order
+ * minimizing the state changes.
+ *
+ * Each submission gets a 64-bit sort key packing, from the most significant
+ * bits: its pass, its pipeline, its material, its mesh and its quantized
+ * depth. The keys are radix sorted in parallel on the job system, so that
+ * the draws sharing a pipeline, then a material, are contiguous. Runs of
+ * submissions with the same pipeline, material and mesh are merged into a
+ * single instanced draw: their transforms are written to the frame ring
+ * storage buffer, and the shaders read them at first_instance +
+ * SV_InstanceID (see DrawConstants in default.slang). The pipeline, the
+ * bindless set and the frame data set are only bound when they change.
+ *
+ * Draws can be submitted from any thread, until the renderer sorts the
+ * queue. The queue is emptied every frame.
+ */
+class VulkanDrawQueue : private NonCopyable<VulkanDrawQueue>
+{
+public:
+	// Bits of the sort key fields, from the most significant ones
+	static constexpr uint32_t s_PassBits = 4;
+	static constexpr uint32_t s_PipelineBits = 12;
+	static constexpr uint32_t s_MaterialBits = 16;
+	static constexpr uint32_t s_MeshBits = 16;
+	static constexpr uint32_t s_DepthBits = 16;
+	static_assert(s_PassBits + s_PipelineBits + s_MaterialBits + s_MeshBits + s_DepthBits == 64);
+
+	static constexpr uint32_t s_MaxPasses = 1u << s_PassBits;
+
+	VulkanDrawQueue();
+	~VulkanDrawQueue();
+
+	/**
+	 * @brief Packs the sort key of a draw. The fields are truncated to their
+	 * number of bits, which only affects the order of the draws.
+	 * @param pass Pass index (less than s_MaxPasses).
+	 * @param pipeline Pipeline index.
+	 * @param material Material identifier.
+	 * @param mesh Mesh index.
+	 * @param depth View depth (positive).
+	 * @return The sort key.
+	 */
+	static uint64_t MakeSortKey(
+		uint32_t pass,
+		uint32_t pipeline,
+		uint32_t material,
+		uint32_t mesh,
+		float depth
+	);
+
+	/**
+	 * @brief Submits a draw for the current frame. Thread-safe. Submissions
+	 * without pipeline or mesh are ignored.
+	 * @param submission Draw state and transform.
+	 */
+	void submit(const DrawSubmission& submission);
+
+	/**
+	 * @brief Sorts the submitted draws, merges them into instanced draws and
+	 * writes their instances to the frame ring. The submissions are cleared,
+	 * the following ones are drawn by the next frame. Must be called once
+	 * per frame, after VulkanFrameRing::begin_frame().
+	 * @param frame_ring Frame ring of the renderer.
+	 */
+	void sort(VulkanFrameRing& frame_ring);
+
+	/**
+	 * @brief Records the sorted draws of a pass. The resources must be pinned.
+	 * @param command_buffer Command buffer.
+	 * @param pass Pass index.
+	 * @param frame_ring Frame ring of the renderer.
+	 * @param frame_constants Uniform data bound with the instances.
+	 */
+	void record(
+		VulkanCommandBuffer& command_buffer,
+		uint32_t pass,
+		const VulkanFrameRing& frame_ring,
+		const VulkanFrameRing::Allocation& frame_constants
+	) const {
+		record(command_buffer, pass, 0, get_nb_batches(), frame_ring, frame_constants);
+	}
+
+	/**
+	 * @brief Records the sorted draws of a pass in a range of batches, so
+	 * that the draws of a pass can be split among several command buffers
+	 * recorded in parallel. The resources must be pinned.
+	 * @param command_buffer Command buffer.
+	 * @param pass Pass index.
+	 * @param first_batch Index of the first batch of the range.
+	 * @param nb_batches Number of batches of the range.
+	 * @param frame_ring Frame ring of the renderer.
+	 * @param frame_constants Uniform data bound with the instances.
+	 */
+	void record(
+		VulkanCommandBuffer& command_buffer,
+		uint32_t pass,
+		uint32_t first_batch,
+		uint32_t nb_batches,
+		const VulkanFrameRing& frame_ring,
+		const VulkanFrameRing::Allocation& frame_constants
+	) const;
+
+	/**
+	 * @brief Returns the number of batches (instanced draws of every pass) of
+	 * the last sorted frame, in recording order.
+	 */
+	uint32_t get_nb_batches() const { return static_cast<uint32_t>(m_batches.size()); }
+
+	/**
+	 * @brief Returns the counters of the last sorted frame.
+	 */
+	const DrawQueueStats& get_stats() const { return m_stats; }
+
+private:
+	// Submission and its sort key
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	// Instanced draw of consecutive sorted submissions
+	struct Batch
+	{
+		uint32_t pass = 0;
+		VulkanPipeline* pipeline = nullptr;
+		uint32_t material = 0;
+		resource::Handle<resource::Mesh> mesh;
+		// Instances in the frame ring allocation
+		uint32_t allocation = 0;
+		uint32_t first_instance = 0;
+		uint32_t nb_instances = 0;
+	};
+
+	// Frame ring storage holding the instances of consecutive sorted entries
+	struct InstanceAllocation
+	{
+		VulkanFrameRing::Allocation allocation;
+		uint32_t first_entry = 0;
+	};
+
+	// Submissions of each job system thread (the last one is shared by the
+	// other threads)
+	std::vector<std::vector<DrawSubmission>> m_threadSubmissions;
+	std::mutex m_sharedMutex;
+
+	// Sorted frame
+	std::vector<DrawSubmission> m_submissions;
+	std::vector<SortEntry> m_entries;
+	std::vector<SortEntry> m_scratch;
+	std::vector<Batch> m_batches;
+	std::vector<InstanceAllocation> m_allocations;
+	// Number of sorted entries with an instance (the others were dropped)
+	uint32_t m_nbInstances = 0;
+	DrawQueueStats m_stats;
+
+	void gather_submissions();
+	void build_batches(VulkanFrameRing& frame_ring);
+	void write_instances();
+	void count_binds();
+};
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "vulkan_buffer.hpp"
+#include "vulkan_layout_cache.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <atomic>
+#include <cstring>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+class VulkanCommandBuffer;
+
+/**
+ * @brief Persistently mapped buffer holding the uniform and storage data
+ * written by the CPU for a frame (per-frame and per-draw constants). Each
+ * frame in flight owns a region of the buffer, allocated linearly and
+ * reclaimed wholesale once the frame fence has been waited (see
+ * begin_frame()).
+ *
+ * The whole buffer is exposed through a single descriptor set holding a
+ * dynamic uniform buffer and a dynamic storage buffer (see s_Set): an
+ * allocation is selected by the dynamic offset given when binding the set,
+ * so writing constants never allocates a buffer nor updates a descriptor.
+ * Small per-draw data should rather be pushed as push constants (see
+ * VulkanCommandBuffer::push_constants(), s_MaxPushConstantsSize).
+ *
+ * Allocations are lock-free and can be made from any thread.
+ */
+class VulkanFrameRing : private NonCopyable<VulkanFrameRing>
+{
+public:
+	// Set index reserved for the frame data in the shaders
+	static constexpr uint32_t s_Set = 1;
+	static constexpr uint32_t s_UniformBinding = 0;
+	static constexpr uint32_t s_StorageBinding = 1;
+
+	// Push constants size guaranteed by every device
+	static constexpr uint32_t s_MaxPushConstantsSize = 128;
+
+	struct Allocation
+	{
+		VK_ATTR(VkBuffer, buffer);
+		// Offset in the buffer, used as dynamic offset
+		uint32_t offset = 0;
+		void* data = nullptr;
+
+		bool is_valid() const { return data != nullptr; }
+	};
+
+	/**
+	 * @brief Creates the ring.
+	 * @param nb_frames Number of frames in flight.
+	 * @param frame_size Size of each frame region in bytes.
+	 */
+	VulkanFrameRing(uint32_t nb_frames, VkDeviceSize frame_size);
+	~VulkanFrameRing();
+
+	/**
+	 * @brief Returns the layout of the frame data set, shared by every
+	 * pipeline accessing it.
+	 */
+	static const DescriptorSetLayoutDesc& GetLayoutDesc();
+
+	/**
+	 * @brief Starts allocating in the region of a frame in flight, releasing
+	 * all its previous allocations. The frame fence must have been waited.
+	 * @param frame_index Index of the frame in flight.
+	 */
+	void begin_frame(uint32_t frame_index);
+
+	/**
+	 * @brief Allocates uniform data in the current frame region.
+	 * @param size Size in bytes (at most get_uniform_range()).
+	 * @return The allocation, invalid if the region is full.
+	 */
+	Allocation allocate_uniform(VkDeviceSize size);
+
+	/**
+	 * @brief Allocates storage data in the current frame region.
+	 * @param size Size in bytes (at most get_storage_range()).
+	 * @return The allocation, invalid if the region is full.
+	 */
+	Allocation allocate_storage(VkDeviceSize size);
+
+	/**
+	 * @brief Allocates uniform data and copies a structure into it.
+	 * @param data Uniform data.
+	 * @return The allocation, invalid if the region is full.
+	 */
+	template<class T>
+	Allocation push_uniform(const T& data)
+	{
+		Allocation allocation = allocate_uniform(sizeof(T));
+		if (allocation.is_valid()) {
+			std::memcpy(allocation.data, &data, sizeof(T));
+		}
+		return allocation;
+	}
+
+	/**
+	 * @brief Binds the frame data set, with the dynamic offsets selecting
+	 * the given allocations.
+	 * @param command_buffer Command buffer.
+	 * @param bind_point Graphics or compute.
+	 * @param layout Pipeline layout using the frame data set (see s_Set).
+	 * @param uniform Uniform data seen by the shaders.
+	 * @param storage Storage data seen by the shaders.
+	 */
+	void bind(
+		VulkanCommandBuffer& command_buffer,
+		VkPipelineBindPoint bind_point,
+		VkPipelineLayout layout,
+		const Allocation& uniform,
+		const Allocation& storage
+	) const;
+
+	/**
+	 * @brief Binds the frame data set, for shaders only reading uniform data.
+	 * @param command_buffer Command buffer.
+	 * @param bind_point Graphics or compute.
+	 * @param layout Pipeline layout using the frame data set (see s_Set).
+	 * @param uniform Uniform data seen by the shaders.
+	 */
+	void bind(
+		VulkanCommandBuffer& command_buffer,
+		VkPipelineBindPoint bind_point,
+		VkPipelineLayout layout,
+		const Allocation& uniform
+	) const {
+		bind(command_buffer, bind_point, layout, uniform, Allocation());
+	}
+
+	/**
+	 * @brief Returns the number of bytes visible through the uniform buffer.
+	 */
+	VkDeviceSize get_uniform_range() const { return m_uniformRange; }
+
+	/**
+	 * @brief Returns the number of bytes visible through the storage buffer.
+	 */
+	VkDeviceSize get_storage_range() const { return m_storageRange; }
+
+	/**
+	 * @brief Returns the number of bytes allocated in the current region.
+	 */
+	VkDeviceSize get_used_size() const;
+
+	/**
+	 * @brief Returns the size of each frame region.
+	 */
+	VkDeviceSize get_frame_size() const { return m_frameSize; }
+
+private:
+	VK_ATTR(VkDevice, m_device);
+	VK_ATTR(VkDescriptorPool, m_pool);
+	VK_ATTR(VkDescriptorSet, m_set);
+
+	std::unique_ptr<VulkanBuffer> m_buffer;
+
+	VkDeviceSize m_frameSize = 0;
+	VkDeviceSize m_alignment = 0;
+	VkDeviceSize m_uniformRange = 0;
+	VkDeviceSize m_storageRange = 0;
+
+	// Start of the current region, and head relative to it
+	VkDeviceSize m_regionOffset = 0;
+	std::atomic<VkDeviceSize> m_head = 0;
+
+	void create_set();
+
+	Allocation allocate(VkDeviceSize size, VkDeviceSize range);
+};
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "vulkan_bindless_set.hpp"
+#include "vulkan_buffer.hpp"
+#include "vulkan_pipeline.hpp"
+#include "vulkan_render_graph.hpp"
+#include "vulkan_uploader.hpp"
+
+#include "resource/mesh.hpp"
+#include "resource/resource_handle.hpp"
+#include "resource/shader.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <array>
+#include <limits>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Object of a GPU scene: a world transform and the meshes of its
+ * levels of detail.
+ */
+struct GpuSceneObject
+{
+	static constexpr uint32_t s_MaxLods = 4;
+
+	// Column-major world transform (affine)
+	std::array<float, 16> transform {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+
+	// Mesh of each LOD, the most detailed first (an invalid handle ends the
+	// list, the first one is required)
+	std::array<resource::Handle<resource::Mesh>, s_MaxLods> lods {};
+
+	// Camera distance up to which each LOD is selected (the last LOD is
+	// selected beyond)
+	std::array<float, s_MaxLods> lod_distances {
+		std::numeric_limits<float>::max(),
+		std::numeric_limits<float>::max(),
+		std::numeric_limits<float>::max(),
+		std::numeric_limits<float>::max()
+	};
+};
+
+// Render graph buffers of the culling results of a frame
+struct GpuSceneDraws
+{
+	// Indirect draw commands, each followed by its object index
+	RenderGraphResource draws;
+	// Number of draws of each batch
+	RenderGraphResource counts;
+
+	bool is_valid() const { return draws.is_valid() && counts.is_valid(); }
+};
+
+/**
+ * @brief Static objects drawn without any per-object CPU work.
+ *
+ * The objects and their LOD meshes are uploaded once to a storage buffer
+ * (rebuilt only when objects are added, or when their meshes become ready).
+ * Every frame, a compute pass culls the objects against the camera frustum,
+ * selects their LOD and appends a VkDrawIndexedIndirectCommand to the batch
+ * of the selected mesh. The draw pass then records one
+ * vkCmdDrawIndexedIndirectCount per batch, i.e. per mesh: the CPU cost of a
+ * frame does not depend on the number of objects. The vertex shader finds
+ * the object of a draw from DrawIndex.
+ *
+ * The culling results are written to per-frame buffers, so a frame never
+ * overwrites the draws of a frame still in flight.
+ */
+class VulkanGpuScene : private NonCopyable<VulkanGpuScene>
+{
+public:
+	// Threads per work group of the culling shader (numthreads in cull.slang)
+	static constexpr uint32_t s_WorkGroupSize = 64;
+	static constexpr uint32_t s_InvalidBatch = UINT32_MAX;
+
+	/**
+	 * @brief Creates the scene.
+	 * @param nb_frames Number of frames in flight.
+	 */
+	explicit VulkanGpuScene(uint32_t nb_frames);
+	~VulkanGpuScene();
+
+	/**
+	 * @brief Adds an object. It is drawn once all its meshes are ready.
+	 * @param object Object transform and meshes.
+	 * @return The object index.
+	 */
+	uint32_t add_object(const GpuSceneObject& object);
+
+	/**
+	 * @brief Removes all the objects.
+	 */
+	void clear();
+
+	/**
+	 * @brief Sets the camera used for the culling and the draws.
+	 * @param view_projection Column-major view projection matrix (Vulkan clip
+	 * space: y down, depth in [0, 1]).
+	 * @param position World space camera position.
+	 * @param lod_scale Scale of the camera distances compared to the LOD
+	 * distances (greater values select coarser LODs).
+	 */
+	void set_camera(
+		const std::array<float, 16>& view_projection,
+		const std::array<float, 3>& position,
+		float lod_scale = 1.0f
+	);
+
+	/**
+	 * @brief Returns the number of added objects.
+	 */
+	uint32_t get_nb_objects() const { return static_cast<uint32_t>(m_objects.size()); }
+
+	/**
+	 * @brief Returns the number of objects uploaded to the GPU (the ones whose
+	 * meshes are ready).
+	 */
+	uint32_t get_nb_gpu_objects() const { return m_nbGpuObjects; }
+
+	/**
+	 * @brief Returns the number of batches (meshes) of the uploaded objects.
+	 */
+	uint32_t get_nb_batches() const { return static_cast<uint32_t>(m_batches.size()); }
+
+	/**
+	 * @brief Returns whether the scene has objects to draw or not (uploaded,
+	 * with valid pipelines).
+	 */
+	bool has_draws() const;
+
+	/**
+	 * @brief Destroys the buffers which are not used by the GPU anymore, and
+	 * uploads the objects again if they changed. Must be called once per
+	 * frame, after waiting for the frame fence.
+	 * @param frame Number of the frame about to be recorded.
+	 * @param nb_frames_in_flight Number of frames in flight.
+	 */
+	void update(uint64_t frame, uint32_t nb_frames_in_flight);
+
+	/**
+	 * @brief Adds the culling pass of a frame to its render graph. The pass
+	 * drawing the scene must read the returned buffers (eIndirectBuffer for
+	 * both, and eStorageBufferRead for the draws).
+	 * @param graph Render graph of the frame.
+	 * @param frame_index Index of the frame in flight.
+	 * @return The culling results, invalid if the scene has nothing to draw.
+	 */
+	GpuSceneDraws add_cull_pass(VulkanRenderGraph& graph, uint32_t frame_index);
+
+	/**
+	 * @brief Records the indirect draws of the scene, in a rendering pass
+	 * with the context color and depth formats. The resources must be pinned.
+	 * @param command_buffer Command buffer.
+	 * @param frame_index Index of the frame in flight.
+	 */
+	void record_draws(VulkanCommandBuffer& command_buffer, uint32_t frame_index) const;
+
+private:
+	// Meshes drawn by the indirect draws of the same batch
+	struct Batch
+	{
+		resource::Handle<resource::Mesh> mesh;
+		VulkanPipeline* pipeline = nullptr;
+		// Range of the batch in the draw buffers
+		uint32_t first_draw = 0;
+		uint32_t capacity = 0;
+	};
+
+	// Culling results of a frame in flight
+	struct FrameDraws
+	{
+		std::unique_ptr<VulkanBuffer> draws;
+		std::unique_ptr<VulkanBuffer> counts;
+		uint32_t draws_index = VulkanBindlessSet::s_InvalidIndex;
+		uint32_t counts_index = VulkanBindlessSet::s_InvalidIndex;
+	};
+
+	// Buffer which may still be used by the frames in flight
+	struct RetiredBuffer
+	{
+		std::unique_ptr<VulkanBuffer> buffer;
+		uint64_t frame = 0;
+	};
+
+	std::vector<GpuSceneObject> m_objects;
+	// Incremented each time the objects change
+	uint64_t m_version = 0;
+	uint64_t m_gpuVersion = 0;
+	// Whether some objects wait for their meshes
+	bool m_pending = false;
+
+	// Camera
+	std::array<float, 16> m_viewProjection {};
+	std::array<float, 4> m_camera {};
+	std::array<std::array<float, 4>, 6> m_frustumPlanes {};
+
+	resource::Handle<resource::Shader> m_cullShader;
+	resource::Handle<resource::Shader> m_drawShader;
+	VulkanPipeline* m_cullPipeline = nullptr;
+
+	// Uploaded objects, followed by the batches
+	std::unique_ptr<VulkanBuffer> m_sceneBuffer;
+	uint32_t m_sceneIndex = VulkanBindlessSet::s_InvalidIndex;
+	UploadToken m_sceneUpload;
+	uint32_t m_nbGpuObjects = 0;
+	uint32_t m_nbDraws = 0;
+	std::vector<Batch> m_batches;
+
+	std::vector<FrameDraws> m_frames;
+	std::vector<RetiredBuffer> m_retiredBuffers;
+	uint64_t m_frame = 0;
+
+	void create_pipelines();
+	void rebuild(const std::vector<const GpuSceneObject*>& objects);
+	void resize_frame_draws();
+	void retire(std::unique_ptr<VulkanBuffer>& buffer, uint32_t& bindless_index);
+	void record_cull(VulkanCommandBuffer& command_buffer, uint32_t frame_index) const;
+	VulkanPipeline* get_draw_pipeline(const resource::VertexLayout& layout) const;
+};
+
+} // namespace vk
+} // namespace jdl
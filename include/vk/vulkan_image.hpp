@@ -0,0 +1,82 @@
+#pragma once
+
+#include "vulkan_allocator.hpp"
+
+#include "utils/non_copyable.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+struct VulkanImageInfo
+{
+	VkExtent3D extent {};
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkImageUsageFlags usage = 0;
+	VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	uint32_t mip_levels = 1;
+	uint32_t array_layers = 1;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	// Render targets benefit from dedicated allocations on many drivers
+	bool dedicated = false;
+};
+
+class VulkanImage : private NonCopyable<VulkanImage>
+{
+public:
+	/**
+	 * @brief Creates the image, allocates its memory and creates a view on
+	 * all its mip levels and layers.
+	 * @param info Image description.
+	 */
+	VulkanImage(const VulkanImageInfo& info);
+
+	/**
+	 * @brief Destroys the image and frees its memory. The image must not be
+	 * in use by the GPU anymore.
+	 */
+	~VulkanImage();
+
+	/**
+	 * @brief Returns the Vulkan image handle.
+	 */
+	VkImage get() const { return m_image; }
+
+	/**
+	 * @brief Returns the Vulkan image view handle.
+	 */
+	VkImageView get_view() const { return m_view; }
+
+	/**
+	 * @brief Returns the image description.
+	 */
+	const VulkanImageInfo& get_info() const { return m_info; }
+
+	/**
+	 * @brief Returns the image format.
+	 */
+	VkFormat get_format() const { return m_info.format; }
+
+	/**
+	 * @brief Returns the image extent.
+	 */
+	VkExtent3D get_extent() const { return m_info.extent; }
+
+	/**
+	 * @brief Returns the image memory allocation.
+	 */
+	const VulkanAllocation& get_allocation() const { return m_allocation; }
+
+private:
+	VK_ATTR(VkDevice, m_device);
+	VK_ATTR(VkImage, m_image);
+	VK_ATTR(VkImageView, m_view);
+
+	VulkanImageInfo m_info;
+	VulkanAllocation m_allocation;
+};
+
+} // namespace vk
+} // namespace jdl
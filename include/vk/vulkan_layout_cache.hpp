@@ -0,0 +1,116 @@
+#pragma once
+
+#include "utils/non_copyable.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+struct DescriptorBindingDesc
+{
+	uint32_t binding = 0;
+	VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uint32_t count = 1;
+	VkShaderStageFlags stages = 0;
+	// Descriptor indexing flags (update-after-bind, partially bound...)
+	VkDescriptorBindingFlags flags = 0;
+
+	bool operator==(const DescriptorBindingDesc&) const = default;
+};
+
+struct DescriptorSetLayoutDesc
+{
+	// Sorted by binding
+	std::vector<DescriptorBindingDesc> bindings;
+	VkDescriptorSetLayoutCreateFlags flags = 0;
+
+	bool operator==(const DescriptorSetLayoutDesc&) const = default;
+
+	uint64_t hash() const;
+};
+
+struct PushConstantRangeDesc
+{
+	uint32_t offset = 0;
+	uint32_t size = 0;
+	VkShaderStageFlags stages = 0;
+
+	bool operator==(const PushConstantRangeDesc&) const = default;
+};
+
+struct PipelineLayoutDesc
+{
+	// One layout per set index (empty for the unused sets)
+	std::vector<DescriptorSetLayoutDesc> sets;
+	std::vector<PushConstantRangeDesc> push_constants;
+
+	bool operator==(const PipelineLayoutDesc&) const = default;
+
+	uint64_t hash() const;
+};
+
+/**
+ * @brief Owns the descriptor set layouts and the pipeline layouts, keyed by
+ * their description: pipelines with identical layouts share the same
+ * handles, so their descriptor sets stay bound across pipeline switches.
+ * Layouts live as long as the cache. Thread-safe.
+ */
+class VulkanLayoutCache : private NonCopyable<VulkanLayoutCache>
+{
+public:
+	VulkanLayoutCache();
+	~VulkanLayoutCache();
+
+	/**
+	 * @brief Returns the descriptor set layout matching desc, created if needed.
+	 * @param desc Descriptor set layout description.
+	 * @return The layout, or VK_NULL_HANDLE if it could not be created.
+	 */
+	VkDescriptorSetLayout get_descriptor_set_layout(const DescriptorSetLayoutDesc& desc);
+
+	/**
+	 * @brief Returns the pipeline layout matching desc, created if needed.
+	 * @param desc Pipeline layout description.
+	 * @return The layout, or VK_NULL_HANDLE if it could not be created.
+	 */
+	VkPipelineLayout get_pipeline_layout(const PipelineLayoutDesc& desc);
+
+	/**
+	 * @brief Returns the number of descriptor set layouts.
+	 */
+	size_t get_nb_descriptor_set_layouts() const;
+
+	/**
+	 * @brief Returns the number of pipeline layouts.
+	 */
+	size_t get_nb_pipeline_layouts() const;
+
+private:
+	template<class Desc>
+	struct Hasher
+	{
+		size_t operator()(const Desc& desc) const { return desc.hash(); }
+	};
+
+	VK_ATTR(VkDevice, m_device);
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<
+		DescriptorSetLayoutDesc, VkDescriptorSetLayout, Hasher<DescriptorSetLayoutDesc>
+	> m_setLayouts;
+	std::unordered_map<
+		PipelineLayoutDesc, VkPipelineLayout, Hasher<PipelineLayoutDesc>
+	> m_pipelineLayouts;
+
+	// m_mutex must be locked
+	VkDescriptorSetLayout get_descriptor_set_layout_locked(const DescriptorSetLayoutDesc& desc);
+};
+
+} // namespace vk
+} // namespace jdl
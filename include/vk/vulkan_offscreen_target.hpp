@@ -0,0 +1,129 @@
+#pragma once
+
+#include "vulkan_buffer.hpp"
+#include "vulkan_image.hpp"
+
+#include "utils/non_copyable.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+struct ReadbackImage
+{
+	// Index of the frame which rendered the image
+	uint64_t frame = 0;
+	// Tightly packed pixels, valid only during the readback callback
+	const void* data = nullptr;
+	VkDeviceSize size = 0;
+
+	VkExtent2D extent {};
+	VkFormat format = VK_FORMAT_UNDEFINED;
+};
+
+class VulkanOffscreenTarget : private NonCopyable<VulkanOffscreenTarget>
+{
+public:
+	/**
+	 * @brief Creates the offscreen render target.
+	 * @param extent Images extent.
+	 * @param format Images color format.
+	 * @param nb_images Number of images (one for each in-flight frame).
+	 * @param readback Whether host-visible readback buffers are created or not.
+	 */
+	VulkanOffscreenTarget(
+		VkExtent2D extent,
+		VkFormat format,
+		uint32_t nb_images,
+		bool readback
+	);
+
+	~VulkanOffscreenTarget();
+
+	/**
+	 * @brief Returns the images color format.
+	 */
+	VkFormat get_format() const { return m_format; }
+
+	/**
+	 * @brief Returns the images extent.
+	 */
+	VkExtent2D get_extent() const { return m_extent; }
+
+	/**
+	 * @brief Returns the number of images.
+	 */
+	size_t get_nb_images() const { return m_images.size(); }
+
+	/**
+	 * @brief Returns an offscreen image.
+	 * @param index Image index
+	 * @return The queried image, or VK_NULL_HANDLE if the index is invalid
+	 */
+	VkImage get_image(size_t index) const {
+		return index < m_images.size() ? m_images[index].image->get() : VK_NULL_HANDLE;
+	}
+
+	/**
+	 * @brief Returns an offscreen image view.
+	 * @param index Image index
+	 * @return The queried image view, or VK_NULL_HANDLE if the index is invalid
+	 */
+	VkImageView get_image_view(size_t index) const {
+		return index < m_images.size() ? m_images[index].image->get_view() : VK_NULL_HANDLE;
+	}
+
+	/**
+	 * @brief Returns whether the images can be read back to host memory or not.
+	 */
+	bool has_readback() const { return m_readback; }
+
+	/**
+	 * @brief Returns the size in bytes of a readback buffer.
+	 */
+	VkDeviceSize get_readback_size() const { return m_readbackSize; }
+
+	/**
+	 * @brief Returns the readback buffer associated to an image.
+	 * @param index Image index
+	 * @return The queried buffer, or VK_NULL_HANDLE if the readback is disabled
+	 */
+	VkBuffer get_readback_buffer(size_t index) const {
+		if (index >= m_images.size() || m_images[index].readback == nullptr) {
+			return VK_NULL_HANDLE;
+		}
+		return m_images[index].readback->get();
+	}
+
+	/**
+	 * @brief Returns the host pointer of a readback buffer.
+	 * @param index Image index
+	 * @return The mapped memory, or nullptr if the readback is disabled
+	 */
+	const void* get_readback_data(size_t index) const {
+		if (index >= m_images.size() || m_images[index].readback == nullptr) {
+			return nullptr;
+		}
+		return m_images[index].readback->get_mapped_data();
+	}
+
+private:
+	struct OffscreenImage
+	{
+		std::unique_ptr<VulkanImage> image;
+		std::unique_ptr<VulkanBuffer> readback;
+	};
+
+	VkExtent2D m_extent {};
+	VkFormat m_format = VK_FORMAT_UNDEFINED;
+
+	bool m_readback = false;
+	VkDeviceSize m_readbackSize = 0;
+
+	std::vector<OffscreenImage> m_images;
+};
+
+} // namespace vk
+} // namespace jdl
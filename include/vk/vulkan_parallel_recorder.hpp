@@ -0,0 +1,88 @@
+#pragma once
+
+#include "vulkan_command_allocator.hpp"
+#include "vulkan_command_buffer.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <functional>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Attachment formats of the dynamic rendering pass the secondary
+ * command buffers are executed in.
+ */
+struct RenderingFormats
+{
+	std::vector<VkFormat> color_formats;
+	VkFormat depth_format = VK_FORMAT_UNDEFINED;
+	VkFormat stencil_format = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+/**
+ * @brief Records secondary command buffers as jobs of the job system. Each
+ * job thread owns its own per-frame command pools, so recording never needs
+ * any lock.
+ * The resulting command buffers are returned in the order of the record
+ * functions, so that the primary command buffer executes them in a fixed
+ * order whatever the worker scheduling.
+ */
+class VulkanParallelRecorder : private NonCopyable<VulkanParallelRecorder>
+{
+public:
+	using RecordFunction = std::function<void(VulkanCommandBuffer&)>;
+
+	/**
+	 * @brief Creates the command pools of every job thread.
+	 * @param nb_frames Number of frames in flight.
+	 */
+	explicit VulkanParallelRecorder(uint32_t nb_frames);
+
+	/**
+	 * @brief Destroys the command pools.
+	 */
+	~VulkanParallelRecorder();
+
+	/**
+	 * @brief Returns the number of threads recording command buffers.
+	 */
+	uint32_t get_nb_threads() const { return static_cast<uint32_t>(m_allocators.size()); }
+
+	/**
+	 * @brief Resets the command pools of a frame. The frame must not be in
+	 * use by the GPU anymore.
+	 * @param frame_index Index of the frame in flight.
+	 */
+	void begin_frame(uint32_t frame_index);
+
+	/**
+	 * @brief Records one secondary command buffer for each record function,
+	 * in parallel, and waits for all of them to be recorded (the calling
+	 * thread records some of them meanwhile, it must be a job system thread).
+	 * @param formats Attachment formats of the rendering pass the command
+	 * buffers will be executed in.
+	 * @param functions The functions recording the commands.
+	 * @param pipeline_statistics Statistics counted by the pipeline statistics
+	 * query active when the command buffers are executed, if any.
+	 * @return The recorded command buffers, in the order of the functions.
+	 * They remain valid until the next begin_frame() call on the same frame.
+	 */
+	std::vector<VulkanCommandBuffer*> record(
+		const RenderingFormats& formats,
+		const std::vector<RecordFunction>& functions,
+		VkQueryPipelineStatisticFlags pipeline_statistics = 0
+	);
+
+private:
+	// Per-frame command pools of each job thread
+	std::vector<std::unique_ptr<VulkanCommandAllocator>> m_allocators;
+};
+
+} // namespace vk
+} // namespace jdl
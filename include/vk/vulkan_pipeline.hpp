@@ -2,65 +2,113 @@
 
 #include "utils/non_copyable.hpp"
 
+#include "vulkan_layout_cache.hpp"
+#include "vulkan_pipeline_desc.hpp"
+
 #include <unordered_map>
 
 
 namespace jdl
 {
-
-namespace resource
-{
-class Shader;
-} // namespace resource
-
 namespace vk
 {
 
-enum class ShaderStage
-{
-	eVertex = VK_SHADER_STAGE_VERTEX_BIT,
-	eFragment = VK_SHADER_STAGE_FRAGMENT_BIT
-};
+// Shader modules to use instead of the current module of their shader
+using ShaderModuleMap = std::unordered_map<const resource::Shader*, VkShaderModule>;
 
 class VulkanPipeline : private NonCopyable<VulkanPipeline>
 {
 public:
-	VulkanPipeline();
+	/**
+	 * @brief Creates the Vulkan pipeline described by desc.
+	 * @param desc Pipeline description.
+	 */
+	explicit VulkanPipeline(const PipelineDesc& desc);
 	~VulkanPipeline();
 
 	/**
-	 * @brief Adds a new shader for the pipeline configuration.
-	 * This has to be called before creating the pipeline.
+	 * @brief Creates several pipelines with a single vkCreateGraphicsPipelines
+	 * call (and a single vkCreateComputePipelines call for the compute ones),
+	 * which lets the driver compile them in parallel.
 	 * 
-	 * @param stage Pipeline shader stage
-	 * @param shader Shader resource
+	 * @param descs Pipeline descriptions.
+	 * @param modules Shader modules overriding the current module of their
+	 * shader (used to rebuild pipelines before a reloaded module is swapped).
+	 * @return The pipelines, in the same order as the descriptions. Pipelines
+	 * that failed to be created are not valid.
+	 */
+	static std::vector<std::unique_ptr<VulkanPipeline>> CreatePipelines(
+		const std::vector<PipelineDesc>& descs,
+		const ShaderModuleMap& modules = {}
+	);
+
+	/**
+	 * @brief Exchanges the Vulkan objects of two pipelines with the same
+	 * description, so that a rebuilt pipeline can replace this one without
+	 * invalidating the pointers to it.
+	 * @param other Pipeline with the same description.
 	 */
-	void add_shader(ShaderStage stage, resource::Shader* shader);
+	void swap(VulkanPipeline& other);
 
 	/**
-	 * @brief Creates the Vulkan pipeline.
+	 * @brief Returns whether the pipeline has been created or not.
 	 */
-	void create();
+	bool is_valid() const { return m_pipeline != VK_NULL_HANDLE; }
 
 	/**
-	 * @brief Returns the Vulkan pipeline layout handle.
+	 * @brief Returns the pipeline description.
+	 */
+	const PipelineDesc& get_desc() const { return m_desc; }
+
+	/**
+	 * @brief Returns the bind point of the pipeline (graphics or compute).
+	 */
+	VkPipelineBindPoint get_bind_point() const {
+		return m_desc.is_compute() ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+	}
+
+	/**
+	 * @brief Returns the pipeline layout description, built from the
+	 * reflection of the shaders.
+	 */
+	const PipelineLayoutDesc& get_layout_desc() const { return m_layoutDesc; }
+
+	/**
+	 * @brief Returns the Vulkan pipeline layout handle (shared by every
+	 * pipeline with the same layout).
 	 */
 	VkPipelineLayout get_pipeline_layout() const { return m_pipelineLayout; }
 
+	/**
+	 * @brief Returns the layout of a descriptor set (VK_NULL_HANDLE if the
+	 * pipeline has no such set).
+	 * @param set Set index.
+	 */
+	VkDescriptorSetLayout get_descriptor_set_layout(uint32_t set) const {
+		return set < m_setLayouts.size() ? m_setLayouts[set] : VK_NULL_HANDLE;
+	}
+
 	/**
 	 * @brief Returns the Vulkan pipeline handle.
 	 */
 	VkPipeline get_pipeline() const { return m_pipeline;  }
 
 private:
+	struct DeferredCreation {};
+
 	VK_ATTR(VkDevice, m_device);
 	VK_ATTR(VkPipelineLayout, m_pipelineLayout);
 	VK_ATTR(VkPipeline, m_pipeline);
 
-	std::unordered_map<ShaderStage, resource::Shader*> m_shaders;
+	PipelineDesc m_desc;
+	PipelineLayoutDesc m_layoutDesc;
+	std::vector<VkDescriptorSetLayout> m_setLayouts;
+
+	// Only creates the pipeline layout, the pipeline is created by CreatePipelines
+	VulkanPipeline(const PipelineDesc& desc, DeferredCreation);
 
+	bool validate_desc() const;
 	void create_pipeline_layout();
-	void create_pipeline();
 };
 
 } // namespace vk
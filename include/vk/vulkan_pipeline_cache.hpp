@@ -0,0 +1,73 @@
+#pragma once
+
+#include "utils/non_copyable.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Pipeline cache persisted on disk. The saved data is only reused by
+ * the exact same device and driver: the vendor ID, device ID, driver version
+ * and pipelineCacheUUID are stored along with it and checked on load.
+ */
+class VulkanPipelineCache : private NonCopyable<VulkanPipelineCache>
+{
+public:
+	/**
+	 * @brief Creates the pipeline cache, from the file content if it is valid.
+	 * @param device Logical device.
+	 * @param properties Properties of the physical device.
+	 * @param path Cache file path. If empty, the cache is not persisted.
+	 */
+	VulkanPipelineCache(
+		VkDevice device,
+		const VkPhysicalDeviceProperties& properties,
+		const std::string& path
+	);
+
+	/**
+	 * @brief Saves and destroys the pipeline cache.
+	 */
+	~VulkanPipelineCache();
+
+	/**
+	 * @brief Returns the Vulkan pipeline cache handle.
+	 */
+	VkPipelineCache get() const { return m_cache; }
+
+	/**
+	 * @brief Writes the cache content to the file. The file is replaced
+	 * atomically, so an interrupted save never leaves a corrupted cache.
+	 * @return Whether the cache has been saved or not.
+	 */
+	bool save() const;
+
+private:
+	// Header written before the driver data
+	struct FileHeader
+	{
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint32_t vendor_id = 0;
+		uint32_t device_id = 0;
+		uint32_t driver_version = 0;
+		uint8_t uuid[VK_UUID_SIZE] {};
+		uint64_t data_size = 0;
+		uint64_t data_hash = 0;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+	VK_ATTR(VkPipelineCache, m_cache);
+
+	VkPhysicalDeviceProperties m_properties {};
+	std::string m_path;
+
+	FileHeader make_header() const;
+	std::vector<char> load() const;
+};
+
+} // namespace vk
+} // namespace jdl
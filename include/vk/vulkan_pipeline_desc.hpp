@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace jdl
+{
+
+namespace resource
+{
+class Shader;
+} // namespace resource
+
+namespace vk
+{
+
+enum class ShaderStage
+{
+	eVertex = VK_SHADER_STAGE_VERTEX_BIT,
+	eFragment = VK_SHADER_STAGE_FRAGMENT_BIT,
+	eCompute = VK_SHADER_STAGE_COMPUTE_BIT
+};
+
+struct ShaderDesc
+{
+	ShaderStage stage = ShaderStage::eVertex;
+	resource::Shader* shader = nullptr;
+	// First entry point of the stage in the shader if empty
+	std::string entry_point;
+
+	bool operator==(const ShaderDesc&) const = default;
+};
+
+struct VertexBindingDesc
+{
+	uint32_t binding = 0;
+	uint32_t stride = 0;
+	VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	bool operator==(const VertexBindingDesc&) const = default;
+};
+
+struct VertexAttributeDesc
+{
+	uint32_t location = 0;
+	uint32_t binding = 0;
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t offset = 0;
+
+	bool operator==(const VertexAttributeDesc&) const = default;
+};
+
+struct RasterStateDesc
+{
+	VkPolygonMode polygon_mode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cull_mode = VK_CULL_MODE_NONE;
+	VkFrontFace front_face = VK_FRONT_FACE_CLOCKWISE;
+	bool depth_bias = false;
+
+	bool operator==(const RasterStateDesc&) const = default;
+};
+
+struct DepthStateDesc
+{
+	bool test = false;
+	bool write = false;
+	VkCompareOp compare_op = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	bool operator==(const DepthStateDesc&) const = default;
+};
+
+struct BlendStateDesc
+{
+	bool enable = false;
+	VkBlendFactor src_color = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor dst_color = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp color_op = VK_BLEND_OP_ADD;
+	VkBlendFactor src_alpha = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor dst_alpha = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp alpha_op = VK_BLEND_OP_ADD;
+	VkColorComponentFlags write_mask = (
+		VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT |
+		VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT
+	);
+
+	bool operator==(const BlendStateDesc&) const = default;
+};
+
+/**
+ * @brief Full description of a graphics or compute pipeline. Two equal
+ * descriptions always produce the same pipeline, so it can be used as a
+ * pipeline key. A compute pipeline is described by a single eCompute shader,
+ * the graphics states are ignored.
+ */
+struct PipelineDesc
+{
+	std::vector<ShaderDesc> shaders;
+
+	std::vector<VertexBindingDesc> vertex_bindings;
+	std::vector<VertexAttributeDesc> vertex_attributes;
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	RasterStateDesc raster;
+	DepthStateDesc depth;
+	// One blend state per color attachment (the default state if missing)
+	std::vector<BlendStateDesc> blend;
+
+	// Dynamic rendering attachments
+	std::vector<VkFormat> color_formats;
+	VkFormat depth_format = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+	bool operator==(const PipelineDesc&) const = default;
+
+	/**
+	 * @brief Returns whether the description is a compute pipeline or not.
+	 */
+	bool is_compute() const {
+		return shaders.size() == 1 && shaders[0].stage == ShaderStage::eCompute;
+	}
+
+	/**
+	 * @brief Returns the description hash. It only depends on the description
+	 * content (shaders are identified by their resource name), so it is stable
+	 * across runs.
+	 */
+	uint64_t hash() const;
+};
+
+struct PipelineDescHasher
+{
+	size_t operator()(const PipelineDesc& desc) const { return desc.hash(); }
+};
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "utils/non_copyable.hpp"
+
+#include "vulkan_pipeline.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Owns every graphics and compute pipeline, keyed by their
+ * description. Asking twice for the same description returns the same
+ * pipeline, so identical pipelines are never created twice. Thread-safe.
+ */
+class VulkanPipelineLibrary : private NonCopyable<VulkanPipelineLibrary>
+{
+public:
+	VulkanPipelineLibrary() = default;
+	~VulkanPipelineLibrary() = default;
+
+	/**
+	 * @brief Returns the pipeline matching desc, created if needed.
+	 * @param desc Pipeline description.
+	 * @return The pipeline, or nullptr if it could not be created.
+	 */
+	VulkanPipeline* get(const PipelineDesc& desc);
+
+	/**
+	 * @brief Returns the pipelines matching descs. The missing ones are
+	 * created with a single batched call.
+	 * 
+	 * @param descs Pipeline descriptions (may contain duplicates).
+	 * @return The pipelines, in the same order as the descriptions. Pipelines
+	 * that could not be created are nullptr.
+	 */
+	std::vector<VulkanPipeline*> get(const std::vector<PipelineDesc>& descs);
+
+	/**
+	 * @brief Returns the pipeline matching desc if it exists, nullptr otherwise.
+	 * @param desc Pipeline description.
+	 */
+	VulkanPipeline* find(const PipelineDesc& desc) const;
+
+	/**
+	 * @brief Returns the number of pipelines in the library.
+	 */
+	size_t get_nb_pipelines() const;
+
+	/**
+	 * @brief Creates new versions of the pipelines using the given shaders,
+	 * with their replacement modules. The library is not modified: the new
+	 * pipelines are swapped in later by swap_pipelines(). Thread-safe, meant
+	 * to run off the render thread.
+	 * @param modules Replacement module of each modified shader.
+	 * @return The rebuilt pipelines (only the valid ones).
+	 */
+	std::vector<std::unique_ptr<VulkanPipeline>> rebuild(const ShaderModuleMap& modules) const;
+
+	/**
+	 * @brief Replaces the Vulkan objects of the library pipelines with the
+	 * ones of rebuilt pipelines. Pointers to the library pipelines stay valid.
+	 * Must be called by the render thread, at a frame boundary.
+	 * @param pipelines Rebuilt pipelines. On return, they hold the previous
+	 * Vulkan objects, to be destroyed once no frame in flight uses them.
+	 */
+	void swap_pipelines(std::vector<std::unique_ptr<VulkanPipeline>>& pipelines);
+
+	/**
+	 * @brief Destroys all pipelines. They must not be in use by the GPU.
+	 */
+	void clear();
+
+private:
+	using PipelineMap = std::unordered_map<
+		PipelineDesc, std::unique_ptr<VulkanPipeline>, PipelineDescHasher
+	>;
+
+	mutable std::mutex m_mutex;
+	PipelineMap m_pipelines;
+};
+
+} // namespace vk
+} // namespace jdl
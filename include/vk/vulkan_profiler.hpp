@@ -0,0 +1,177 @@
+#pragma once
+
+#include "vulkan_command_buffer.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+struct PipelineStatistics
+{
+	uint64_t input_vertices = 0;
+	uint64_t input_primitives = 0;
+	uint64_t vertex_invocations = 0;
+	uint64_t clipping_invocations = 0;
+	uint64_t clipping_primitives = 0;
+	uint64_t fragment_invocations = 0;
+};
+
+struct ProfilerScopeStats
+{
+	std::string name;
+
+	// Number of samples used to compute the statistics (rolling window)
+	size_t nb_samples = 0;
+
+	// GPU durations, in milliseconds
+	double last_ms = 0.0;
+	double min_ms = 0.0;
+	double avg_ms = 0.0;
+	double p99_ms = 0.0;
+
+	// Last pipeline statistics (top-level scopes only, if enabled)
+	bool has_pipeline_statistics = false;
+	PipelineStatistics pipeline_statistics;
+};
+
+class VulkanProfiler : private NonCopyable<VulkanProfiler>
+{
+public:
+	/**
+	 * @brief Creates the GPU profiler.
+	 * @param nb_frames Number of in-flight frames.
+	 * @param enabled Whether the GPU timings are recorded or not.
+	 * @param pipeline_statistics Whether the pipeline statistics are recorded
+	 * or not (requires the pipelineStatisticsQuery device feature).
+	 * @param secondary_command_buffers Whether the profiled scopes may
+	 * execute secondary command buffers or not (the pipeline statistics then
+	 * require the inheritedQueries device feature).
+	 */
+	VulkanProfiler(
+		uint32_t nb_frames,
+		bool enabled,
+		bool pipeline_statistics,
+		bool secondary_command_buffers = false
+	);
+	~VulkanProfiler();
+
+	/**
+	 * @brief Returns whether the profiler records anything or not.
+	 */
+	bool is_enabled() const { return m_enabled; }
+
+	/**
+	 * @brief Returns the statistics counted by the pipeline statistics
+	 * queries (0 if disabled), to be inherited by the secondary command
+	 * buffers executed inside a scope.
+	 */
+	VkQueryPipelineStatisticFlags get_pipeline_statistics_flags() const;
+
+	/**
+	 * @brief Starts profiling a frame. Must be called right after the command
+	 * buffer begins, once the frame fence has been waited: the results of the
+	 * previous frame that used the same slot are collected without stalling.
+	 * @param command_buffer The frame command buffer.
+	 * @param frame_index Index of the in-flight frame.
+	 */
+	void begin_frame(VulkanCommandBuffer& command_buffer, uint32_t frame_index);
+
+	/**
+	 * @brief Opens a named timing scope. Scopes can be nested.
+	 * @param command_buffer The frame command buffer.
+	 * @param name Scope name.
+	 */
+	void begin_scope(VulkanCommandBuffer& command_buffer, const char* name);
+
+	/**
+	 * @brief Closes the last opened timing scope.
+	 * @param command_buffer The frame command buffer.
+	 */
+	void end_scope(VulkanCommandBuffer& command_buffer);
+
+	/**
+	 * @brief Returns the rolling statistics of every scope, in the order the
+	 * scopes were first recorded.
+	 */
+	std::vector<ProfilerScopeStats> get_stats() const;
+
+	/**
+	 * @brief Clears all the collected statistics.
+	 */
+	void reset_stats();
+
+	/**
+	 * @brief Returns the statistics as a JSON document.
+	 */
+	std::string to_json() const;
+
+	/**
+	 * @brief Writes the statistics as a JSON file.
+	 * @param path Output file path.
+	 * @return Whether the file has been written or not.
+	 */
+	bool dump_json(const std::string& path) const;
+
+private:
+	// Maximum number of scopes recorded in a single frame
+	static constexpr uint32_t s_MaxScopes = 64;
+	// Number of samples kept for the rolling statistics
+	static constexpr size_t s_HistorySize = 240;
+	// Open scope which has not been recorded (too many scopes)
+	static constexpr size_t s_IgnoredScope = SIZE_MAX;
+
+	struct ScopeRecord
+	{
+		size_t scope;
+		uint32_t query;
+		int32_t statistics_query = -1;
+	};
+
+	struct FrameQueries
+	{
+		VK_ATTR(VkQueryPool, timestamps);
+		VK_ATTR(VkQueryPool, statistics);
+
+		std::vector<ScopeRecord> records;
+		uint32_t nb_statistics = 0;
+	};
+
+	struct ScopeHistory
+	{
+		std::string name;
+
+		std::vector<double> samples;
+		size_t next_sample = 0;
+
+		bool has_pipeline_statistics = false;
+		PipelineStatistics pipeline_statistics;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+
+	bool m_enabled = false;
+	bool m_pipelineStatistics = false;
+
+	// Nanoseconds per timestamp tick, and mask of the valid timestamp bits
+	double m_timestampPeriod = 1.0;
+	uint64_t m_timestampMask = UINT64_MAX;
+
+	std::vector<FrameQueries> m_frames;
+	FrameQueries* m_currentFrame = nullptr;
+	std::vector<size_t> m_openScopes;
+
+	std::vector<ScopeHistory> m_scopes;
+	std::unordered_map<std::string, size_t> m_scopeIndices;
+
+	void collect_results(FrameQueries& frame);
+	size_t get_scope_index(const char* name);
+};
+
+} // namespace vk
+} // namespace jdl
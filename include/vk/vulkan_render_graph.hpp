@@ -0,0 +1,377 @@
+#pragma once
+
+#include "vulkan_allocator.hpp"
+#include "vulkan_command_buffer.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <functional>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+class VulkanProfiler;
+
+/**
+ * @brief How a render graph pass uses a resource. Each access implies the
+ * pipeline stages, the memory accesses and (for images) the layout, from
+ * which the barriers are inferred.
+ */
+enum class RenderGraphAccess
+{
+	eNone,
+	// Images
+	eColorAttachment,
+	eDepthAttachment,
+	eDepthRead,
+	eSampledFragment,
+	eSampledCompute,
+	eStorageReadCompute,
+	eStorageWriteCompute,
+	eTransferSrc,
+	eTransferDst,
+	ePresent,
+	// Buffers
+	eVertexBuffer,
+	eIndexBuffer,
+	eIndirectBuffer,
+	eUniformBuffer,
+	eStorageBufferRead,
+	eStorageBufferWrite,
+	eHostRead
+};
+
+struct RenderGraphImageDesc
+{
+	VkExtent2D extent {};
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+// Handle of a render graph resource, only valid for the graph which created it
+struct RenderGraphResource
+{
+	static constexpr uint32_t s_Invalid = UINT32_MAX;
+
+	uint32_t index = s_Invalid;
+
+	bool is_valid() const { return index != s_Invalid; }
+	bool operator==(const RenderGraphResource&) const = default;
+};
+
+/**
+ * @brief Declares the resources used by a pass. Attachments are bound with
+ * dynamic rendering when the pass is executed.
+ */
+class RenderGraphPass
+{
+public:
+	using ExecuteFunction = std::function<void(VulkanCommandBuffer&)>;
+
+	/**
+	 * @brief Writes a color attachment.
+	 * @param image Target image.
+	 * @param load_op Load operation (LOAD makes the pass depend on the
+	 * previous content of the image).
+	 * @param clear_value Clear color, used with VK_ATTACHMENT_LOAD_OP_CLEAR.
+	 */
+	RenderGraphPass& write_color(
+		RenderGraphResource image,
+		VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		VkClearValue clear_value = {}
+	);
+
+	/**
+	 * @brief Writes a depth attachment.
+	 * @param image Target image.
+	 * @param load_op Load operation.
+	 * @param clear_depth Clear depth, used with VK_ATTACHMENT_LOAD_OP_CLEAR.
+	 */
+	RenderGraphPass& write_depth(
+		RenderGraphResource image,
+		VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		float clear_depth = 1.0f
+	);
+
+	/**
+	 * @brief Reads a resource.
+	 * @param resource Read resource.
+	 * @param access How the resource is read.
+	 */
+	RenderGraphPass& read(RenderGraphResource resource, RenderGraphAccess access);
+
+	/**
+	 * @brief Writes a resource outside of the attachments (storage, transfer).
+	 * @param resource Written resource.
+	 * @param access How the resource is written.
+	 */
+	RenderGraphPass& write(RenderGraphResource resource, RenderGraphAccess access);
+
+	/**
+	 * @brief Prevents the pass from being culled, even if nothing reads
+	 * what it writes.
+	 */
+	RenderGraphPass& set_side_effects() { m_sideEffects = true; return *this; }
+
+	/**
+	 * @brief Makes the pass contents recorded in secondary command buffers,
+	 * executed by the execute function.
+	 */
+	RenderGraphPass& use_secondary_command_buffers() { m_secondary = true; return *this; }
+
+	/**
+	 * @brief Sets the function recording the pass commands.
+	 * @param function Execute function.
+	 */
+	RenderGraphPass& set_execute(ExecuteFunction function) {
+		m_execute = std::move(function);
+		return *this;
+	}
+
+	/**
+	 * @brief Returns the pass name.
+	 */
+	const std::string& get_name() const { return m_name; }
+
+private:
+	friend class VulkanRenderGraph;
+
+	struct ResourceAccess
+	{
+		RenderGraphResource resource;
+		RenderGraphAccess access = RenderGraphAccess::eNone;
+		bool write = false;
+		// Whether the previous content is needed (always true for reads)
+		bool preserve = true;
+	};
+
+	// Merged uses of a resource by the pass, requested from the command buffer
+	struct Transition
+	{
+		uint32_t resource = 0;
+		ResourceState state;
+		// Whether the state of the resource before the graph is declared first
+		bool first_use = false;
+	};
+
+	struct Attachment
+	{
+		RenderGraphResource image;
+		VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		VkClearValue clear_value {};
+	};
+
+	std::string m_name;
+	std::vector<ResourceAccess> m_accesses;
+	std::vector<Attachment> m_colorAttachments;
+	Attachment m_depthAttachment;
+	ExecuteFunction m_execute;
+	bool m_sideEffects = false;
+	bool m_secondary = false;
+
+	// Compilation results
+	bool m_culled = false;
+	std::vector<Transition> m_transitions;
+	std::vector<VkAttachmentStoreOp> m_colorStoreOps;
+	VkAttachmentStoreOp m_depthStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+};
+
+/**
+ * @brief Frame graph of passes declaring the resources they read and write.
+ * 
+ * The graph is rebuilt every frame: reset(), import/create the resources,
+ * add the passes (in submission order), compile() and execute(). Compiling
+ * culls the passes whose results are never used, merges the accesses of each
+ * pass into the resource states it requests, and places the transient images
+ * in a single memory allocation, where the images whose lifetimes do not
+ * overlap share memory. The states are requested from the resource tracker of
+ * the command buffer when the graph is executed, which infers the minimal
+ * barriers (batched in one VkDependencyInfo per pass).
+ * 
+ * Transient images are kept alive across frames while the graph layout does
+ * not change, so a graph must only be reused once the GPU has finished the
+ * frame that executed it (i.e. one graph per frame in flight).
+ */
+class VulkanRenderGraph : private NonCopyable<VulkanRenderGraph>
+{
+public:
+	VulkanRenderGraph();
+	~VulkanRenderGraph();
+
+	/**
+	 * @brief Removes all passes and resources, the transient memory is kept.
+	 */
+	void reset();
+
+	/**
+	 * @brief Imports an image owned outside of the graph (single mip level
+	 * and array layer).
+	 * @param name Debug name.
+	 * @param image Vulkan image.
+	 * @param view Vulkan image view.
+	 * @param desc Image description.
+	 * @param initial_layout Layout of the image before the graph.
+	 * @param final_access Access following the graph (ePresent, ...), the
+	 * image is transitioned accordingly after the last pass.
+	 */
+	RenderGraphResource import_image(
+		const std::string& name,
+		VkImage image,
+		VkImageView view,
+		const RenderGraphImageDesc& desc,
+		VkImageLayout initial_layout,
+		RenderGraphAccess final_access = RenderGraphAccess::eNone
+	);
+
+	/**
+	 * @brief Imports a buffer owned outside of the graph.
+	 * @param name Debug name.
+	 * @param buffer Vulkan buffer.
+	 * @param final_access Access following the graph (eHostRead, ...).
+	 */
+	RenderGraphResource import_buffer(
+		const std::string& name,
+		VkBuffer buffer,
+		RenderGraphAccess final_access = RenderGraphAccess::eNone
+	);
+
+	/**
+	 * @brief Declares a transient image, allocated by the graph and only
+	 * valid during the frame. Its content is undefined before its first write.
+	 * @param name Debug name.
+	 * @param desc Image description (the usage is inferred from the passes).
+	 */
+	RenderGraphResource create_image(const std::string& name, const RenderGraphImageDesc& desc);
+
+	/**
+	 * @brief Adds a pass, executed after the previously added ones.
+	 * @param name Pass name (also used as profiler scope).
+	 */
+	RenderGraphPass& add_pass(const std::string& name);
+
+	/**
+	 * @brief Culls the passes, computes the resource transitions and
+	 * allocates the transient images.
+	 */
+	void compile();
+
+	/**
+	 * @brief Records the compiled graph.
+	 * @param command_buffer Recording command buffer.
+	 * @param profiler Optional profiler, each pass being recorded in a scope.
+	 */
+	void execute(VulkanCommandBuffer& command_buffer, VulkanProfiler* profiler = nullptr);
+
+	/**
+	 * @brief Returns the Vulkan image of an image resource. Transient images
+	 * are only available once the graph is compiled.
+	 */
+	VkImage get_image(RenderGraphResource image) const;
+
+	/**
+	 * @brief Returns the Vulkan image view of an image resource.
+	 */
+	VkImageView get_image_view(RenderGraphResource image) const;
+
+	/**
+	 * @brief Returns the Vulkan buffer of a buffer resource.
+	 */
+	VkBuffer get_buffer(RenderGraphResource buffer) const;
+
+	/**
+	 * @brief Returns the number of passes kept by the last compilation.
+	 */
+	uint32_t get_nb_active_passes() const { return m_nbActivePasses; }
+
+	/**
+	 * @brief Returns the number of barriers recorded by the last execution.
+	 */
+	uint32_t get_nb_barriers() const { return m_nbBarriers; }
+
+	/**
+	 * @brief Returns the memory size of the transient images, and the size
+	 * they would use without aliasing.
+	 */
+	VkDeviceSize get_transient_memory_size() const { return m_transientMemory.size; }
+	VkDeviceSize get_transient_unaliased_size() const { return m_transientUnaliasedSize; }
+
+private:
+	enum class ResourceType { eImage, eBuffer };
+
+	struct Resource
+	{
+		std::string name;
+		ResourceType type = ResourceType::eImage;
+		bool imported = false;
+
+		RenderGraphImageDesc image_desc;
+		VkImageUsageFlags image_usage = 0;
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+		VK_ATTR(VkImage, image);
+		VK_ATTR(VkImageView, view);
+		VK_ATTR(VkBuffer, buffer);
+
+		VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		RenderGraphAccess final_access = RenderGraphAccess::eNone;
+		// State declared to the command buffer before the first use
+		ResourceState initial_state;
+
+		// Lifetime, in active pass indices
+		uint32_t first_pass = UINT32_MAX;
+		uint32_t last_pass = 0;
+		// Transient image slot
+		uint32_t transient = UINT32_MAX;
+	};
+
+	// Transient image, kept across frames while the graph layout is unchanged
+	struct TransientImage
+	{
+		RenderGraphImageDesc desc;
+		VkImageUsageFlags usage = 0;
+		VkImageAspectFlags aspect = 0;
+		uint32_t first_pass = 0;
+		uint32_t last_pass = 0;
+
+		VK_ATTR(VkImage, image);
+		VK_ATTR(VkImageView, view);
+		VkMemoryRequirements requirements {};
+		VkDeviceSize offset = 0;
+		// Transient images which used parts of the memory before this one
+		std::vector<uint32_t> aliased;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+
+	std::vector<Resource> m_resources;
+	std::vector<std::unique_ptr<RenderGraphPass>> m_passes;
+
+	std::vector<TransientImage> m_transientImages;
+	VulkanAllocation m_transientMemory;
+	VkDeviceSize m_transientUnaliasedSize = 0;
+
+	// Transitions after the last pass (imported resources final accesses)
+	std::vector<RenderGraphPass::Transition> m_finalTransitions;
+
+	uint32_t m_nbActivePasses = 0;
+	uint32_t m_nbBarriers = 0;
+	bool m_compiled = false;
+
+	void cull_passes();
+	void compute_lifetimes();
+	void allocate_transient_images();
+	void destroy_transient_images();
+	void compute_transitions();
+
+	void record_transitions(
+		VulkanCommandBuffer& command_buffer,
+		const std::vector<RenderGraphPass::Transition>& transitions
+	) const;
+	void execute_pass(RenderGraphPass& pass, VulkanCommandBuffer& command_buffer);
+};
+
+} // namespace vk
+} // namespace jdl
@@ -1,21 +1,76 @@
 #pragma once
 
+#include "vulkan_command_allocator.hpp"
 #include "vulkan_command_buffer.hpp"
+#include "vulkan_context.hpp"
+#include "vulkan_draw_queue.hpp"
+#include "vulkan_frame_ring.hpp"
+#include "vulkan_gpu_scene.hpp"
+#include "vulkan_offscreen_target.hpp"
+#include "vulkan_parallel_recorder.hpp"
+#include "vulkan_profiler.hpp"
+#include "vulkan_render_graph.hpp"
+#include "vulkan_shader_reloader.hpp"
 
 #include "core/events.hpp"
 
 #include "utils/non_copyable.hpp"
 
+#include <chrono>
+#include <functional>
+
 
 namespace jdl
 {
 namespace vk
 {
 
+struct VulkanRendererSettings
+{
+    // Context settings (headless mode, ...)
+    VulkanContextSettings context;
+
+    // Number of frames the CPU can record while the GPU is still rendering the
+    // previous ones (1: lowest latency, 3: highest throughput)
+    uint32_t nb_frames_in_flight = 2;
+
+    // Offscreen images extent, used when running headless (one image is
+    // rendered for each frame in flight)
+    VkExtent2D headless_extent = {800, 600};
+    // Copies every offscreen image to host memory, used when running headless
+    bool headless_readback = false;
+
+    // Size of the uniform/storage data written by the CPU for each frame in
+    // flight, in bytes
+    VkDeviceSize frame_data_size = 4 * 1024 * 1024;
+
+    // Records the main pass in secondary command buffers on the job system
+    // threads (false: records everything on the calling thread)
+    bool parallel_recording = false;
+
+    // Watches this directory and hot reloads the modified shaders (disabled
+    // if empty)
+    std::string shader_reload_directory = "shaders";
+
+    // Records the GPU timings of each pass
+    bool gpu_profiling = true;
+    // Records the pipeline statistics of each top-level GPU profiler scope
+    bool pipeline_statistics = false;
+};
+
 class VulkanRenderer : private NonCopyable<VulkanRenderer>
 {
 public:
-    VulkanRenderer();
+    using ReadbackCallback = std::function<void(const ReadbackImage&)>;
+
+    // Draw queue pass recorded by the main pass
+    static constexpr uint32_t s_MainPass = 0;
+
+    /**
+     * @brief Creates the renderer.
+     * @param settings Renderer settings.
+     */
+    VulkanRenderer(const VulkanRendererSettings& settings = {});
     ~VulkanRenderer();
 
     /**
@@ -24,11 +79,52 @@ public:
      */
     void set_background_color(float r, float g, float b, float a = 1.0f);
 
+    /**
+     * @brief Sets the function receiving the rendered images when running
+     * headless with readback enabled. An image is delivered once the GPU has
+     * finished it, i.e. a few frames after render_frame() was called.
+     * @param callback The readback callback.
+     */
+    void set_readback_callback(ReadbackCallback callback) {
+        m_readbackCallback = std::move(callback);
+    }
+
+    /**
+     * @brief Returns the GPU profiler.
+     */
+    VulkanProfiler& get_profiler() { return *m_profiler; }
+    const VulkanProfiler& get_profiler() const { return *m_profiler; }
+
+    /**
+     * @brief Returns the scene culled and drawn by the GPU.
+     */
+    VulkanGpuScene& get_scene() { return *m_scene; }
+    const VulkanGpuScene& get_scene() const { return *m_scene; }
+
+    /**
+     * @brief Returns the queue of the draws of the next frame.
+     */
+    VulkanDrawQueue& get_draw_queue() { return *m_drawQueue; }
+    const VulkanDrawQueue& get_draw_queue() const { return *m_drawQueue; }
+
+    /**
+     * @brief Returns the number of frames in flight.
+     */
+    uint32_t get_nb_frames_in_flight() const {
+        return static_cast<uint32_t>(m_frames.size());
+    }
+
     /**
      * @brief Renders a new frame.
      */
     void render_frame();
 
+    /**
+     * @brief Waits for all the submitted frames and delivers their pending
+     * readbacks. Does nothing when rendering to a window.
+     */
+    void flush_readbacks();
+
     /**
      * @brief Waits for the renderer to be in idle state.
      */
@@ -41,32 +137,98 @@ public:
     void resize_event(const core::ResizeEvent& event);
 
 private:
+    // Maximum number of frames in flight
+    static constexpr uint32_t s_MaxFramesInFlight = 4;
+    // Minimum number of draw queue batches recorded by each job
+    static constexpr uint32_t s_MinBatchesPerRecording = 128;
+
+    // Per-frame state, owned by a frame in flight
+    struct FrameData
+    {
+        VK_ATTR(VkSemaphore, image_acquired);
+        VK_ATTR(VkFence, in_flight);
+        // Rebuilt every frame, owns the transient images of the frame
+        std::unique_ptr<VulkanRenderGraph> render_graph;
+    };
+
     VK_ATTR(VkDevice, m_device);
 
     // Background color
     VkClearValue m_clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
 
-    // Synchronization objects (one for each in-flight frame)
-    std::vector<VkSemaphore> m_imageAcquiredSemaphores;
-    std::vector<VkSemaphore> m_renderFinishedSemaphores;
-    std::vector<VkFence> m_inFlightFences;
+    // GPU timestamps/statistics profiler
+    std::unique_ptr<VulkanProfiler> m_profiler;
+
+    // Offscreen render target (headless mode only)
+    std::unique_ptr<VulkanOffscreenTarget> m_offscreenTarget;
+
+    // Readback state of each offscreen image
+    ReadbackCallback m_readbackCallback;
+    std::vector<bool> m_pendingReadbacks;
+    std::vector<uint64_t> m_readbackFrames;
+
+    // Per-frame state (one for each frame in flight)
+    std::vector<FrameData> m_frames;
+
+    // Per-frame graphics command pools
+    std::unique_ptr<VulkanCommandAllocator> m_commandAllocator;
 
-    // Command buffers (one for each in-flight frame)
-    std::vector<std::unique_ptr<VulkanCommandBuffer>> m_commandBuffers;
+    // Per-frame uniform/storage data (one region for each frame in flight)
+    std::unique_ptr<VulkanFrameRing> m_frameRing;
 
-    // Index of the current in-flight frame
-    uint32_t m_currentImage = 0;
+    // Objects culled and drawn by the GPU
+    std::unique_ptr<VulkanGpuScene> m_scene;
+
+    // Draws submitted by the CPU, sorted every frame
+    std::unique_ptr<VulkanDrawQueue> m_drawQueue;
+
+    // Shader hot reload (if enabled)
+    std::unique_ptr<VulkanShaderReloader> m_shaderReloader;
+
+    // Secondary command buffers recorder (multi-threaded recording only)
+    std::unique_ptr<VulkanParallelRecorder> m_parallelRecorder;
+
+    // Render finished semaphores (one for each swapchain image, since a
+    // semaphore waited by a presentation can only be reused once the image
+    // is acquired again)
+    std::vector<VkSemaphore> m_renderFinishedSemaphores;
+
+    // Index of the current frame in flight
+    uint32_t m_currentFrame = 0;
+    // Number of submitted frames
+    uint64_t m_frameCount = 0;
+    // Creation time of the renderer (time origin of the shaders)
+    std::chrono::steady_clock::time_point m_startTime;
 
     // Indicates that the framebuffer has been resized (swapchain is dirty)
     bool m_framebufferResized = false;
 
-    void create_sync_objects();
-    void create_command_buffers();
+    void create_offscreen_target(
+        const VulkanRendererSettings& settings,
+        uint32_t nb_frames
+    );
+    void create_frames(uint32_t nb_frames);
+    void create_render_finished_semaphores();
+    void destroy_render_finished_semaphores();
+    void recreate_swapchain();
+
+    void render_swapchain_frame();
+    void render_offscreen_frame();
+
+    void deliver_readback(uint32_t image_index);
 
     void record_command_buffer(
         VulkanCommandBuffer* command_buffer,
         uint32_t image_index
     );
+    void record_main_pass(
+        VulkanCommandBuffer& command_buffer,
+        VkExtent2D extent,
+        const VulkanFrameRing::Allocation& frame_constants,
+        bool draw_scene,
+        uint32_t first_batch,
+        uint32_t nb_batches
+    );
 };
 
 } // namespace vk
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Pipeline stages, memory accesses and layout (images only) of a resource use
+struct ResourceState
+{
+	VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2 access = VK_ACCESS_2_NONE;
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+// Barriers recorded with a single VkDependencyInfo
+struct BarrierBatch
+{
+	std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+	std::vector<VkImageMemoryBarrier2> image_barriers;
+};
+
+/**
+ * @brief Tracks the state of each image subresource (mip level, array layer)
+ * and buffer used by a command buffer. Requested states are turned into the
+ * minimal barriers, queued until flush() returns them as a single batch:
+ * - read after read in the same layout needs no barrier;
+ * - read after write only waits for the write once per reading stage;
+ * - write after read only needs an execution dependency.
+ * 
+ * A resource requested twice before a flush (e.g. written then read) starts
+ * a new batch, recorded after the previous one.
+ * 
+ * Resources used for the first time are assumed to be in the UNDEFINED
+ * layout, with no previous access to wait for. Resources whose content or
+ * layout must be kept across command buffers must be declared with
+ * set_image_state()/set_buffer_state().
+ */
+class VulkanResourceTracker
+{
+public:
+	/**
+	 * @brief Forgets every resource and drops the pending barriers.
+	 */
+	void reset();
+
+	/**
+	 * @brief Declares the current state of image subresources, without barrier.
+	 * @param image Vulkan image.
+	 * @param range Subresource range (explicit level and layer counts).
+	 * @param state Current state.
+	 */
+	void set_image_state(VkImage image, const VkImageSubresourceRange& range, const ResourceState& state);
+
+	/**
+	 * @brief Declares the current state of a buffer, without barrier.
+	 * @param buffer Vulkan buffer.
+	 * @param state Current state (the layout is ignored).
+	 */
+	void set_buffer_state(VkBuffer buffer, const ResourceState& state);
+
+	/**
+	 * @brief Requests image subresources to be in a state. The barrier, if
+	 * any, is queued until the next flush.
+	 * @param image Vulkan image.
+	 * @param range Subresource range (explicit level and layer counts).
+	 * @param state Requested state.
+	 */
+	void require_image_state(VkImage image, const VkImageSubresourceRange& range, const ResourceState& state);
+
+	/**
+	 * @brief Requests a buffer to be in a state. The barrier, if any, is
+	 * queued until the next flush.
+	 * @param buffer Vulkan buffer.
+	 * @param state Requested state (the layout is ignored).
+	 */
+	void require_buffer_state(VkBuffer buffer, const ResourceState& state);
+
+	/**
+	 * @brief Returns whether barriers are waiting to be flushed.
+	 */
+	bool has_pending_barriers() const {
+		return !m_batches.empty() || !m_batch.image_barriers.empty() || !m_batch.buffer_barriers.empty();
+	}
+
+	/**
+	 * @brief Returns the pending barriers, to be recorded in order.
+	 */
+	std::vector<BarrierBatch> flush();
+
+	/**
+	 * @brief Returns the number of barriers queued since the last reset, and
+	 * the number of requests which did not need any.
+	 */
+	uint32_t get_nb_barriers() const { return m_nbBarriers; }
+	uint32_t get_nb_skipped() const { return m_nbSkipped; }
+
+private:
+	struct TrackedState
+	{
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		// Last write, and the reads following it
+		VkPipelineStageFlags2 write_stages = VK_PIPELINE_STAGE_2_NONE;
+		VkAccessFlags2 write_access = VK_ACCESS_2_NONE;
+		VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE;
+		// Stages/accesses to which the last write has been made visible
+		VkPipelineStageFlags2 visible_stages = VK_PIPELINE_STAGE_2_NONE;
+		VkAccessFlags2 visible_access = VK_ACCESS_2_NONE;
+		// Whether a barrier on the resource is waiting to be flushed
+		bool pending = false;
+	};
+
+	struct SubresourceKey
+	{
+		VkImage image = VK_NULL_HANDLE;
+		uint32_t mip_level = 0;
+		uint32_t array_layer = 0;
+
+		bool operator==(const SubresourceKey&) const = default;
+	};
+
+	struct SubresourceKeyHasher
+	{
+		size_t operator()(const SubresourceKey& key) const {
+			size_t h = std::hash<VkImage>()(key.image);
+			h ^= (static_cast<size_t>(key.mip_level) << 16 | key.array_layer) + 0x9e3779b9 + (h << 6) + (h >> 2);
+			return h;
+		}
+	};
+
+	std::unordered_map<SubresourceKey, TrackedState, SubresourceKeyHasher> m_images;
+	std::unordered_map<VkBuffer, TrackedState> m_buffers;
+
+	// Batch being filled, and the full batches preceding it
+	BarrierBatch m_batch;
+	std::vector<BarrierBatch> m_batches;
+
+	uint32_t m_nbBarriers = 0;
+	uint32_t m_nbSkipped = 0;
+
+	static TrackedState MakeTrackedState(const ResourceState& state);
+
+	bool conflicts(const TrackedState& tracked, const ResourceState& state, bool is_image) const;
+	void split_batch();
+	bool update(
+		TrackedState& tracked,
+		const ResourceState& state,
+		bool is_image,
+		VkPipelineStageFlags2& src_stages,
+		VkAccessFlags2& src_access
+	);
+};
+
+} // namespace vk
+} // namespace jdl
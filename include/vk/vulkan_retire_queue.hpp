@@ -0,0 +1,62 @@
+#pragma once
+
+#include "vulkan_buffer.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Keeps the buffers released outside of the render thread (e.g.
+ * resources removed from the resource manager) alive until the frames in
+ * flight which may use them are finished. Thread-safe.
+ */
+class VulkanRetireQueue : private NonCopyable<VulkanRetireQueue>
+{
+public:
+	VulkanRetireQueue() = default;
+
+	/**
+	 * @brief Destroys the remaining buffers. The device must be idle.
+	 */
+	~VulkanRetireQueue() = default;
+
+	/**
+	 * @brief Retires a buffer. It must not be used by the next recorded
+	 * frames, but may still be used by the frames in flight: it is destroyed
+	 * once they are finished.
+	 * @param buffer Buffer (ignored if null).
+	 */
+	void retire(std::unique_ptr<VulkanBuffer> buffer);
+
+	/**
+	 * @brief Destroys the buffers which are not used by the GPU anymore. Must
+	 * be called once per frame, after waiting for the frame fence.
+	 * @param frame Number of the frame about to be recorded.
+	 * @param nb_frames_in_flight Number of frames in flight.
+	 */
+	void update(uint64_t frame, uint32_t nb_frames_in_flight);
+
+private:
+	struct RetiredBuffer
+	{
+		std::unique_ptr<VulkanBuffer> buffer;
+		uint64_t frame;
+	};
+
+	std::mutex m_mutex;
+	std::deque<RetiredBuffer> m_retired;
+	// Frame passed to the last update()
+	uint64_t m_frame = 0;
+};
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "utils/non_copyable.hpp"
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Content-addressed shader modules: modules are keyed by the hash of
+ * their SPIR-V code, so identical bytecode shares a single reference-counted
+ * module, whatever the file or resource it comes from. Thread-safe.
+ */
+class VulkanShaderModuleCache : private NonCopyable<VulkanShaderModuleCache>
+{
+public:
+	VulkanShaderModuleCache();
+	~VulkanShaderModuleCache();
+
+	/**
+	 * @brief Computes the content hash of SPIR-V code.
+	 * @param code SPIR-V code.
+	 * @param size Code size in bytes.
+	 */
+	static uint64_t Hash(const void* code, size_t size);
+
+	/**
+	 * @brief Returns the module of the code with this content hash, created
+	 * if needed. The module must be released by release().
+	 * @param hash Content hash (see Hash()).
+	 * @param code SPIR-V code (only read if the module is created).
+	 * @param size Code size in bytes.
+	 * @return The module, or VK_NULL_HANDLE if the code is invalid.
+	 */
+	VkShaderModule acquire(uint64_t hash, const void* code, size_t size);
+
+	/**
+	 * @brief Releases a module returned by acquire(). It is destroyed with its
+	 * last reference, so it must not be in use by the GPU anymore.
+	 * @param module Shader module (ignored if VK_NULL_HANDLE).
+	 */
+	void release(VkShaderModule module);
+
+	/**
+	 * @brief Returns the number of distinct modules.
+	 */
+	size_t get_nb_modules() const;
+
+	/**
+	 * @brief Returns the number of acquire() calls which reused a module.
+	 */
+	uint64_t get_nb_hits() const;
+
+private:
+	struct Entry
+	{
+		VkShaderModule module;
+		size_t size;
+		uint32_t nb_references;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<uint64_t, Entry, std::identity> m_entries;
+	std::unordered_map<VkShaderModule, uint64_t> m_hashes;
+	uint64_t m_nbHits = 0;
+};
+
+} // namespace vk
+} // namespace jdl
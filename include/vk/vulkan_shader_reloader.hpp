@@ -0,0 +1,104 @@
+#pragma once
+
+#include "vulkan_pipeline.hpp"
+
+#include "resource/resource_handle.hpp"
+#include "resource/shader.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Shader hot reload without stalling the GPU. A background thread
+ * watches a directory (inotify), creates new modules for the modified
+ * shaders and rebuilds the pipelines using them. The render thread swaps
+ * them in at a frame boundary, and destroys the previous objects once the
+ * frames in flight using them are finished.
+ */
+class VulkanShaderReloader : private NonCopyable<VulkanShaderReloader>
+{
+public:
+	/**
+	 * @brief Starts watching a directory.
+	 * @param directory Directory of the shader files.
+	 */
+	explicit VulkanShaderReloader(const std::string& directory);
+	~VulkanShaderReloader();
+
+	/**
+	 * @brief Returns whether the directory is watched or not.
+	 */
+	bool is_watching() const { return m_thread.joinable(); }
+
+	/**
+	 * @brief Swaps in the reloaded shaders and their rebuilt pipelines, and
+	 * destroys the retired objects. Must be called by the render thread, once
+	 * the fence of the frame about to be recorded has been waited.
+	 * @param frame Number of frames submitted so far.
+	 * @param nb_frames_in_flight Number of frames in flight.
+	 */
+	void update(uint64_t frame, uint32_t nb_frames_in_flight);
+
+private:
+	// Files are reloaded once they stopped changing for this long (editors
+	// and compilers write them in several steps)
+	static constexpr int s_DebounceMs = 50;
+
+	struct ShaderReload
+	{
+		resource::Handle<resource::Shader> shader;
+		VkShaderModule module;
+		uint64_t hash;
+	};
+
+	// Built by the watcher thread, applied by the render thread
+	struct PendingReload
+	{
+		std::vector<ShaderReload> shaders;
+		std::vector<std::unique_ptr<VulkanPipeline>> pipelines;
+	};
+
+	// Previous objects, destroyed once the frames using them are finished
+	struct RetiredObjects
+	{
+		uint64_t frame;
+		std::vector<VkShaderModule> modules;
+		std::vector<std::unique_ptr<VulkanPipeline>> pipelines;
+	};
+
+	std::filesystem::path m_directory;
+	int m_inotify = -1;
+
+	std::thread m_thread;
+	std::atomic<bool> m_stop = false;
+
+	// At most one reload in flight: the next one is built once the modules
+	// of the previous one are swapped, so it rebuilds with the latest modules
+	std::mutex m_mutex;
+	std::condition_variable m_appliedCondition;
+	std::optional<PendingReload> m_pending;
+
+	// Render thread only
+	std::vector<RetiredObjects> m_retired;
+
+	void thread_loop();
+	void read_events(std::unordered_set<std::string>& files);
+	void reload(const std::unordered_set<std::string>& files);
+	void destroy(RetiredObjects& objects);
+};
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "vulkan_buffer.hpp"
+
+#include "utils/non_copyable.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Persistently mapped host-visible buffer used as a ring: regions are
+ * allocated at the head and released in allocation order, once the GPU has
+ * consumed them. Positions are monotonic byte counters, so that a region is
+ * released by giving the head position recorded after its allocation.
+ * Not thread-safe.
+ */
+class VulkanStagingRing : private NonCopyable<VulkanStagingRing>
+{
+public:
+	struct Region
+	{
+		VK_ATTR(VkBuffer, buffer);
+		VkDeviceSize offset = 0;
+		void* data = nullptr;
+
+		bool is_valid() const { return data != nullptr; }
+	};
+
+	/**
+	 * @brief Creates the ring.
+	 * @param size Ring size in bytes.
+	 */
+	VulkanStagingRing(VkDeviceSize size);
+
+	/**
+	 * @brief Returns the ring size in bytes.
+	 */
+	VkDeviceSize get_size() const { return m_size; }
+
+	/**
+	 * @brief Returns the number of bytes currently in use.
+	 */
+	VkDeviceSize get_used_size() const { return m_head - m_tail; }
+
+	/**
+	 * @brief Returns the current head position.
+	 */
+	uint64_t get_head() const { return m_head; }
+
+	/**
+	 * @brief Allocates a contiguous region.
+	 * @param size Region size in bytes.
+	 * @param alignment Region offset alignment (power of 2).
+	 * @return The allocated region, invalid if there is not enough space.
+	 */
+	Region allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+	/**
+	 * @brief Releases all the regions allocated before a head position.
+	 * @param position A head position returned by get_head().
+	 */
+	void release(uint64_t position);
+
+private:
+	std::unique_ptr<VulkanBuffer> m_buffer;
+	VkDeviceSize m_size = 0;
+
+	uint64_t m_head = 0;
+	uint64_t m_tail = 0;
+};
+
+} // namespace vk
+} // namespace jdl
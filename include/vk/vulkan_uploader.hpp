@@ -0,0 +1,188 @@
+#pragma once
+
+#include "vulkan_buffer.hpp"
+#include "vulkan_command_buffer.hpp"
+#include "vulkan_image.hpp"
+#include "vulkan_staging_ring.hpp"
+
+#include "utils/non_copyable.hpp"
+
+#include <deque>
+#include <mutex>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+/**
+ * @brief Identifies the batch of an upload. The uploaded data can be used
+ * by the graphics queue once the token is complete.
+ */
+struct UploadToken
+{
+	uint64_t value = 0;
+
+	bool is_valid() const { return value != 0; }
+};
+
+/**
+ * @brief Upload scheduler. Uploads are copied into a staging ring, and the
+ * copies are batched and submitted on the transfer queue, so that streaming
+ * data never stalls the graphics queue. When the transfer queue belongs to
+ * another family, the ownership of the destination resources is released by
+ * the transfer queue and acquired by the graphics queue once the copies are
+ * done. Upload calls are thread-safe and never submit anything; flush(),
+ * update() and the wait functions submit to the queues and must be called
+ * from the rendering thread.
+ */
+class VulkanUploader : private NonCopyable<VulkanUploader>
+{
+public:
+	static constexpr VkDeviceSize s_DefaultStagingSize = 64ull * 1024 * 1024;
+
+	/**
+	 * @brief Creates the uploader.
+	 * @param staging_size Size of the staging ring. Larger uploads get their
+	 * own temporary staging buffer.
+	 */
+	VulkanUploader(VkDeviceSize staging_size = s_DefaultStagingSize);
+
+	/**
+	 * @brief Waits for all the uploads and destroys the uploader.
+	 */
+	~VulkanUploader();
+
+	/**
+	 * @brief Schedules a buffer upload.
+	 * @param dst Destination buffer.
+	 * @param data Source data, copied before returning.
+	 * @param size Number of bytes to upload.
+	 * @param dst_offset Destination offset.
+	 * @param dst_stages Pipeline stages which will read the buffer.
+	 * @param dst_access Accesses which will read the buffer.
+	 * @return The token of the upload batch.
+	 */
+	UploadToken upload_buffer(
+		const VulkanBuffer& dst,
+		const void* data,
+		VkDeviceSize size,
+		VkDeviceSize dst_offset = 0,
+		VkPipelineStageFlags2 dst_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		VkAccessFlags2 dst_access = VK_ACCESS_2_MEMORY_READ_BIT
+	);
+
+	/**
+	 * @brief Schedules an image upload into the first mip level of all the
+	 * image layers. The previous content of the image is discarded.
+	 * @param dst Destination image.
+	 * @param data Source texels, tightly packed, copied before returning.
+	 * @param size Number of bytes to upload.
+	 * @param final_layout Layout of the image once uploaded.
+	 * @return The token of the upload batch.
+	 */
+	UploadToken upload_image(
+		const VulkanImage& dst,
+		const void* data,
+		VkDeviceSize size,
+		VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	);
+
+	/**
+	 * @brief Submits the pending uploads to the transfer queue.
+	 * @return The token of the submitted batch, invalid if nothing was pending.
+	 */
+	UploadToken flush();
+
+	/**
+	 * @brief Submits the pending uploads, acquires the resources of the
+	 * finished batches on the graphics queue and recycles their staging
+	 * memory. Must be called once per frame.
+	 */
+	void update();
+
+	/**
+	 * @brief Returns whether an upload batch is complete or not.
+	 * @param token The token of the batch.
+	 */
+	bool is_complete(UploadToken token) const;
+
+	/**
+	 * @brief Waits for an upload batch to complete.
+	 * @param token The token of the batch.
+	 */
+	void wait(UploadToken token);
+
+	/**
+	 * @brief Waits for all the upload batches to complete.
+	 */
+	void wait_idle();
+
+private:
+	struct Batch
+	{
+		uint64_t value = 0;
+
+		std::unique_ptr<VulkanCommandBuffer> transfer_commands;
+		std::unique_ptr<VulkanCommandBuffer> acquire_commands;
+
+		// Barriers recorded at the end of the transfer commands (ownership
+		// releases, or final barriers without ownership transfer)
+		std::vector<VkBufferMemoryBarrier2> buffer_releases;
+		std::vector<VkImageMemoryBarrier2> image_releases;
+
+		// Ownership acquisitions to record on the graphics queue
+		std::vector<VkBufferMemoryBarrier2> buffer_acquires;
+		std::vector<VkImageMemoryBarrier2> image_acquires;
+
+		// Staging memory to release once the batch is complete
+		uint64_t staging_position = 0;
+		std::vector<std::unique_ptr<VulkanBuffer>> large_stagings;
+
+		bool acquire_submitted = false;
+	};
+
+	VK_ATTR(VkDevice, m_device);
+	VK_ATTR(VkQueue, m_transferQueue);
+	VK_ATTR(VkQueue, m_graphicsQueue);
+
+	uint32_t m_transferFamily = UINT32_MAX;
+	uint32_t m_graphicsFamily = UINT32_MAX;
+	bool m_ownershipTransfer = false;
+
+	VK_ATTR(VkCommandPool, m_transferPool);
+	VK_ATTR(VkCommandPool, m_graphicsPool);
+
+	// Signaled by the transfer queue (and by the graphics queue after the
+	// ownership acquisitions) with the batch values
+	VK_ATTR(VkSemaphore, m_transferSemaphore);
+	VK_ATTR(VkSemaphore, m_acquireSemaphore);
+
+	mutable std::mutex m_mutex;
+
+	std::unique_ptr<VulkanStagingRing> m_stagingRing;
+
+	Batch m_openBatch;
+	std::deque<Batch> m_submittedBatches;
+	uint64_t m_nextValue = 1;
+
+	std::vector<std::unique_ptr<VulkanCommandBuffer>> m_freeTransferCommands;
+	std::vector<std::unique_ptr<VulkanCommandBuffer>> m_freeAcquireCommands;
+
+	VkSemaphore get_completion_semaphore() const {
+		return m_ownershipTransfer ? m_acquireSemaphore : m_transferSemaphore;
+	}
+
+	uint64_t get_semaphore_value(VkSemaphore semaphore) const;
+
+	VulkanCommandBuffer& get_transfer_commands();
+	VulkanStagingRing::Region allocate_staging(VkDeviceSize size);
+
+	UploadToken flush_locked();
+	void submit_acquire(Batch& batch);
+	void process_batches();
+};
+
+} // namespace vk
+} // namespace jdl
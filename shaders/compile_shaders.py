@@ -1,6 +1,7 @@
 import argparse
 import logging
 import os
+import re
 import shutil
 import subprocess
 
@@ -30,6 +31,13 @@ def get_slang_compiler() -> str:
         raise NotImplementedError(f"Unsupported platform: {os.name}")
 
 
+def get_entry_points(shader_path: str) -> list[str]:
+    # Functions preceded by a [shader("<stage>")] attribute
+    with open(shader_path, "r", encoding="utf-8") as f:
+        source: str = f.read()
+    return re.findall(r'\[shader\("\w+"\)\](?:\s*\[[^\]]*\])*\s*\w+\s+(\w+)\s*\(', source)
+
+
 def syntax() -> argparse.ArgumentParser:
     parser = argparse.ArgumentParser(description="Compiles Slang shaders to SPIR-V")
     parser.add_argument(
@@ -68,10 +76,10 @@ def main() -> None:
             "-profile", "spirv_1_4",
             "-emit-spirv-directly",
             "-fvk-use-entrypoint-name",
-            "-entry", "vert_main",
-            "-entry", "frag_main",
-            "-o", f"{path_split[0]}.spv",
         ]
+        for entry_point in get_entry_points(shader_path):
+            compiler_args.extend(["-entry", entry_point])
+        compiler_args.extend(["-o", f"{path_split[0]}.spv"])
         subprocess.Popen(compiler_args)
 
 
@@ -4,6 +4,8 @@
 
 #include "utils/logger.hpp"
 
+#include <chrono>
+
 
 namespace jdl
 {
@@ -13,7 +15,7 @@ namespace core
 Application* Application::s_Application = nullptr;
 const char* Application::s_Name = nullptr;
 
-Application::Application(const char* name, int width, int height)
+Application::Application(const char* name, int width, int height, bool headless)
 {
     if (s_Application != nullptr) {
         JDL_FATAL("The application has already been created");
@@ -21,8 +23,19 @@ Application::Application(const char* name, int width, int height)
     s_Application = this;
     s_Name = name;
 
-    m_window = std::make_unique<Window>(name, width, height);
-    m_renderer = std::make_unique<vk::VulkanRenderer>();
+    vk::VulkanRendererSettings settings;
+    settings.context.headless = headless;
+    settings.headless_extent = {
+        static_cast<uint32_t>(width), static_cast<uint32_t>(height)
+    };
+
+    // Created first: every other system may run jobs
+    m_jobSystem = std::make_unique<JobSystem>();
+
+    if (!headless) {
+        m_window = std::make_unique<Window>(name, width, height);
+    }
+    m_renderer = std::make_unique<vk::VulkanRenderer>(settings);
 }
 
 Application::~Application()
@@ -34,15 +47,47 @@ Application::~Application()
 
     m_renderer.reset();
     m_window.reset();
+    m_jobSystem.reset();
+}
+
+bool Application::is_running() const
+{
+    if (m_quitRequested) {
+        return false;
+    }
+    return m_window == nullptr || m_window->is_running();
 }
 
-void Application::run()
+void Application::run(uint64_t nb_frames)
 {
-    while (m_window->is_running())
+    auto start_time = std::chrono::steady_clock::now();
+
+    uint64_t frame = 0;
+    while (is_running() && (nb_frames == 0 || frame < nb_frames))
     {
-        m_window->poll_events();
+        if (m_window != nullptr) {
+            m_window->poll_events();
+        }
+
+        // Safe point: the asynchronously loaded resources create their GPU objects
+        resource::ResourceManager::Update();
+
+        update();
+
         m_renderer->render_frame();
+        ++frame;
+    }
+    m_renderer->flush_readbacks();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    if (frame > 0 && elapsed.count() > 0.0)
+    {
+        JDL_INFO(
+            "{} frames rendered in {:.3f}s ({:.1f} FPS)",
+            frame, elapsed.count(), frame / elapsed.count()
+        );
     }
+    vk::VulkanContext::GetAllocator().log_stats();
 }
 
 void Application::resize_event(const ResizeEvent& event)
@@ -0,0 +1,306 @@
+#include "core/job_system.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+
+
+namespace jdl
+{
+namespace core
+{
+
+struct Job
+{
+    JobSystem::JobFunction function;
+    JobCounter* counter = nullptr;
+};
+
+// Number of failed job searches before a worker goes to sleep
+static constexpr uint32_t s_NbSpinsBeforeSleep = 64;
+
+JobSystem* JobSystem::s_JobSystem = nullptr;
+
+static thread_local uint32_t s_ThreadIndex = JobSystem::s_InvalidThreadIndex;
+
+JobSystem::JobSystem(uint32_t nb_workers)
+{
+    if (s_JobSystem != nullptr) {
+        JDL_FATAL("The job system has already been created");
+    }
+    s_JobSystem = this;
+
+    if (nb_workers == 0) {
+        nb_workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    m_queues.resize(nb_workers + 1);
+    for (auto& queue : m_queues) {
+        queue = std::make_unique<utils::WorkStealingDeque<Job*>>();
+    }
+
+    s_ThreadIndex = 0;
+    m_workers.reserve(nb_workers);
+    for (uint32_t i = 1; i <= nb_workers; ++i) {
+        m_workers.emplace_back(&JobSystem::worker_loop, this, i);
+    }
+
+    JDL_INFO("Job System: OK ({} workers)", nb_workers);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_sleepCondition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+
+    s_ThreadIndex = s_InvalidThreadIndex;
+    s_JobSystem = nullptr;
+}
+
+uint32_t JobSystem::GetThreadIndex()
+{
+    return s_ThreadIndex;
+}
+
+void JobSystem::run(JobFunction function, JobCounter* counter)
+{
+    if (counter != nullptr) {
+        counter->m_value.fetch_add(1, std::memory_order_relaxed);
+    }
+    submit(new Job { std::move(function), counter });
+}
+
+void JobSystem::run_after(JobCounter& dependency, JobFunction function, JobCounter* counter)
+{
+    if (counter != nullptr) {
+        counter->m_value.fetch_add(1, std::memory_order_relaxed);
+    }
+    Job* job = new Job { std::move(function), counter };
+
+    {
+        // Checked under the lock: the counter cannot release its
+        // continuations in the meantime
+        std::lock_guard lock(dependency.m_mutex);
+        if (!dependency.is_done())
+        {
+            dependency.m_continuations.push_back(job);
+            return;
+        }
+    }
+    submit(job);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    uint32_t thread_index = s_ThreadIndex;
+
+    while (!counter.is_done())
+    {
+        // Helps instead of blocking (only the threads owning a deque)
+        Job* job = thread_index != s_InvalidThreadIndex ? find_job(thread_index) : nullptr;
+        if (job != nullptr) {
+            execute(job);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    // The last job decrements the counter under its lock: once the lock is
+    // acquired, the counter is not used anymore and can be destroyed
+    std::lock_guard lock(counter.m_mutex);
+
+    if (counter.m_exception)
+    {
+        std::exception_ptr exception = counter.m_exception;
+        counter.m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t batch_size, const RangeFunction& function)
+{
+    if (count == 0) {
+        return;
+    }
+    if (batch_size == 0)
+    {
+        // A few batches per thread, so that stealing can balance the load
+        batch_size = std::max(1u, count / (get_nb_threads() * 4));
+    }
+
+    JobCounter counter;
+    for (uint32_t begin = batch_size; begin < count; begin += batch_size)
+    {
+        uint32_t end = std::min(begin + batch_size, count);
+        run([&function, begin, end] { function(begin, end); }, &counter);
+    }
+
+    // The calling thread takes the first batch. The other batches reference
+    // the function and the counter: they must finish even if it throws
+    std::exception_ptr exception;
+    try {
+        function(0, std::min(batch_size, count));
+    }
+    catch (...) {
+        exception = std::current_exception();
+    }
+
+    try {
+        wait(counter);
+    }
+    catch (...)
+    {
+        if (!exception) {
+            exception = std::current_exception();
+        }
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::submit(Job* job)
+{
+    m_nbPendingJobs.fetch_add(1, std::memory_order_seq_cst);
+
+    uint32_t thread_index = s_ThreadIndex;
+    if (thread_index == s_InvalidThreadIndex || !m_queues[thread_index]->push(job))
+    {
+        std::lock_guard lock(m_injectedMutex);
+        m_injectedJobs.push_back(job);
+        m_nbInjectedJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    // A worker increments the sleeping count before checking for pending
+    // jobs: either it sees this job, or this thread sees it sleeping
+    if (m_nbSleepingWorkers.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::lock_guard lock(m_sleepMutex);
+        }
+        m_sleepCondition.notify_one();
+    }
+}
+
+Job* JobSystem::find_job(uint32_t thread_index)
+{
+    Job* job = nullptr;
+
+    // Own jobs first (most recent, hot in cache)
+    if (m_queues[thread_index]->pop(job)) {
+        return job;
+    }
+
+    // Jobs submitted from outside
+    if (m_nbInjectedJobs.load(std::memory_order_acquire) > 0)
+    {
+        std::lock_guard lock(m_injectedMutex);
+        if (!m_injectedJobs.empty())
+        {
+            job = m_injectedJobs.back();
+            m_injectedJobs.pop_back();
+            m_nbInjectedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    // Steals the oldest job of another thread, starting with the next one
+    uint32_t nb_queues = static_cast<uint32_t>(m_queues.size());
+    for (uint32_t i = 1; i < nb_queues; ++i)
+    {
+        uint32_t victim = (thread_index + i) % nb_queues;
+        if (m_queues[victim]->steal(job)) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(Job* job)
+{
+    m_nbPendingJobs.fetch_sub(1, std::memory_order_relaxed);
+
+    try {
+        job->function();
+    }
+    catch (...)
+    {
+        if (job->counter != nullptr)
+        {
+            std::lock_guard lock(job->counter->m_mutex);
+            if (!job->counter->m_exception) {
+                job->counter->m_exception = std::current_exception();
+            }
+        }
+        else {
+            JDL_ERROR("Unhandled exception in a job without counter");
+        }
+    }
+
+    JobCounter* counter = job->counter;
+    delete job;
+
+    if (counter != nullptr) {
+        finish(*counter);
+    }
+}
+
+void JobSystem::finish(JobCounter& counter)
+{
+    std::vector<Job*> continuations;
+    {
+        std::lock_guard lock(counter.m_mutex);
+        if (counter.m_value.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+
+        // Last job: releases the jobs depending on the counter
+        continuations.swap(counter.m_continuations);
+    }
+    for (Job* job : continuations) {
+        submit(job);
+    }
+}
+
+void JobSystem::worker_loop(uint32_t thread_index)
+{
+    s_ThreadIndex = thread_index;
+    uint32_t nb_spins = 0;
+
+    while (!m_stop.load(std::memory_order_relaxed))
+    {
+        Job* job = find_job(thread_index);
+        if (job != nullptr)
+        {
+            execute(job);
+            nb_spins = 0;
+            continue;
+        }
+
+        if (++nb_spins < s_NbSpinsBeforeSleep)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+        m_nbSleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        m_sleepCondition.wait(lock, [this] {
+            return m_stop.load() || m_nbPendingJobs.load(std::memory_order_seq_cst) > 0;
+        });
+        m_nbSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        nb_spins = 0;
+    }
+}
+
+} // namespace core
+} // namespace jdl
@@ -1,18 +1,210 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "core/application.hpp"
 
+#include "resource/gltf_importer.hpp"
+#include "resource/resource_manager.hpp"
+
 #include "utils/logger.hpp"
 
 using namespace jdl;
 
+using Matrix = std::array<float, 16>;
+using Vector = std::array<float, 3>;
+
+// Column-major matrix product
+static Matrix s_Multiply(const Matrix& a, const Matrix& b)
+{
+    Matrix result {};
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int k = 0; k < 4; ++k) {
+                result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+            }
+        }
+    }
+    return result;
+}
+
+static Vector s_Normalize(const Vector& v)
+{
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    return { v[0] / length, v[1] / length, v[2] / length };
+}
+
+static Vector s_Cross(const Vector& a, const Vector& b)
+{
+    return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+static float s_Dot(const Vector& a, const Vector& b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Right-handed view matrix
+static Matrix s_LookAt(const Vector& eye, const Vector& target, const Vector& up)
+{
+    Vector f = s_Normalize({ target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] });
+    Vector s = s_Normalize(s_Cross(f, up));
+    Vector u = s_Cross(s, f);
+    return {
+        s[0], u[0], -f[0], 0.0f,
+        s[1], u[1], -f[1], 0.0f,
+        s[2], u[2], -f[2], 0.0f,
+        -s_Dot(s, eye), -s_Dot(u, eye), s_Dot(f, eye), 1.0f
+    };
+}
+
+// Perspective projection to the Vulkan clip space (y down, depth in [0, 1])
+static Matrix s_Perspective(float fov_y, float aspect, float near, float far)
+{
+    float f = 1.0f / std::tan(0.5f * fov_y);
+    return {
+        f / aspect, 0.0f, 0.0f, 0.0f,
+        0.0f, -f, 0.0f, 0.0f,
+        0.0f, 0.0f, far / (near - far), -1.0f,
+        0.0f, 0.0f, near * far / (near - far), 0.0f
+    };
+}
+
 
 class Sandbox : public core::Application
 {
 public:
-    Sandbox(const char* name, int width, int height)
-        : core::Application(name, width, height)
-    {}
+    Sandbox(const char* name, int width, int height, bool headless)
+        : core::Application(name, width, height, headless)
+        , m_aspect(static_cast<float>(width) / static_cast<float>(height))
+    {
+        m_defaultMesh = resource::ResourceManager::GetHandle<resource::Mesh>("__DEFAULT_MESH__");
+    }
+
+    /**
+     * @brief Starts importing a glTF scene, its meshes appear progressively.
+     * @param path .gltf or .glb file path.
+     */
+    void import_scene(const std::string& path)
+    {
+        m_importer = std::make_unique<resource::GltfImporter>(path);
+    }
+
+protected:
+    void update() override
+    {
+        // The default mesh is drawn over the scene
+        GetRenderer().get_draw_queue().submit({
+            .pass = vk::VulkanRenderer::s_MainPass,
+            .pipeline = &vk::VulkanContext::GetPipeline(),
+            .mesh = m_defaultMesh
+        });
+
+        if (m_importer == nullptr) {
+            return;
+        }
+
+        // Every primitive of every node becomes an object of the GPU scene,
+        // drawn once its mesh is ready
+        auto& scene = GetRenderer().get_scene();
+        if (!m_sceneAdded && m_importer->get_state() == resource::ImportState::eDone)
+        {
+            const auto& reader = m_importer->get_reader();
+            for (const auto& node : reader.get_nodes())
+            {
+                if (node.mesh == resource::s_GltfInvalidIndex) {
+                    continue;
+                }
+
+                const auto& mesh = reader.get_meshes()[node.mesh];
+                for (uint32_t i = 0; i < mesh.nb_primitives; ++i)
+                {
+                    vk::GpuSceneObject object;
+                    object.transform = node.world_transform;
+                    object.lods[0] = m_importer->get_mesh(mesh.first_primitive + i);
+                    if (object.lods[0].is_valid()) {
+                        scene.add_object(object);
+                        m_objects.push_back(object);
+                    }
+                }
+            }
+            m_sceneAdded = true;
+        }
+
+        // Frames the scene once all its meshes are uploaded
+        if (m_sceneAdded && !m_sceneFramed && scene.get_nb_gpu_objects() == scene.get_nb_objects()) {
+            frame_scene();
+        }
+
+        // Orbits around the scene
+        if (m_sceneFramed)
+        {
+            m_angle += 0.005f;
+            Vector eye {
+                m_center[0] + m_distance * std::sin(m_angle),
+                m_center[1] + 0.3f * m_distance,
+                m_center[2] + m_distance * std::cos(m_angle)
+            };
+            Matrix view = s_LookAt(eye, m_center, { 0.0f, 1.0f, 0.0f });
+            Matrix projection = s_Perspective(0.8f, m_aspect, 0.01f * m_distance, 10.0f * m_distance);
+            scene.set_camera(s_Multiply(projection, view), eye);
+        }
+    }
+
+private:
+    resource::Handle<resource::Mesh> m_defaultMesh;
+    std::unique_ptr<resource::GltfImporter> m_importer;
+    std::vector<vk::GpuSceneObject> m_objects;
+    bool m_sceneAdded = false;
+    bool m_sceneFramed = false;
+
+    float m_aspect = 1.0f;
+    Vector m_center {};
+    float m_distance = 1.0f;
+    float m_angle = 0.0f;
+
+    void frame_scene()
+    {
+        // Bounds of the world space bounding spheres
+        Vector min { INFINITY, INFINITY, INFINITY };
+        Vector max { -INFINITY, -INFINITY, -INFINITY };
+
+        auto guard = resource::ResourceManager::Pin();
+        for (const auto& object : m_objects)
+        {
+            const auto* mesh = resource::ResourceManager::Get(object.lods[0]);
+            if (mesh == nullptr) {
+                continue;
+            }
+
+            const auto& bounds = mesh->get_bounds();
+            const auto& m = object.transform;
+            float radius = std::sqrt(s_Dot(bounds.extent, bounds.extent)) * std::max({
+                std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]),
+                std::sqrt(m[4] * m[4] + m[5] * m[5] + m[6] * m[6]),
+                std::sqrt(m[8] * m[8] + m[9] * m[9] + m[10] * m[10])
+            });
+            for (int i = 0; i < 3; ++i)
+            {
+                float center = m[i] * bounds.center[0] + m[4 + i] * bounds.center[1] + m[8 + i] * bounds.center[2] + m[12 + i];
+                min[i] = std::min(min[i], center - radius);
+                max[i] = std::max(max[i], center + radius);
+            }
+        }
+
+        if (min[0] <= max[0])
+        {
+            m_center = { 0.5f * (min[0] + max[0]), 0.5f * (min[1] + max[1]), 0.5f * (min[2] + max[2]) };
+            Vector half { 0.5f * (max[0] - min[0]), 0.5f * (max[1] - min[1]), 0.5f * (max[2] - min[2]) };
+            m_distance = std::max(2.0f * std::sqrt(s_Dot(half, half)), 0.001f);
+        }
+        m_sceneFramed = true;
+    }
 };
 
 
@@ -22,8 +214,40 @@ int main(int argc, char** argv)
     {
         utils::Logger::Init();
 
-        Sandbox application("JDLEngine", 800, 600);
-        application.run();
+        // --headless: renders offscreen / --frames N: stops after N frames
+        // --gpu-profile <path>: dumps the GPU profiler stats to a JSON file
+        // --scene <path>: imports a glTF scene (.gltf or .glb)
+        bool headless = false;
+        uint64_t nb_frames = 0;
+        std::string gpu_profile_path;
+        std::string scene_path;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--headless") {
+                headless = true;
+            }
+            else if (arg == "--frames" && i + 1 < argc) {
+                nb_frames = std::stoull(argv[++i]);
+            }
+            else if (arg == "--gpu-profile" && i + 1 < argc) {
+                gpu_profile_path = argv[++i];
+            }
+            else if (arg == "--scene" && i + 1 < argc) {
+                scene_path = argv[++i];
+            }
+        }
+
+        Sandbox application("JDLEngine", 800, 600, headless);
+        if (!scene_path.empty()) {
+            application.import_scene(scene_path);
+        }
+        application.run(nb_frames);
+
+        if (!gpu_profile_path.empty()) {
+            application.GetRenderer().get_profiler().dump_json(gpu_profile_path);
+        }
 
         return EXIT_SUCCESS;
     }
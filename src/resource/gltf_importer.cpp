@@ -0,0 +1,87 @@
+#include "resource/gltf_importer.hpp"
+#include "resource/resource_manager.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+GltfImporter::GltfImporter(const std::string& path, bool full_precision)
+	: m_path(path)
+	, m_fullPrecision(full_precision)
+	, m_startTime(std::chrono::steady_clock::now())
+{
+	core::JobSystem::Get().run([this] { parse(); }, &m_jobs);
+}
+
+GltfImporter::~GltfImporter()
+{
+	// The jobs reference the importer and its mapped buffers
+	core::JobSystem::Get().wait(m_jobs);
+}
+
+void GltfImporter::parse()
+{
+	if (!m_reader.open(m_path))
+	{
+		m_state.store(ImportState::eFailed, std::memory_order_release);
+		return;
+	}
+
+	uint32_t nb_primitives = static_cast<uint32_t>(m_reader.get_primitives().size());
+	m_meshes = std::make_unique<std::atomic<uint32_t>[]>(nb_primitives);
+	m_state.store(nb_primitives > 0 ? ImportState::eDecoding : ImportState::eDone, std::memory_order_release);
+
+	// One job per primitive: the first meshes are ready while the others
+	// are still decoded
+	for (uint32_t primitive = 0; primitive < nb_primitives; ++primitive) {
+		core::JobSystem::Get().run([this, primitive] { decode(primitive); }, &m_jobs);
+	}
+}
+
+void GltfImporter::decode(uint32_t primitive)
+{
+	VertexData vertices;
+	std::vector<uint32_t> indices;
+	if (m_reader.decode_primitive(primitive, vertices, indices))
+	{
+		// <file>/<mesh>/<primitive>, the manager makes the name unique
+		const auto& meshes = m_reader.get_meshes();
+		auto mesh = std::find_if(meshes.begin(), meshes.end(), [primitive](const GltfMesh& mesh) {
+			return primitive >= mesh.first_primitive && primitive < mesh.first_primitive + mesh.nb_primitives;
+		});
+		std::string name = std::filesystem::path(m_path).stem().string() + "/"
+			+ (mesh->name.empty() ? std::to_string(mesh - meshes.begin()) : mesh->name) + "/"
+			+ std::to_string(primitive - mesh->first_primitive);
+
+		// Encoded by the resource loader, uploaded by ResourceManager::Update()
+		VertexLayout layout = VertexLayout::ForData(vertices, m_fullPrecision);
+		Handle<Mesh> handle = ResourceManager::CreateAsync<Mesh>(name, std::move(vertices), std::move(indices), layout);
+		m_meshes[primitive].store(handle.get_value(), std::memory_order_release);
+	}
+	else {
+		m_nbFailed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// The last primitive completes the import
+	uint32_t nb_decoded = m_nbDecoded.fetch_add(1, std::memory_order_acq_rel) + 1;
+	if (nb_decoded == m_reader.get_primitives().size())
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_startTime;
+		JDL_INFO(
+			"Imported {}: {} primitives ({} failed), {} nodes, {} materials in {:.3f}s",
+			m_path, nb_decoded, m_nbFailed.load(std::memory_order_relaxed),
+			m_reader.get_nodes().size(), m_reader.get_materials().size(), elapsed.count()
+		);
+		m_state.store(ImportState::eDone, std::memory_order_release);
+	}
+}
+
+} // namespace resource
+} // namespace jdl
@@ -0,0 +1,1177 @@
+#include "resource/gltf_reader.hpp"
+
+#include "utils/json_reader.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+// .glb container (little-endian)
+static constexpr uint32_t s_GlbMagic = 0x46546c67;		// "glTF"
+static constexpr uint32_t s_GlbJsonChunk = 0x4e4f534a;	// "JSON"
+static constexpr uint32_t s_GlbBinChunk = 0x004e4942;	// "BIN\0"
+
+// Accessor component types
+static constexpr uint32_t s_Int8 = 5120;
+static constexpr uint32_t s_Uint8 = 5121;
+static constexpr uint32_t s_Int16 = 5122;
+static constexpr uint32_t s_Uint16 = 5123;
+static constexpr uint32_t s_Uint32 = 5125;
+static constexpr uint32_t s_Float = 5126;
+
+static constexpr std::array<float, 16> s_Identity {
+	1.0f, 0.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f, 0.0f,
+	0.0f, 0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 0.0f, 1.0f
+};
+
+static uint32_t s_GetComponentSize(uint32_t component_type)
+{
+	switch (component_type)
+	{
+		case s_Int8:
+		case s_Uint8: return 1;
+		case s_Int16:
+		case s_Uint16: return 2;
+		case s_Uint32:
+		case s_Float: return 4;
+		default: return 0;
+	}
+}
+
+static uint32_t s_GetNbComponents(std::string_view type)
+{
+	if (type == "SCALAR") return 1;
+	if (type == "VEC2") return 2;
+	if (type == "VEC3") return 3;
+	if (type == "VEC4") return 4;
+	if (type == "MAT2") return 4;
+	if (type == "MAT3") return 9;
+	if (type == "MAT4") return 16;
+	return 0;
+}
+
+// Reads one component as a float, normalized integers are mapped to [0, 1]
+// or [-1, 1]
+static float s_ReadComponent(const std::byte* src, uint32_t component_type, bool normalized)
+{
+	auto read = [src]<class T>(T) {
+		T value;
+		std::memcpy(&value, src, sizeof(T));
+		return value;
+	};
+
+	switch (component_type)
+	{
+		case s_Int8:
+		{
+			float value = read(int8_t());
+			return normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case s_Uint8:
+		{
+			float value = read(uint8_t());
+			return normalized ? value / 255.0f : value;
+		}
+		case s_Int16:
+		{
+			float value = read(int16_t());
+			return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+		}
+		case s_Uint16:
+		{
+			float value = read(uint16_t());
+			return normalized ? value / 65535.0f : value;
+		}
+		case s_Uint32:
+			return static_cast<float>(read(uint32_t()));
+		default:
+			return read(float());
+	}
+}
+
+// Decodes the percent-encoded characters of a relative URI
+static std::string s_DecodeUri(std::string_view uri)
+{
+	std::string path;
+	path.reserve(uri.size());
+	for (size_t i = 0; i < uri.size(); ++i)
+	{
+		if (uri[i] == '%' && i + 2 < uri.size())
+		{
+			int value = 0;
+			auto [ptr, ec] = std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16);
+			if (ec == std::errc() && ptr == uri.data() + i + 3)
+			{
+				path += static_cast<char>(value);
+				i += 2;
+				continue;
+			}
+		}
+		path += uri[i];
+	}
+	return path;
+}
+
+static bool s_DecodeBase64(std::string_view text, std::vector<std::byte>& data)
+{
+	auto decode = [](char c) -> int {
+		if (c >= 'A' && c <= 'Z') return c - 'A';
+		if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+		if (c >= '0' && c <= '9') return c - '0' + 52;
+		if (c == '+') return 62;
+		if (c == '/') return 63;
+		return -1;
+	};
+
+	while (!text.empty() && text.back() == '=') {
+		text.remove_suffix(1);
+	}
+
+	data.clear();
+	data.reserve(text.size() * 3 / 4);
+
+	uint32_t bits = 0;
+	uint32_t nb_bits = 0;
+	for (char c : text)
+	{
+		int value = decode(c);
+		if (value < 0) {
+			return false;
+		}
+		bits = (bits << 6) | static_cast<uint32_t>(value);
+		nb_bits += 6;
+		if (nb_bits >= 8)
+		{
+			nb_bits -= 8;
+			data.push_back(static_cast<std::byte>((bits >> nb_bits) & 0xff));
+		}
+	}
+	return true;
+}
+
+// Decodes a base64 "data:" URI, returns false if the URI is not one
+static bool s_IsDataUri(std::string_view uri, std::string_view& base64)
+{
+	static constexpr std::string_view s_Base64Marker = ";base64,";
+	if (!uri.starts_with("data:")) {
+		return false;
+	}
+	size_t marker = uri.find(s_Base64Marker);
+	base64 = marker != std::string_view::npos ? uri.substr(marker + s_Base64Marker.size()) : std::string_view();
+	return true;
+}
+
+static std::array<float, 16> s_Multiply(const std::array<float, 16>& a, const std::array<float, 16>& b)
+{
+	std::array<float, 16> result {};
+	for (size_t column = 0; column < 4; ++column)
+	{
+		for (size_t row = 0; row < 4; ++row)
+		{
+			float sum = 0.0f;
+			for (size_t k = 0; k < 4; ++k) {
+				sum += a[k * 4 + row] * b[column * 4 + k];
+			}
+			result[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+// T * R * S, column-major
+static std::array<float, 16> s_ComposeTransform(
+	const std::array<float, 3>& translation,
+	const std::array<float, 4>& rotation,
+	const std::array<float, 3>& scale
+)
+{
+	auto [x, y, z, w] = rotation;
+	std::array<float, 16> matrix {
+		1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f,
+		2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f,
+		2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+		translation[0], translation[1], translation[2], 1.0f
+	};
+	for (size_t column = 0; column < 3; ++column)
+	{
+		for (size_t row = 0; row < 3; ++row) {
+			matrix[column * 4 + row] *= scale[column];
+		}
+	}
+	return matrix;
+}
+
+// --- DOCUMENT ---
+
+bool GltfReader::open(const std::string& path)
+{
+	m_path = path;
+	m_directory = std::filesystem::path(path).parent_path().string();
+
+	if (!m_file.open(path))
+	{
+		JDL_ERROR("Failed to read glTF file {}", path);
+		return false;
+	}
+
+	const std::byte* data = m_file.get_data();
+	size_t size = m_file.get_size();
+	auto read_u32 = [data](size_t offset) {
+		uint32_t value;
+		std::memcpy(&value, data + offset, sizeof(value));
+		return value;
+	};
+
+	std::string_view json(reinterpret_cast<const char*>(data), size);
+	if (size >= 12 && read_u32(0) == s_GlbMagic)
+	{
+		// Header, JSON chunk, optional binary chunk
+		if (read_u32(4) != 2 || read_u32(8) > size || size < 20 || read_u32(16) != s_GlbJsonChunk)
+		{
+			JDL_ERROR("Invalid glb file {}", path);
+			return false;
+		}
+		size = read_u32(8);
+
+		uint64_t json_size = read_u32(12);
+		if (20 + json_size > size)
+		{
+			JDL_ERROR("Invalid glb file {}: truncated JSON chunk", path);
+			return false;
+		}
+		json = std::string_view(reinterpret_cast<const char*>(data + 20), json_size);
+
+		// Chunks are aligned on 4 bytes
+		uint64_t bin_offset = 20 + ((json_size + 3) & ~3ull);
+		if (bin_offset + 8 <= size && read_u32(bin_offset + 4) == s_GlbBinChunk)
+		{
+			uint64_t bin_size = read_u32(bin_offset);
+			if (bin_offset + 8 + bin_size > size)
+			{
+				JDL_ERROR("Invalid glb file {}: truncated binary chunk", path);
+				return false;
+			}
+			m_glbChunk = { data + bin_offset + 8, static_cast<size_t>(bin_size) };
+		}
+	}
+
+	return parse_document(json);
+}
+
+bool GltfReader::parse_document(std::string_view json)
+{
+	utils::JsonReader reader(json);
+	std::vector<std::string> buffer_uris;
+	std::vector<std::string> image_uris;
+	std::vector<uint32_t> image_views;
+	bool has_default_scene = false;
+
+	// Single pass over the top-level members, in any order: the references
+	// between the tables are resolved afterwards
+	reader.begin_object();
+	std::string_view key;
+	while (reader.next_member(key))
+	{
+		if (key == "asset")
+		{
+			reader.begin_object();
+			std::string_view asset_key;
+			while (reader.next_member(asset_key))
+			{
+				std::string_view version;
+				if (asset_key == "version" && reader.read_raw_string(version))
+				{
+					if (!version.starts_with("2."))
+					{
+						JDL_ERROR("{}: unsupported glTF version {}", m_path, version);
+						return false;
+					}
+				}
+				else {
+					reader.skip();
+				}
+			}
+		}
+		else if (key == "extensionsRequired")
+		{
+			reader.begin_array();
+			while (reader.next_element())
+			{
+				std::string_view extension;
+				reader.read_raw_string(extension);
+
+				// Quantized attributes are decoded like any other accessor
+				if (extension != "KHR_mesh_quantization")
+				{
+					JDL_ERROR("{}: unsupported required extension {}", m_path, extension);
+					return false;
+				}
+			}
+		}
+		else if (key == "buffers") {
+			read_buffers(reader, buffer_uris);
+		}
+		else if (key == "bufferViews") {
+			read_buffer_views(reader);
+		}
+		else if (key == "accessors") {
+			read_accessors(reader);
+		}
+		else if (key == "meshes") {
+			read_meshes(reader);
+		}
+		else if (key == "materials") {
+			read_materials(reader);
+		}
+		else if (key == "textures") {
+			read_textures(reader);
+		}
+		else if (key == "images") {
+			read_images(reader, image_uris, image_views);
+		}
+		else if (key == "nodes") {
+			read_nodes(reader);
+		}
+		else if (key == "scenes") {
+			read_scenes(reader);
+		}
+		else if (key == "scene") {
+			has_default_scene = reader.read_uint(m_defaultScene);
+		}
+		else {
+			reader.skip();
+		}
+	}
+
+	if (reader.has_error() || !reader.is_end())
+	{
+		JDL_ERROR("{}: invalid JSON document near offset {}", m_path, reader.get_offset());
+		return false;
+	}
+	if (has_default_scene && m_defaultScene >= m_scenes.size())
+	{
+		JDL_ERROR("{}: invalid default scene", m_path);
+		return false;
+	}
+
+	return load_buffers(buffer_uris) && resolve() && load_images(image_uris, image_views);
+}
+
+bool GltfReader::read_buffers(utils::JsonReader& reader, std::vector<std::string>& uris)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		std::string uri;
+		uint64_t size = 0;
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "uri") {
+				reader.read_string(uri);
+			}
+			else if (key == "byteLength") {
+				reader.read_uint64(size);
+			}
+			else {
+				reader.skip();
+			}
+		}
+
+		uris.push_back(std::move(uri));
+		m_buffers.emplace_back().size = size;
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_buffer_views(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		BufferView& view = m_views.emplace_back();
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "buffer") {
+				reader.read_uint(view.buffer);
+			}
+			else if (key == "byteOffset") {
+				reader.read_uint64(view.offset);
+			}
+			else if (key == "byteLength") {
+				reader.read_uint64(view.size);
+			}
+			else if (key == "byteStride") {
+				reader.read_uint(view.stride);
+			}
+			else {
+				reader.skip();
+			}
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_accessors(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		Accessor& accessor = m_accessors.emplace_back();
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			std::string_view type;
+			if (key == "bufferView") {
+				reader.read_uint(accessor.view);
+			}
+			else if (key == "byteOffset") {
+				reader.read_uint64(accessor.offset);
+			}
+			else if (key == "count") {
+				reader.read_uint(accessor.count);
+			}
+			else if (key == "componentType") {
+				reader.read_uint(accessor.component_type);
+			}
+			else if (key == "normalized") {
+				reader.read_bool(accessor.normalized);
+			}
+			else if (key == "type" && reader.read_raw_string(type)) {
+				accessor.nb_components = s_GetNbComponents(type);
+			}
+			else if (key == "sparse")
+			{
+				accessor.sparse = true;
+				reader.skip();
+			}
+			else {
+				reader.skip();
+			}
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_meshes(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		GltfMesh& mesh = m_meshes.emplace_back();
+		mesh.first_primitive = static_cast<uint32_t>(m_primitives.size());
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "name") {
+				reader.read_string(mesh.name);
+			}
+			else if (key == "primitives")
+			{
+				reader.begin_array();
+				while (reader.next_element()) {
+					read_primitive(reader, m_primitives.emplace_back());
+				}
+			}
+			else {
+				reader.skip();
+			}
+		}
+
+		mesh.nb_primitives = static_cast<uint32_t>(m_primitives.size()) - mesh.first_primitive;
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_primitive(utils::JsonReader& reader, GltfPrimitive& primitive)
+{
+	static constexpr std::pair<std::string_view, VertexAttribute> s_Attributes[] = {
+		{ "POSITION", VertexAttribute::ePosition },
+		{ "NORMAL", VertexAttribute::eNormal },
+		{ "TANGENT", VertexAttribute::eTangent },
+		{ "TEXCOORD_0", VertexAttribute::eTexCoord },
+		{ "COLOR_0", VertexAttribute::eColor }
+	};
+
+	reader.begin_object();
+	std::string_view key;
+	while (reader.next_member(key))
+	{
+		if (key == "attributes")
+		{
+			reader.begin_object();
+			std::string_view name;
+			while (reader.next_member(name))
+			{
+				auto it = std::find_if(std::begin(s_Attributes), std::end(s_Attributes), [name](const auto& attribute) {
+					return attribute.first == name;
+				});
+				if (it != std::end(s_Attributes)) {
+					reader.read_uint(primitive.attributes[static_cast<size_t>(it->second)]);
+				}
+				else {
+					reader.skip();
+				}
+			}
+		}
+		else if (key == "indices") {
+			reader.read_uint(primitive.indices);
+		}
+		else if (key == "material") {
+			reader.read_uint(primitive.material);
+		}
+		else if (key == "mode") {
+			reader.read_uint(primitive.mode);
+		}
+		else {
+			reader.skip();
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_texture_ref(utils::JsonReader& reader, GltfTextureRef& texture, float* scale)
+{
+	// The texture index is stored until the textures are resolved
+	reader.begin_object();
+	std::string_view key;
+	while (reader.next_member(key))
+	{
+		if (key == "index") {
+			reader.read_uint(texture.image);
+		}
+		else if (key == "texCoord") {
+			reader.read_uint(texture.texcoord);
+		}
+		else if ((key == "scale" || key == "strength") && scale != nullptr) {
+			reader.read_float(*scale);
+		}
+		else {
+			reader.skip();
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_materials(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		GltfMaterial& material = m_materials.emplace_back();
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			std::string_view alpha_mode;
+			if (key == "name") {
+				reader.read_string(material.name);
+			}
+			else if (key == "pbrMetallicRoughness")
+			{
+				reader.begin_object();
+				std::string_view pbr_key;
+				while (reader.next_member(pbr_key))
+				{
+					if (pbr_key == "baseColorFactor") {
+						reader.read_floats(material.base_color_factor.data(), 4);
+					}
+					else if (pbr_key == "metallicFactor") {
+						reader.read_float(material.metallic_factor);
+					}
+					else if (pbr_key == "roughnessFactor") {
+						reader.read_float(material.roughness_factor);
+					}
+					else if (pbr_key == "baseColorTexture") {
+						read_texture_ref(reader, material.base_color_texture, nullptr);
+					}
+					else if (pbr_key == "metallicRoughnessTexture") {
+						read_texture_ref(reader, material.metallic_roughness_texture, nullptr);
+					}
+					else {
+						reader.skip();
+					}
+				}
+			}
+			else if (key == "normalTexture") {
+				read_texture_ref(reader, material.normal_texture, &material.normal_scale);
+			}
+			else if (key == "occlusionTexture") {
+				read_texture_ref(reader, material.occlusion_texture, &material.occlusion_strength);
+			}
+			else if (key == "emissiveTexture") {
+				read_texture_ref(reader, material.emissive_texture, nullptr);
+			}
+			else if (key == "emissiveFactor") {
+				reader.read_floats(material.emissive_factor.data(), 3);
+			}
+			else if (key == "alphaMode" && reader.read_raw_string(alpha_mode))
+			{
+				material.alpha_mode = alpha_mode == "MASK" ? GltfAlphaMode::eMask
+					: alpha_mode == "BLEND" ? GltfAlphaMode::eBlend
+					: GltfAlphaMode::eOpaque;
+			}
+			else if (key == "alphaCutoff") {
+				reader.read_float(material.alpha_cutoff);
+			}
+			else if (key == "doubleSided") {
+				reader.read_bool(material.double_sided);
+			}
+			else {
+				reader.skip();
+			}
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_textures(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		uint32_t& image = m_textureImages.emplace_back(s_GltfInvalidIndex);
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "source") {
+				reader.read_uint(image);
+			}
+			else {
+				reader.skip();
+			}
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_images(utils::JsonReader& reader, std::vector<std::string>& uris, std::vector<uint32_t>& views)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		GltfImage& image = m_images.emplace_back();
+		std::string& uri = uris.emplace_back();
+		uint32_t& view = views.emplace_back(s_GltfInvalidIndex);
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "name") {
+				reader.read_string(image.name);
+			}
+			else if (key == "uri") {
+				reader.read_string(uri);
+			}
+			else if (key == "mimeType") {
+				reader.read_string(image.mime_type);
+			}
+			else if (key == "bufferView") {
+				reader.read_uint(view);
+			}
+			else {
+				reader.skip();
+			}
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_nodes(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		GltfNode& node = m_nodes.emplace_back();
+		node.local_transform = s_Identity;
+		node.world_transform = s_Identity;
+
+		std::array<float, 3> translation {};
+		std::array<float, 4> rotation { 0.0f, 0.0f, 0.0f, 1.0f };
+		std::array<float, 3> scale { 1.0f, 1.0f, 1.0f };
+		bool has_matrix = false;
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "name") {
+				reader.read_string(node.name);
+			}
+			else if (key == "mesh") {
+				reader.read_uint(node.mesh);
+			}
+			else if (key == "children")
+			{
+				reader.begin_array();
+				while (reader.next_element()) {
+					reader.read_uint(node.children.emplace_back());
+				}
+			}
+			else if (key == "matrix") {
+				has_matrix = reader.read_floats(node.local_transform.data(), 16) == 16;
+			}
+			else if (key == "translation") {
+				reader.read_floats(translation.data(), 3);
+			}
+			else if (key == "rotation") {
+				reader.read_floats(rotation.data(), 4);
+			}
+			else if (key == "scale") {
+				reader.read_floats(scale.data(), 3);
+			}
+			else {
+				reader.skip();
+			}
+		}
+
+		if (!has_matrix) {
+			node.local_transform = s_ComposeTransform(translation, rotation, scale);
+		}
+	}
+	return !reader.has_error();
+}
+
+bool GltfReader::read_scenes(utils::JsonReader& reader)
+{
+	reader.begin_array();
+	while (reader.next_element())
+	{
+		Scene& scene = m_scenes.emplace_back();
+
+		reader.begin_object();
+		std::string_view key;
+		while (reader.next_member(key))
+		{
+			if (key == "nodes")
+			{
+				reader.begin_array();
+				while (reader.next_element()) {
+					reader.read_uint(scene.nodes.emplace_back());
+				}
+			}
+			else {
+				reader.skip();
+			}
+		}
+	}
+	return !reader.has_error();
+}
+
+// --- RESOLUTION ---
+
+bool GltfReader::load_buffers(const std::vector<std::string>& uris)
+{
+	for (size_t i = 0; i < m_buffers.size(); ++i)
+	{
+		Buffer& buffer = m_buffers[i];
+		size_t size = static_cast<size_t>(buffer.size);
+		std::string_view base64;
+
+		if (uris[i].empty())
+		{
+			// Binary chunk of the .glb file (first buffer only)
+			if (i != 0 || m_glbChunk.data() == nullptr || m_glbChunk.size() < size)
+			{
+				JDL_ERROR("{}: buffer {} has no data", m_path, i);
+				return false;
+			}
+			buffer.data = m_glbChunk.first(size);
+		}
+		else if (s_IsDataUri(uris[i], base64))
+		{
+			if (!s_DecodeBase64(base64, buffer.embedded) || buffer.embedded.size() < size)
+			{
+				JDL_ERROR("{}: invalid embedded buffer {}", m_path, i);
+				return false;
+			}
+			buffer.data = { buffer.embedded.data(), size };
+		}
+		else
+		{
+			// External buffers are mapped, never read into memory
+			std::string path = (std::filesystem::path(m_directory) / s_DecodeUri(uris[i])).string();
+			buffer.file = std::make_unique<utils::MappedFile>();
+			if (!buffer.file->open(path) || buffer.file->get_size() < size)
+			{
+				JDL_ERROR("{}: failed to read buffer {}", m_path, path);
+				return false;
+			}
+			buffer.data = { buffer.file->get_data(), size };
+		}
+	}
+	return true;
+}
+
+bool GltfReader::load_images(const std::vector<std::string>& uris, const std::vector<uint32_t>& views)
+{
+	for (size_t i = 0; i < m_images.size(); ++i)
+	{
+		GltfImage& image = m_images[i];
+		std::string_view base64;
+
+		if (views[i] != s_GltfInvalidIndex)
+		{
+			if (views[i] >= m_views.size())
+			{
+				JDL_ERROR("{}: invalid buffer view for image {}", m_path, i);
+				return false;
+			}
+			const BufferView& view = m_views[views[i]];
+			image.data = m_buffers[view.buffer].data.subspan(view.offset, view.size);
+		}
+		else if (s_IsDataUri(uris[i], base64))
+		{
+			auto& data = m_embeddedImages.emplace_back();
+			if (!s_DecodeBase64(base64, data))
+			{
+				JDL_ERROR("{}: invalid embedded image {}", m_path, i);
+				return false;
+			}
+			image.data = data;
+		}
+		else if (!uris[i].empty()) {
+			image.path = (std::filesystem::path(m_directory) / s_DecodeUri(uris[i])).string();
+		}
+	}
+	return true;
+}
+
+bool GltfReader::resolve()
+{
+	auto fail = [this](const char* reason, size_t index) {
+		JDL_ERROR("{}: {} {}", m_path, reason, index);
+		return false;
+	};
+
+	// Views and accessors are bound-checked once, decoding trusts them
+	for (size_t i = 0; i < m_views.size(); ++i)
+	{
+		const BufferView& view = m_views[i];
+		if (view.buffer >= m_buffers.size() || view.offset > m_buffers[view.buffer].data.size()
+			|| view.size > m_buffers[view.buffer].data.size() - view.offset)
+		{
+			return fail("invalid buffer view", i);
+		}
+	}
+
+	for (size_t i = 0; i < m_accessors.size(); ++i)
+	{
+		const Accessor& accessor = m_accessors[i];
+		uint32_t element_size = s_GetComponentSize(accessor.component_type) * accessor.nb_components;
+		if (element_size == 0) {
+			return fail("invalid accessor type", i);
+		}
+
+		// Accessors without view are zero-filled (or fully sparse)
+		if (accessor.view == s_GltfInvalidIndex || accessor.count == 0) {
+			continue;
+		}
+		if (accessor.view >= m_views.size()) {
+			return fail("invalid accessor view", i);
+		}
+
+		const BufferView& view = m_views[accessor.view];
+		uint64_t stride = view.stride != 0 ? view.stride : element_size;
+		uint64_t end = accessor.offset + stride * (accessor.count - 1) + element_size;
+		if (end > view.size) {
+			return fail("accessor out of its buffer view", i);
+		}
+	}
+
+	for (size_t i = 0; i < m_primitives.size(); ++i)
+	{
+		const GltfPrimitive& primitive = m_primitives[i];
+		bool is_valid = primitive.indices == s_GltfInvalidIndex || primitive.indices < m_accessors.size();
+		for (uint32_t accessor : primitive.attributes) {
+			is_valid &= accessor == s_GltfInvalidIndex || accessor < m_accessors.size();
+		}
+		is_valid &= primitive.material == s_GltfInvalidIndex || primitive.material < m_materials.size();
+		if (!is_valid) {
+			return fail("invalid primitive", i);
+		}
+	}
+
+	// Texture indices to image indices
+	for (GltfMaterial& material : m_materials)
+	{
+		for (GltfTextureRef* texture : {
+			&material.base_color_texture, &material.metallic_roughness_texture,
+			&material.normal_texture, &material.occlusion_texture, &material.emissive_texture
+		})
+		{
+			if (!texture->is_valid()) {
+				continue;
+			}
+			uint32_t image = texture->image < m_textureImages.size() ? m_textureImages[texture->image] : s_GltfInvalidIndex;
+			texture->image = image < m_images.size() ? image : s_GltfInvalidIndex;
+		}
+	}
+
+	// Hierarchy: parents from the children lists, each node has at most one
+	for (size_t i = 0; i < m_nodes.size(); ++i)
+	{
+		GltfNode& node = m_nodes[i];
+		if (node.mesh != s_GltfInvalidIndex && node.mesh >= m_meshes.size()) {
+			return fail("invalid mesh of node", i);
+		}
+		for (uint32_t child : node.children)
+		{
+			if (child >= m_nodes.size() || child == i || m_nodes[child].parent != s_GltfInvalidIndex) {
+				return fail("invalid children of node", i);
+			}
+			m_nodes[child].parent = static_cast<uint32_t>(i);
+		}
+	}
+
+	if (!m_scenes.empty()) {
+		m_rootNodes = m_scenes[m_defaultScene].nodes;
+	}
+	else
+	{
+		for (size_t i = 0; i < m_nodes.size(); ++i)
+		{
+			if (m_nodes[i].parent == s_GltfInvalidIndex) {
+				m_rootNodes.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+
+	// World transforms, parents first (iterative, a cycle leaves nodes unvisited)
+	std::vector<uint32_t> stack;
+	for (uint32_t root : m_rootNodes)
+	{
+		if (root >= m_nodes.size() || m_nodes[root].parent != s_GltfInvalidIndex) {
+			return fail("invalid root node", root);
+		}
+		m_nodes[root].world_transform = m_nodes[root].local_transform;
+		stack.push_back(root);
+	}
+	while (!stack.empty())
+	{
+		const GltfNode& node = m_nodes[stack.back()];
+		stack.pop_back();
+		for (uint32_t child : node.children)
+		{
+			m_nodes[child].world_transform = s_Multiply(node.world_transform, m_nodes[child].local_transform);
+			stack.push_back(child);
+		}
+	}
+	return true;
+}
+
+// --- DECODING ---
+
+const std::byte* GltfReader::get_element(const Accessor& accessor, uint32_t element, uint32_t element_size) const
+{
+	const BufferView& view = m_views[accessor.view];
+	uint64_t stride = view.stride != 0 ? view.stride : element_size;
+	return m_buffers[view.buffer].data.data() + view.offset + accessor.offset + stride * element;
+}
+
+bool GltfReader::read_accessor(uint32_t index, std::vector<float>& values, uint32_t& nb_components) const
+{
+	const Accessor& accessor = m_accessors[index];
+	if (accessor.sparse)
+	{
+		JDL_ERROR("{}: sparse accessor {} not supported", m_path, index);
+		return false;
+	}
+
+	nb_components = accessor.nb_components;
+	values.assign(size_t(accessor.count) * nb_components, 0.0f);
+	if (accessor.view == s_GltfInvalidIndex) {
+		return true;
+	}
+
+	uint32_t component_size = s_GetComponentSize(accessor.component_type);
+	uint32_t element_size = component_size * nb_components;
+	const BufferView& view = m_views[accessor.view];
+
+	// Tightly packed floats are copied at once
+	if (accessor.component_type == s_Float && (view.stride == 0 || view.stride == element_size))
+	{
+		std::memcpy(values.data(), get_element(accessor, 0, element_size), values.size() * sizeof(float));
+		return true;
+	}
+
+	float* dst = values.data();
+	for (uint32_t element = 0; element < accessor.count; ++element)
+	{
+		const std::byte* src = get_element(accessor, element, element_size);
+		for (uint32_t component = 0; component < nb_components; ++component) {
+			*dst++ = s_ReadComponent(src + component * component_size, accessor.component_type, accessor.normalized);
+		}
+	}
+	return true;
+}
+
+bool GltfReader::read_indices(uint32_t index, std::vector<uint32_t>& values) const
+{
+	const Accessor& accessor = m_accessors[index];
+	if (accessor.sparse || accessor.nb_components != 1 || accessor.view == s_GltfInvalidIndex)
+	{
+		JDL_ERROR("{}: invalid index accessor {}", m_path, index);
+		return false;
+	}
+
+	uint32_t size = s_GetComponentSize(accessor.component_type);
+	values.resize(accessor.count);
+	for (uint32_t element = 0; element < accessor.count; ++element)
+	{
+		const std::byte* src = get_element(accessor, element, size);
+		switch (accessor.component_type)
+		{
+			case s_Uint8:
+				values[element] = static_cast<uint8_t>(*src);
+				break;
+			case s_Uint16:
+			{
+				uint16_t value;
+				std::memcpy(&value, src, sizeof(value));
+				values[element] = value;
+				break;
+			}
+			case s_Uint32:
+				std::memcpy(&values[element], src, sizeof(uint32_t));
+				break;
+			default:
+				JDL_ERROR("{}: invalid index type of accessor {}", m_path, index);
+				return false;
+		}
+	}
+	return true;
+}
+
+bool GltfReader::decode_primitive(uint32_t index, VertexData& vertices, std::vector<uint32_t>& indices) const
+{
+	const GltfPrimitive& primitive = m_primitives[index];
+	auto get_accessor = [&primitive](VertexAttribute attribute) {
+		return primitive.attributes[static_cast<size_t>(attribute)];
+	};
+
+	uint32_t position_accessor = get_accessor(VertexAttribute::ePosition);
+	if (position_accessor == s_GltfInvalidIndex || m_accessors[position_accessor].nb_components != 3)
+	{
+		JDL_ERROR("{}: primitive {} has no valid positions", m_path, index);
+		return false;
+	}
+	uint32_t nb_vertices = m_accessors[position_accessor].count;
+
+	// Attributes, with their expected number of components
+	struct Target
+	{
+		VertexAttribute attribute;
+		std::vector<float>* values;
+		uint32_t nb_components;
+	};
+	Target targets[] = {
+		{ VertexAttribute::ePosition, &vertices.positions, 3 },
+		{ VertexAttribute::eNormal, &vertices.normals, 3 },
+		{ VertexAttribute::eTangent, &vertices.tangents, 4 },
+		{ VertexAttribute::eTexCoord, &vertices.texcoords, 2 },
+		{ VertexAttribute::eColor, &vertices.colors, 4 }
+	};
+
+	for (const Target& target : targets)
+	{
+		uint32_t accessor = get_accessor(target.attribute);
+		if (accessor == s_GltfInvalidIndex) {
+			continue;
+		}
+
+		uint32_t nb_components = 0;
+		if (!read_accessor(accessor, *target.values, nb_components)) {
+			return false;
+		}
+
+		// RGB colors get an opaque alpha
+		if (target.attribute == VertexAttribute::eColor && nb_components == 3)
+		{
+			std::vector<float> rgba(size_t(nb_vertices) * 4, 1.0f);
+			for (size_t i = 0; i < nb_vertices && i * 3 + 2 < target.values->size(); ++i) {
+				std::copy_n(target.values->data() + i * 3, 3, rgba.data() + i * 4);
+			}
+			*target.values = std::move(rgba);
+			nb_components = 4;
+		}
+
+		if (nb_components != target.nb_components || m_accessors[accessor].count != nb_vertices)
+		{
+			JDL_ERROR("{}: primitive {} has an invalid vertex attribute", m_path, index);
+			return false;
+		}
+	}
+
+	// Non indexed primitives use the vertex order
+	std::vector<uint32_t> source;
+	if (primitive.indices != s_GltfInvalidIndex)
+	{
+		if (!read_indices(primitive.indices, source)) {
+			return false;
+		}
+	}
+	else
+	{
+		source.resize(nb_vertices);
+		for (uint32_t i = 0; i < nb_vertices; ++i) {
+			source[i] = i;
+		}
+	}
+
+	// Strips and fans are converted to lists, keeping the winding
+	switch (primitive.mode)
+	{
+		case 4:
+			indices = std::move(source);
+			indices.resize(indices.size() - indices.size() % 3);
+			break;
+		case 5:
+			indices.clear();
+			for (size_t i = 2; i < source.size(); ++i)
+			{
+				bool is_odd = (i % 2) == 1;
+				indices.insert(indices.end(), {
+					source[i - 2], source[is_odd ? i : i - 1], source[is_odd ? i - 1 : i]
+				});
+			}
+			break;
+		case 6:
+			indices.clear();
+			for (size_t i = 2; i < source.size(); ++i) {
+				indices.insert(indices.end(), { source[i - 1], source[i], source[0] });
+			}
+			break;
+		default:
+			JDL_ERROR("{}: primitive {} is not made of triangles", m_path, index);
+			return false;
+	}
+	return true;
+}
+
+} // namespace resource
+} // namespace jdl
@@ -0,0 +1,156 @@
+#include "resource/mesh.hpp"
+
+#include "vk/vulkan_command_buffer.hpp"
+#include "vk/vulkan_context.hpp"
+
+
+namespace jdl
+{
+namespace resource
+{
+
+Mesh::Mesh(
+	const std::string& name,
+	VertexData vertices,
+	std::vector<uint32_t> indices,
+	const VertexLayout& layout
+)
+	: Resource(name)
+	, m_layout(layout)
+	, m_vertices(std::move(vertices))
+	, m_indices(std::move(indices))
+{}
+
+Mesh::Mesh(const std::string& name, const std::string& path)
+	: Resource(name)
+	, m_path(path)
+{}
+
+PositionDequantization Mesh::get_position_dequantization() const
+{
+	PositionDequantization dequantization;
+	if (m_layout.get_format(VertexAttribute::ePosition) != VertexFormat::eSnorm16x4) {
+		return dequantization;
+	}
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		dequantization.scale[axis] = m_bounds.extent[axis];
+		dequantization.offset[axis] = m_bounds.center[axis];
+	}
+	return dequantization;
+}
+
+bool Mesh::is_drawable() const
+{
+	return is_ready() && vk::VulkanContext::GetUploader().is_complete(m_uploadToken);
+}
+
+void Mesh::bind(vk::VulkanCommandBuffer& command_buffer) const
+{
+	std::vector<VkBuffer> buffers;
+	for (uint32_t stream = 0; stream < m_layout.get_nb_streams(); ++stream) {
+		buffers.push_back(get_vertex_buffer(stream));
+	}
+	command_buffer.bind_vertex_buffers(0, buffers);
+	command_buffer.bind_index_buffer(get_index_buffer(), 0, m_indexType);
+}
+
+void Mesh::draw(
+	vk::VulkanCommandBuffer& command_buffer,
+	uint32_t nb_instances,
+	uint32_t first_instance
+) const
+{
+	command_buffer.draw_indexed(m_nbIndices, nb_instances, 0, 0, first_instance);
+}
+
+bool Mesh::load()
+{
+	if (!m_path.empty())
+	{
+		// Cooked mesh: only the header is read, the blobs stay mapped
+		if (!m_file.open(m_path)) {
+			return false;
+		}
+		m_layout = m_file.get_layout();
+		m_bounds = m_file.get_bounds();
+		m_nbVertices = m_file.get_nb_vertices();
+		m_nbIndices = m_file.get_nb_indices();
+		m_indexType = m_file.get_index_type();
+		return true;
+	}
+
+	// Encoded on the loader thread, the source data is not needed anymore
+	if (!encode_mesh(get_name(), m_vertices, m_indices, m_layout, m_encoded)) {
+		return false;
+	}
+	m_bounds = m_encoded.bounds;
+	m_nbVertices = m_encoded.nb_vertices;
+	m_nbIndices = m_encoded.nb_indices;
+	m_indexType = m_encoded.index_type;
+
+	m_vertices = {};
+	m_indices = {};
+	return true;
+}
+
+bool Mesh::finalize()
+{
+	auto& uploader = vk::VulkanContext::GetUploader();
+	bool is_mapped = !m_path.empty();
+
+	// Device local buffers
+	for (uint32_t stream = 0; stream < m_layout.get_nb_streams(); ++stream)
+	{
+		const void* data = is_mapped
+			? static_cast<const void*>(m_file.get_stream(stream).data())
+			: static_cast<const void*>(m_encoded.streams[stream].data());
+		size_t size = m_nbVertices * m_layout.get_stride(stream);
+
+		m_vertexBuffers[stream] = std::make_unique<vk::VulkanBuffer>(
+			size,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			vk::MemoryUsage::eGpuOnly
+		);
+		m_uploadToken = uploader.upload_buffer(
+			*m_vertexBuffers[stream], data, size, 0,
+			VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT
+		);
+	}
+
+	const void* index_data = is_mapped
+		? static_cast<const void*>(m_file.get_indices().data())
+		: static_cast<const void*>(m_encoded.indices.data());
+	size_t index_size = m_nbIndices * (m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+
+	m_indexBuffer = std::make_unique<vk::VulkanBuffer>(
+		index_size,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		vk::MemoryUsage::eGpuOnly
+	);
+	m_uploadToken = uploader.upload_buffer(
+		*m_indexBuffer, index_data, index_size, 0,
+		VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT
+	);
+
+	// The uploader copied the data
+	m_encoded = {};
+	m_file.close();
+	return true;
+}
+
+void Mesh::clear_resource()
+{
+	// The frames in flight may still draw the mesh
+	auto& retire_queue = vk::VulkanContext::GetRetireQueue();
+	for (auto& buffer : m_vertexBuffers) {
+		retire_queue.retire(std::move(buffer));
+	}
+	retire_queue.retire(std::move(m_indexBuffer));
+	m_encoded = {};
+	m_file.close();
+}
+
+} // namespace resource
+} // namespace jdl
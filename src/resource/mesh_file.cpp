@@ -0,0 +1,226 @@
+#include "resource/mesh_file.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+static_assert(std::endian::native == std::endian::little, "Mesh files are little-endian");
+static_assert(std::is_trivially_copyable_v<MeshFile::Header>);
+
+// Largest vertex count addressable with 16-bit indices
+static constexpr size_t s_MaxVertices16 = 1ull << 16;
+
+static uint64_t s_AlignBlob(uint64_t offset)
+{
+	return (offset + MeshFile::s_BlobAlignment - 1) & ~(MeshFile::s_BlobAlignment - 1);
+}
+
+bool encode_mesh(
+	const std::string& name,
+	const VertexData& vertices,
+	const std::vector<uint32_t>& indices,
+	const VertexLayout& layout,
+	EncodedMesh& mesh
+)
+{
+	if (!layout.is_valid())
+	{
+		JDL_ERROR("Mesh {}: invalid vertex layout", name);
+		return false;
+	}
+
+	size_t nb_vertices = vertices.get_nb_vertices();
+	if (nb_vertices == 0 || indices.empty() || nb_vertices > UINT32_MAX || indices.size() > UINT32_MAX)
+	{
+		JDL_ERROR("Mesh {}: no geometry", name);
+		return false;
+	}
+	if (indices.size() % 3 != 0)
+	{
+		JDL_ERROR("Mesh {}: not a triangle list", name);
+		return false;
+	}
+	uint32_t max_index = *std::max_element(indices.begin(), indices.end());
+	if (max_index >= nb_vertices)
+	{
+		JDL_ERROR("Mesh {}: index out of range", name);
+		return false;
+	}
+
+	mesh.layout = layout;
+	mesh.nb_vertices = static_cast<uint32_t>(nb_vertices);
+	mesh.nb_indices = static_cast<uint32_t>(indices.size());
+	mesh.max_index = max_index;
+	mesh.bounds = vertices.compute_bounds();
+
+	encode_vertices(vertices, layout, mesh.bounds, mesh.streams);
+
+	if (nb_vertices <= s_MaxVertices16)
+	{
+		mesh.index_type = VK_INDEX_TYPE_UINT16;
+		mesh.indices.resize(indices.size() * sizeof(uint16_t));
+
+		auto dst = reinterpret_cast<uint16_t*>(mesh.indices.data());
+		std::transform(indices.begin(), indices.end(), dst, [](uint32_t index) {
+			return static_cast<uint16_t>(index);
+		});
+	}
+	else
+	{
+		mesh.index_type = VK_INDEX_TYPE_UINT32;
+		mesh.indices.resize(indices.size() * sizeof(uint32_t));
+		std::memcpy(mesh.indices.data(), indices.data(), mesh.indices.size());
+	}
+	return true;
+}
+
+bool write_mesh_file(const std::string& path, const EncodedMesh& mesh)
+{
+	MeshFile::Header header {};
+	header.magic = MeshFile::s_Magic;
+	header.version = MeshFile::s_Version;
+	for (size_t i = 0; i < VertexLayout::s_NbAttributes; ++i) {
+		header.formats[i] = static_cast<uint8_t>(mesh.layout.formats[i]);
+	}
+	header.streams = static_cast<uint8_t>(mesh.layout.streams);
+	header.index_size = mesh.index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	header.nb_vertices = mesh.nb_vertices;
+	header.nb_indices = mesh.nb_indices;
+	header.max_index = mesh.max_index;
+	std::copy(mesh.bounds.center.begin(), mesh.bounds.center.end(), header.center);
+	std::copy(mesh.bounds.extent.begin(), mesh.bounds.extent.end(), header.extent);
+
+	// Blobs follow the header, each one aligned
+	uint64_t offset = sizeof(MeshFile::Header);
+	auto place_blob = [&offset](MeshFile::Blob& blob, size_t size) {
+		blob.offset = s_AlignBlob(offset);
+		blob.size = size;
+		offset = blob.offset + size;
+	};
+	for (uint32_t stream = 0; stream < mesh.layout.get_nb_streams(); ++stream) {
+		place_blob(header.stream_blobs[stream], mesh.streams[stream].size());
+	}
+	place_blob(header.index_blob, mesh.indices.size());
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		JDL_ERROR("Failed to create mesh file {}", path);
+		return false;
+	}
+
+	static constexpr char s_Zeros[MeshFile::s_BlobAlignment] {};
+	uint64_t position = 0;
+	auto write = [&file, &position](const void* data, uint64_t blob_offset, size_t size) {
+		file.write(s_Zeros, static_cast<std::streamsize>(blob_offset - position));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		position = blob_offset + size;
+	};
+
+	write(&header, 0, sizeof(header));
+	for (uint32_t stream = 0; stream < mesh.layout.get_nb_streams(); ++stream)
+	{
+		const auto& blob = header.stream_blobs[stream];
+		write(mesh.streams[stream].data(), blob.offset, blob.size);
+	}
+	write(mesh.indices.data(), header.index_blob.offset, header.index_blob.size);
+
+	if (!file)
+	{
+		JDL_ERROR("Failed to write mesh file {}", path);
+		return false;
+	}
+	return true;
+}
+
+bool MeshFile::open(const std::string& path)
+{
+	if (!m_file.open(path))
+	{
+		JDL_ERROR("Failed to read mesh file {}", path);
+		return false;
+	}
+
+	auto fail = [this, &path](const char* reason) {
+		JDL_ERROR("Invalid mesh file {}: {}", path, reason);
+		m_file.close();
+		return false;
+	};
+
+	if (m_file.get_size() < sizeof(Header)) {
+		return fail("truncated header");
+	}
+	std::memcpy(&m_header, m_file.get_data(), sizeof(Header));
+
+	if (m_header.magic != s_Magic) {
+		return fail("not a mesh file");
+	}
+	if (m_header.version != s_Version) {
+		return fail("outdated version, the mesh must be cooked again");
+	}
+
+	// Layout, checked before any cast to the enumerations
+	static constexpr uint8_t s_MaxFormat = static_cast<uint8_t>(VertexFormat::eUnorm8x4);
+	static constexpr uint8_t s_MaxStreams = static_cast<uint8_t>(VertexStreams::eSplitPositions);
+	if (m_header.streams > s_MaxStreams) {
+		return fail("invalid vertex streams");
+	}
+	for (size_t i = 0; i < VertexLayout::s_NbAttributes; ++i)
+	{
+		if (m_header.formats[i] > s_MaxFormat) {
+			return fail("invalid vertex format");
+		}
+		m_layout.formats[i] = static_cast<VertexFormat>(m_header.formats[i]);
+	}
+	m_layout.streams = static_cast<VertexStreams>(m_header.streams);
+	if (!m_layout.is_valid()) {
+		return fail("invalid vertex layout");
+	}
+	if (m_header.index_size != sizeof(uint16_t) && m_header.index_size != sizeof(uint32_t)) {
+		return fail("invalid index size");
+	}
+
+	// Same checks as encode_mesh(), the index range being stored at cook time
+	if (m_header.nb_vertices == 0 || m_header.nb_indices == 0) {
+		return fail("no geometry");
+	}
+	if (m_header.nb_indices % 3 != 0) {
+		return fail("not a triangle list");
+	}
+	if (m_header.max_index >= m_header.nb_vertices) {
+		return fail("index out of range");
+	}
+
+	// Blob sizes must match the counts, and the blobs must fit in the file
+	uint64_t file_size = m_file.get_size();
+	auto is_valid_blob = [file_size](const Blob& blob, uint64_t expected_size) {
+		return blob.size == expected_size && blob.offset % s_BlobAlignment == 0
+			&& blob.offset <= file_size && blob.size <= file_size - blob.offset;
+	};
+	for (uint32_t stream = 0; stream < m_layout.get_nb_streams(); ++stream)
+	{
+		uint64_t size = uint64_t(m_header.nb_vertices) * m_layout.get_stride(stream);
+		if (!is_valid_blob(m_header.stream_blobs[stream], size)) {
+			return fail("invalid vertex stream");
+		}
+	}
+	if (!is_valid_blob(m_header.index_blob, uint64_t(m_header.nb_indices) * m_header.index_size)) {
+		return fail("invalid indices");
+	}
+
+	std::copy(std::begin(m_header.center), std::end(m_header.center), m_bounds.center.begin());
+	std::copy(std::begin(m_header.extent), std::end(m_header.extent), m_bounds.extent.begin());
+	return true;
+}
+
+} // namespace resource
+} // namespace jdl
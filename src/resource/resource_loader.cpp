@@ -0,0 +1,192 @@
+#include "resource/resource_loader.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+ResourceLoader::ResourceLoader(uint32_t nb_threads)
+{
+	m_threads.reserve(std::max(nb_threads, 1u));
+	for (uint32_t i = 0; i < std::max(nb_threads, 1u); ++i) {
+		m_threads.emplace_back(&ResourceLoader::thread_loop, this);
+	}
+}
+
+ResourceLoader::~ResourceLoader()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+
+		for (Resource* resource : m_queue) {
+			resource->set_load_state(LoadState::eUnloaded);
+		}
+		m_queue.clear();
+	}
+	m_workCondition.notify_all();
+
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+
+	// Loaded but never finalized
+	for (Resource* resource : m_loaded) {
+		resource->set_load_state(LoadState::eUnloaded);
+	}
+}
+
+void ResourceLoader::enqueue(Resource* resource)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		resource->set_load_state(LoadState::eQueued);
+		m_queue.push_back(resource);
+	}
+	m_workCondition.notify_one();
+}
+
+void ResourceLoader::cancel(Resource* resource)
+{
+	std::unique_lock lock(m_mutex);
+
+	auto queued = std::find(m_queue.begin(), m_queue.end(), resource);
+	if (queued != m_queue.end()) {
+		m_queue.erase(queued);
+	}
+
+	m_loadedCondition.wait(lock, [this, resource] {
+		return std::find(m_loading.begin(), m_loading.end(), resource) == m_loading.end()
+			&& m_finalizing != resource;
+	});
+
+	auto loaded = std::find(m_loaded.begin(), m_loaded.end(), resource);
+	if (loaded != m_loaded.end()) {
+		m_loaded.erase(loaded);
+	}
+
+	if (resource->get_load_state() != LoadState::eReady) {
+		resource->set_load_state(LoadState::eUnloaded);
+	}
+}
+
+uint32_t ResourceLoader::finalize(double budget_ms)
+{
+	auto start_time = std::chrono::steady_clock::now();
+	uint32_t nb_finalized = 0;
+
+	while (true)
+	{
+		Resource* resource = nullptr;
+		{
+			std::lock_guard lock(m_mutex);
+			if (m_loaded.empty()) {
+				break;
+			}
+			resource = m_loaded.front();
+			m_loaded.pop_front();
+			// A cancel() waits for the end of the finalization
+			m_finalizing = resource;
+		}
+
+		bool finalized = false;
+		try {
+			finalized = resource->finalize();
+		}
+		catch (const std::exception& e) {
+			JDL_ERROR("Exception while finalizing resource {}: {}", resource->get_name(), e.what());
+		}
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_finalizing = nullptr;
+
+			resource->set_load_state(finalized ? LoadState::eReady : LoadState::eFailed);
+			if (!finalized) {
+				JDL_ERROR("Failed to finalize resource {}", resource->get_name());
+			}
+		}
+		m_loadedCondition.notify_all();
+		++nb_finalized;
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+		if (elapsed.count() >= budget_ms) {
+			break;
+		}
+	}
+	return nb_finalized;
+}
+
+void ResourceLoader::wait_all()
+{
+	{
+		std::unique_lock lock(m_mutex);
+		m_loadedCondition.wait(lock, [this] {
+			return m_queue.empty() && m_loading.empty();
+		});
+	}
+	while (finalize(std::numeric_limits<double>::max()) > 0) {}
+}
+
+uint32_t ResourceLoader::get_nb_pending() const
+{
+	std::lock_guard lock(m_mutex);
+	return static_cast<uint32_t>(
+		m_queue.size() + m_loading.size() + m_loaded.size() + (m_finalizing != nullptr ? 1 : 0)
+	);
+}
+
+void ResourceLoader::thread_loop()
+{
+	while (true)
+	{
+		Resource* resource = nullptr;
+		{
+			std::unique_lock lock(m_mutex);
+			m_workCondition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_stop) {
+				return;
+			}
+
+			resource = m_queue.front();
+			m_queue.pop_front();
+			m_loading.push_back(resource);
+			resource->set_load_state(LoadState::eLoading);
+		}
+
+		bool loaded = false;
+		try {
+			loaded = resource->load();
+		}
+		catch (const std::exception& e) {
+			JDL_ERROR("Exception while loading resource {}: {}", resource->get_name(), e.what());
+		}
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_loading.erase(std::find(m_loading.begin(), m_loading.end(), resource));
+
+			if (loaded)
+			{
+				resource->set_load_state(LoadState::eFinalizing);
+				m_loaded.push_back(resource);
+			}
+			else
+			{
+				resource->set_load_state(LoadState::eFailed);
+				JDL_ERROR("Failed to load resource {}", resource->get_name());
+			}
+		}
+		m_loadedCondition.notify_all();
+	}
+}
+
+} // namespace resource
+} // namespace jdl
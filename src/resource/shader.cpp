@@ -1,7 +1,5 @@
 #include "resource/shader.hpp"
 
-#include <fstream>
-
 #include "utils/logger.hpp"
 
 #include "vk/vulkan_context.hpp"
@@ -15,48 +13,74 @@ namespace resource
 Shader::Shader(const std::string& name, const std::string& path)
 	: Resource(name)
 	, m_path(path)
+{}
+
+VkShaderModule Shader::create_module_from_file(uint64_t& hash, ShaderReflection& reflection) const
 {
-	m_device = vk::VulkanContext::GetDevice().get_device();
-	create_shader();
+	utils::MappedFile file;
+	if (!file.open(m_path))
+	{
+		JDL_ERROR("Failed to read shader {}", m_path);
+		return VK_NULL_HANDLE;
+	}
+	if (!reflection.reflect(file.get_data(), file.get_size()))
+	{
+		JDL_ERROR("Invalid SPIR-V shader {}", m_path);
+		return VK_NULL_HANDLE;
+	}
+
+	hash = vk::VulkanShaderModuleCache::Hash(file.get_data(), file.get_size());
+	return vk::VulkanContext::GetShaderModuleCache().acquire(
+		hash, file.get_data(), file.get_size()
+	);
 }
 
-void Shader::reload()
+VkShaderModule Shader::swap_module(VkShaderModule module, uint64_t hash)
 {
-	clear_resource();
-	create_shader();
+	m_hash = hash;
+	std::swap(m_module, module);
+	return module;
 }
 
-void Shader::create_shader()
+bool Shader::load()
 {
-	// Read the shader file
-	std::ifstream stream(m_path, std::ios::binary | std::ios::ate);
-	if (!stream)
+	// Mapped without any copy, reflected and hashed on the loader thread
+	if (!m_file.open(m_path))
 	{
 		JDL_ERROR("Failed to read shader {}", m_path);
-		return;
+		return false;
 	}
 
-	size_t code_size = stream.tellg();
-	std::vector<char> code(code_size);
+	if (!m_reflection.reflect(m_file.get_data(), m_file.get_size()))
+	{
+		JDL_ERROR("Invalid SPIR-V shader {}", m_path);
+		return false;
+	}
 
-	stream.seekg(0);
-	stream.read(code.data(), code_size);
+	m_hash = vk::VulkanShaderModuleCache::Hash(m_file.get_data(), m_file.get_size());
+	return true;
+}
 
-	VkShaderModuleCreateInfo create_info {};
-	create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	create_info.codeSize = code_size;
-	create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+bool Shader::finalize()
+{
+	// Identical code shares the module of the first shader which loaded it
+	m_module = vk::VulkanContext::GetShaderModuleCache().acquire(
+		m_hash, m_file.get_data(), m_file.get_size()
+	);
 
-	VK_CALL(vkCreateShaderModule(m_device, &create_info, nullptr, &m_module));
+	// The code is not needed anymore
+	m_file.close();
+	return m_module != VK_NULL_HANDLE;
 }
 
 void Shader::clear_resource()
 {
 	if (m_module != VK_NULL_HANDLE)
 	{
-		vkDestroyShaderModule(m_device, m_module, nullptr);
+		vk::VulkanContext::GetShaderModuleCache().release(m_module);
 		m_module = VK_NULL_HANDLE;
 	}
+	m_file.close();
 }
 
 } // namespace resource
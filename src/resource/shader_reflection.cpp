@@ -0,0 +1,568 @@
+#include "resource/shader_reflection.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+static constexpr uint32_t s_SpirvMagic = 0x07230203;
+static constexpr uint32_t s_SpirvHeaderSize = 5;
+
+// Entry points list every global variable they use since SPIR-V 1.4
+static constexpr uint32_t s_SpirvVersion14 = 0x00010400;
+
+enum class SpirvOp : uint32_t
+{
+	eName = 5,
+	eEntryPoint = 15,
+	eTypeBool = 20,
+	eTypeInt = 21,
+	eTypeFloat = 22,
+	eTypeVector = 23,
+	eTypeMatrix = 24,
+	eTypeImage = 25,
+	eTypeSampler = 26,
+	eTypeSampledImage = 27,
+	eTypeArray = 28,
+	eTypeRuntimeArray = 29,
+	eTypeStruct = 30,
+	eTypePointer = 32,
+	eConstant = 43,
+	eSpecConstant = 50,
+	eVariable = 59,
+	eDecorate = 71,
+	eMemberDecorate = 72,
+	eTypeAccelerationStructure = 5341
+};
+
+enum class SpirvDecoration : uint32_t
+{
+	eBlock = 2,
+	eBufferBlock = 3,
+	eArrayStride = 6,
+	eMatrixStride = 7,
+	eBuiltIn = 11,
+	eLocation = 30,
+	eBinding = 33,
+	eDescriptorSet = 34,
+	eOffset = 35
+};
+
+enum class SpirvStorageClass : uint32_t
+{
+	eUniformConstant = 0,
+	eInput = 1,
+	eUniform = 2,
+	ePushConstant = 9,
+	eStorageBuffer = 12
+};
+
+enum class SpirvDim : uint32_t
+{
+	eBuffer = 5,
+	eSubpassData = 6
+};
+
+static constexpr uint32_t s_NoValue = UINT32_MAX;
+
+struct SpirvMember
+{
+	uint32_t offset = s_NoValue;
+	uint32_t matrix_stride = 0;
+	bool builtin = false;
+};
+
+// Everything known about a SPIR-V id (type, constant or variable)
+struct SpirvId
+{
+	SpirvOp op {};
+	std::string name;
+
+	// Types
+	uint32_t element = 0;		// Component/column/element/pointee/image type
+	uint32_t count = 0;			// Vector size, matrix columns or array length id
+	uint32_t width = 0;			// Scalar width in bits
+	bool is_signed = false;
+	uint32_t dim = 0;			// Image dimension
+	uint32_t sampled = 0;		// Image usage (1: sampled, 2: storage)
+	std::vector<uint32_t> members;
+	std::vector<SpirvMember> member_decorations;
+
+	// Pointers and variables
+	uint32_t storage_class = s_NoValue;
+
+	// Constants
+	uint32_t value = 0;
+
+	// Decorations
+	uint32_t set = 0;
+	uint32_t binding = s_NoValue;
+	uint32_t location = s_NoValue;
+	uint32_t array_stride = 0;
+	bool builtin = false;
+	bool block = false;
+	bool buffer_block = false;
+};
+
+struct SpirvEntryPoint
+{
+	ShaderEntryPoint entry_point;
+	std::vector<uint32_t> interface;
+};
+
+static std::string s_ReadString(const uint32_t* words, uint32_t nb_words, uint32_t& nb_read)
+{
+	const char* chars = reinterpret_cast<const char*>(words);
+	size_t length = strnlen(chars, nb_words * sizeof(uint32_t));
+
+	// Null-terminated, padded to a word boundary
+	nb_read = static_cast<uint32_t>(length / sizeof(uint32_t) + 1);
+	return std::string(chars, length);
+}
+
+static bool s_GetStage(uint32_t execution_model, VkShaderStageFlagBits& stage)
+{
+	switch (execution_model)
+	{
+	case 0: stage = VK_SHADER_STAGE_VERTEX_BIT; return true;
+	case 1: stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; return true;
+	case 2: stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; return true;
+	case 3: stage = VK_SHADER_STAGE_GEOMETRY_BIT; return true;
+	case 4: stage = VK_SHADER_STAGE_FRAGMENT_BIT; return true;
+	case 5: stage = VK_SHADER_STAGE_COMPUTE_BIT; return true;
+	default: return false;
+	}
+}
+
+static uint32_t s_GetSize(const std::vector<SpirvId>& ids, uint32_t type_id, uint32_t matrix_stride = 0)
+{
+	const SpirvId& type = ids[type_id];
+	switch (type.op)
+	{
+	case SpirvOp::eTypeBool:
+		return 4;
+	case SpirvOp::eTypeInt:
+	case SpirvOp::eTypeFloat:
+		return type.width / 8;
+	case SpirvOp::eTypeVector:
+		return type.count * s_GetSize(ids, type.element);
+	case SpirvOp::eTypeMatrix:
+		return type.count * (matrix_stride != 0 ? matrix_stride : s_GetSize(ids, type.element));
+	case SpirvOp::eTypeArray:
+	{
+		uint32_t stride = type.array_stride != 0 ? type.array_stride : s_GetSize(ids, type.element);
+		return ids[type.count].value * stride;
+	}
+	case SpirvOp::eTypeStruct:
+	{
+		uint32_t size = 0;
+		for (size_t i = 0; i < type.members.size(); ++i)
+		{
+			const SpirvMember& member = type.member_decorations[i];
+			uint32_t offset = member.offset != s_NoValue ? member.offset : size;
+			size = std::max(size, offset + s_GetSize(ids, type.members[i], member.matrix_stride));
+		}
+		return size;
+	}
+	default:
+		return 0;
+	}
+}
+
+static bool s_GetDescriptorType(
+	const std::vector<SpirvId>& ids,
+	const SpirvId& variable,
+	VkDescriptorType& type,
+	uint32_t& count
+)
+{
+	// Arrays of descriptors
+	uint32_t type_id = ids[variable.element].element;
+	count = 1;
+	while (ids[type_id].op == SpirvOp::eTypeArray || ids[type_id].op == SpirvOp::eTypeRuntimeArray)
+	{
+		const SpirvId& array = ids[type_id];
+		count = array.op == SpirvOp::eTypeArray ? count * ids[array.count].value : 0;
+		type_id = array.element;
+	}
+
+	const SpirvId& resource = ids[type_id];
+	auto storage_class = static_cast<SpirvStorageClass>(variable.storage_class);
+
+	if (storage_class == SpirvStorageClass::eStorageBuffer)
+	{
+		type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		return true;
+	}
+	if (storage_class == SpirvStorageClass::eUniform)
+	{
+		type = resource.buffer_block
+			? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+			: VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		return true;
+	}
+	if (storage_class != SpirvStorageClass::eUniformConstant) {
+		return false;
+	}
+
+	switch (resource.op)
+	{
+	case SpirvOp::eTypeSampler:
+		type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		return true;
+	case SpirvOp::eTypeSampledImage:
+		type = static_cast<SpirvDim>(ids[resource.element].dim) == SpirvDim::eBuffer
+			? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+			: VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		return true;
+	case SpirvOp::eTypeImage:
+		if (static_cast<SpirvDim>(resource.dim) == SpirvDim::eBuffer) {
+			type = resource.sampled == 2
+				? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+				: VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+		}
+		else if (static_cast<SpirvDim>(resource.dim) == SpirvDim::eSubpassData) {
+			type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		}
+		else {
+			type = resource.sampled == 2
+				? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+				: VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		return true;
+	case SpirvOp::eTypeAccelerationStructure:
+		type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static VkFormat s_GetVertexFormat(const std::vector<SpirvId>& ids, uint32_t type_id)
+{
+	static constexpr VkFormat s_FloatFormats[] = {
+		VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT
+	};
+	static constexpr VkFormat s_SintFormats[] = {
+		VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT
+	};
+	static constexpr VkFormat s_UintFormats[] = {
+		VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT
+	};
+
+	uint32_t count = 1;
+	const SpirvId* component = &ids[type_id];
+	if (component->op == SpirvOp::eTypeVector)
+	{
+		count = component->count;
+		component = &ids[component->element];
+	}
+
+	if (count < 1 || count > 4 || component->width != 32) {
+		return VK_FORMAT_UNDEFINED;
+	}
+	if (component->op == SpirvOp::eTypeFloat) {
+		return s_FloatFormats[count - 1];
+	}
+	if (component->op == SpirvOp::eTypeInt) {
+		return component->is_signed ? s_SintFormats[count - 1] : s_UintFormats[count - 1];
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+bool ShaderReflection::reflect(const void* code, size_t size)
+{
+	*this = {};
+
+	if (code == nullptr || size % sizeof(uint32_t) != 0 || size < s_SpirvHeaderSize * sizeof(uint32_t)) {
+		return false;
+	}
+
+	const auto* words = static_cast<const uint32_t*>(code);
+	uint32_t nb_words = static_cast<uint32_t>(size / sizeof(uint32_t));
+	if (words[0] != s_SpirvMagic) {
+		return false;
+	}
+
+	uint32_t version = words[1];
+	uint32_t bound = words[3];
+	std::vector<SpirvId> ids(bound);
+	std::vector<SpirvEntryPoint> entry_points;
+
+	auto is_valid_id = [bound](uint32_t id) { return id < bound; };
+
+	// Gathers the ids
+	for (uint32_t offset = s_SpirvHeaderSize; offset < nb_words;)
+	{
+		uint32_t nb_instruction_words = words[offset] >> 16;
+		auto op = static_cast<SpirvOp>(words[offset] & 0xFFFF);
+		if (nb_instruction_words == 0 || offset + nb_instruction_words > nb_words) {
+			return false;
+		}
+
+		const uint32_t* operands = words + offset + 1;
+		uint32_t nb_operands = nb_instruction_words - 1;
+		offset += nb_instruction_words;
+
+		// Every handled instruction has at least 2 operands, except the
+		// types without parameters
+		uint32_t result = nb_operands > 0 ? operands[0] : s_NoValue;
+		if (!is_valid_id(result)) {
+			continue;
+		}
+
+		switch (op)
+		{
+		case SpirvOp::eName:
+		{
+			uint32_t nb_read = 0;
+			ids[result].name = s_ReadString(operands + 1, nb_operands - 1, nb_read);
+			break;
+		}
+		case SpirvOp::eEntryPoint:
+		{
+			if (nb_operands < 3) {
+				return false;
+			}
+			SpirvEntryPoint entry_point;
+			if (!s_GetStage(operands[0], entry_point.entry_point.stage)) {
+				break;
+			}
+
+			uint32_t nb_read = 0;
+			entry_point.entry_point.name = s_ReadString(operands + 2, nb_operands - 2, nb_read);
+			for (uint32_t i = 2 + nb_read; i < nb_operands; ++i) {
+				entry_point.interface.push_back(operands[i]);
+			}
+			entry_points.push_back(std::move(entry_point));
+			break;
+		}
+		case SpirvOp::eDecorate:
+		{
+			if (nb_operands < 2) {
+				return false;
+			}
+			SpirvId& target = ids[operands[0]];
+			uint32_t value = nb_operands > 2 ? operands[2] : 0;
+
+			switch (static_cast<SpirvDecoration>(operands[1]))
+			{
+			case SpirvDecoration::eBlock: target.block = true; break;
+			case SpirvDecoration::eBufferBlock: target.buffer_block = true; break;
+			case SpirvDecoration::eArrayStride: target.array_stride = value; break;
+			case SpirvDecoration::eBuiltIn: target.builtin = true; break;
+			case SpirvDecoration::eLocation: target.location = value; break;
+			case SpirvDecoration::eBinding: target.binding = value; break;
+			case SpirvDecoration::eDescriptorSet: target.set = value; break;
+			default: break;
+			}
+			break;
+		}
+		case SpirvOp::eMemberDecorate:
+		{
+			if (nb_operands < 3) {
+				return false;
+			}
+			SpirvId& target = ids[operands[0]];
+			uint32_t member_index = operands[1];
+			uint32_t value = nb_operands > 3 ? operands[3] : 0;
+
+			if (member_index >= target.member_decorations.size()) {
+				target.member_decorations.resize(member_index + 1);
+			}
+			SpirvMember& member = target.member_decorations[member_index];
+
+			switch (static_cast<SpirvDecoration>(operands[2]))
+			{
+			case SpirvDecoration::eOffset: member.offset = value; break;
+			case SpirvDecoration::eMatrixStride: member.matrix_stride = value; break;
+			case SpirvDecoration::eBuiltIn: member.builtin = true; break;
+			default: break;
+			}
+			break;
+		}
+		case SpirvOp::eTypeBool:
+		case SpirvOp::eTypeSampler:
+		case SpirvOp::eTypeAccelerationStructure:
+			ids[result].op = op;
+			break;
+		case SpirvOp::eTypeInt:
+		case SpirvOp::eTypeFloat:
+			if (nb_operands < 2) {
+				return false;
+			}
+			ids[result].op = op;
+			ids[result].width = operands[1];
+			ids[result].is_signed = op == SpirvOp::eTypeInt && nb_operands > 2 && operands[2] != 0;
+			break;
+		case SpirvOp::eTypeVector:
+		case SpirvOp::eTypeMatrix:
+		case SpirvOp::eTypeArray:
+			if (nb_operands < 3 || !is_valid_id(operands[1]) || !is_valid_id(operands[2])) {
+				return false;
+			}
+			ids[result].op = op;
+			ids[result].element = operands[1];
+			ids[result].count = operands[2];
+			break;
+		case SpirvOp::eTypeImage:
+			if (nb_operands < 7) {
+				return false;
+			}
+			ids[result].op = op;
+			ids[result].dim = operands[2];
+			ids[result].sampled = operands[6];
+			break;
+		case SpirvOp::eTypeSampledImage:
+		case SpirvOp::eTypeRuntimeArray:
+			if (nb_operands < 2 || !is_valid_id(operands[1])) {
+				return false;
+			}
+			ids[result].op = op;
+			ids[result].element = operands[1];
+			break;
+		case SpirvOp::eTypeStruct:
+			ids[result].op = op;
+			for (uint32_t i = 1; i < nb_operands; ++i)
+			{
+				if (!is_valid_id(operands[i])) {
+					return false;
+				}
+				ids[result].members.push_back(operands[i]);
+			}
+			break;
+		case SpirvOp::eTypePointer:
+			if (nb_operands < 3 || !is_valid_id(operands[2])) {
+				return false;
+			}
+			ids[result].op = op;
+			ids[result].storage_class = operands[1];
+			ids[result].element = operands[2];
+			break;
+		case SpirvOp::eConstant:
+		case SpirvOp::eSpecConstant:
+			// Result type first: the result is the second operand
+			if (nb_operands < 3 || !is_valid_id(operands[1])) {
+				return false;
+			}
+			ids[operands[1]].op = op;
+			ids[operands[1]].value = operands[2];
+			break;
+		case SpirvOp::eVariable:
+			if (nb_operands < 3 || !is_valid_id(operands[1]) || ids[result].op != SpirvOp::eTypePointer) {
+				return false;
+			}
+			ids[operands[1]].op = op;
+			ids[operands[1]].element = operands[0];
+			ids[operands[1]].storage_class = operands[2];
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (SpirvId& id : ids) {
+		id.member_decorations.resize(id.members.size());
+	}
+
+	// Stages using each variable
+	std::vector<VkShaderStageFlags> variable_stages(bound, 0);
+	VkShaderStageFlags all_stages = 0;
+	for (const auto& entry_point : entry_points)
+	{
+		this->entry_points.push_back(entry_point.entry_point);
+		all_stages |= entry_point.entry_point.stage;
+
+		for (uint32_t id : entry_point.interface)
+		{
+			if (is_valid_id(id)) {
+				variable_stages[id] |= entry_point.entry_point.stage;
+			}
+		}
+	}
+
+	for (uint32_t id = 0; id < bound; ++id)
+	{
+		const SpirvId& variable = ids[id];
+		if (variable.op != SpirvOp::eVariable) {
+			continue;
+		}
+
+		auto storage_class = static_cast<SpirvStorageClass>(variable.storage_class);
+		VkShaderStageFlags stages = (
+			version >= s_SpirvVersion14 || storage_class == SpirvStorageClass::eInput
+				? variable_stages[id]
+				: all_stages
+		);
+		if (stages == 0) {
+			continue;
+		}
+
+		uint32_t type_id = ids[variable.element].element;
+
+		if (storage_class == SpirvStorageClass::ePushConstant)
+		{
+			const SpirvId& block = ids[type_id];
+			uint32_t begin = UINT32_MAX;
+			for (const auto& member : block.member_decorations) {
+				begin = std::min(begin, member.offset);
+			}
+			if (begin == UINT32_MAX || begin == s_NoValue) {
+				begin = 0;
+			}
+			push_constants.push_back({begin, s_GetSize(ids, type_id) - begin, stages});
+		}
+		else if (storage_class == SpirvStorageClass::eInput)
+		{
+			// Vertex attributes only (no built-ins)
+			if ((stages & VK_SHADER_STAGE_VERTEX_BIT) == 0 || variable.builtin || variable.location == s_NoValue) {
+				continue;
+			}
+			vertex_inputs.push_back({variable.location, s_GetVertexFormat(ids, type_id), variable.name});
+		}
+		else if (variable.binding != s_NoValue)
+		{
+			ShaderBinding binding;
+			binding.set = variable.set;
+			binding.binding = variable.binding;
+			binding.stages = stages;
+			binding.name = variable.name;
+			if (s_GetDescriptorType(ids, variable, binding.type, binding.count)) {
+				bindings.push_back(std::move(binding));
+			}
+		}
+	}
+
+	std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) {
+		return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+	});
+	std::sort(vertex_inputs.begin(), vertex_inputs.end(), [](const auto& a, const auto& b) {
+		return a.location < b.location;
+	});
+	return true;
+}
+
+const ShaderEntryPoint* ShaderReflection::find_entry_point(VkShaderStageFlagBits stage) const
+{
+	auto it = std::find_if(entry_points.begin(), entry_points.end(), [stage](const auto& entry_point) {
+		return entry_point.stage == stage;
+	});
+	return it != entry_points.end() ? &*it : nullptr;
+}
+
+const ShaderEntryPoint* ShaderReflection::find_entry_point(const std::string& name) const
+{
+	auto it = std::find_if(entry_points.begin(), entry_points.end(), [&name](const auto& entry_point) {
+		return entry_point.name == name;
+	});
+	return it != entry_points.end() ? &*it : nullptr;
+}
+
+} // namespace resource
+} // namespace jdl
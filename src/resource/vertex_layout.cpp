@@ -0,0 +1,438 @@
+#include "resource/vertex_layout.hpp"
+#include "resource/shader.hpp"
+
+#include "utils/hash.hpp"
+
+#include "vk/vulkan_pipeline_desc.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+
+namespace jdl
+{
+namespace resource
+{
+
+// --- ENCODING ---
+
+static int16_t s_ToSnorm16(float value)
+{
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static uint8_t s_ToUnorm8(float value)
+{
+	return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+// IEEE 754 half float, rounded to nearest even (overflows to infinity)
+static uint16_t s_ToHalf(float value)
+{
+	uint32_t bits = std::bit_cast<uint32_t>(value);
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t exponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	// NaN and infinity
+	if (exponent == 0xff) {
+		return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+	}
+
+	int32_t half_exponent = static_cast<int32_t>(exponent) - 127 + 15;
+	if (half_exponent >= 0x1f) {
+		return static_cast<uint16_t>(sign | 0x7c00);
+	}
+
+	if (half_exponent <= 0)
+	{
+		// Subnormal half (or zero)
+		if (half_exponent < -10) {
+			return static_cast<uint16_t>(sign);
+		}
+		mantissa |= 0x800000;
+		uint32_t shift = static_cast<uint32_t>(14 - half_exponent);
+		uint32_t half_mantissa = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+			++half_mantissa;
+		}
+		return static_cast<uint16_t>(sign | half_mantissa);
+	}
+
+	uint32_t half = sign | (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+		// May carry into the exponent, which is the correct rounding
+		++half;
+	}
+	return static_cast<uint16_t>(half);
+}
+
+// Octahedral mapping of a unit vector to [-1, 1]^2
+static std::array<float, 2> s_OctEncode(float x, float y, float z)
+{
+	float norm = std::abs(x) + std::abs(y) + std::abs(z);
+	if (norm == 0.0f) {
+		return {0.0f, 0.0f};
+	}
+	x /= norm;
+	y /= norm;
+
+	if (z < 0.0f)
+	{
+		float u = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float v = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		return {u, v};
+	}
+	return {x, y};
+}
+
+template<class T>
+static void s_Store(uint8_t* dst, const T& value)
+{
+	std::memcpy(dst, &value, sizeof(T));
+}
+
+// Writes one attribute of a vertex (src holds the full precision components)
+static void s_EncodeAttribute(
+	VertexAttribute attribute,
+	VertexFormat format,
+	const float* src,
+	const MeshBounds& bounds,
+	uint8_t* dst
+)
+{
+	switch (format)
+	{
+		case VertexFormat::eFloat32x2:
+			std::memcpy(dst, src, 2 * sizeof(float));
+			break;
+		case VertexFormat::eFloat32x3:
+			std::memcpy(dst, src, 3 * sizeof(float));
+			break;
+		case VertexFormat::eFloat32x4:
+			std::memcpy(dst, src, 4 * sizeof(float));
+			break;
+		case VertexFormat::eFloat16x2:
+			s_Store(dst, std::array<uint16_t, 2>{ s_ToHalf(src[0]), s_ToHalf(src[1]) });
+			break;
+		case VertexFormat::eSnorm16x4:
+		{
+			std::array<int16_t, 4> value { 0, 0, 0, 32767 };
+			for (size_t i = 0; i < 3; ++i)
+			{
+				float extent = bounds.extent[i];
+				value[i] = s_ToSnorm16(extent > 0.0f ? (src[i] - bounds.center[i]) / extent : 0.0f);
+			}
+			s_Store(dst, value);
+			break;
+		}
+		case VertexFormat::eOctSnorm16x2:
+		{
+			auto [u, v] = s_OctEncode(src[0], src[1], src[2]);
+			if (attribute == VertexAttribute::eTangent)
+			{
+				// Handedness in the sign of v: v is remapped to [0, 1], kept
+				// away from 0 which has no sign
+				v = std::max(v * 0.5f + 0.5f, 1.0f / 32767.0f);
+				if (src[3] < 0.0f) {
+					v = -v;
+				}
+			}
+			s_Store(dst, std::array<int16_t, 2>{ s_ToSnorm16(u), s_ToSnorm16(v) });
+			break;
+		}
+		case VertexFormat::eUnorm8x4:
+			s_Store(dst, std::array<uint8_t, 4>{
+				s_ToUnorm8(src[0]), s_ToUnorm8(src[1]), s_ToUnorm8(src[2]), s_ToUnorm8(src[3])
+			});
+			break;
+		case VertexFormat::eNone:
+			break;
+	}
+}
+
+// --- VertexLayout STRUCT ---
+
+VertexLayout VertexLayout::Full(bool has_tangents, bool has_colors)
+{
+	VertexLayout layout;
+	layout.set_format(VertexAttribute::ePosition, VertexFormat::eFloat32x3)
+		.set_format(VertexAttribute::eNormal, VertexFormat::eFloat32x3)
+		.set_format(VertexAttribute::eTexCoord, VertexFormat::eFloat32x2);
+	if (has_tangents) {
+		layout.set_format(VertexAttribute::eTangent, VertexFormat::eFloat32x4);
+	}
+	if (has_colors) {
+		layout.set_format(VertexAttribute::eColor, VertexFormat::eFloat32x4);
+	}
+	return layout;
+}
+
+VertexLayout VertexLayout::Compact(bool has_tangents, bool has_colors)
+{
+	VertexLayout layout;
+	layout.streams = VertexStreams::eSplitPositions;
+	layout.set_format(VertexAttribute::ePosition, VertexFormat::eSnorm16x4)
+		.set_format(VertexAttribute::eNormal, VertexFormat::eOctSnorm16x2)
+		.set_format(VertexAttribute::eTexCoord, VertexFormat::eFloat16x2);
+	if (has_tangents) {
+		layout.set_format(VertexAttribute::eTangent, VertexFormat::eOctSnorm16x2);
+	}
+	if (has_colors) {
+		layout.set_format(VertexAttribute::eColor, VertexFormat::eUnorm8x4);
+	}
+	return layout;
+}
+
+VertexLayout VertexLayout::ForData(const VertexData& data, bool full_precision)
+{
+	bool has_tangents = !data.tangents.empty();
+	bool has_colors = !data.colors.empty();
+	VertexLayout layout = full_precision ? Full(has_tangents, has_colors) : Compact(has_tangents, has_colors);
+
+	if (data.normals.empty()) {
+		layout.set_format(VertexAttribute::eNormal, VertexFormat::eNone);
+	}
+	if (data.texcoords.empty()) {
+		layout.set_format(VertexAttribute::eTexCoord, VertexFormat::eNone);
+	}
+
+	// Nothing to split from the positions
+	if (layout.get_stride(1) == 0) {
+		layout.streams = VertexStreams::eInterleaved;
+	}
+	return layout;
+}
+
+uint32_t VertexLayout::GetFormatSize(VertexFormat format)
+{
+	switch (format)
+	{
+		case VertexFormat::eFloat32x2: return 8;
+		case VertexFormat::eFloat32x3: return 12;
+		case VertexFormat::eFloat32x4: return 16;
+		case VertexFormat::eFloat16x2: return 4;
+		case VertexFormat::eSnorm16x4: return 8;
+		case VertexFormat::eOctSnorm16x2: return 4;
+		case VertexFormat::eUnorm8x4: return 4;
+		case VertexFormat::eNone: return 0;
+	}
+	return 0;
+}
+
+VkFormat VertexLayout::GetVkFormat(VertexFormat format)
+{
+	switch (format)
+	{
+		case VertexFormat::eFloat32x2: return VK_FORMAT_R32G32_SFLOAT;
+		case VertexFormat::eFloat32x3: return VK_FORMAT_R32G32B32_SFLOAT;
+		case VertexFormat::eFloat32x4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+		case VertexFormat::eFloat16x2: return VK_FORMAT_R16G16_SFLOAT;
+		case VertexFormat::eSnorm16x4: return VK_FORMAT_R16G16B16A16_SNORM;
+		case VertexFormat::eOctSnorm16x2: return VK_FORMAT_R16G16_SNORM;
+		case VertexFormat::eUnorm8x4: return VK_FORMAT_R8G8B8A8_UNORM;
+		case VertexFormat::eNone: return VK_FORMAT_UNDEFINED;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+uint32_t VertexLayout::get_offset(VertexAttribute attribute) const
+{
+	// Attributes are packed in their enumeration order
+	uint32_t stream = get_stream(attribute);
+	uint32_t offset = 0;
+	for (size_t i = 0; i < static_cast<size_t>(attribute); ++i)
+	{
+		if (get_stream(static_cast<VertexAttribute>(i)) == stream) {
+			offset += GetFormatSize(formats[i]);
+		}
+	}
+	return offset;
+}
+
+uint32_t VertexLayout::get_stride(uint32_t stream) const
+{
+	uint32_t stride = 0;
+	for (size_t i = 0; i < s_NbAttributes; ++i)
+	{
+		if (get_stream(static_cast<VertexAttribute>(i)) == stream) {
+			stride += GetFormatSize(formats[i]);
+		}
+	}
+	return stride;
+}
+
+uint32_t VertexLayout::get_vertex_size() const
+{
+	uint32_t size = 0;
+	for (VertexFormat format : formats) {
+		size += GetFormatSize(format);
+	}
+	return size;
+}
+
+bool VertexLayout::is_valid() const
+{
+	auto is_allowed = [](VertexFormat format, std::initializer_list<VertexFormat> allowed) {
+		return format == VertexFormat::eNone ||
+			std::find(allowed.begin(), allowed.end(), format) != allowed.end();
+	};
+
+	using enum VertexFormat;
+	return has(VertexAttribute::ePosition)
+		&& (streams == VertexStreams::eInterleaved || get_stride(1) > 0)
+		&& is_allowed(get_format(VertexAttribute::ePosition), {eFloat32x3, eFloat32x4, eSnorm16x4})
+		&& is_allowed(get_format(VertexAttribute::eNormal), {eFloat32x3, eFloat32x4, eOctSnorm16x2})
+		&& is_allowed(get_format(VertexAttribute::eTangent), {eFloat32x4, eOctSnorm16x2})
+		&& is_allowed(get_format(VertexAttribute::eTexCoord), {eFloat32x2, eFloat16x2})
+		&& is_allowed(get_format(VertexAttribute::eColor), {eFloat32x4, eUnorm8x4});
+}
+
+void VertexLayout::fill_pipeline_desc(vk::PipelineDesc& desc) const
+{
+	const ShaderReflection* reflection = nullptr;
+	for (const auto& shader : desc.shaders)
+	{
+		if (shader.stage == vk::ShaderStage::eVertex && shader.shader != nullptr) {
+			reflection = &shader.shader->get_reflection();
+		}
+	}
+
+	desc.vertex_bindings.clear();
+	desc.vertex_attributes.clear();
+
+	std::array<bool, s_MaxStreams> used_streams {};
+	for (size_t i = 0; i < s_NbAttributes; ++i)
+	{
+		auto attribute = static_cast<VertexAttribute>(i);
+		if (!has(attribute)) {
+			continue;
+		}
+
+		uint32_t location = static_cast<uint32_t>(i);
+		if (reflection != nullptr)
+		{
+			bool is_read = std::any_of(
+				reflection->vertex_inputs.begin(), reflection->vertex_inputs.end(),
+				[location](const auto& input) { return input.location == location; }
+			);
+			if (!is_read) {
+				continue;
+			}
+		}
+
+		uint32_t stream = get_stream(attribute);
+		used_streams[stream] = true;
+		desc.vertex_attributes.push_back({
+			location, stream, GetVkFormat(formats[i]), get_offset(attribute)
+		});
+	}
+
+	// Unused streams are not bound, the mesh keeps binding all of them
+	for (uint32_t stream = 0; stream < get_nb_streams(); ++stream)
+	{
+		if (used_streams[stream]) {
+			desc.vertex_bindings.push_back({stream, get_stride(stream), VK_VERTEX_INPUT_RATE_VERTEX});
+		}
+	}
+}
+
+uint64_t VertexLayout::hash() const
+{
+	uint64_t h = utils::fnv1a_64(streams, utils::s_Fnv1aOffsetBasis);
+	for (VertexFormat format : formats) {
+		h = utils::fnv1a_64(format, h);
+	}
+	return h;
+}
+
+// --- VERTEX DATA ---
+
+MeshBounds VertexData::compute_bounds() const
+{
+	MeshBounds bounds;
+	size_t nb_vertices = get_nb_vertices();
+	if (nb_vertices == 0) {
+		return bounds;
+	}
+
+	std::array<float, 3> min { positions[0], positions[1], positions[2] };
+	std::array<float, 3> max = min;
+	for (size_t v = 1; v < nb_vertices; ++v)
+	{
+		for (size_t i = 0; i < 3; ++i)
+		{
+			min[i] = std::min(min[i], positions[3 * v + i]);
+			max[i] = std::max(max[i], positions[3 * v + i]);
+		}
+	}
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		bounds.center[i] = 0.5f * (min[i] + max[i]);
+		bounds.extent[i] = 0.5f * (max[i] - min[i]);
+	}
+	return bounds;
+}
+
+void encode_vertices(
+	const VertexData& data,
+	const VertexLayout& layout,
+	const MeshBounds& bounds,
+	std::array<std::vector<uint8_t>, VertexLayout::s_MaxStreams>& streams
+)
+{
+	size_t nb_vertices = data.get_nb_vertices();
+
+	// Source array, components and default value of each attribute
+	struct Source
+	{
+		const std::vector<float>* values;
+		size_t nb_components;
+		std::array<float, 4> fallback;
+	};
+	const std::array<Source, VertexLayout::s_NbAttributes> sources {{
+		{&data.positions, 3, {0.0f, 0.0f, 0.0f, 1.0f}},
+		{&data.normals, 3, {0.0f, 0.0f, 1.0f, 0.0f}},
+		{&data.tangents, 4, {1.0f, 0.0f, 0.0f, 1.0f}},
+		{&data.texcoords, 2, {0.0f, 0.0f, 0.0f, 0.0f}},
+		{&data.colors, 4, {1.0f, 1.0f, 1.0f, 1.0f}}
+	}};
+
+	for (uint32_t stream = 0; stream < VertexLayout::s_MaxStreams; ++stream) {
+		streams[stream].assign(nb_vertices * layout.get_stride(stream), 0);
+	}
+
+	for (size_t i = 0; i < VertexLayout::s_NbAttributes; ++i)
+	{
+		auto attribute = static_cast<VertexAttribute>(i);
+		VertexFormat format = layout.get_format(attribute);
+		if (format == VertexFormat::eNone) {
+			continue;
+		}
+
+		const Source& source = sources[i];
+		bool has_values = source.values->size() >= nb_vertices * source.nb_components;
+
+		uint32_t stream = layout.get_stream(attribute);
+		uint32_t stride = layout.get_stride(stream);
+		uint8_t* dst = streams[stream].data() + layout.get_offset(attribute);
+
+		for (size_t v = 0; v < nb_vertices; ++v, dst += stride)
+		{
+			std::array<float, 4> value = source.fallback;
+			if (has_values) {
+				std::copy_n(source.values->data() + v * source.nb_components, source.nb_components, value.begin());
+			}
+			s_EncodeAttribute(attribute, format, value.data(), bounds, dst);
+		}
+	}
+}
+
+} // namespace resource
+} // namespace jdl
@@ -0,0 +1,70 @@
+#include "utils/epoch_manager.hpp"
+
+
+namespace jdl
+{
+namespace utils
+{
+
+namespace
+{
+    // Round-robin shard of the calling thread
+    uint32_t s_GetThreadShard(uint32_t nb_shards)
+    {
+        static std::atomic<uint32_t> s_NextShard = 0;
+        thread_local const uint32_t s_Shard = s_NextShard.fetch_add(1, std::memory_order_relaxed);
+        return s_Shard % nb_shards;
+    }
+}
+
+EpochGuard::EpochGuard(EpochManager& manager, uint32_t shard, uint32_t parity)
+    : m_manager(manager), m_shard(shard), m_parity(parity)
+{}
+
+EpochGuard::~EpochGuard()
+{
+    m_manager.unpin(m_shard, m_parity);
+}
+
+EpochGuard EpochManager::pin()
+{
+    uint32_t shard = s_GetThreadShard(s_NbShards);
+
+    for (;;)
+    {
+        uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        uint32_t parity = static_cast<uint32_t>(epoch & 1);
+        m_shards[shard].readers[parity].fetch_add(1, std::memory_order_seq_cst);
+
+        // The epoch may have moved before the counter was visible
+        if (m_epoch.load(std::memory_order_seq_cst) == epoch) {
+            return EpochGuard(*this, shard, parity);
+        }
+        m_shards[shard].readers[parity].fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+void EpochManager::unpin(uint32_t shard, uint32_t parity)
+{
+    m_shards[shard].readers[parity].fetch_sub(1, std::memory_order_seq_cst);
+}
+
+uint64_t EpochManager::try_advance()
+{
+    uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+
+    // Readers of epoch - 1 share the parity of epoch + 1
+    uint32_t parity = static_cast<uint32_t>((epoch + 1) & 1);
+    for (const Shard& shard : m_shards)
+    {
+        if (shard.readers[parity].load(std::memory_order_seq_cst) != 0) {
+            return epoch;
+        }
+    }
+
+    m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    return m_epoch.load(std::memory_order_seq_cst);
+}
+
+} // namespace utils
+} // namespace jdl
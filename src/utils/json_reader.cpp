@@ -0,0 +1,445 @@
+#include "utils/json_reader.hpp"
+
+#include <charconv>
+#include <cmath>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+// Containers deeper than this are rejected by skip() (no recursion)
+static constexpr uint32_t s_MaxSkipDepth = 256;
+
+static bool s_IsWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static int s_HexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool s_ParseHex4(std::string_view text, size_t offset, uint32_t& value)
+{
+    if (offset + 4 > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        int digit = s_HexValue(text[offset + i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+static void s_AppendUtf8(std::string& output, uint32_t code_point)
+{
+    if (code_point < 0x80) {
+        output += static_cast<char>(code_point);
+    }
+    else if (code_point < 0x800)
+    {
+        output += static_cast<char>(0xc0 | (code_point >> 6));
+        output += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    else if (code_point < 0x10000)
+    {
+        output += static_cast<char>(0xe0 | (code_point >> 12));
+        output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        output += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    else
+    {
+        output += static_cast<char>(0xf0 | (code_point >> 18));
+        output += static_cast<char>(0x80 | ((code_point >> 12) & 0x3f));
+        output += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+        output += static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+}
+
+char JsonReader::peek_char()
+{
+    while (m_offset < m_text.size() && s_IsWhitespace(m_text[m_offset])) {
+        ++m_offset;
+    }
+    return m_offset < m_text.size() ? m_text[m_offset] : '\0';
+}
+
+bool JsonReader::consume(char c)
+{
+    if (m_error || peek_char() != c) {
+        return fail();
+    }
+    ++m_offset;
+    return true;
+}
+
+bool JsonReader::fail()
+{
+    m_error = true;
+    return false;
+}
+
+JsonReader::Type JsonReader::peek()
+{
+    if (m_error) {
+        return Type::eInvalid;
+    }
+
+    switch (peek_char())
+    {
+        case 'n': return Type::eNull;
+        case 't':
+        case 'f': return Type::eBool;
+        case '"': return Type::eString;
+        case '[': return Type::eArray;
+        case '{': return Type::eObject;
+        case '-':
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return Type::eNumber;
+        default: return Type::eInvalid;
+    }
+}
+
+bool JsonReader::begin_object()
+{
+    if (!consume('{')) {
+        return false;
+    }
+    m_first = true;
+    return true;
+}
+
+bool JsonReader::begin_array()
+{
+    if (!consume('[')) {
+        return false;
+    }
+    m_first = true;
+    return true;
+}
+
+bool JsonReader::next_item(char closing)
+{
+    if (m_error) {
+        return false;
+    }
+
+    char c = peek_char();
+    if (c == closing)
+    {
+        ++m_offset;
+        m_first = false;
+        return false;
+    }
+
+    // Items after the first one are preceded by a comma
+    if (!m_first && !consume(',')) {
+        return false;
+    }
+    m_first = false;
+    return true;
+}
+
+bool JsonReader::next_member(std::string_view& key)
+{
+    if (!next_item('}')) {
+        return false;
+    }
+    return scan_string(key) && consume(':');
+}
+
+bool JsonReader::next_element()
+{
+    return next_item(']');
+}
+
+bool JsonReader::scan_string(std::string_view& value)
+{
+    if (!consume('"')) {
+        return false;
+    }
+
+    size_t begin = m_offset;
+    while (m_offset < m_text.size())
+    {
+        char c = m_text[m_offset];
+        if (c == '"')
+        {
+            value = m_text.substr(begin, m_offset - begin);
+            ++m_offset;
+            return true;
+        }
+        if (c == '\\') {
+            ++m_offset;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            return fail();
+        }
+        ++m_offset;
+    }
+    return fail();
+}
+
+bool JsonReader::read_raw_string(std::string_view& value)
+{
+    return scan_string(value);
+}
+
+bool JsonReader::read_string(std::string& value)
+{
+    std::string_view raw;
+    if (!scan_string(raw)) {
+        return false;
+    }
+
+    value.clear();
+    value.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        if (raw[i] != '\\')
+        {
+            value += raw[i];
+            continue;
+        }
+
+        // scan_string() guarantees a character after the backslash
+        char escape = raw[++i];
+        switch (escape)
+        {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u':
+            {
+                uint32_t code_point = 0;
+                if (!s_ParseHex4(raw, i + 1, code_point)) {
+                    return fail();
+                }
+                i += 4;
+
+                // Surrogate pair
+                if (code_point >= 0xd800 && code_point < 0xdc00)
+                {
+                    uint32_t low = 0;
+                    if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u'
+                        || !s_ParseHex4(raw, i + 3, low) || low < 0xdc00 || low >= 0xe000)
+                    {
+                        return fail();
+                    }
+                    i += 6;
+                    code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+                }
+                s_AppendUtf8(value, code_point);
+                break;
+            }
+            default:
+                return fail();
+        }
+    }
+    return true;
+}
+
+bool JsonReader::read_number(double& value)
+{
+    if (m_error || peek() != Type::eNumber) {
+        return fail();
+    }
+
+    const char* begin = m_text.data() + m_offset;
+    const char* end = m_text.data() + m_text.size();
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc()) {
+        return fail();
+    }
+    m_offset += static_cast<size_t>(result.ptr - begin);
+    return true;
+}
+
+bool JsonReader::read_float(float& value)
+{
+    double number = 0.0;
+    if (!read_number(number)) {
+        return false;
+    }
+    value = static_cast<float>(number);
+    return true;
+}
+
+bool JsonReader::read_uint64(uint64_t& value)
+{
+    double number = 0.0;
+    if (!read_number(number)) {
+        return false;
+    }
+    // Exact integers only (2^53 is the largest exact double)
+    if (number < 0.0 || number > 9007199254740992.0 || std::floor(number) != number) {
+        return fail();
+    }
+    value = static_cast<uint64_t>(number);
+    return true;
+}
+
+bool JsonReader::read_uint(uint32_t& value)
+{
+    uint64_t number = 0;
+    if (!read_uint64(number)) {
+        return false;
+    }
+    if (number > UINT32_MAX) {
+        return fail();
+    }
+    value = static_cast<uint32_t>(number);
+    return true;
+}
+
+bool JsonReader::read_bool(bool& value)
+{
+    if (m_error) {
+        return false;
+    }
+
+    peek_char();
+    if (m_text.substr(m_offset, 4) == "true")
+    {
+        value = true;
+        m_offset += 4;
+        return true;
+    }
+    if (m_text.substr(m_offset, 5) == "false")
+    {
+        value = false;
+        m_offset += 5;
+        return true;
+    }
+    return fail();
+}
+
+size_t JsonReader::read_floats(float* values, size_t max_count)
+{
+    if (!begin_array()) {
+        return 0;
+    }
+
+    size_t count = 0;
+    while (next_element())
+    {
+        if (count == max_count || !read_float(values[count])) {
+            fail();
+            return 0;
+        }
+        ++count;
+    }
+    return m_error ? 0 : count;
+}
+
+bool JsonReader::skip()
+{
+    // Iterative, with the kind of each open container in a bit stack
+    uint8_t stack[s_MaxSkipDepth / 8] {};
+    uint32_t depth = 0;
+
+    do
+    {
+        if (m_error) {
+            return false;
+        }
+
+        // Inside a container: move to its next item, or close it
+        if (depth > 0)
+        {
+            bool is_object = (stack[(depth - 1) / 8] >> ((depth - 1) % 8)) & 1;
+            bool has_item = false;
+            if (is_object)
+            {
+                std::string_view key;
+                has_item = next_member(key);
+            }
+            else {
+                has_item = next_element();
+            }
+
+            if (!has_item)
+            {
+                if (m_error) {
+                    return false;
+                }
+                --depth;
+                continue;
+            }
+        }
+
+        switch (peek())
+        {
+            case Type::eObject:
+            case Type::eArray:
+            {
+                if (depth == s_MaxSkipDepth) {
+                    return fail();
+                }
+                bool is_object = peek_char() == '{';
+                uint8_t bit = static_cast<uint8_t>(1u << (depth % 8));
+                stack[depth / 8] = is_object ? (stack[depth / 8] | bit) : (stack[depth / 8] & ~bit);
+                ++depth;
+                ++m_offset;
+                m_first = true;
+                break;
+            }
+            case Type::eString:
+            {
+                std::string_view value;
+                scan_string(value);
+                break;
+            }
+            case Type::eNumber:
+            {
+                double value = 0.0;
+                read_number(value);
+                break;
+            }
+            case Type::eBool:
+            {
+                bool value = false;
+                read_bool(value);
+                break;
+            }
+            case Type::eNull:
+            {
+                if (m_text.substr(m_offset, 4) != "null") {
+                    return fail();
+                }
+                m_offset += 4;
+                break;
+            }
+            case Type::eInvalid:
+                return fail();
+        }
+    }
+    while (depth > 0);
+
+    return !m_error;
+}
+
+bool JsonReader::is_end()
+{
+    return peek_char() == '\0' && m_offset == m_text.size();
+}
+
+} // namespace utils
+} // namespace jdl
@@ -0,0 +1,81 @@
+#include "utils/mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JDL_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+
+namespace jdl
+{
+namespace utils
+{
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef JDL_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(file_stat.st_size);
+    if (m_size > 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        m_data = static_cast<const std::byte*>(data);
+    }
+
+    // The mapping stays valid once the descriptor is closed
+    ::close(fd);
+    return true;
+#else
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        return false;
+    }
+
+    m_buffer.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+
+    m_data = m_buffer.empty() ? nullptr : m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef JDL_HAS_MMAP
+    if (m_data != nullptr) {
+        munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+#endif
+    m_buffer = {};
+    m_data = nullptr;
+    m_size = 0;
+}
+
+} // namespace utils
+} // namespace jdl
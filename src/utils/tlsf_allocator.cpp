@@ -0,0 +1,260 @@
+#include "utils/tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+
+
+namespace jdl
+{
+namespace utils
+{
+
+TlsfAllocator::TlsfAllocator(uint64_t size)
+    : m_size(size)
+{
+    for (auto& lists : m_freeLists) {
+        lists.fill(s_InvalidNode);
+    }
+
+    uint32_t node = create_node();
+    m_nodes[node].offset = 0;
+    m_nodes[node].size = size;
+    insert_free_node(node);
+}
+
+TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0 || size > m_size) {
+        return {};
+    }
+
+    // Any node of size + alignment - 1 bytes can hold an aligned range
+    uint64_t search_size = size + (alignment > 1 ? alignment - 1 : 0);
+    uint32_t node = find_free_node(search_size);
+    if (node == s_InvalidNode) {
+        return {};
+    }
+    remove_free_node(node);
+
+    // Give the leading padding back to the free lists
+    uint64_t offset = m_nodes[node].offset;
+    uint64_t aligned_offset = (offset + alignment - 1) & ~(alignment - 1);
+    if (aligned_offset > offset)
+    {
+        uint32_t aligned_node = split_node(node, aligned_offset - offset);
+        insert_free_node(node);
+        node = aligned_node;
+    }
+
+    // Give the trailing space back to the free lists
+    if (m_nodes[node].size > size)
+    {
+        uint32_t remainder = split_node(node, size);
+        insert_free_node(remainder);
+    }
+
+    m_nodes[node].used = true;
+    m_usedSize += size;
+    ++m_nbAllocations;
+
+    return { .offset = m_nodes[node].offset, .size = size, .node = node };
+}
+
+void TlsfAllocator::free(uint32_t node)
+{
+    if (node >= m_nodes.size() || !m_nodes[node].used) {
+        return;
+    }
+
+    m_nodes[node].used = false;
+    m_usedSize -= m_nodes[node].size;
+    --m_nbAllocations;
+
+    // Merge with the free physical neighbours
+    uint32_t next = m_nodes[node].next_physical;
+    if (next != s_InvalidNode && !m_nodes[next].used)
+    {
+        remove_free_node(next);
+        merge_with_next(node);
+    }
+
+    uint32_t prev = m_nodes[node].prev_physical;
+    if (prev != s_InvalidNode && !m_nodes[prev].used)
+    {
+        remove_free_node(prev);
+        merge_with_next(prev);
+        node = prev;
+    }
+
+    insert_free_node(node);
+}
+
+uint64_t TlsfAllocator::get_largest_free_size() const
+{
+    if (m_firstLevelBitmap == 0) {
+        return 0;
+    }
+
+    // The largest node is in the highest non empty list
+    uint32_t fl = 63 - std::countl_zero(m_firstLevelBitmap);
+    uint32_t sl = 31 - std::countl_zero(m_secondLevelBitmaps[fl]);
+
+    uint64_t largest = 0;
+    for (uint32_t node = m_freeLists[fl][sl]; node != s_InvalidNode; node = m_nodes[node].next_free) {
+        largest = std::max(largest, m_nodes[node].size);
+    }
+    return largest;
+}
+
+void TlsfAllocator::MappingInsert(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    uint32_t msb = 63 - std::countl_zero(size);
+    if (msb < s_SecondLevelLog2)
+    {
+        // Small sizes are all stored in the first list, one size per sub-list
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+    }
+    else
+    {
+        fl = msb - s_SecondLevelLog2 + 1;
+        sl = static_cast<uint32_t>(size >> (msb - s_SecondLevelLog2)) & (s_SecondLevelCount - 1);
+    }
+}
+
+void TlsfAllocator::MappingSearch(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    // Round up to the next sub-list so that any node found is large enough
+    uint32_t msb = 63 - std::countl_zero(size);
+    if (msb >= s_SecondLevelLog2)
+    {
+        uint64_t round = (uint64_t(1) << (msb - s_SecondLevelLog2)) - 1;
+        if (size <= UINT64_MAX - round) {
+            size += round;
+        }
+    }
+    MappingInsert(size, fl, sl);
+}
+
+uint32_t TlsfAllocator::create_node()
+{
+    if (!m_unusedNodes.empty())
+    {
+        uint32_t node = m_unusedNodes.back();
+        m_unusedNodes.pop_back();
+        m_nodes[node] = {};
+        return node;
+    }
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void TlsfAllocator::release_node(uint32_t node)
+{
+    m_unusedNodes.push_back(node);
+}
+
+void TlsfAllocator::insert_free_node(uint32_t node)
+{
+    uint32_t fl, sl;
+    MappingInsert(m_nodes[node].size, fl, sl);
+
+    uint32_t head = m_freeLists[fl][sl];
+    m_nodes[node].prev_free = s_InvalidNode;
+    m_nodes[node].next_free = head;
+    if (head != s_InvalidNode) {
+        m_nodes[head].prev_free = node;
+    }
+    m_freeLists[fl][sl] = node;
+
+    m_firstLevelBitmap |= uint64_t(1) << fl;
+    m_secondLevelBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::remove_free_node(uint32_t node)
+{
+    uint32_t fl, sl;
+    MappingInsert(m_nodes[node].size, fl, sl);
+
+    uint32_t prev = m_nodes[node].prev_free;
+    uint32_t next = m_nodes[node].next_free;
+    if (prev != s_InvalidNode) {
+        m_nodes[prev].next_free = next;
+    }
+    else {
+        m_freeLists[fl][sl] = next;
+    }
+    if (next != s_InvalidNode) {
+        m_nodes[next].prev_free = prev;
+    }
+
+    if (m_freeLists[fl][sl] == s_InvalidNode)
+    {
+        m_secondLevelBitmaps[fl] &= ~(1u << sl);
+        if (m_secondLevelBitmaps[fl] == 0) {
+            m_firstLevelBitmap &= ~(uint64_t(1) << fl);
+        }
+    }
+}
+
+uint32_t TlsfAllocator::find_free_node(uint64_t size) const
+{
+    uint32_t fl, sl;
+    MappingSearch(size, fl, sl);
+    if (fl >= s_FirstLevelCount) {
+        return s_InvalidNode;
+    }
+
+    // First non empty sub-list of the same first level, then of the next ones
+    uint32_t sl_map = m_secondLevelBitmaps[fl] & (~0u << sl);
+    if (sl_map == 0)
+    {
+        uint64_t fl_map = fl + 1 < 64 ? m_firstLevelBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return s_InvalidNode;
+        }
+        fl = std::countr_zero(fl_map);
+        sl_map = m_secondLevelBitmaps[fl];
+    }
+    sl = std::countr_zero(sl_map);
+
+    // Rounding up the size guarantees that any node of the list is large enough
+    return m_freeLists[fl][sl];
+}
+
+uint32_t TlsfAllocator::split_node(uint32_t node, uint64_t size)
+{
+    uint32_t remainder = create_node();
+
+    Node& first = m_nodes[node];
+    Node& second = m_nodes[remainder];
+
+    second.offset = first.offset + size;
+    second.size = first.size - size;
+    second.prev_physical = node;
+    second.next_physical = first.next_physical;
+    if (second.next_physical != s_InvalidNode) {
+        m_nodes[second.next_physical].prev_physical = remainder;
+    }
+
+    first.size = size;
+    first.next_physical = remainder;
+
+    return remainder;
+}
+
+void TlsfAllocator::merge_with_next(uint32_t node)
+{
+    uint32_t next = m_nodes[node].next_physical;
+
+    m_nodes[node].size += m_nodes[next].size;
+    m_nodes[node].next_physical = m_nodes[next].next_physical;
+    if (m_nodes[node].next_physical != s_InvalidNode) {
+        m_nodes[m_nodes[node].next_physical].prev_physical = node;
+    }
+
+    release_node(next);
+}
+
+} // namespace utils
+} // namespace jdl
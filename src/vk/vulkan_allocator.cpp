@@ -0,0 +1,431 @@
+#include "vk/vulkan_allocator.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+#include <bit>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+static constexpr double s_MiB = 1024.0 * 1024.0;
+
+// Heaps smaller than this threshold get proportionally smaller blocks
+static constexpr VkDeviceSize s_SmallHeapSize = 1024ull * 1024 * 1024;
+
+VulkanAllocator::VulkanAllocator(VkDeviceSize block_size)
+	: m_blockSize(block_size)
+{
+	const auto& device = VulkanContext::GetDevice();
+	m_device = device.get_device();
+	m_memoryProperties = device.get_memory_properties();
+}
+
+VulkanAllocator::~VulkanAllocator()
+{
+	uint32_t nb_leaks = 0;
+	for (const auto& stats : m_dedicatedStats) {
+		nb_leaks += stats.count;
+	}
+
+	for (auto& block : m_blocks)
+	{
+		if (block == nullptr) {
+			continue;
+		}
+		nb_leaks += block->tlsf->get_nb_allocations();
+		free_memory(block->memory, block->mapped_data);
+	}
+	m_blocks.clear();
+
+	if (nb_leaks > 0) {
+		JDL_WARN("Vulkan Allocator: {} allocations have not been freed", nb_leaks);
+	}
+}
+
+VulkanAllocation VulkanAllocator::allocate(
+	const VkMemoryRequirements& requirements,
+	MemoryUsage usage,
+	bool linear,
+	bool dedicated
+)
+{
+	return do_allocate(requirements, usage, linear, dedicated, nullptr);
+}
+
+VulkanAllocation VulkanAllocator::allocate_buffer(VkBuffer buffer, MemoryUsage usage, bool dedicated)
+{
+	VkMemoryDedicatedRequirements dedicated_requirements {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS
+	};
+	VkMemoryRequirements2 requirements {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+		.pNext = &dedicated_requirements
+	};
+	VkBufferMemoryRequirementsInfo2 requirements_info {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+		.buffer = buffer
+	};
+	vkGetBufferMemoryRequirements2(m_device, &requirements_info, &requirements);
+
+	VkMemoryDedicatedAllocateInfo dedicated_info {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+		.buffer = buffer
+	};
+	dedicated |= dedicated_requirements.requiresDedicatedAllocation
+		|| dedicated_requirements.prefersDedicatedAllocation;
+
+	return do_allocate(requirements.memoryRequirements, usage, true, dedicated, &dedicated_info);
+}
+
+VulkanAllocation VulkanAllocator::allocate_image(VkImage image, MemoryUsage usage, bool dedicated)
+{
+	VkMemoryDedicatedRequirements dedicated_requirements {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS
+	};
+	VkMemoryRequirements2 requirements {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+		.pNext = &dedicated_requirements
+	};
+	VkImageMemoryRequirementsInfo2 requirements_info {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+		.image = image
+	};
+	vkGetImageMemoryRequirements2(m_device, &requirements_info, &requirements);
+
+	VkMemoryDedicatedAllocateInfo dedicated_info {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+		.image = image
+	};
+	dedicated |= dedicated_requirements.requiresDedicatedAllocation
+		|| dedicated_requirements.prefersDedicatedAllocation;
+
+	return do_allocate(requirements.memoryRequirements, usage, false, dedicated, &dedicated_info);
+}
+
+VulkanAllocation VulkanAllocator::do_allocate(
+	const VkMemoryRequirements& requirements,
+	MemoryUsage usage,
+	bool linear,
+	bool dedicated,
+	const VkMemoryDedicatedAllocateInfo* dedicated_info
+)
+{
+	uint32_t memory_type = find_memory_type(requirements.memoryTypeBits, usage);
+	if (memory_type == UINT32_MAX)
+	{
+		JDL_ERROR("Vulkan Allocator: no memory type matches the requirements");
+		return {};
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	// Large resources would waste most of a block: give them their own memory
+	if (dedicated || requirements.size > get_block_size(memory_type) / 2) {
+		return allocate_dedicated(memory_type, requirements.size, dedicated_info);
+	}
+
+	VulkanAllocation allocation = allocate_from_blocks(memory_type, requirements, linear);
+	if (!allocation.is_valid())
+	{
+		// No new block could be allocated, the exact size may still fit
+		allocation = allocate_dedicated(memory_type, requirements.size, dedicated_info);
+	}
+	return allocation;
+}
+
+void VulkanAllocator::free(VulkanAllocation& allocation)
+{
+	if (!allocation.is_valid()) {
+		return;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	if (allocation.is_dedicated())
+	{
+		free_memory(allocation.memory, allocation.mapped_data);
+
+		auto& stats = m_dedicatedStats[allocation.memory_type];
+		stats.bytes -= allocation.size;
+		--stats.count;
+	}
+	else
+	{
+		auto& block = m_blocks[allocation.block];
+		block->tlsf->free(allocation.node);
+
+		// Keep one empty block per pool to avoid allocating it again right away
+		if (block->tlsf->is_empty())
+		{
+			bool has_other_block = false;
+			for (const auto& other : m_blocks)
+			{
+				if (other != nullptr && other != block &&
+					other->memory_type == block->memory_type && other->linear == block->linear)
+				{
+					has_other_block = true;
+					break;
+				}
+			}
+
+			if (has_other_block)
+			{
+				free_memory(block->memory, block->mapped_data);
+				block.reset();
+			}
+		}
+	}
+
+	allocation = {};
+}
+
+std::vector<MemoryHeapStats> VulkanAllocator::get_heap_stats() const
+{
+	std::vector<MemoryHeapStats> heaps(m_memoryProperties.memoryHeapCount);
+	for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; ++i)
+	{
+		heaps[i].heap_size = m_memoryProperties.memoryHeaps[i].size;
+		heaps[i].flags = m_memoryProperties.memoryHeaps[i].flags;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i)
+	{
+		auto& heap = heaps[m_memoryProperties.memoryTypes[i].heapIndex];
+		heap.reserved_bytes += m_dedicatedStats[i].bytes;
+		heap.used_bytes += m_dedicatedStats[i].bytes;
+		heap.nb_allocations += m_dedicatedStats[i].count;
+		heap.nb_dedicated_allocations += m_dedicatedStats[i].count;
+	}
+
+	for (const auto& block : m_blocks)
+	{
+		if (block == nullptr) {
+			continue;
+		}
+
+		auto& heap = heaps[m_memoryProperties.memoryTypes[block->memory_type].heapIndex];
+		heap.reserved_bytes += block->tlsf->get_size();
+		heap.used_bytes += block->tlsf->get_used_size();
+		heap.nb_allocations += block->tlsf->get_nb_allocations();
+		++heap.nb_blocks;
+	}
+
+	return heaps;
+}
+
+void VulkanAllocator::log_stats() const
+{
+	auto heaps = get_heap_stats();
+	for (size_t i = 0; i < heaps.size(); ++i)
+	{
+		const auto& heap = heaps[i];
+		JDL_INFO(
+			"Memory heap {} ({}): {:.1f}/{:.1f} MiB used/reserved, {:.1f} MiB total, "
+			"{} blocks, {} allocations ({} dedicated)",
+			i,
+			(heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device" : "host",
+			heap.used_bytes / s_MiB,
+			heap.reserved_bytes / s_MiB,
+			heap.heap_size / s_MiB,
+			heap.nb_blocks,
+			heap.nb_allocations,
+			heap.nb_dedicated_allocations
+		);
+	}
+}
+
+uint32_t VulkanAllocator::find_memory_type(uint32_t type_bits, MemoryUsage usage) const
+{
+	VkMemoryPropertyFlags required = 0;
+	VkMemoryPropertyFlags preferred = 0;
+	VkMemoryPropertyFlags unwanted = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+	switch (usage)
+	{
+		case MemoryUsage::eGpuOnly:
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			unwanted |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			break;
+		case MemoryUsage::eCpuToGpu:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			unwanted |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		case MemoryUsage::eGpuToCpu:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+	}
+
+	// Keep the matching type with the most preferred and the fewest unwanted properties
+	uint32_t best_type = UINT32_MAX;
+	int best_score = INT32_MIN;
+	for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i)
+	{
+		VkMemoryPropertyFlags flags = m_memoryProperties.memoryTypes[i].propertyFlags;
+		if (!(type_bits & (1u << i)) || (flags & required) != required) {
+			continue;
+		}
+
+		int score = std::popcount(flags & preferred) - std::popcount(flags & unwanted);
+		if (score > best_score)
+		{
+			best_type = i;
+			best_score = score;
+		}
+	}
+	return best_type;
+}
+
+VkDeviceSize VulkanAllocator::get_block_size(uint32_t memory_type) const
+{
+	uint32_t heap_index = m_memoryProperties.memoryTypes[memory_type].heapIndex;
+	VkDeviceSize heap_size = m_memoryProperties.memoryHeaps[heap_index].size;
+
+	if (heap_size <= s_SmallHeapSize) {
+		return std::min(m_blockSize, heap_size / 8);
+	}
+	return m_blockSize;
+}
+
+VkDeviceMemory VulkanAllocator::allocate_memory(
+	uint32_t memory_type,
+	VkDeviceSize size,
+	void** mapped_data,
+	const VkMemoryDedicatedAllocateInfo* dedicated_info
+)
+{
+	VkMemoryAllocateInfo alloc_info {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		.pNext = dedicated_info,
+		.allocationSize = size,
+		.memoryTypeIndex = memory_type
+	};
+
+	// Running out of memory is not fatal: the caller can try something else
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	if (vkAllocateMemory(m_device, &alloc_info, nullptr, &memory) != VK_SUCCESS) {
+		return VK_NULL_HANDLE;
+	}
+
+	// Host visible memory stays mapped during its whole lifetime
+	*mapped_data = nullptr;
+	auto flags = m_memoryProperties.memoryTypes[memory_type].propertyFlags;
+	if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		VK_CALL(vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, mapped_data));
+	}
+
+	return memory;
+}
+
+void VulkanAllocator::free_memory(VkDeviceMemory memory, void* mapped_data)
+{
+	if (mapped_data != nullptr) {
+		vkUnmapMemory(m_device, memory);
+	}
+	vkFreeMemory(m_device, memory, nullptr);
+}
+
+VulkanAllocation VulkanAllocator::allocate_dedicated(
+	uint32_t memory_type,
+	VkDeviceSize size,
+	const VkMemoryDedicatedAllocateInfo* dedicated_info
+)
+{
+	VulkanAllocation allocation;
+	allocation.memory = allocate_memory(memory_type, size, &allocation.mapped_data, dedicated_info);
+	if (allocation.memory == VK_NULL_HANDLE)
+	{
+		JDL_ERROR(
+			"Vulkan Allocator: failed to allocate {:.1f} MiB (memory type {})",
+			size / s_MiB, memory_type
+		);
+		return {};
+	}
+	allocation.size = size;
+	allocation.memory_type = memory_type;
+
+	auto& stats = m_dedicatedStats[memory_type];
+	stats.bytes += size;
+	++stats.count;
+
+	return allocation;
+}
+
+VulkanAllocation VulkanAllocator::allocate_from_blocks(
+	uint32_t memory_type,
+	const VkMemoryRequirements& requirements,
+	bool linear
+)
+{
+	auto try_allocate = [&](uint32_t block_index) -> VulkanAllocation
+	{
+		MemoryBlock& block = *m_blocks[block_index];
+
+		auto range = block.tlsf->allocate(requirements.size, requirements.alignment);
+		if (!range.is_valid()) {
+			return {};
+		}
+
+		VulkanAllocation allocation;
+		allocation.memory = block.memory;
+		allocation.offset = range.offset;
+		allocation.size = range.size;
+		allocation.memory_type = memory_type;
+		allocation.block = block_index;
+		allocation.node = range.node;
+		if (block.mapped_data != nullptr) {
+			allocation.mapped_data = static_cast<char*>(block.mapped_data) + range.offset;
+		}
+		return allocation;
+	};
+
+	// Existing blocks of the same pool
+	uint32_t free_slot = UINT32_MAX;
+	for (uint32_t i = 0; i < m_blocks.size(); ++i)
+	{
+		const auto& block = m_blocks[i];
+		if (block == nullptr)
+		{
+			free_slot = std::min(free_slot, i);
+			continue;
+		}
+		if (block->memory_type != memory_type || block->linear != linear) {
+			continue;
+		}
+
+		VulkanAllocation allocation = try_allocate(i);
+		if (allocation.is_valid()) {
+			return allocation;
+		}
+	}
+
+	// New block
+	auto block = std::make_unique<MemoryBlock>();
+	VkDeviceSize block_size = get_block_size(memory_type);
+
+	block->memory = allocate_memory(memory_type, block_size, &block->mapped_data);
+	if (block->memory == VK_NULL_HANDLE) {
+		return {};
+	}
+	block->memory_type = memory_type;
+	block->linear = linear;
+	block->tlsf = std::make_unique<utils::TlsfAllocator>(block_size);
+
+	if (free_slot == UINT32_MAX)
+	{
+		free_slot = static_cast<uint32_t>(m_blocks.size());
+		m_blocks.emplace_back();
+	}
+	m_blocks[free_slot] = std::move(block);
+
+	return try_allocate(free_slot);
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,259 @@
+#include "vk/vulkan_bindless_set.hpp"
+#include "vk/vulkan_command_buffer.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Number of slots per type of resource (clamped to the device limits)
+static constexpr uint32_t s_MaxTextures = 16384;
+static constexpr uint32_t s_MaxSamplers = 256;
+static constexpr uint32_t s_MaxStorageBuffers = 16384;
+
+// Upper bound of the variable-count binding declared by the layout
+static constexpr uint32_t s_MaxVariableCount = 1u << 20;
+
+static constexpr VkDescriptorBindingFlags s_BindingFlags =
+	VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+	VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+	VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+VulkanBindlessSet::VulkanBindlessSet()
+{
+	m_device = VulkanContext::GetDevice().get_device();
+
+	const auto& limits = VulkanContext::GetDevice().get_vulkan12_properties();
+
+	auto& textures = m_tables[static_cast<size_t>(BindlessType::eTexture)];
+	textures.descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	textures.capacity = std::min({
+		s_MaxTextures,
+		limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		limits.maxDescriptorSetUpdateAfterBindSampledImages
+	});
+
+	auto& samplers = m_tables[static_cast<size_t>(BindlessType::eSampler)];
+	samplers.descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+	samplers.capacity = std::min({
+		s_MaxSamplers,
+		limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+		limits.maxDescriptorSetUpdateAfterBindSamplers
+	});
+
+	auto& buffers = m_tables[static_cast<size_t>(BindlessType::eStorageBuffer)];
+	buffers.descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	buffers.capacity = std::min({
+		s_MaxStorageBuffers,
+		limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+		limits.maxDescriptorSetUpdateAfterBindStorageBuffers
+	});
+
+	create_layout();
+	create_set();
+}
+
+VulkanBindlessSet::~VulkanBindlessSet()
+{
+	// The set is freed along with its pool, the layout belongs to the cache
+	vkDestroyDescriptorPool(m_device, m_pool, nullptr);
+}
+
+uint32_t VulkanBindlessSet::register_texture(VkImageView view, VkImageLayout layout)
+{
+	VkDescriptorImageInfo image_info { VK_NULL_HANDLE, view, layout };
+	return register_descriptor(BindlessType::eTexture, &image_info, nullptr);
+}
+
+uint32_t VulkanBindlessSet::register_sampler(VkSampler sampler)
+{
+	VkDescriptorImageInfo image_info { sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+	return register_descriptor(BindlessType::eSampler, &image_info, nullptr);
+}
+
+uint32_t VulkanBindlessSet::register_storage_buffer(
+	VkBuffer buffer,
+	VkDeviceSize offset,
+	VkDeviceSize range
+)
+{
+	VkDescriptorBufferInfo buffer_info { buffer, offset, range };
+	return register_descriptor(BindlessType::eStorageBuffer, nullptr, &buffer_info);
+}
+
+void VulkanBindlessSet::unregister(BindlessType type, uint32_t index)
+{
+	if (index == s_InvalidIndex) {
+		return;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	auto& table = m_tables[static_cast<size_t>(type)];
+	if (index >= table.next_index)
+	{
+		JDL_ERROR("Bindless index {} has never been registered", index);
+		return;
+	}
+
+	// The descriptor is left as is: partially bound slots may hold stale
+	// descriptors as long as no shader accesses them
+	table.retired.push_back({index, m_frame});
+	--table.nb_registered;
+}
+
+void VulkanBindlessSet::update(uint64_t frame, uint32_t nb_frames_in_flight)
+{
+	std::lock_guard lock(m_mutex);
+
+	// Indices released after update(F) may be used by the frames up to F,
+	// which are finished once the fence of frame F + nb_frames_in_flight - 1
+	// is waited
+	for (auto& table : m_tables)
+	{
+		while (!table.retired.empty() && table.retired.front().frame + nb_frames_in_flight <= frame)
+		{
+			table.free_indices.push_back(table.retired.front().index);
+			table.retired.pop_front();
+		}
+	}
+	m_frame = frame;
+}
+
+void VulkanBindlessSet::bind(
+	VulkanCommandBuffer& command_buffer,
+	VkPipelineBindPoint bind_point,
+	VkPipelineLayout layout
+) const
+{
+	command_buffer.bind_descriptor_sets(bind_point, layout, s_Set, { m_set });
+}
+
+uint32_t VulkanBindlessSet::get_capacity(BindlessType type) const
+{
+	return m_tables[static_cast<size_t>(type)].capacity;
+}
+
+uint32_t VulkanBindlessSet::get_nb_registered(BindlessType type) const
+{
+	std::lock_guard lock(m_mutex);
+	return m_tables[static_cast<size_t>(type)].nb_registered;
+}
+
+void VulkanBindlessSet::create_layout()
+{
+	for (size_t i = 0; i < s_NbTypes; ++i)
+	{
+		DescriptorBindingDesc binding;
+		binding.binding = GetBinding(static_cast<BindlessType>(i));
+		binding.type = m_tables[i].descriptor_type;
+		binding.count = m_tables[i].capacity;
+		binding.stages = VK_SHADER_STAGE_ALL;
+		binding.flags = s_BindingFlags;
+
+		m_layoutDesc.bindings.push_back(binding);
+	}
+
+	// Only the last binding may have a variable count: the layout declares
+	// the device limit, so the set can be reallocated larger with the same
+	// layout (and the same pipelines)
+	const auto& limits = VulkanContext::GetDevice().get_vulkan12_properties();
+
+	auto& last = m_layoutDesc.bindings.back();
+	last.count = std::min({
+		s_MaxVariableCount,
+		limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+		limits.maxDescriptorSetUpdateAfterBindStorageBuffers
+	});
+	last.flags |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+	m_layoutDesc.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+
+	m_layout = VulkanContext::GetLayoutCache().get_descriptor_set_layout(m_layoutDesc);
+	if (m_layout == VK_NULL_HANDLE) {
+		JDL_FATAL("Cannot create the bindless descriptor set layout");
+	}
+}
+
+void VulkanBindlessSet::create_set()
+{
+	std::array<VkDescriptorPoolSize, s_NbTypes> pool_sizes;
+	for (size_t i = 0; i < s_NbTypes; ++i) {
+		pool_sizes[i] = { m_tables[i].descriptor_type, m_tables[i].capacity };
+	}
+
+	VkDescriptorPoolCreateInfo pool_info {};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	pool_info.maxSets = 1;
+	pool_info.poolSizeCount = VK_SIZE(pool_sizes);
+	pool_info.pPoolSizes = VK_DATA(pool_sizes);
+
+	VK_CALL(vkCreateDescriptorPool(m_device, &pool_info, nullptr, &m_pool));
+
+	uint32_t variable_count = m_tables.back().capacity;
+
+	VkDescriptorSetVariableDescriptorCountAllocateInfo count_info {};
+	count_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+	count_info.descriptorSetCount = 1;
+	count_info.pDescriptorCounts = &variable_count;
+
+	VkDescriptorSetAllocateInfo alloc_info {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc_info.pNext = &count_info;
+	alloc_info.descriptorPool = m_pool;
+	alloc_info.descriptorSetCount = 1;
+	alloc_info.pSetLayouts = &m_layout;
+
+	VK_CALL(vkAllocateDescriptorSets(m_device, &alloc_info, &m_set));
+}
+
+uint32_t VulkanBindlessSet::register_descriptor(
+	BindlessType type,
+	const VkDescriptorImageInfo* image_info,
+	const VkDescriptorBufferInfo* buffer_info
+)
+{
+	// Writes to the set are serialized: the set must be externally
+	// synchronized, even for distinct descriptors
+	std::lock_guard lock(m_mutex);
+
+	auto& table = m_tables[static_cast<size_t>(type)];
+
+	uint32_t index = s_InvalidIndex;
+	if (!table.free_indices.empty())
+	{
+		index = table.free_indices.back();
+		table.free_indices.pop_back();
+	}
+	else if (table.next_index < table.capacity) {
+		index = table.next_index++;
+	}
+	else
+	{
+		JDL_ERROR("Bindless array {} is full ({} slots)", GetBinding(type), table.capacity);
+		return s_InvalidIndex;
+	}
+
+	VkWriteDescriptorSet write {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = m_set;
+	write.dstBinding = GetBinding(type);
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = table.descriptor_type;
+	write.pImageInfo = image_info;
+	write.pBufferInfo = buffer_info;
+
+	vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+	++table.nb_registered;
+	return index;
+}
+
+} // namespace vk
+} // namespace jdl
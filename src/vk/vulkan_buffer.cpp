@@ -0,0 +1,59 @@
+#include "vk/vulkan_buffer.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+#include <cstring>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanBuffer::VulkanBuffer(
+	VkDeviceSize size,
+	VkBufferUsageFlags usage,
+	MemoryUsage memory_usage,
+	bool dedicated
+)
+	: m_size(size)
+	, m_usage(usage)
+{
+	m_device = VulkanContext::GetDevice().get_device();
+
+	VkBufferCreateInfo buffer_info {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.size = size,
+		.usage = usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE
+	};
+	VK_CALL(vkCreateBuffer(m_device, &buffer_info, nullptr, &m_buffer));
+
+	m_allocation = VulkanContext::GetAllocator().allocate_buffer(m_buffer, memory_usage, dedicated);
+	if (!m_allocation.is_valid()) {
+		JDL_FATAL("Failed to allocate the memory of a {} bytes buffer", size);
+	}
+
+	VK_CALL(vkBindBufferMemory(m_device, m_buffer, m_allocation.memory, m_allocation.offset));
+}
+
+VulkanBuffer::~VulkanBuffer()
+{
+	vkDestroyBuffer(m_device, m_buffer, nullptr);
+	VulkanContext::GetAllocator().free(m_allocation);
+}
+
+void VulkanBuffer::write(const void* data, VkDeviceSize size, VkDeviceSize offset)
+{
+	if (!is_mapped()) {
+		JDL_FATAL("Cannot write into a buffer which is not host visible");
+	}
+	if (offset + size > m_size) {
+		JDL_FATAL("Buffer write out of range ({} + {} > {})", offset, size, m_size);
+	}
+	std::memcpy(static_cast<char*>(m_allocation.mapped_data) + offset, data, size);
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,73 @@
+#include "vk/vulkan_command_allocator.hpp"
+
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanCommandAllocator::VulkanCommandAllocator(
+	uint32_t queue_family_index,
+	uint32_t nb_frames
+)
+{
+	m_device = VulkanContext::GetDevice().get_device();
+
+	VkCommandPoolCreateInfo create_info {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+		.queueFamilyIndex = queue_family_index
+	};
+
+	m_frames.resize(nb_frames);
+	for (auto& frame : m_frames) {
+		VK_CALL(vkCreateCommandPool(m_device, &create_info, nullptr, &frame.pool));
+	}
+}
+
+VulkanCommandAllocator::~VulkanCommandAllocator()
+{
+	// Destroying a pool frees all its command buffers
+	for (auto& frame : m_frames) {
+		vkDestroyCommandPool(m_device, frame.pool, nullptr);
+	}
+}
+
+void VulkanCommandAllocator::begin_frame(uint32_t frame_index)
+{
+	if (frame_index >= m_frames.size()) {
+		JDL_FATAL("Invalid command allocator frame index ({})", frame_index);
+	}
+	m_currentFrame = frame_index;
+
+	FramePool& frame = m_frames[frame_index];
+	VK_CALL(vkResetCommandPool(m_device, frame.pool, 0));
+
+	frame.nb_used_primaries = 0;
+	frame.nb_used_secondaries = 0;
+}
+
+VulkanCommandBuffer* VulkanCommandAllocator::allocate(VkCommandBufferLevel level)
+{
+	FramePool& frame = m_frames[m_currentFrame];
+
+	bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	auto& buffers = primary ? frame.primaries : frame.secondaries;
+	size_t& nb_used = primary ? frame.nb_used_primaries : frame.nb_used_secondaries;
+
+	// Reuse a command buffer already allocated in a previous frame
+	if (nb_used == buffers.size())
+	{
+		buffers.emplace_back(
+			std::make_unique<VulkanCommandBuffer>(frame.pool, level, false)
+		);
+	}
+	return buffers[nb_used++].get();
+}
+
+} // namespace vk
+} // namespace jdl
@@ -10,15 +10,20 @@ namespace jdl
 namespace vk
 {
 
-VulkanCommandBuffer::VulkanCommandBuffer(VkCommandPool command_pool)
+VulkanCommandBuffer::VulkanCommandBuffer(
+	VkCommandPool command_pool,
+	VkCommandBufferLevel level,
+	bool resettable
+)
 {
 	m_device = VulkanContext::GetDevice().get_device();
 	m_commandPool = command_pool;
+	m_resettable = resettable;
 
 	VkCommandBufferAllocateInfo alloc_info {
 		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
 		.commandPool = command_pool,
-		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.level = level,
 		.commandBufferCount = 1,
 	};
 	VK_CALL(vkAllocateCommandBuffers(m_device, &alloc_info, &m_commandBuffer));
@@ -28,18 +33,53 @@ VulkanCommandBuffer::~VulkanCommandBuffer() {}
 
 void VulkanCommandBuffer::begin()
 {
-	VK_CALL(vkResetCommandBuffer(m_commandBuffer, 0));
+	// Command buffers from a transient pool are reset along with their pool
+	if (m_resettable) {
+		VK_CALL(vkResetCommandBuffer(m_commandBuffer, 0));
+	}
+
+	VkCommandBufferBeginInfo begin_info {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = m_resettable ? 0u : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+	};
+	VK_CALL(vkBeginCommandBuffer(m_commandBuffer, &begin_info));
+
+	m_resourceTracker.reset();
+	m_recording = true;
+	m_rendering = false;
+}
+
+void VulkanCommandBuffer::begin_secondary(
+	const VkCommandBufferInheritanceRenderingInfo& rendering_info,
+	VkQueryPipelineStatisticFlags pipeline_statistics
+)
+{
+	if (m_resettable) {
+		VK_CALL(vkResetCommandBuffer(m_commandBuffer, 0));
+	}
 
+	VkCommandBufferInheritanceInfo inheritance_info {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		.pNext = &rendering_info,
+		.pipelineStatistics = pipeline_statistics
+	};
 	VkCommandBufferBeginInfo begin_info {
-		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+			| (m_resettable ? 0u : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT),
+		.pInheritanceInfo = &inheritance_info
 	};
 	VK_CALL(vkBeginCommandBuffer(m_commandBuffer, &begin_info));
 
+	m_resourceTracker.reset();
 	m_recording = true;
+	// Executed inside the rendering pass of the primary command buffer
+	m_rendering = true;
 }
 
 void VulkanCommandBuffer::end()
 {
+	flush_barriers();
 	VK_CALL(vkEndCommandBuffer(m_commandBuffer));
 	m_recording = false;
 }
@@ -65,56 +105,300 @@ void VulkanCommandBuffer::submit(
 	VK_CALL(vkQueueSubmit(queue, 1, &submit_info, fence));
 }
 
+void VulkanCommandBuffer::submit2(
+	VkQueue queue,
+	const std::vector<VkSemaphoreSubmitInfo>& wait_semaphores,
+	const std::vector<VkSemaphoreSubmitInfo>& signal_semaphores,
+	VkFence fence
+)
+{
+	VkCommandBufferSubmitInfo command_buffer_info {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+		.commandBuffer = m_commandBuffer
+	};
+	VkSubmitInfo2 submit_info {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+		.waitSemaphoreInfoCount = VK_SIZE(wait_semaphores),
+		.pWaitSemaphoreInfos = VK_DATA(wait_semaphores),
+		.commandBufferInfoCount = 1,
+		.pCommandBufferInfos = &command_buffer_info,
+		.signalSemaphoreInfoCount = VK_SIZE(signal_semaphores),
+		.pSignalSemaphoreInfos = VK_DATA(signal_semaphores)
+	};
+	VK_CALL(vkQueueSubmit2(queue, 1, &submit_info, fence));
+}
+
 void VulkanCommandBuffer::destroy()
 {
 	vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffer);
 	m_commandBuffer = VK_NULL_HANDLE;
 }
 
-void VulkanCommandBuffer::transition_image_layout(
+void VulkanCommandBuffer::execute_commands(
+	const std::vector<VulkanCommandBuffer*>& command_buffers
+)
+{
+	if (m_rendering) {
+		check_no_pending_barriers("vkCmdExecuteCommands");
+	}
+	else {
+		flush_barriers();
+	}
+
+	std::vector<VkCommandBuffer> handles;
+	handles.reserve(command_buffers.size());
+	for (auto command_buffer : command_buffers) {
+		handles.push_back(command_buffer->get());
+	}
+	vkCmdExecuteCommands(m_commandBuffer, VK_SIZE(handles), VK_DATA(handles));
+}
+
+void VulkanCommandBuffer::transition_image(
 	VkImage image,
-	VkImageLayout old_layout,
-	VkImageLayout new_layout,
+	const VkImageSubresourceRange& range,
+	const ResourceState& state
+)
+{
+	if (m_rendering) {
+		JDL_FATAL("Image transitions cannot be requested inside a rendering pass");
+	}
+	m_resourceTracker.require_image_state(image, range, state);
+}
+
+void VulkanCommandBuffer::transition_buffer(VkBuffer buffer, const ResourceState& state)
+{
+	if (m_rendering) {
+		JDL_FATAL("Buffer transitions cannot be requested inside a rendering pass");
+	}
+	m_resourceTracker.require_buffer_state(buffer, state);
+}
+
+void VulkanCommandBuffer::check_no_pending_barriers(const char* command) const
+{
+	if (m_resourceTracker.has_pending_barriers()) {
+		JDL_FATAL("{} recorded with pending barriers inside a rendering pass", command);
+	}
+}
+
+void VulkanCommandBuffer::flush_barriers()
+{
+	if (!m_resourceTracker.has_pending_barriers()) {
+		return;
+	}
+
+	for (const auto& batch : m_resourceTracker.flush())
+	{
+		VkDependencyInfo dependency_info {
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.bufferMemoryBarrierCount = VK_SIZE(batch.buffer_barriers),
+			.pBufferMemoryBarriers = VK_DATA(batch.buffer_barriers),
+			.imageMemoryBarrierCount = VK_SIZE(batch.image_barriers),
+			.pImageMemoryBarriers = VK_DATA(batch.image_barriers)
+		};
+		vkCmdPipelineBarrier2(m_commandBuffer, &dependency_info);
+	}
+}
+
+void VulkanCommandBuffer::memory_barrier(
 	VkAccessFlags2 src_access_mask,
 	VkAccessFlags2 dst_access_mask,
 	VkPipelineStageFlags2 src_stage_mask,
-	VkPipelineStageFlags2 dst_stage_mask,
-	VkImageAspectFlags aspect_mask
+	VkPipelineStageFlags2 dst_stage_mask
 )
 {
-	VkImageMemoryBarrier2 barrier {
-		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+	flush_barriers();
+
+	VkMemoryBarrier2 barrier {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
 		.srcStageMask = src_stage_mask,
 		.srcAccessMask = src_access_mask,
 		.dstStageMask = dst_stage_mask,
-		.dstAccessMask = dst_access_mask,
-		.oldLayout = old_layout,
-		.newLayout = new_layout,
-		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-		.image = image,
-		.subresourceRange = {
-			.aspectMask = aspect_mask,
-			.baseMipLevel = 0,
-			.levelCount = 1,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		}
+		.dstAccessMask = dst_access_mask
 	};
 
 	VkDependencyInfo dependency_info {
 		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-		.imageMemoryBarrierCount = 1,
-		.pImageMemoryBarriers = &barrier
+		.memoryBarrierCount = 1,
+		.pMemoryBarriers = &barrier
 	};
 	vkCmdPipelineBarrier2(m_commandBuffer, &dependency_info);
 }
 
+void VulkanCommandBuffer::pipeline_barrier(
+	const std::vector<VkBufferMemoryBarrier2>& buffer_barriers,
+	const std::vector<VkImageMemoryBarrier2>& image_barriers
+)
+{
+	flush_barriers();
+
+	if (buffer_barriers.empty() && image_barriers.empty()) {
+		return;
+	}
+
+	VkDependencyInfo dependency_info {
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.bufferMemoryBarrierCount = VK_SIZE(buffer_barriers),
+		.pBufferMemoryBarriers = VK_DATA(buffer_barriers),
+		.imageMemoryBarrierCount = VK_SIZE(image_barriers),
+		.pImageMemoryBarriers = VK_DATA(image_barriers)
+	};
+	vkCmdPipelineBarrier2(m_commandBuffer, &dependency_info);
+}
+
+void VulkanCommandBuffer::copy_buffer(
+	VkBuffer src,
+	VkDeviceSize src_offset,
+	VkBuffer dst,
+	VkDeviceSize dst_offset,
+	VkDeviceSize size
+)
+{
+	flush_barriers();
+
+	VkBufferCopy region {
+		.srcOffset = src_offset,
+		.dstOffset = dst_offset,
+		.size = size
+	};
+	vkCmdCopyBuffer(m_commandBuffer, src, dst, 1, &region);
+}
+
+void VulkanCommandBuffer::fill_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t value)
+{
+	flush_barriers();
+	vkCmdFillBuffer(m_commandBuffer, buffer, offset, size, value);
+}
+
+void VulkanCommandBuffer::copy_buffer_to_image(
+	VkBuffer buffer,
+	VkDeviceSize offset,
+	VkImage image,
+	VkExtent3D extent,
+	VkImageAspectFlags aspect_mask,
+	uint32_t nb_layers
+)
+{
+	flush_barriers();
+
+	VkBufferImageCopy region {
+		.bufferOffset = offset,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource = {
+			.aspectMask = aspect_mask,
+			.mipLevel = 0,
+			.baseArrayLayer = 0,
+			.layerCount = nb_layers
+		},
+		.imageOffset = {0, 0, 0},
+		.imageExtent = extent
+	};
+	vkCmdCopyBufferToImage(
+		m_commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region
+	);
+}
+
+void VulkanCommandBuffer::copy_image_to_buffer(
+	VkImage image,
+	VkImageLayout layout,
+	VkExtent2D extent,
+	VkBuffer buffer
+)
+{
+	flush_barriers();
+
+	VkBufferImageCopy region {
+		.bufferOffset = 0,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipLevel = 0,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		},
+		.imageOffset = {0, 0, 0},
+		.imageExtent = {extent.width, extent.height, 1}
+	};
+	vkCmdCopyImageToBuffer(m_commandBuffer, image, layout, buffer, 1, &region);
+}
+
+void VulkanCommandBuffer::begin_rendering(const VkRenderingInfo& rendering_info)
+{
+	// Barriers cannot be recorded inside a rendering pass
+	flush_barriers();
+	vkCmdBeginRendering(m_commandBuffer, &rendering_info);
+	m_rendering = true;
+}
+
+void VulkanCommandBuffer::end_rendering()
+{
+	vkCmdEndRendering(m_commandBuffer);
+	m_rendering = false;
+}
+
 void VulkanCommandBuffer::bind_graphics_pipeline(VkPipeline pipeline)
 {
 	vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 }
 
+void VulkanCommandBuffer::bind_compute_pipeline(VkPipeline pipeline)
+{
+	vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+}
+
+void VulkanCommandBuffer::bind_descriptor_sets(
+	VkPipelineBindPoint bind_point,
+	VkPipelineLayout layout,
+	uint32_t first_set,
+	const std::vector<VkDescriptorSet>& sets,
+	const std::vector<uint32_t>& dynamic_offsets
+)
+{
+	vkCmdBindDescriptorSets(
+		m_commandBuffer, bind_point, layout, first_set,
+		VK_SIZE(sets), VK_DATA(sets),
+		VK_SIZE(dynamic_offsets), VK_DATA(dynamic_offsets)
+	);
+}
+
+void VulkanCommandBuffer::push_constants(
+	VkPipelineLayout layout,
+	VkShaderStageFlags stages,
+	uint32_t offset,
+	uint32_t size,
+	const void* data
+)
+{
+	vkCmdPushConstants(m_commandBuffer, layout, stages, offset, size, data);
+}
+
+void VulkanCommandBuffer::bind_vertex_buffers(
+	uint32_t first_binding,
+	const std::vector<VkBuffer>& buffers,
+	const std::vector<VkDeviceSize>& offsets
+)
+{
+	std::vector<VkDeviceSize> zero_offsets;
+	if (offsets.empty()) {
+		zero_offsets.resize(buffers.size(), 0);
+	}
+	const auto& buffer_offsets = offsets.empty() ? zero_offsets : offsets;
+
+	vkCmdBindVertexBuffers(
+		m_commandBuffer, first_binding, VK_SIZE(buffers), VK_DATA(buffers), VK_DATA(buffer_offsets)
+	);
+}
+
+void VulkanCommandBuffer::bind_index_buffer(
+	VkBuffer buffer,
+	VkDeviceSize offset,
+	VkIndexType index_type
+)
+{
+	vkCmdBindIndexBuffer(m_commandBuffer, buffer, offset, index_type);
+}
+
 void VulkanCommandBuffer::set_viewport(
 	VkOffset2D offset,
 	VkExtent2D extent,
@@ -146,8 +430,53 @@ void VulkanCommandBuffer::draw(
 	uint32_t first_instance
 )
 {
+	check_no_pending_barriers("vkCmdDraw");
 	vkCmdDraw(m_commandBuffer, nb_vertices, nb_instances, first_vertex, first_instance);
 }
 
+void VulkanCommandBuffer::draw_indexed(
+	uint32_t nb_indices,
+	uint32_t nb_instances,
+	uint32_t first_index,
+	int32_t vertex_offset,
+	uint32_t first_instance
+)
+{
+	check_no_pending_barriers("vkCmdDrawIndexed");
+	vkCmdDrawIndexed(m_commandBuffer, nb_indices, nb_instances, first_index, vertex_offset, first_instance);
+}
+
+void VulkanCommandBuffer::draw_indexed_indirect(
+	VkBuffer buffer,
+	VkDeviceSize offset,
+	uint32_t nb_draws,
+	uint32_t stride
+)
+{
+	check_no_pending_barriers("vkCmdDrawIndexedIndirect");
+	vkCmdDrawIndexedIndirect(m_commandBuffer, buffer, offset, nb_draws, stride);
+}
+
+void VulkanCommandBuffer::draw_indexed_indirect_count(
+	VkBuffer buffer,
+	VkDeviceSize offset,
+	VkBuffer count_buffer,
+	VkDeviceSize count_offset,
+	uint32_t max_draws,
+	uint32_t stride
+)
+{
+	check_no_pending_barriers("vkCmdDrawIndexedIndirectCount");
+	vkCmdDrawIndexedIndirectCount(
+		m_commandBuffer, buffer, offset, count_buffer, count_offset, max_draws, stride
+	);
+}
+
+void VulkanCommandBuffer::dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+	flush_barriers();
+	vkCmdDispatch(m_commandBuffer, x, y, z);
+}
+
 } // namespace vk
 } // namespace jdl
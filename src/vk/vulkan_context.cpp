@@ -2,6 +2,7 @@
 
 #include "core/window.hpp"
 
+#include "resource/mesh.hpp"
 #include "resource/resource_manager.hpp"
 #include "resource/shader.hpp"
 
@@ -15,6 +16,14 @@ namespace vk
 
 VulkanContext VulkanContext::s_Context;
 
+VkFormat VulkanContext::GetColorFormat()
+{
+    if (s_Context.m_settings.headless) {
+        return s_Context.m_settings.headless_format;
+    }
+    return s_Context.m_swapchain->get_surface_format().format;
+}
+
 void VulkanContext::RecreateSwapchain()
 {
     s_Context.m_device->wait_idle();
@@ -23,16 +32,27 @@ void VulkanContext::RecreateSwapchain()
     s_Context.m_swapchain = std::make_unique<VulkanSwapchain>();
 }
 
-void VulkanContext::do_init()
+void VulkanContext::do_init(const VulkanContextSettings& settings)
 {
     if (m_instance != nullptr) {
         return;
     }
+    m_settings = settings;
 
     create_instance();
-    create_window_surface();
+    if (!m_settings.headless) {
+        create_window_surface();
+    }
     create_device();
-    create_swapchain();
+    create_allocator();
+    create_uploader();
+    create_retire_queue();
+    create_shader_module_cache();
+    if (!m_settings.headless) {
+        create_swapchain();
+    }
+    create_layout_cache();
+    create_bindless_set();
     create_default_resources();
     create_pipeline();
 }
@@ -43,11 +63,22 @@ void VulkanContext::do_destroy()
         return;
     }
 
-    m_pipeline.reset();
+    m_pipeline = nullptr;
+    m_pipelineLibrary.reset();
+    m_bindlessSet.reset();
+    m_layoutCache.reset();
+    m_shaderModuleCache.reset();
     m_swapchain.reset();
+    m_uploader.reset();
+    m_retireQueue.reset();
+
+    if (m_windowSurface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(m_instance->get_handle(), m_windowSurface, nullptr);
+        m_windowSurface = VK_NULL_HANDLE;
+    }
 
-    vkDestroySurfaceKHR(m_instance->get_handle(), m_windowSurface, nullptr);
-    
+    m_allocator.reset();
     m_device.reset();
     m_instance.reset();
 }
@@ -72,12 +103,56 @@ void VulkanContext::create_device()
     JDL_INFO("Vulkan Device: OK ({})", m_device->get_device_name());
 }
 
+void VulkanContext::create_allocator()
+{
+    m_allocator = std::make_unique<VulkanAllocator>();
+    JDL_INFO("Vulkan Allocator: OK");
+}
+
+void VulkanContext::create_uploader()
+{
+    m_uploader = std::make_unique<VulkanUploader>();
+    JDL_INFO(
+        "Vulkan Uploader: OK ({})",
+        m_device->has_dedicated_transfer_queue() ? "dedicated transfer queue" : "graphics queue"
+    );
+}
+
+void VulkanContext::create_retire_queue()
+{
+    m_retireQueue = std::make_unique<VulkanRetireQueue>();
+    JDL_INFO("Vulkan Retire Queue: OK");
+}
+
+void VulkanContext::create_shader_module_cache()
+{
+    m_shaderModuleCache = std::make_unique<VulkanShaderModuleCache>();
+    JDL_INFO("Vulkan Shader Module Cache: OK");
+}
+
 void VulkanContext::create_swapchain()
 {
     m_swapchain = std::make_unique<VulkanSwapchain>();
     JDL_INFO("Vulkan Swapchain: OK");
 }
 
+void VulkanContext::create_layout_cache()
+{
+    m_layoutCache = std::make_unique<VulkanLayoutCache>();
+    JDL_INFO("Vulkan Layout Cache: OK");
+}
+
+void VulkanContext::create_bindless_set()
+{
+    m_bindlessSet = std::make_unique<VulkanBindlessSet>();
+    JDL_INFO(
+        "Vulkan Bindless Set: OK ({} textures, {} samplers, {} storage buffers)",
+        m_bindlessSet->get_capacity(BindlessType::eTexture),
+        m_bindlessSet->get_capacity(BindlessType::eSampler),
+        m_bindlessSet->get_capacity(BindlessType::eStorageBuffer)
+    );
+}
+
 void VulkanContext::create_default_resources()
 {
     // Default shader
@@ -85,6 +160,25 @@ void VulkanContext::create_default_resources()
         "__DEFAULT_SHADER__",
         "shaders/default.spv"
     );
+
+    // Default mesh (colored triangle)
+    resource::VertexData vertices;
+    vertices.positions = {
+        0.0f, -0.5f, 0.0f,
+        0.5f, 0.5f, 0.0f,
+        -0.5f, 0.5f, 0.0f
+    };
+    vertices.colors = {
+        1.0f, 0.0f, 0.0f, 1.0f,
+        0.0f, 1.0f, 0.0f, 1.0f,
+        0.0f, 0.0f, 1.0f, 1.0f
+    };
+    resource::ResourceManager::Create<resource::Mesh>(
+        "__DEFAULT_MESH__",
+        std::move(vertices),
+        std::vector<uint32_t>{ 0, 1, 2 },
+        resource::VertexLayout::Compact(false, true)
+    );
 }
 
 void VulkanContext::create_pipeline()
@@ -92,11 +186,25 @@ void VulkanContext::create_pipeline()
     auto shader = resource::ResourceManager::Get<resource::Shader>(
         "__DEFAULT_SHADER__"
     );
+    auto mesh = resource::ResourceManager::Get<resource::Mesh>(
+        "__DEFAULT_MESH__"
+    );
+
+    m_pipelineLibrary = std::make_unique<VulkanPipelineLibrary>();
 
-    m_pipeline = std::make_unique<VulkanPipeline>();
-    m_pipeline->add_shader(ShaderStage::eVertex, shader);
-    m_pipeline->add_shader(ShaderStage::eFragment, shader);
-    m_pipeline->create();
+    PipelineDesc desc;
+    desc.shaders = {
+        {ShaderStage::eVertex, shader},
+        {ShaderStage::eFragment, shader}
+    };
+    desc.color_formats = { GetColorFormat() };
+    desc.depth_format = GetDepthFormat();
+    mesh->get_layout().fill_pipeline_desc(desc);
+
+    m_pipeline = m_pipelineLibrary->get(desc);
+    if (m_pipeline == nullptr) {
+        JDL_FATAL("Cannot create the default pipeline");
+    }
 
     JDL_INFO("Vulkan Pipeline: OK");
 }
@@ -12,11 +12,19 @@ namespace vk
 
 // --- DEVICE EXTENSIONS ---
 
-const std::vector<const char*> s_DeviceExtensions {
-	VK_KHR_SWAPCHAIN_EXTENSION_NAME
-};
+static std::vector<const char*> s_GetDeviceExtensions()
+{
+	// Nothing is presented when rendering offscreen
+	if (VulkanContext::IsHeadless()) {
+		return {};
+	}
+	return { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+}
 
-static bool s_DeviceExtensionsSupported(VkPhysicalDevice device)
+static bool s_DeviceExtensionsSupported(
+	VkPhysicalDevice device,
+	const std::vector<const char*>& device_extensions
+)
 {
 	uint32_t nb_extensions = 0;
 	VK_CALL(
@@ -33,7 +41,7 @@ static bool s_DeviceExtensionsSupported(VkPhysicalDevice device)
 	);
 
 	std::set<std::string> required_extensions {
-		s_DeviceExtensions.begin(), s_DeviceExtensions.end()
+		device_extensions.begin(), device_extensions.end()
 	};
 	for (const auto& extension : extensions) {
 		required_extensions.erase(extension.extensionName);
@@ -42,6 +50,85 @@ static bool s_DeviceExtensionsSupported(VkPhysicalDevice device)
 	return required_extensions.empty();
 }
 
+// --- FEATURES ---
+
+// Descriptor indexing features required by the bindless descriptor set
+static void s_EnableDescriptorIndexing(VkPhysicalDeviceVulkan12Features& features)
+{
+	features.descriptorIndexing = true;
+	features.runtimeDescriptorArray = true;
+	features.descriptorBindingPartiallyBound = true;
+	features.descriptorBindingVariableDescriptorCount = true;
+	features.descriptorBindingUpdateUnusedWhilePending = true;
+	features.descriptorBindingSampledImageUpdateAfterBind = true;
+	features.descriptorBindingStorageBufferUpdateAfterBind = true;
+	features.shaderSampledImageArrayNonUniformIndexing = true;
+	features.shaderStorageBufferArrayNonUniformIndexing = true;
+}
+
+static bool s_DescriptorIndexingSupported(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceVulkan12Features supported {};
+	supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &supported;
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return supported.descriptorIndexing
+		&& supported.runtimeDescriptorArray
+		&& supported.descriptorBindingPartiallyBound
+		&& supported.descriptorBindingVariableDescriptorCount
+		&& supported.descriptorBindingUpdateUnusedWhilePending
+		&& supported.descriptorBindingSampledImageUpdateAfterBind
+		&& supported.descriptorBindingStorageBufferUpdateAfterBind
+		&& supported.shaderSampledImageArrayNonUniformIndexing
+		&& supported.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+// Indirect draws whose commands and count are written by the GPU (culling)
+static bool s_IndirectCountSupported(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceVulkan12Features supported {};
+	supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &supported;
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return supported.drawIndirectCount && features.features.multiDrawIndirect;
+}
+
+// --- QUEUE FAMILIES ---
+
+static uint32_t s_FindTransferQueueFamily(
+	const std::vector<VkQueueFamilyProperties>& queues,
+	uint32_t graphics_family
+)
+{
+	// Transfer-only families are backed by the DMA engines: uploads run
+	// without stealing any graphics or compute time
+	for (uint32_t i = 0; i < queues.size(); ++i)
+	{
+		VkQueueFlags flags = queues[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) &&
+			!(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			return i;
+		}
+	}
+	for (uint32_t i = 0; i < queues.size(); ++i)
+	{
+		VkQueueFlags flags = queues[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+			return i;
+		}
+	}
+	// Graphics queues always support transfer operations
+	return graphics_family;
+}
+
 // --- VulkanDevice CLASS ---
 
 VulkanDevice::VulkanDevice()
@@ -49,26 +136,38 @@ VulkanDevice::VulkanDevice()
 	select_physical_device();
 	create_device();
 	create_command_pool();
+	create_pipeline_cache();
 }
 
 VulkanDevice::~VulkanDevice()
 {
+	m_pipelineCache.reset();
 	vkDestroyCommandPool(m_device, m_graphicsPool, nullptr);
 	vkDestroyDevice(m_device, nullptr);
 }
 
-std::string VulkanDevice::get_device_name() const
+uint32_t VulkanDevice::find_memory_type(
+	uint32_t type_bits,
+	VkMemoryPropertyFlags properties
+) const
 {
-	VkPhysicalDeviceProperties properties;
-	vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
-
-	return properties.deviceName;
+	for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i)
+	{
+		const auto& memory_type = m_memoryProperties.memoryTypes[i];
+		if ((type_bits & (1u << i)) && (memory_type.propertyFlags & properties) == properties) {
+			return i;
+		}
+	}
+	return UINT32_MAX;
 }
 
 void VulkanDevice::select_physical_device()
 {
 	VkInstance instance = VulkanContext::GetInstance().get_handle();
 	VkSurfaceKHR surface = VulkanContext::GetWindowSurface();
+	bool headless = VulkanContext::IsHeadless();
+
+	auto device_extensions = s_GetDeviceExtensions();
 
 	uint32_t nb_devices = 0;
 	VK_CALL(vkEnumeratePhysicalDevices(instance, &nb_devices, nullptr));
@@ -85,7 +184,13 @@ void VulkanDevice::select_physical_device()
 
 	for (VkPhysicalDevice device : devices)
 	{
-		if (!s_DeviceExtensionsSupported(device)) {
+		if (!s_DeviceExtensionsSupported(device, device_extensions)) {
+			continue;
+		}
+		if (!s_DescriptorIndexingSupported(device)) {
+			continue;
+		}
+		if (!s_IndirectCountSupported(device)) {
 			continue;
 		}
 
@@ -106,25 +211,34 @@ void VulkanDevice::select_physical_device()
 				queue_indices.graphics = i;
 			}
 
+			// Without a surface, the present queue is the graphics one
 			VkBool32 present_supported = VK_FALSE;
-			vkGetPhysicalDeviceSurfaceSupportKHR(
-				device, i, surface, &present_supported
-			);
+			if (headless) {
+				present_supported = queue_indices.graphics != UINT32_MAX;
+			}
+			else
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(
+					device, i, surface, &present_supported
+				);
+			}
 			if (present_supported) {
-				queue_indices.present = i;
+				queue_indices.present = headless ? queue_indices.graphics : i;
 			}
 
 			if (queue_indices.is_complete())
 			{
+				queue_indices.transfer = s_FindTransferQueueFamily(queues, queue_indices.graphics);
+
 				compatible_devices.push_back(device);
 				compatible_queues.push_back(queue_indices);
 
 				break;
 			}
 		}
-		if (compatible_devices.empty()) {
-			JDL_FATAL("There are no GPU meeting the application requirements");
-		}
+	}
+	if (compatible_devices.empty()) {
+		JDL_FATAL("There are no GPU meeting the application requirements");
 	}
 
 	// Multiple compatible devices: use the dedicated graphics card in priority
@@ -144,6 +258,17 @@ void VulkanDevice::select_physical_device()
 			break;
 		}
 	}
+
+	m_vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &m_vulkan12Properties;
+	vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties);
+
+	m_properties = properties.properties;
+	m_vulkan12Properties.pNext = nullptr;
+	vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
 }
 
 void VulkanDevice::create_device()
@@ -169,33 +294,49 @@ void VulkanDevice::create_device()
 	vulkan13_features.dynamicRendering = true;
 	vulkan13_features.synchronization2 = true;
 
-	// Vulkan 1.2 features
+	// Vulkan 1.2 features: descriptor indexing backs the bindless set,
+	// indirect count backs the GPU culling
 	VkPhysicalDeviceVulkan12Features vulkan12_features {};
 	vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12_features.timelineSemaphore = true;
+	vulkan12_features.drawIndirectCount = true;
+	s_EnableDescriptorIndexing(vulkan12_features);
 	vulkan12_features.pNext = &vulkan13_features;
 
-	// Vulkan 1.1 features
+	// Vulkan 1.1 features: draw parameters give DrawIndex to the shaders
 	VkPhysicalDeviceVulkan11Features vulkan11_features {};
 	vulkan11_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
 	vulkan11_features.shaderDrawParameters = true;
 	vulkan11_features.pNext = &vulkan12_features;
 
+	// Core features: optional ones are enabled only if supported
+	VkPhysicalDeviceFeatures supported_features;
+	vkGetPhysicalDeviceFeatures(m_physicalDevice, &supported_features);
+
+	m_enabledFeatures.pipelineStatisticsQuery = supported_features.pipelineStatisticsQuery;
+	m_enabledFeatures.inheritedQueries = supported_features.inheritedQueries;
+	m_enabledFeatures.multiDrawIndirect = true;
+
 	VkPhysicalDeviceFeatures2 device_features {};
 	device_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	device_features.features = m_enabledFeatures;
 	device_features.pNext = &vulkan11_features;
 
+	auto device_extensions = s_GetDeviceExtensions();
+
 	VkDeviceCreateInfo create_info {};
 	create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	create_info.queueCreateInfoCount = VK_SIZE(queue_infos);
 	create_info.pQueueCreateInfos = VK_DATA(queue_infos);
-	create_info.enabledExtensionCount = VK_SIZE(s_DeviceExtensions);
-	create_info.ppEnabledExtensionNames = VK_DATA(s_DeviceExtensions);
+	create_info.enabledExtensionCount = VK_SIZE(device_extensions);
+	create_info.ppEnabledExtensionNames = VK_DATA(device_extensions);
 	create_info.pNext = &device_features;
 
 	VK_CALL(vkCreateDevice(m_physicalDevice, &create_info, nullptr, &m_device));
 
 	vkGetDeviceQueue(m_device, m_queueFamilyIndices.graphics, 0, &m_graphicsQueue);
 	vkGetDeviceQueue(m_device, m_queueFamilyIndices.present, 0, &m_presentQueue);
+	vkGetDeviceQueue(m_device, m_queueFamilyIndices.transfer, 0, &m_transferQueue);
 }
 
 void VulkanDevice::create_command_pool()
@@ -208,5 +349,12 @@ void VulkanDevice::create_command_pool()
 	VK_CALL(vkCreateCommandPool(m_device, &create_info, nullptr, &m_graphicsPool));
 }
 
+void VulkanDevice::create_pipeline_cache()
+{
+	m_pipelineCache = std::make_unique<VulkanPipelineCache>(
+		m_device, m_properties, VulkanContext::GetSettings().pipeline_cache_path
+	);
+}
+
 } // namespace vk
 } // namespace jdl
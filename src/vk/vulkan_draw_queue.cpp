@@ -0,0 +1,469 @@
+#include "vk/vulkan_draw_queue.hpp"
+
+#include "core/job_system.hpp"
+
+#include "resource/resource_manager.hpp"
+
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Instance of the frame ring storage buffer (Instance in default.slang)
+struct GpuInstance
+{
+	// Rows of the world transform
+	float rows[3][4];
+};
+static_assert(sizeof(GpuInstance) == 48);
+
+// Per-draw constants, pushed as push constants (DrawConstants in default.slang)
+struct DrawConstants
+{
+	// Dequantization of the positions (mesh bounds)
+	float position_scale[4];
+	float position_offset[4];
+	// Index of the first instance of the draw in the storage buffer
+	uint32_t first_instance;
+};
+// The push constant range reflected from default.slang ends at first_instance
+static_assert(sizeof(DrawConstants) == 36);
+static_assert(sizeof(DrawConstants) <= VulkanFrameRing::s_MaxPushConstantsSize);
+
+// Radix sort digits
+static constexpr uint32_t s_RadixBits = 8;
+static constexpr uint32_t s_RadixSize = 1u << s_RadixBits;
+// Minimum number of entries handled by a sorting job
+static constexpr uint32_t s_SortBlockSize = 4096;
+
+static uint64_t s_Mask(uint64_t value, uint32_t bits)
+{
+	return value & ((uint64_t(1) << bits) - 1);
+}
+
+/**
+ * @brief Stable LSD radix sort of the entries by key, 8 bits per pass. Each
+ * pass splits the entries into blocks: the jobs count the digits of their
+ * block, then scatter it at the offsets given by the prefix sums of all the
+ * counts. The passes whose digit is the same for every key are skipped.
+ * @param entries Entries to sort.
+ * @param scratch Temporary storage.
+ */
+template<class Entry>
+static void s_RadixSort(std::vector<Entry>& entries, std::vector<Entry>& scratch)
+{
+	uint32_t count = static_cast<uint32_t>(entries.size());
+	scratch.resize(count);
+
+	auto& job_system = core::JobSystem::Get();
+	uint32_t nb_blocks = std::clamp(count / s_SortBlockSize, 1u, job_system.get_nb_threads() * 4);
+	std::vector<std::array<uint32_t, s_RadixSize>> histograms(nb_blocks);
+
+	Entry* source = entries.data();
+	Entry* destination = scratch.data();
+
+	for (uint32_t shift = 0; shift < 64; shift += s_RadixBits)
+	{
+		job_system.parallel_for(nb_blocks, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t block = begin; block < end; ++block)
+			{
+				auto& histogram = histograms[block];
+				histogram.fill(0);
+				uint32_t first = static_cast<uint64_t>(count) * block / nb_blocks;
+				uint32_t last = static_cast<uint64_t>(count) * (block + 1) / nb_blocks;
+				for (uint32_t i = first; i < last; ++i) {
+					++histogram[(source[i].key >> shift) & (s_RadixSize - 1)];
+				}
+			}
+		});
+
+		// Exclusive prefix sums, digit by digit then block by block so that
+		// the sort is stable
+		uint32_t offset = 0;
+		bool skip = false;
+		for (uint32_t digit = 0; digit < s_RadixSize && !skip; ++digit)
+		{
+			uint32_t digit_count = 0;
+			for (auto& histogram : histograms)
+			{
+				uint32_t block_count = histogram[digit];
+				histogram[digit] = offset + digit_count;
+				digit_count += block_count;
+			}
+			skip = digit_count == count;
+			offset += digit_count;
+		}
+		if (skip) {
+			continue;
+		}
+
+		job_system.parallel_for(nb_blocks, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t block = begin; block < end; ++block)
+			{
+				auto& histogram = histograms[block];
+				uint32_t first = static_cast<uint64_t>(count) * block / nb_blocks;
+				uint32_t last = static_cast<uint64_t>(count) * (block + 1) / nb_blocks;
+				for (uint32_t i = first; i < last; ++i) {
+					destination[histogram[(source[i].key >> shift) & (s_RadixSize - 1)]++] = source[i];
+				}
+			}
+		});
+		std::swap(source, destination);
+	}
+
+	if (source != entries.data()) {
+		entries.swap(scratch);
+	}
+}
+
+// State bound while recording the batches of a pass
+struct BoundState
+{
+	const VulkanPipeline* pipeline = nullptr;
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	uint32_t allocation = UINT32_MAX;
+	bool bindless = false;
+	bool frame_data = false;
+};
+
+// Bindings to record before a batch
+struct BindChanges
+{
+	bool pipeline = false;
+	bool bindless = false;
+	bool frame_data = false;
+};
+
+static BindChanges s_UpdateBoundState(BoundState& state, const VulkanPipeline* pipeline, uint32_t allocation)
+{
+	BindChanges changes;
+	if (pipeline != state.pipeline)
+	{
+		changes.pipeline = true;
+		state.pipeline = pipeline;
+
+		// Binding a pipeline with another layout may disturb the bound sets
+		if (pipeline->get_pipeline_layout() != state.layout)
+		{
+			state.layout = pipeline->get_pipeline_layout();
+			state.bindless = pipeline->get_descriptor_set_layout(VulkanBindlessSet::s_Set)
+				== VulkanContext::GetBindlessSet().get_layout();
+			state.frame_data = pipeline->get_descriptor_set_layout(VulkanFrameRing::s_Set) != VK_NULL_HANDLE;
+			state.allocation = UINT32_MAX;
+			changes.bindless = state.bindless;
+		}
+	}
+
+	if (state.frame_data && allocation != state.allocation)
+	{
+		changes.frame_data = true;
+		state.allocation = allocation;
+	}
+	return changes;
+}
+
+VulkanDrawQueue::VulkanDrawQueue()
+{
+	// One list per job system thread, and one for the other threads
+	m_threadSubmissions.resize(core::JobSystem::Get().get_nb_threads() + 1);
+}
+
+VulkanDrawQueue::~VulkanDrawQueue() = default;
+
+uint64_t VulkanDrawQueue::MakeSortKey(
+	uint32_t pass,
+	uint32_t pipeline,
+	uint32_t material,
+	uint32_t mesh,
+	float depth
+)
+{
+	// The bits of a positive float increase with its value: the most
+	// significant ones are a coarse depth (NaN and negative depths are 0)
+	uint32_t depth_bits = std::bit_cast<uint32_t>(depth > 0.0f ? depth : 0.0f) >> (32 - s_DepthBits);
+
+	uint64_t key = s_Mask(pass, s_PassBits);
+	key = (key << s_PipelineBits) | s_Mask(pipeline, s_PipelineBits);
+	key = (key << s_MaterialBits) | s_Mask(material, s_MaterialBits);
+	key = (key << s_MeshBits) | s_Mask(mesh, s_MeshBits);
+	key = (key << s_DepthBits) | s_Mask(depth_bits, s_DepthBits);
+	return key;
+}
+
+void VulkanDrawQueue::submit(const DrawSubmission& submission)
+{
+	if (submission.pipeline == nullptr || !submission.mesh.is_valid()) {
+		return;
+	}
+
+	uint32_t thread_index = core::JobSystem::GetThreadIndex();
+	if (thread_index < m_threadSubmissions.size() - 1)
+	{
+		m_threadSubmissions[thread_index].push_back(submission);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_sharedMutex);
+	m_threadSubmissions.back().push_back(submission);
+}
+
+void VulkanDrawQueue::sort(VulkanFrameRing& frame_ring)
+{
+	gather_submissions();
+	m_batches.clear();
+	m_allocations.clear();
+	m_nbInstances = 0;
+
+	uint32_t count = static_cast<uint32_t>(m_submissions.size());
+	m_stats = DrawQueueStats { .nb_submissions = count };
+	if (count == 0) {
+		return;
+	}
+
+	// Compact pipeline indices, stored in the keys until they are built
+	std::unordered_map<const VulkanPipeline*, uint32_t> pipeline_indices;
+	const VulkanPipeline* last_pipeline = nullptr;
+	uint32_t last_index = 0;
+
+	m_entries.resize(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const VulkanPipeline* pipeline = m_submissions[i].pipeline;
+		if (pipeline != last_pipeline)
+		{
+			uint32_t index = static_cast<uint32_t>(pipeline_indices.size());
+			last_index = pipeline_indices.try_emplace(pipeline, index).first->second;
+			last_pipeline = pipeline;
+		}
+		m_entries[i] = { last_index, i };
+	}
+
+	core::JobSystem::Get().parallel_for(count, s_SortBlockSize, [this](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const DrawSubmission& submission = m_submissions[i];
+			m_entries[i].key = MakeSortKey(
+				submission.pass,
+				static_cast<uint32_t>(m_entries[i].key),
+				submission.material,
+				submission.mesh.get_index(),
+				submission.depth
+			);
+		}
+	});
+
+	s_RadixSort(m_entries, m_scratch);
+
+	build_batches(frame_ring);
+	write_instances();
+	count_binds();
+}
+
+void VulkanDrawQueue::record(
+	VulkanCommandBuffer& command_buffer,
+	uint32_t pass,
+	uint32_t first_batch,
+	uint32_t nb_batches,
+	const VulkanFrameRing& frame_ring,
+	const VulkanFrameRing::Allocation& frame_constants
+) const
+{
+	auto& bindless_set = VulkanContext::GetBindlessSet();
+
+	BoundState state;
+	VkShaderStageFlags push_constant_stages = 0;
+	const resource::Mesh* bound_mesh = nullptr;
+
+	uint32_t end = std::min(first_batch + nb_batches, get_nb_batches());
+	for (uint32_t i = first_batch; i < end; ++i)
+	{
+		const Batch& batch = m_batches[i];
+		if (batch.pass != pass || !batch.pipeline->is_valid()) {
+			continue;
+		}
+		const auto* mesh = resource::ResourceManager::Get(batch.mesh);
+		if (mesh == nullptr || !mesh->is_drawable()) {
+			continue;
+		}
+
+		BindChanges changes = s_UpdateBoundState(state, batch.pipeline, batch.allocation);
+		if (changes.pipeline)
+		{
+			command_buffer.bind_graphics_pipeline(batch.pipeline->get_pipeline());
+
+			push_constant_stages = 0;
+			for (const auto& range : batch.pipeline->get_layout_desc().push_constants) {
+				push_constant_stages |= range.stages;
+			}
+		}
+		if (changes.bindless) {
+			bindless_set.bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.layout);
+		}
+		if (changes.frame_data)
+		{
+			frame_ring.bind(
+				command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, state.layout,
+				frame_constants, m_allocations[batch.allocation].allocation
+			);
+		}
+
+		if (push_constant_stages != 0)
+		{
+			auto dequantization = mesh->get_position_dequantization();
+
+			DrawConstants constants {};
+			std::copy(dequantization.scale.begin(), dequantization.scale.end(), constants.position_scale);
+			std::copy(dequantization.offset.begin(), dequantization.offset.end(), constants.position_offset);
+			constants.first_instance = batch.first_instance;
+
+			command_buffer.push_constants(state.layout, push_constant_stages, constants);
+		}
+
+		if (mesh != bound_mesh)
+		{
+			mesh->bind(command_buffer);
+			bound_mesh = mesh;
+		}
+		mesh->draw(command_buffer, batch.nb_instances);
+	}
+}
+
+void VulkanDrawQueue::gather_submissions()
+{
+	size_t count = 0;
+	for (const auto& submissions : m_threadSubmissions) {
+		count += submissions.size();
+	}
+
+	m_submissions.clear();
+	m_submissions.reserve(count);
+
+	std::lock_guard<std::mutex> lock(m_sharedMutex);
+	for (auto& submissions : m_threadSubmissions)
+	{
+		m_submissions.insert(m_submissions.end(), submissions.begin(), submissions.end());
+		submissions.clear();
+	}
+}
+
+void VulkanDrawQueue::build_batches(VulkanFrameRing& frame_ring)
+{
+	uint32_t count = static_cast<uint32_t>(m_entries.size());
+	uint32_t max_instances = static_cast<uint32_t>(frame_ring.get_storage_range() / sizeof(GpuInstance));
+
+	// Free instances of the last allocation
+	uint32_t remaining = 0;
+	uint32_t used = 0;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const DrawSubmission& submission = m_submissions[m_entries[i].index];
+
+		// The instances are allocated by chunks visible through the storage
+		// buffer range
+		if (remaining == 0)
+		{
+			uint32_t nb_instances = std::min(count - i, max_instances);
+			auto allocation = nb_instances > 0
+				? frame_ring.allocate_storage(nb_instances * sizeof(GpuInstance))
+				: VulkanFrameRing::Allocation();
+			if (!allocation.is_valid())
+			{
+				JDL_WARN("Draw queue: the frame ring is full, {} draws are dropped", count - i);
+				break;
+			}
+			m_allocations.push_back({ allocation, i });
+			remaining = nb_instances;
+			used = 0;
+		}
+
+		// Consecutive submissions sharing their state become instances of
+		// the same draw
+		uint32_t allocation_index = static_cast<uint32_t>(m_allocations.size() - 1);
+		bool merge = !m_batches.empty()
+			&& m_batches.back().pass == submission.pass
+			&& m_batches.back().pipeline == submission.pipeline
+			&& m_batches.back().material == submission.material
+			&& m_batches.back().mesh == submission.mesh
+			&& m_batches.back().allocation == allocation_index;
+		if (!merge)
+		{
+			m_batches.push_back(Batch {
+				.pass = submission.pass,
+				.pipeline = submission.pipeline,
+				.material = submission.material,
+				.mesh = submission.mesh,
+				.allocation = allocation_index,
+				.first_instance = used
+			});
+		}
+
+		++m_batches.back().nb_instances;
+		++used;
+		--remaining;
+		++m_nbInstances;
+	}
+
+	m_stats.nb_draws = static_cast<uint32_t>(m_batches.size());
+}
+
+void VulkanDrawQueue::write_instances()
+{
+	core::JobSystem::Get().parallel_for(m_nbInstances, s_SortBlockSize, [this](uint32_t begin, uint32_t end) {
+		// Allocation of the first entry, the allocations are sorted by entry
+		auto it = std::upper_bound(
+			m_allocations.begin(), m_allocations.end(), begin,
+			[](uint32_t entry, const InstanceAllocation& allocation) { return entry < allocation.first_entry; }
+		);
+		uint32_t allocation_index = static_cast<uint32_t>(it - m_allocations.begin()) - 1;
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			if (allocation_index + 1 < m_allocations.size() && m_allocations[allocation_index + 1].first_entry == i) {
+				++allocation_index;
+			}
+			const InstanceAllocation& allocation = m_allocations[allocation_index];
+
+			auto* instance = static_cast<GpuInstance*>(allocation.allocation.data) + (i - allocation.first_entry);
+			const auto& transform = m_submissions[m_entries[i].index].transform;
+			for (uint32_t row = 0; row < 3; ++row)
+			{
+				for (uint32_t column = 0; column < 4; ++column) {
+					instance->rows[row][column] = transform[column * 4 + row];
+				}
+			}
+		}
+	});
+}
+
+void VulkanDrawQueue::count_binds()
+{
+	BoundState state;
+	uint32_t pass = UINT32_MAX;
+
+	for (const Batch& batch : m_batches)
+	{
+		// Each pass is recorded from scratch
+		if (batch.pass != pass)
+		{
+			state = BoundState();
+			pass = batch.pass;
+		}
+
+		BindChanges changes = s_UpdateBoundState(state, batch.pipeline, batch.allocation);
+		m_stats.nb_pipeline_binds += changes.pipeline ? 1 : 0;
+		m_stats.nb_descriptor_binds += (changes.bindless ? 1 : 0) + (changes.frame_data ? 1 : 0);
+	}
+}
+
+} // namespace vk
+} // namespace jdl
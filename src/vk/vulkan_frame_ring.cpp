@@ -0,0 +1,176 @@
+#include "vk/vulkan_frame_ring.hpp"
+#include "vk/vulkan_command_buffer.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Descriptor ranges: the shaders see this many bytes from each dynamic offset
+static constexpr VkDeviceSize s_MaxUniformRange = 64 * 1024;
+static constexpr VkDeviceSize s_MaxStorageRange = 1024 * 1024;
+
+VulkanFrameRing::VulkanFrameRing(uint32_t nb_frames, VkDeviceSize frame_size)
+{
+	auto& device = VulkanContext::GetDevice();
+	m_device = device.get_device();
+
+	const auto& limits = device.get_properties().limits;
+	m_alignment = std::max(
+		limits.minUniformBufferOffsetAlignment,
+		limits.minStorageBufferOffsetAlignment
+	);
+	m_frameSize = (frame_size + m_alignment - 1) & ~(m_alignment - 1);
+
+	m_uniformRange = std::min({
+		s_MaxUniformRange,
+		m_frameSize,
+		static_cast<VkDeviceSize>(limits.maxUniformBufferRange)
+	});
+	m_storageRange = std::min({
+		s_MaxStorageRange,
+		m_frameSize,
+		static_cast<VkDeviceSize>(limits.maxStorageBufferRange)
+	});
+
+	// Offset + range must stay inside the buffer for any dynamic offset of
+	// the last region
+	VkDeviceSize size = nb_frames * m_frameSize + std::max(m_uniformRange, m_storageRange);
+	m_buffer = std::make_unique<VulkanBuffer>(
+		size,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		MemoryUsage::eCpuToGpu,
+		true
+	);
+
+	create_set();
+}
+
+VulkanFrameRing::~VulkanFrameRing()
+{
+	vkDestroyDescriptorPool(m_device, m_pool, nullptr);
+}
+
+const DescriptorSetLayoutDesc& VulkanFrameRing::GetLayoutDesc()
+{
+	static const DescriptorSetLayoutDesc s_LayoutDesc {
+		.bindings = {
+			{s_UniformBinding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_ALL},
+			{s_StorageBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_ALL}
+		}
+	};
+	return s_LayoutDesc;
+}
+
+void VulkanFrameRing::begin_frame(uint32_t frame_index)
+{
+	m_regionOffset = frame_index * m_frameSize;
+	m_head.store(0, std::memory_order_relaxed);
+}
+
+VulkanFrameRing::Allocation VulkanFrameRing::allocate_uniform(VkDeviceSize size)
+{
+	return allocate(size, m_uniformRange);
+}
+
+VulkanFrameRing::Allocation VulkanFrameRing::allocate_storage(VkDeviceSize size)
+{
+	return allocate(size, m_storageRange);
+}
+
+void VulkanFrameRing::bind(
+	VulkanCommandBuffer& command_buffer,
+	VkPipelineBindPoint bind_point,
+	VkPipelineLayout layout,
+	const Allocation& uniform,
+	const Allocation& storage
+) const
+{
+	// Dynamic offsets are given in binding order
+	command_buffer.bind_descriptor_sets(
+		bind_point, layout, s_Set, { m_set }, { uniform.offset, storage.offset }
+	);
+}
+
+VkDeviceSize VulkanFrameRing::get_used_size() const
+{
+	return std::min(m_head.load(std::memory_order_relaxed), m_frameSize);
+}
+
+void VulkanFrameRing::create_set()
+{
+	std::array<VkDescriptorPoolSize, 2> pool_sizes {{
+		{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1},
+		{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1}
+	}};
+
+	VkDescriptorPoolCreateInfo pool_info {};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets = 1;
+	pool_info.poolSizeCount = VK_SIZE(pool_sizes);
+	pool_info.pPoolSizes = VK_DATA(pool_sizes);
+
+	VK_CALL(vkCreateDescriptorPool(m_device, &pool_info, nullptr, &m_pool));
+
+	VkDescriptorSetLayout layout = VulkanContext::GetLayoutCache().get_descriptor_set_layout(GetLayoutDesc());
+	if (layout == VK_NULL_HANDLE) {
+		JDL_FATAL("Cannot create the frame data descriptor set layout");
+	}
+
+	VkDescriptorSetAllocateInfo alloc_info {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc_info.descriptorPool = m_pool;
+	alloc_info.descriptorSetCount = 1;
+	alloc_info.pSetLayouts = &layout;
+
+	VK_CALL(vkAllocateDescriptorSets(m_device, &alloc_info, &m_set));
+
+	// Written once: allocations are selected by the dynamic offsets
+	VkDescriptorBufferInfo uniform_info { m_buffer->get(), 0, m_uniformRange };
+	VkDescriptorBufferInfo storage_info { m_buffer->get(), 0, m_storageRange };
+
+	std::array<VkWriteDescriptorSet, 2> writes {};
+	for (auto& write : writes)
+	{
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_set;
+		write.descriptorCount = 1;
+	}
+	writes[0].dstBinding = s_UniformBinding;
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	writes[0].pBufferInfo = &uniform_info;
+	writes[1].dstBinding = s_StorageBinding;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	writes[1].pBufferInfo = &storage_info;
+
+	vkUpdateDescriptorSets(m_device, VK_SIZE(writes), VK_DATA(writes), 0, nullptr);
+}
+
+VulkanFrameRing::Allocation VulkanFrameRing::allocate(VkDeviceSize size, VkDeviceSize range)
+{
+	if (size == 0 || size > range) {
+		return {};
+	}
+
+	// Each allocation starts on an aligned offset: reserve the size rounded
+	// up to the alignment, the region start being aligned
+	VkDeviceSize aligned_size = (size + m_alignment - 1) & ~(m_alignment - 1);
+	VkDeviceSize head = m_head.fetch_add(aligned_size, std::memory_order_relaxed);
+	if (head + size > m_frameSize) {
+		return {};
+	}
+
+	VkDeviceSize offset = m_regionOffset + head;
+	return {
+		.buffer = m_buffer->get(),
+		.offset = static_cast<uint32_t>(offset),
+		.data = static_cast<char*>(m_buffer->get_mapped_data()) + offset
+	};
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,544 @@
+#include "vk/vulkan_gpu_scene.hpp"
+
+#include "resource/resource_manager.hpp"
+
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+#include "vk/vulkan_frame_ring.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Object of the scene buffer (GpuObject in cull.slang and scene.slang)
+struct GpuObject
+{
+	// Rows of the world transform
+	float rows[3][4];
+	// World space bounding sphere (center, radius)
+	float sphere[4];
+	uint32_t lod_batches[GpuSceneObject::s_MaxLods];
+	float lod_distances[GpuSceneObject::s_MaxLods];
+};
+static_assert(sizeof(GpuObject) == 96);
+
+// Batch of the scene buffer, stored after the objects
+struct GpuBatch
+{
+	uint32_t nb_indices;
+	uint32_t first_draw;
+	uint32_t padding[2];
+};
+static_assert(sizeof(GpuBatch) == 16);
+
+// Draw written by the culling shader, DrawIndex finds the object index
+struct GpuDraw
+{
+	VkDrawIndexedIndirectCommand command;
+	uint32_t object;
+};
+static_assert(sizeof(GpuDraw) == 24);
+
+// Push constants of the culling shader (CullConstants in cull.slang)
+struct CullConstants
+{
+	float frustum_planes[6][4];
+	float camera[4];
+	uint32_t scene;
+	uint32_t draws;
+	uint32_t counts;
+	uint32_t nb_objects;
+};
+static_assert(sizeof(CullConstants) <= VulkanFrameRing::s_MaxPushConstantsSize);
+
+// Push constants of the scene shader (SceneConstants in scene.slang)
+struct SceneConstants
+{
+	float view_projection[16];
+	float position_scale[4];
+	float position_offset[4];
+	uint32_t scene;
+	uint32_t draws;
+	uint32_t first_draw;
+	uint32_t padding;
+};
+static_assert(sizeof(SceneConstants) <= VulkanFrameRing::s_MaxPushConstantsSize);
+
+VulkanGpuScene::VulkanGpuScene(uint32_t nb_frames)
+	: m_frames(nb_frames)
+{
+	m_cullShader = resource::ResourceManager::Create<resource::Shader>(
+		"__CULL_SHADER__",
+		"shaders/cull.spv"
+	);
+	m_drawShader = resource::ResourceManager::Create<resource::Shader>(
+		"__SCENE_SHADER__",
+		"shaders/scene.spv"
+	);
+	create_pipelines();
+
+	// Identity camera until the application sets one
+	set_camera(GpuSceneObject {}.transform, { 0.0f, 0.0f, 0.0f });
+}
+
+VulkanGpuScene::~VulkanGpuScene()
+{
+	// The scene is destroyed once the device is idle
+	auto& bindless_set = VulkanContext::GetBindlessSet();
+	bindless_set.unregister(BindlessType::eStorageBuffer, m_sceneIndex);
+	for (auto& frame : m_frames)
+	{
+		bindless_set.unregister(BindlessType::eStorageBuffer, frame.draws_index);
+		bindless_set.unregister(BindlessType::eStorageBuffer, frame.counts_index);
+	}
+}
+
+uint32_t VulkanGpuScene::add_object(const GpuSceneObject& object)
+{
+	m_objects.push_back(object);
+	++m_version;
+	return static_cast<uint32_t>(m_objects.size() - 1);
+}
+
+void VulkanGpuScene::clear()
+{
+	m_objects.clear();
+	++m_version;
+}
+
+void VulkanGpuScene::set_camera(
+	const std::array<float, 16>& view_projection,
+	const std::array<float, 3>& position,
+	float lod_scale
+)
+{
+	m_viewProjection = view_projection;
+	m_camera = { position[0], position[1], position[2], lod_scale };
+
+	// Planes of the clip volume (-w <= x, y <= w, 0 <= z <= w), from the rows
+	// of the matrix
+	const auto& m = view_projection;
+	auto row = [&m](uint32_t i) {
+		return std::array<float, 4> { m[i], m[4 + i], m[8 + i], m[12 + i] };
+	};
+	std::array<float, 4> x = row(0), y = row(1), z = row(2), w = row(3);
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		m_frustumPlanes[0][i] = w[i] + x[i];
+		m_frustumPlanes[1][i] = w[i] - x[i];
+		m_frustumPlanes[2][i] = w[i] + y[i];
+		m_frustumPlanes[3][i] = w[i] - y[i];
+		m_frustumPlanes[4][i] = z[i];
+		m_frustumPlanes[5][i] = w[i] - z[i];
+	}
+
+	// Normalized, so that the sphere radii can be compared to the distances
+	for (auto& plane : m_frustumPlanes)
+	{
+		float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 0.0f)
+		{
+			for (float& value : plane) {
+				value /= length;
+			}
+		}
+	}
+}
+
+bool VulkanGpuScene::has_draws() const
+{
+	return m_nbGpuObjects > 0 && !m_batches.empty()
+		&& m_cullPipeline != nullptr && m_cullPipeline->is_valid()
+		&& VulkanContext::GetUploader().is_complete(m_sceneUpload);
+}
+
+void VulkanGpuScene::update(uint64_t frame, uint32_t nb_frames_in_flight)
+{
+	m_frame = frame;
+
+	// Buffers retired at update(F) may be used by the frames up to F - 1
+	std::erase_if(m_retiredBuffers, [frame, nb_frames_in_flight](const RetiredBuffer& retired) {
+		return retired.frame + nb_frames_in_flight <= frame;
+	});
+
+	if (m_version == m_gpuVersion && !m_pending) {
+		return;
+	}
+
+	// Objects whose meshes are ready (the ones still loading are checked
+	// again next frame)
+	auto guard = resource::ResourceManager::Pin();
+	std::vector<const GpuSceneObject*> objects;
+	bool pending = false;
+	for (const auto& object : m_objects)
+	{
+		bool ready = object.lods[0].is_valid();
+		for (const auto& lod : object.lods)
+		{
+			if (!lod.is_valid()) {
+				break;
+			}
+			const auto* mesh = resource::ResourceManager::Get(lod);
+			if (mesh == nullptr || !mesh->is_drawable())
+			{
+				// Removed or failed meshes are never drawn
+				pending |= mesh != nullptr && mesh->get_load_state() != resource::LoadState::eFailed;
+				ready = false;
+			}
+		}
+		if (ready) {
+			objects.push_back(&object);
+		}
+	}
+	m_pending = pending;
+
+	if (m_version == m_gpuVersion && objects.size() == m_nbGpuObjects) {
+		return;
+	}
+	m_gpuVersion = m_version;
+	rebuild(objects);
+}
+
+GpuSceneDraws VulkanGpuScene::add_cull_pass(VulkanRenderGraph& graph, uint32_t frame_index)
+{
+	if (!has_draws()) {
+		return {};
+	}
+
+	const FrameDraws& frame = m_frames[frame_index];
+	GpuSceneDraws draws {
+		.draws = graph.import_buffer("scene_draws", frame.draws->get()),
+		.counts = graph.import_buffer("scene_draw_counts", frame.counts->get())
+	};
+
+	graph.add_pass("cull")
+		.write(draws.draws, RenderGraphAccess::eStorageBufferWrite)
+		.write(draws.counts, RenderGraphAccess::eStorageBufferWrite)
+		.set_execute([this, frame_index](VulkanCommandBuffer& command_buffer) {
+			record_cull(command_buffer, frame_index);
+		});
+
+	return draws;
+}
+
+void VulkanGpuScene::record_draws(VulkanCommandBuffer& command_buffer, uint32_t frame_index) const
+{
+	const FrameDraws& frame = m_frames[frame_index];
+	auto& bindless_set = VulkanContext::GetBindlessSet();
+
+	SceneConstants constants {
+		.scene = m_sceneIndex,
+		.draws = frame.draws_index
+	};
+	std::copy(m_viewProjection.begin(), m_viewProjection.end(), constants.view_projection);
+
+	// One indirect draw per batch: the pipeline only changes with the vertex
+	// layout, and the bindless set with the pipeline layout
+	const VulkanPipeline* bound_pipeline = nullptr;
+	VkPipelineLayout bound_layout = VK_NULL_HANDLE;
+	VkShaderStageFlags push_constant_stages = 0;
+
+	for (uint32_t i = 0; i < m_batches.size(); ++i)
+	{
+		const Batch& batch = m_batches[i];
+		const auto* mesh = resource::ResourceManager::Get(batch.mesh);
+		if (mesh == nullptr || !mesh->is_drawable() || batch.pipeline == nullptr || !batch.pipeline->is_valid()) {
+			continue;
+		}
+
+		if (batch.pipeline != bound_pipeline)
+		{
+			command_buffer.bind_graphics_pipeline(batch.pipeline->get_pipeline());
+			bound_pipeline = batch.pipeline;
+
+			if (batch.pipeline->get_pipeline_layout() != bound_layout)
+			{
+				bound_layout = batch.pipeline->get_pipeline_layout();
+				bindless_set.bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bound_layout);
+
+				push_constant_stages = 0;
+				for (const auto& range : batch.pipeline->get_layout_desc().push_constants) {
+					push_constant_stages |= range.stages;
+				}
+			}
+		}
+
+		auto dequantization = mesh->get_position_dequantization();
+		std::copy(dequantization.scale.begin(), dequantization.scale.end(), constants.position_scale);
+		std::copy(dequantization.offset.begin(), dequantization.offset.end(), constants.position_offset);
+		constants.first_draw = batch.first_draw;
+
+		command_buffer.push_constants(bound_layout, push_constant_stages, constants);
+
+		mesh->bind(command_buffer);
+		command_buffer.draw_indexed_indirect_count(
+			frame.draws->get(), batch.first_draw * sizeof(GpuDraw),
+			frame.counts->get(), i * sizeof(uint32_t),
+			batch.capacity, sizeof(GpuDraw)
+		);
+	}
+}
+
+void VulkanGpuScene::create_pipelines()
+{
+	auto* cull_shader = resource::ResourceManager::Get(m_cullShader);
+	if (cull_shader == nullptr || !cull_shader->is_ready())
+	{
+		JDL_WARN("GPU scene disabled: the culling shader is not available");
+		return;
+	}
+
+	PipelineDesc desc;
+	desc.shaders = {
+		{ShaderStage::eCompute, cull_shader}
+	};
+	m_cullPipeline = VulkanContext::GetPipelineLibrary().get(desc);
+	if (m_cullPipeline == nullptr) {
+		JDL_ERROR("Cannot create the culling pipeline");
+	}
+}
+
+VulkanPipeline* VulkanGpuScene::get_draw_pipeline(const resource::VertexLayout& layout) const
+{
+	auto* shader = resource::ResourceManager::Get(m_drawShader);
+	if (shader == nullptr || !shader->is_ready()) {
+		return nullptr;
+	}
+
+	// The library returns the same pipeline for the meshes sharing a layout
+	PipelineDesc desc;
+	desc.shaders = {
+		{ShaderStage::eVertex, shader},
+		{ShaderStage::eFragment, shader}
+	};
+	desc.depth = { .test = true, .write = true };
+	desc.color_formats = { VulkanContext::GetColorFormat() };
+	desc.depth_format = VulkanContext::GetDepthFormat();
+	layout.fill_pipeline_desc(desc);
+
+	return VulkanContext::GetPipelineLibrary().get(desc);
+}
+
+void VulkanGpuScene::rebuild(const std::vector<const GpuSceneObject*>& objects)
+{
+	retire(m_sceneBuffer, m_sceneIndex);
+	m_batches.clear();
+	m_nbGpuObjects = 0;
+	m_nbDraws = 0;
+
+	if (objects.empty()) {
+		return;
+	}
+
+	// One batch per mesh, with room for every object which may select it
+	std::unordered_map<uint32_t, uint32_t> mesh_batches;
+	std::vector<GpuObject> gpu_objects(objects.size());
+
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		const GpuSceneObject& object = *objects[i];
+		GpuObject& gpu_object = gpu_objects[i];
+
+		const auto& m = object.transform;
+		for (uint32_t row = 0; row < 3; ++row)
+		{
+			for (uint32_t column = 0; column < 4; ++column) {
+				gpu_object.rows[row][column] = m[column * 4 + row];
+			}
+		}
+
+		for (uint32_t lod = 0; lod < GpuSceneObject::s_MaxLods; ++lod)
+		{
+			gpu_object.lod_batches[lod] = s_InvalidBatch;
+			gpu_object.lod_distances[lod] = object.lod_distances[lod];
+		}
+
+		// The LODs stop at the first invalid one, as in update() and in the
+		// culling shader
+		for (uint32_t lod = 0; lod < GpuSceneObject::s_MaxLods; ++lod)
+		{
+			if (!object.lods[lod].is_valid()) {
+				break;
+			}
+
+			auto [it, inserted] = mesh_batches.try_emplace(
+				object.lods[lod].get_value(), static_cast<uint32_t>(m_batches.size())
+			);
+			if (inserted) {
+				m_batches.push_back({ .mesh = object.lods[lod] });
+			}
+
+			// An object draws its mesh once, even if several LODs share it
+			uint32_t batch = it->second;
+			bool counted = std::find(gpu_object.lod_batches, gpu_object.lod_batches + lod, batch)
+				!= gpu_object.lod_batches + lod;
+			if (!counted) {
+				++m_batches[batch].capacity;
+			}
+			gpu_object.lod_batches[lod] = batch;
+		}
+
+		// Sphere around the bounds of the most detailed LOD, scaled by the
+		// largest axis scale
+		const auto& bounds = resource::ResourceManager::Get(object.lods[0])->get_bounds();
+		float radius = std::sqrt(
+			bounds.extent[0] * bounds.extent[0] +
+			bounds.extent[1] * bounds.extent[1] +
+			bounds.extent[2] * bounds.extent[2]
+		);
+		float max_scale = 0.0f;
+		for (uint32_t column = 0; column < 3; ++column)
+		{
+			float scale = std::sqrt(
+				m[column * 4] * m[column * 4] +
+				m[column * 4 + 1] * m[column * 4 + 1] +
+				m[column * 4 + 2] * m[column * 4 + 2]
+			);
+			max_scale = std::max(max_scale, scale);
+		}
+
+		for (uint32_t row = 0; row < 3; ++row)
+		{
+			const float* r = gpu_object.rows[row];
+			gpu_object.sphere[row] = r[0] * bounds.center[0] + r[1] * bounds.center[1] + r[2] * bounds.center[2] + r[3];
+		}
+		gpu_object.sphere[3] = radius * max_scale;
+	}
+
+	std::vector<GpuBatch> gpu_batches(m_batches.size());
+	for (size_t i = 0; i < m_batches.size(); ++i)
+	{
+		Batch& batch = m_batches[i];
+		const auto* mesh = resource::ResourceManager::Get(batch.mesh);
+
+		// A removed mesh keeps its draw range, never drawn (no pipeline)
+		batch.pipeline = mesh != nullptr ? get_draw_pipeline(mesh->get_layout()) : nullptr;
+		batch.first_draw = m_nbDraws;
+		m_nbDraws += batch.capacity;
+
+		gpu_batches[i] = {
+			.nb_indices = mesh != nullptr ? mesh->get_nb_indices() : 0,
+			.first_draw = batch.first_draw
+		};
+	}
+	m_nbGpuObjects = static_cast<uint32_t>(objects.size());
+
+	// Objects followed by the batches: the culling shader finds the batches
+	// from the number of objects
+	size_t objects_size = gpu_objects.size() * sizeof(GpuObject);
+	size_t batches_size = gpu_batches.size() * sizeof(GpuBatch);
+	std::vector<std::byte> data(objects_size + batches_size);
+	std::memcpy(data.data(), gpu_objects.data(), objects_size);
+	std::memcpy(data.data() + objects_size, gpu_batches.data(), batches_size);
+
+	m_sceneBuffer = std::make_unique<VulkanBuffer>(
+		data.size(),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		MemoryUsage::eGpuOnly
+	);
+	m_sceneUpload = VulkanContext::GetUploader().upload_buffer(
+		*m_sceneBuffer, data.data(), data.size(), 0,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+		VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+	);
+	m_sceneIndex = VulkanContext::GetBindlessSet().register_storage_buffer(m_sceneBuffer->get());
+
+	resize_frame_draws();
+
+	JDL_INFO(
+		"GPU scene: {} objects ({} pending), {} batches, {} draws",
+		m_nbGpuObjects, m_objects.size() - m_nbGpuObjects, m_batches.size(), m_nbDraws
+	);
+}
+
+void VulkanGpuScene::resize_frame_draws()
+{
+	auto& bindless_set = VulkanContext::GetBindlessSet();
+
+	// Grown by powers of two, so that loading a scene progressively does not
+	// reallocate them every time
+	VkDeviceSize draws_size = std::bit_ceil(std::max(m_nbDraws, 1u)) * sizeof(GpuDraw);
+	VkDeviceSize counts_size = std::bit_ceil(std::max(get_nb_batches(), 1u)) * sizeof(uint32_t);
+
+	for (auto& frame : m_frames)
+	{
+		if (frame.draws == nullptr || frame.draws->get_size() < draws_size)
+		{
+			retire(frame.draws, frame.draws_index);
+			frame.draws = std::make_unique<VulkanBuffer>(
+				draws_size,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				MemoryUsage::eGpuOnly
+			);
+			frame.draws_index = bindless_set.register_storage_buffer(frame.draws->get());
+		}
+
+		if (frame.counts == nullptr || frame.counts->get_size() < counts_size)
+		{
+			retire(frame.counts, frame.counts_index);
+			frame.counts = std::make_unique<VulkanBuffer>(
+				counts_size,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				MemoryUsage::eGpuOnly
+			);
+			frame.counts_index = bindless_set.register_storage_buffer(frame.counts->get());
+		}
+	}
+}
+
+void VulkanGpuScene::retire(std::unique_ptr<VulkanBuffer>& buffer, uint32_t& bindless_index)
+{
+	if (buffer == nullptr) {
+		return;
+	}
+
+	VulkanContext::GetBindlessSet().unregister(BindlessType::eStorageBuffer, bindless_index);
+	bindless_index = VulkanBindlessSet::s_InvalidIndex;
+	m_retiredBuffers.push_back({ std::move(buffer), m_frame });
+}
+
+void VulkanGpuScene::record_cull(VulkanCommandBuffer& command_buffer, uint32_t frame_index) const
+{
+	const FrameDraws& frame = m_frames[frame_index];
+
+	// The batches append their draws from 0
+	command_buffer.fill_buffer(frame.counts->get(), 0, VK_WHOLE_SIZE, 0);
+	command_buffer.memory_barrier(
+		VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
+	);
+
+	VkPipelineLayout layout = m_cullPipeline->get_pipeline_layout();
+	command_buffer.bind_compute_pipeline(m_cullPipeline->get_pipeline());
+	VulkanContext::GetBindlessSet().bind(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout);
+
+	CullConstants constants {
+		.camera = { m_camera[0], m_camera[1], m_camera[2], m_camera[3] },
+		.scene = m_sceneIndex,
+		.draws = frame.draws_index,
+		.counts = frame.counts_index,
+		.nb_objects = m_nbGpuObjects
+	};
+	for (uint32_t i = 0; i < 6; ++i) {
+		std::copy(m_frustumPlanes[i].begin(), m_frustumPlanes[i].end(), constants.frustum_planes[i]);
+	}
+	command_buffer.push_constants(layout, VK_SHADER_STAGE_COMPUTE_BIT, constants);
+
+	command_buffer.dispatch((m_nbGpuObjects + s_WorkGroupSize - 1) / s_WorkGroupSize);
+}
+
+} // namespace vk
+} // namespace jdl
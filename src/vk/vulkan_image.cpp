@@ -0,0 +1,71 @@
+#include "vk/vulkan_image.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanImage::VulkanImage(const VulkanImageInfo& info)
+	: m_info(info)
+{
+	m_device = VulkanContext::GetDevice().get_device();
+
+	VkImageCreateInfo image_info {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = info.extent.depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D,
+		.format = info.format,
+		.extent = info.extent,
+		.mipLevels = info.mip_levels,
+		.arrayLayers = info.array_layers,
+		.samples = info.samples,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = info.usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+	};
+	VK_CALL(vkCreateImage(m_device, &image_info, nullptr, &m_image));
+
+	m_allocation = VulkanContext::GetAllocator().allocate_image(m_image, MemoryUsage::eGpuOnly, info.dedicated);
+	if (!m_allocation.is_valid()) {
+		JDL_FATAL("Failed to allocate the memory of a {}x{} image", info.extent.width, info.extent.height);
+	}
+
+	VK_CALL(vkBindImageMemory(m_device, m_image, m_allocation.memory, m_allocation.offset));
+
+	VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+	if (info.extent.depth > 1) {
+		view_type = VK_IMAGE_VIEW_TYPE_3D;
+	}
+	else if (info.array_layers > 1) {
+		view_type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	}
+
+	VkImageViewCreateInfo view_info {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.image = m_image,
+		.viewType = view_type,
+		.format = info.format,
+		.subresourceRange = {
+			.aspectMask = info.aspect,
+			.baseMipLevel = 0,
+			.levelCount = info.mip_levels,
+			.baseArrayLayer = 0,
+			.layerCount = info.array_layers
+		}
+	};
+	VK_CALL(vkCreateImageView(m_device, &view_info, nullptr, &m_view));
+}
+
+VulkanImage::~VulkanImage()
+{
+	vkDestroyImageView(m_device, m_view, nullptr);
+	vkDestroyImage(m_device, m_image, nullptr);
+	VulkanContext::GetAllocator().free(m_allocation);
+}
+
+} // namespace vk
+} // namespace jdl
@@ -4,6 +4,8 @@
 
 #include "utils/logger.hpp"
 
+#include "vk/vulkan_context.hpp"
+
 
 namespace jdl
 {
@@ -151,7 +153,11 @@ void VulkanInstance::create_instance()
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.apiVersion = VK_API_VERSION_1_4;
 
-    auto extensions = core::Application::GetWindow().GetRequiredInstanceExtensions();
+    // No surface extension is required when rendering offscreen
+    std::vector<const char*> extensions;
+    if (!VulkanContext::IsHeadless()) {
+        extensions = core::Window::GetRequiredInstanceExtensions();
+    }
     if (s_UseValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
@@ -0,0 +1,166 @@
+#include "vk/vulkan_layout_cache.hpp"
+
+#include "utils/hash.hpp"
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+uint64_t DescriptorSetLayoutDesc::hash() const
+{
+	using utils::fnv1a_64;
+
+	uint64_t h = fnv1a_64(bindings.size(), utils::s_Fnv1aOffsetBasis);
+	h = fnv1a_64(flags, h);
+	for (const auto& binding : bindings)
+	{
+		h = fnv1a_64(binding.binding, h);
+		h = fnv1a_64(binding.type, h);
+		h = fnv1a_64(binding.count, h);
+		h = fnv1a_64(binding.stages, h);
+		h = fnv1a_64(binding.flags, h);
+	}
+	return h;
+}
+
+uint64_t PipelineLayoutDesc::hash() const
+{
+	using utils::fnv1a_64;
+
+	uint64_t h = fnv1a_64(sets.size(), utils::s_Fnv1aOffsetBasis);
+	for (const auto& set : sets) {
+		h = fnv1a_64(set.hash(), h);
+	}
+
+	h = fnv1a_64(push_constants.size(), h);
+	for (const auto& range : push_constants)
+	{
+		h = fnv1a_64(range.offset, h);
+		h = fnv1a_64(range.size, h);
+		h = fnv1a_64(range.stages, h);
+	}
+	return h;
+}
+
+VulkanLayoutCache::VulkanLayoutCache()
+{
+	m_device = VulkanContext::GetDevice().get_device();
+}
+
+VulkanLayoutCache::~VulkanLayoutCache()
+{
+	for (const auto& [desc, layout] : m_pipelineLayouts) {
+		vkDestroyPipelineLayout(m_device, layout, nullptr);
+	}
+	for (const auto& [desc, layout] : m_setLayouts) {
+		vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+	}
+}
+
+VkDescriptorSetLayout VulkanLayoutCache::get_descriptor_set_layout(const DescriptorSetLayoutDesc& desc)
+{
+	std::lock_guard lock(m_mutex);
+	return get_descriptor_set_layout_locked(desc);
+}
+
+VkPipelineLayout VulkanLayoutCache::get_pipeline_layout(const PipelineLayoutDesc& desc)
+{
+	std::lock_guard lock(m_mutex);
+
+	auto it = m_pipelineLayouts.find(desc);
+	if (it != m_pipelineLayouts.end()) {
+		return it->second;
+	}
+
+	std::vector<VkDescriptorSetLayout> set_layouts;
+	set_layouts.reserve(desc.sets.size());
+	for (const auto& set : desc.sets)
+	{
+		VkDescriptorSetLayout set_layout = get_descriptor_set_layout_locked(set);
+		if (set_layout == VK_NULL_HANDLE) {
+			return VK_NULL_HANDLE;
+		}
+		set_layouts.push_back(set_layout);
+	}
+
+	std::vector<VkPushConstantRange> ranges;
+	ranges.reserve(desc.push_constants.size());
+	for (const auto& range : desc.push_constants) {
+		ranges.push_back({range.stages, range.offset, range.size});
+	}
+
+	VkPipelineLayoutCreateInfo layout_info {};
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.setLayoutCount = VK_SIZE(set_layouts);
+	layout_info.pSetLayouts = VK_DATA(set_layouts);
+	layout_info.pushConstantRangeCount = VK_SIZE(ranges);
+	layout_info.pPushConstantRanges = VK_DATA(ranges);
+
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	VK_CALL(vkCreatePipelineLayout(m_device, &layout_info, nullptr, &layout));
+	if (layout != VK_NULL_HANDLE) {
+		m_pipelineLayouts.emplace(desc, layout);
+	}
+	return layout;
+}
+
+size_t VulkanLayoutCache::get_nb_descriptor_set_layouts() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_setLayouts.size();
+}
+
+size_t VulkanLayoutCache::get_nb_pipeline_layouts() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_pipelineLayouts.size();
+}
+
+VkDescriptorSetLayout VulkanLayoutCache::get_descriptor_set_layout_locked(
+	const DescriptorSetLayoutDesc& desc
+)
+{
+	auto it = m_setLayouts.find(desc);
+	if (it != m_setLayouts.end()) {
+		return it->second;
+	}
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	std::vector<VkDescriptorBindingFlags> binding_flags;
+	bindings.reserve(desc.bindings.size());
+	binding_flags.reserve(desc.bindings.size());
+	bool has_binding_flags = false;
+	for (const auto& binding : desc.bindings)
+	{
+		bindings.push_back({binding.binding, binding.type, binding.count, binding.stages, nullptr});
+		binding_flags.push_back(binding.flags);
+		has_binding_flags |= binding.flags != 0;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info {};
+	flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flags_info.bindingCount = VK_SIZE(binding_flags);
+	flags_info.pBindingFlags = VK_DATA(binding_flags);
+
+	VkDescriptorSetLayoutCreateInfo layout_info {};
+	layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.pNext = has_binding_flags ? &flags_info : nullptr;
+	layout_info.flags = desc.flags;
+	layout_info.bindingCount = VK_SIZE(bindings);
+	layout_info.pBindings = VK_DATA(bindings);
+
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	VK_CALL(vkCreateDescriptorSetLayout(m_device, &layout_info, nullptr, &layout));
+	if (layout != VK_NULL_HANDLE) {
+		m_setLayouts.emplace(desc, layout);
+	}
+	return layout;
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,66 @@
+#include "vk/vulkan_offscreen_target.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+static VkDeviceSize s_GetPixelSize(VkFormat format)
+{
+	switch (format)
+	{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			return 4;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			return 8;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+		default:
+			JDL_FATAL("Unsupported offscreen format {}", (int)format);
+			return 0;
+	}
+}
+
+VulkanOffscreenTarget::VulkanOffscreenTarget(
+	VkExtent2D extent,
+	VkFormat format,
+	uint32_t nb_images,
+	bool readback
+)
+	: m_extent(extent)
+	, m_format(format)
+	, m_readback(readback)
+{
+	m_readbackSize = s_GetPixelSize(format) * extent.width * extent.height;
+
+	VulkanImageInfo image_info {
+		.extent = { extent.width, extent.height, 1 },
+		.format = format,
+		.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		.dedicated = true
+	};
+
+	m_images.resize(nb_images);
+	for (auto& image : m_images)
+	{
+		image.image = std::make_unique<VulkanImage>(image_info);
+		if (m_readback)
+		{
+			image.readback = std::make_unique<VulkanBuffer>(
+				m_readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryUsage::eGpuToCpu
+			);
+		}
+	}
+}
+
+VulkanOffscreenTarget::~VulkanOffscreenTarget() {}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,88 @@
+#include "vk/vulkan_parallel_recorder.hpp"
+
+#include "core/job_system.hpp"
+
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanParallelRecorder::VulkanParallelRecorder(uint32_t nb_frames)
+{
+	auto& device = VulkanContext::GetDevice();
+	uint32_t graphics_family = device.get_queue_family_indices().graphics;
+
+	m_allocators.resize(core::JobSystem::Get().get_nb_threads());
+	for (auto& allocator : m_allocators) {
+		allocator = std::make_unique<VulkanCommandAllocator>(graphics_family, nb_frames);
+	}
+
+	JDL_INFO("Vulkan Parallel Recorder: OK ({} threads)", m_allocators.size());
+}
+
+VulkanParallelRecorder::~VulkanParallelRecorder() {}
+
+void VulkanParallelRecorder::begin_frame(uint32_t frame_index)
+{
+	// No recording job runs between two batches: the pools can be reset
+	for (auto& allocator : m_allocators) {
+		allocator->begin_frame(frame_index);
+	}
+}
+
+std::vector<VulkanCommandBuffer*> VulkanParallelRecorder::record(
+	const RenderingFormats& formats,
+	const std::vector<RecordFunction>& functions,
+	VkQueryPipelineStatisticFlags pipeline_statistics
+)
+{
+	if (functions.empty()) {
+		return {};
+	}
+
+	// The calling thread records some of the functions with its own pools
+	if (core::JobSystem::GetThreadIndex() >= m_allocators.size()) {
+		JDL_FATAL("Secondary command buffers must be recorded from a job system thread");
+	}
+
+	VkCommandBufferInheritanceRenderingInfo rendering_info {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+		.colorAttachmentCount = VK_SIZE(formats.color_formats),
+		.pColorAttachmentFormats = VK_DATA(formats.color_formats),
+		.depthAttachmentFormat = formats.depth_format,
+		.stencilAttachmentFormat = formats.stencil_format,
+		.rasterizationSamples = formats.samples
+	};
+	std::vector<VulkanCommandBuffer*> results(functions.size(), nullptr);
+
+	// One function per job: the slow ones do not stall the others. Jobs only
+	// run on the job system threads, each recording with its own pools
+	auto& job_system = core::JobSystem::Get();
+	job_system.parallel_for(
+		static_cast<uint32_t>(functions.size()), 1,
+		[&](uint32_t begin, uint32_t end) {
+			VulkanCommandAllocator& allocator = *m_allocators[core::JobSystem::GetThreadIndex()];
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				VulkanCommandBuffer* command_buffer = allocator.allocate(
+					VK_COMMAND_BUFFER_LEVEL_SECONDARY
+				);
+				command_buffer->begin_secondary(rendering_info, pipeline_statistics);
+				functions[i](*command_buffer);
+				command_buffer->end();
+
+				results[i] = command_buffer;
+			}
+		}
+	);
+
+	return results;
+}
+
+} // namespace vk
+} // namespace jdl
@@ -5,6 +5,10 @@
 #include "utils/logger.hpp"
 
 #include "vk/vulkan_context.hpp"
+#include "vk/vulkan_frame_ring.hpp"
+
+#include <algorithm>
+#include <set>
 
 
 namespace jdl
@@ -12,176 +16,538 @@ namespace jdl
 namespace vk
 {
 
-static const std::unordered_map<ShaderStage, const char*> s_ShaderEntryPoint {
-	{ShaderStage::eVertex, "vert_main"},
-	{ShaderStage::eFragment, "frag_main"}
-};
-
 static const std::vector<VkDynamicState> s_DynamicState = {
 	VK_DYNAMIC_STATE_VIEWPORT,
 	VK_DYNAMIC_STATE_SCISSOR
 };
 
-VulkanPipeline::VulkanPipeline()
+// Entry point of a shader stage: the named one, or the first one of the stage
+static const resource::ShaderEntryPoint* s_FindEntryPoint(const ShaderDesc& shader)
 {
-	m_device = VulkanContext::GetDevice().get_device();
+	const auto& reflection = shader.shader->get_reflection();
+	return shader.entry_point.empty()
+		? reflection.find_entry_point(static_cast<VkShaderStageFlagBits>(shader.stage))
+		: reflection.find_entry_point(shader.entry_point);
 }
 
-VulkanPipeline::~VulkanPipeline()
+// Sets shared by every pipeline, whatever the bindings its shaders access
+static const DescriptorSetLayoutDesc* s_FindSharedSet(uint32_t set)
 {
-	if (m_pipelineLayout != VK_NULL_HANDLE) {
-		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+	if (set == VulkanBindlessSet::s_Set) {
+		return &VulkanContext::GetBindlessSet().get_layout_desc();
 	}
-	if (m_pipeline != VK_NULL_HANDLE) {
-		vkDestroyPipeline(m_device, m_pipeline, nullptr);
+	if (set == VulkanFrameRing::s_Set) {
+		return &VulkanFrameRing::GetLayoutDesc();
 	}
+	return nullptr;
 }
 
-void VulkanPipeline::add_shader(ShaderStage stage, resource::Shader* shader)
+// Bindings of a shared set must match its layout (dynamic buffers are
+// reflected as regular ones)
+static bool s_MatchesSharedSet(
+	const resource::ShaderBinding& binding,
+	const DescriptorSetLayoutDesc& set
+)
 {
-	if (m_pipeline != VK_NULL_HANDLE)
+	auto it = std::find_if(set.bindings.begin(), set.bindings.end(), [&binding](const auto& other) {
+		return other.binding == binding.binding;
+	});
+	if (it == set.bindings.end() || binding.count > it->count) {
+		return false;
+	}
+
+	switch (it->type)
 	{
-		JDL_ERROR("Cannot add shader on a created pipeline");
-		return;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+			return binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			return binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		default:
+			return binding.type == it->type;
 	}
-	m_shaders[stage] = shader;
 }
 
-void VulkanPipeline::create()
+// Merges the resources used by each stage into a pipeline layout description
+static bool s_BuildLayoutDesc(const PipelineDesc& desc, PipelineLayoutDesc& layout)
 {
-	if (m_pipeline != VK_NULL_HANDLE)
+	std::set<uint32_t> shared_sets;
+	for (const auto& shader : desc.shaders)
 	{
-		JDL_ERROR("Vulkan pipeline has already been created");
-		return;
+		auto stage = static_cast<VkShaderStageFlags>(shader.stage);
+		const auto& reflection = shader.shader->get_reflection();
+
+		for (const auto& binding : reflection.bindings)
+		{
+			if ((binding.stages & stage) == 0) {
+				continue;
+			}
+			if (const auto* shared_set = s_FindSharedSet(binding.set))
+			{
+				if (!s_MatchesSharedSet(binding, *shared_set))
+				{
+					JDL_ERROR(
+						"Shader {}: {} does not match the layout of set {}",
+						shader.shader->get_name(), binding.name, binding.set
+					);
+					return false;
+				}
+				shared_sets.insert(binding.set);
+				continue;
+			}
+			if (binding.count == 0)
+			{
+				JDL_ERROR(
+					"Shader {}: runtime-sized array {} is only supported in the bindless set",
+					shader.shader->get_name(), binding.name
+				);
+				return false;
+			}
+
+			if (binding.set >= layout.sets.size()) {
+				layout.sets.resize(binding.set + 1);
+			}
+			auto& bindings = layout.sets[binding.set].bindings;
+
+			auto it = std::find_if(bindings.begin(), bindings.end(), [&binding](const auto& other) {
+				return other.binding == binding.binding;
+			});
+			if (it == bindings.end()) {
+				bindings.push_back({binding.binding, binding.type, binding.count, stage});
+			}
+			else if (it->type != binding.type || it->count != binding.count)
+			{
+				JDL_ERROR(
+					"Set {} binding {} is declared differently by several stages",
+					binding.set, binding.binding
+				);
+				return false;
+			}
+			else {
+				it->stages |= stage;
+			}
+		}
+
+		for (const auto& range : reflection.push_constants)
+		{
+			if ((range.stages & stage) == 0) {
+				continue;
+			}
+
+			auto& ranges = layout.push_constants;
+			auto it = std::find_if(ranges.begin(), ranges.end(), [&range](const auto& other) {
+				return other.offset == range.offset && other.size == range.size;
+			});
+			if (it == ranges.end()) {
+				ranges.push_back({range.offset, range.size, stage});
+			}
+			else {
+				it->stages |= stage;
+			}
+		}
 	}
-	if (m_shaders.find(ShaderStage::eVertex) == m_shaders.end())
+
+	for (uint32_t set : shared_sets)
 	{
-		JDL_ERROR("Cannot create pipeline: missing vertex shader");
-		return;
+		if (set >= layout.sets.size()) {
+			layout.sets.resize(set + 1);
+		}
+		layout.sets[set] = *s_FindSharedSet(set);
 	}
-	if (m_shaders.find(ShaderStage::eFragment) == m_shaders.end())
+
+	for (auto& set : layout.sets)
 	{
-		JDL_ERROR("Cannot create pipeline: missing fragment shader");
-		return;
+		std::sort(set.bindings.begin(), set.bindings.end(), [](const auto& a, const auto& b) {
+			return a.binding < b.binding;
+		});
 	}
-
-	create_pipeline_layout();
-	create_pipeline();
+	return true;
 }
 
-void VulkanPipeline::create_pipeline_layout()
+// Create infos of a pipeline, kept alive until vkCreateGraphicsPipelines returns
+struct PipelineCreateState
 {
-	VkPipelineLayoutCreateInfo pipeline_layout_info {};
-	pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	std::vector<VkPipelineShaderStageCreateInfo> shader_infos;
+	std::vector<VkVertexInputBindingDescription> vertex_bindings;
+	std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+	std::vector<VkPipelineColorBlendAttachmentState> blend_attachments;
 
-	VK_CALL(
-		vkCreatePipelineLayout(
-			m_device, &pipeline_layout_info, nullptr, &m_pipelineLayout
-		)
-	);
-}
+	VkPipelineDynamicStateCreateInfo dynamic_state {};
+	VkPipelineVertexInputStateCreateInfo vertex_input {};
+	VkPipelineInputAssemblyStateCreateInfo input_assembly {};
+	VkPipelineViewportStateCreateInfo viewport_state {};
+	VkPipelineRasterizationStateCreateInfo rasterizer {};
+	VkPipelineMultisampleStateCreateInfo multisampling {};
+	VkPipelineDepthStencilStateCreateInfo depth_stencil {};
+	VkPipelineColorBlendStateCreateInfo color_blending {};
+	VkPipelineRenderingCreateInfo rendering_info {};
+	VkGraphicsPipelineCreateInfo pipeline_info {};
+};
 
-void VulkanPipeline::create_pipeline()
+static void s_FillCreateState(
+	const PipelineDesc& desc,
+	VkPipelineLayout layout,
+	const ShaderModuleMap& modules,
+	PipelineCreateState& state
+)
 {
-	VkSurfaceFormatKHR format = VulkanContext::GetSwapchain().get_surface_format();
-
 	// Shaders
-	std::vector<VkPipelineShaderStageCreateInfo> shader_infos;
-	for (const auto& [stage, shader] : m_shaders)
+	for (const auto& shader : desc.shaders)
 	{
+		auto module = modules.find(shader.shader);
+
 		VkPipelineShaderStageCreateInfo shader_info {};
 		shader_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shader_info.stage = static_cast<VkShaderStageFlagBits>(stage);
-		shader_info.module = shader->get_module();
-		shader_info.pName = s_ShaderEntryPoint.at(stage);
+		shader_info.stage = static_cast<VkShaderStageFlagBits>(shader.stage);
+		shader_info.module = module != modules.end()
+			? module->second
+			: shader.shader->get_module();
+		shader_info.pName = s_FindEntryPoint(shader)->name.c_str();
 
-		shader_infos.push_back(shader_info);
+		state.shader_infos.push_back(shader_info);
 	}
 
 	// Dynamic state
-	VkPipelineDynamicStateCreateInfo dynamic_state {};
-	dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamic_state.dynamicStateCount = VK_SIZE(s_DynamicState);
-	dynamic_state.pDynamicStates = VK_DATA(s_DynamicState);
+	state.dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	state.dynamic_state.dynamicStateCount = VK_SIZE(s_DynamicState);
+	state.dynamic_state.pDynamicStates = VK_DATA(s_DynamicState);
 
 	// Vertex input
-	VkPipelineVertexInputStateCreateInfo vertex_input {};
-	vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertex_input.vertexBindingDescriptionCount = 0;
-	vertex_input.vertexAttributeDescriptionCount = 0;
+	for (const auto& binding : desc.vertex_bindings)
+	{
+		state.vertex_bindings.push_back({
+			binding.binding, binding.stride, binding.input_rate
+		});
+	}
+	for (const auto& attribute : desc.vertex_attributes)
+	{
+		state.vertex_attributes.push_back({
+			attribute.location, attribute.binding, attribute.format, attribute.offset
+		});
+	}
+
+	state.vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	state.vertex_input.vertexBindingDescriptionCount = VK_SIZE(state.vertex_bindings);
+	state.vertex_input.pVertexBindingDescriptions = VK_DATA(state.vertex_bindings);
+	state.vertex_input.vertexAttributeDescriptionCount = VK_SIZE(state.vertex_attributes);
+	state.vertex_input.pVertexAttributeDescriptions = VK_DATA(state.vertex_attributes);
 
 	// Input assembly
-	VkPipelineInputAssemblyStateCreateInfo input_assembly {};
-	input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	input_assembly.primitiveRestartEnable = VK_FALSE;
+	state.input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	state.input_assembly.topology = desc.topology;
+	state.input_assembly.primitiveRestartEnable = VK_FALSE;
 
 	// Viewport/Scissor
-	VkPipelineViewportStateCreateInfo viewport_state {};
-	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewport_state.viewportCount = 1;
-	viewport_state.scissorCount = 1;
+	state.viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	state.viewport_state.viewportCount = 1;
+	state.viewport_state.scissorCount = 1;
 
 	// Rasterizer
-	VkPipelineRasterizationStateCreateInfo rasterizer {};
-	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizer.depthClampEnable = VK_FALSE;
-	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_NONE;
-	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-	rasterizer.depthBiasEnable = VK_FALSE;
+	state.rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	state.rasterizer.depthClampEnable = VK_FALSE;
+	state.rasterizer.rasterizerDiscardEnable = VK_FALSE;
+	state.rasterizer.polygonMode = desc.raster.polygon_mode;
+	state.rasterizer.lineWidth = 1.0f;
+	state.rasterizer.cullMode = desc.raster.cull_mode;
+	state.rasterizer.frontFace = desc.raster.front_face;
+	state.rasterizer.depthBiasEnable = desc.raster.depth_bias ? VK_TRUE : VK_FALSE;
 
 	// Multisampling
-	VkPipelineMultisampleStateCreateInfo multisampling {};
-	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	state.multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	state.multisampling.sampleShadingEnable = VK_FALSE;
+	state.multisampling.rasterizationSamples = desc.samples;
+
+	// Depth
+	state.depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	state.depth_stencil.depthTestEnable = desc.depth.test ? VK_TRUE : VK_FALSE;
+	state.depth_stencil.depthWriteEnable = desc.depth.write ? VK_TRUE : VK_FALSE;
+	state.depth_stencil.depthCompareOp = desc.depth.compare_op;
+	state.depth_stencil.depthBoundsTestEnable = VK_FALSE;
+	state.depth_stencil.stencilTestEnable = VK_FALSE;
 
 	// Color blending
-	VkPipelineColorBlendAttachmentState color_blend_attachment {};
-	color_blend_attachment.colorWriteMask = (
-		VK_COLOR_COMPONENT_R_BIT |
-		VK_COLOR_COMPONENT_G_BIT |
-		VK_COLOR_COMPONENT_B_BIT |
-		VK_COLOR_COMPONENT_A_BIT
-	);
-	color_blend_attachment.blendEnable = VK_FALSE;
+	for (size_t i = 0; i < desc.color_formats.size(); i++)
+	{
+		BlendStateDesc blend = i < desc.blend.size() ? desc.blend[i] : BlendStateDesc {};
 
-	VkPipelineColorBlendStateCreateInfo color_blending {};
-	color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	color_blending.logicOpEnable = VK_FALSE;
-	color_blending.attachmentCount = 1;
-	color_blending.pAttachments = &color_blend_attachment;
+		VkPipelineColorBlendAttachmentState attachment {};
+		attachment.blendEnable = blend.enable ? VK_TRUE : VK_FALSE;
+		attachment.srcColorBlendFactor = blend.src_color;
+		attachment.dstColorBlendFactor = blend.dst_color;
+		attachment.colorBlendOp = blend.color_op;
+		attachment.srcAlphaBlendFactor = blend.src_alpha;
+		attachment.dstAlphaBlendFactor = blend.dst_alpha;
+		attachment.alphaBlendOp = blend.alpha_op;
+		attachment.colorWriteMask = blend.write_mask;
+
+		state.blend_attachments.push_back(attachment);
+	}
+
+	state.color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	state.color_blending.logicOpEnable = VK_FALSE;
+	state.color_blending.attachmentCount = VK_SIZE(state.blend_attachments);
+	state.color_blending.pAttachments = VK_DATA(state.blend_attachments);
 
 	// Dynamic rendering
-	VkPipelineRenderingCreateInfo rendering_info {};
-	rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
-	rendering_info.colorAttachmentCount = 1;
-	rendering_info.pColorAttachmentFormats = &format.format;
+	state.rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	state.rendering_info.colorAttachmentCount = VK_SIZE(desc.color_formats);
+	state.rendering_info.pColorAttachmentFormats = VK_DATA(desc.color_formats);
+	state.rendering_info.depthAttachmentFormat = desc.depth_format;
 
-	VkGraphicsPipelineCreateInfo pipeline_info {};
-	pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipeline_info.stageCount = VK_SIZE(shader_infos);
-	pipeline_info.pStages = VK_DATA(shader_infos);
-	pipeline_info.pVertexInputState = &vertex_input;
-	pipeline_info.pInputAssemblyState = &input_assembly;
-	pipeline_info.pViewportState = &viewport_state;
-	pipeline_info.pRasterizationState = &rasterizer;
-	pipeline_info.pMultisampleState = &multisampling;
-	pipeline_info.pDepthStencilState = nullptr;
-	pipeline_info.pColorBlendState = &color_blending;
-	pipeline_info.pDynamicState = &dynamic_state;
-	pipeline_info.layout = m_pipelineLayout;
-	pipeline_info.pNext = &rendering_info;
+	state.pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	state.pipeline_info.stageCount = VK_SIZE(state.shader_infos);
+	state.pipeline_info.pStages = VK_DATA(state.shader_infos);
+	state.pipeline_info.pVertexInputState = &state.vertex_input;
+	state.pipeline_info.pInputAssemblyState = &state.input_assembly;
+	state.pipeline_info.pViewportState = &state.viewport_state;
+	state.pipeline_info.pRasterizationState = &state.rasterizer;
+	state.pipeline_info.pMultisampleState = &state.multisampling;
+	state.pipeline_info.pDepthStencilState = (
+		desc.depth_format != VK_FORMAT_UNDEFINED ? &state.depth_stencil : nullptr
+	);
+	state.pipeline_info.pColorBlendState = &state.color_blending;
+	state.pipeline_info.pDynamicState = &state.dynamic_state;
+	state.pipeline_info.layout = layout;
+	state.pipeline_info.pNext = &state.rendering_info;
+}
+
+// A compute pipeline only has its shader stage
+static VkComputePipelineCreateInfo s_GetComputeCreateInfo(
+	const PipelineDesc& desc,
+	VkPipelineLayout layout,
+	const ShaderModuleMap& modules
+)
+{
+	const ShaderDesc& shader = desc.shaders[0];
+	auto module = modules.find(shader.shader);
+
+	VkComputePipelineCreateInfo pipeline_info {};
+	pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_info.stage.module = module != modules.end()
+		? module->second
+		: shader.shader->get_module();
+	pipeline_info.stage.pName = s_FindEntryPoint(shader)->name.c_str();
+	pipeline_info.layout = layout;
+	return pipeline_info;
+}
+
+VulkanPipeline::VulkanPipeline(const PipelineDesc& desc)
+	: VulkanPipeline(desc, DeferredCreation {})
+{
+	if (m_pipelineLayout == VK_NULL_HANDLE) {
+		return;
+	}
+
+	if (m_desc.is_compute())
+	{
+		VkComputePipelineCreateInfo pipeline_info = s_GetComputeCreateInfo(m_desc, m_pipelineLayout, {});
+		VK_CALL(
+			vkCreateComputePipelines(
+				m_device,
+				VulkanContext::GetDevice().get_pipeline_cache(),
+				1, &pipeline_info, nullptr, &m_pipeline
+			)
+		);
+		return;
+	}
+
+	PipelineCreateState state;
+	s_FillCreateState(m_desc, m_pipelineLayout, {}, state);
 
 	VK_CALL(
 		vkCreateGraphicsPipelines(
-			m_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline
+			m_device,
+			VulkanContext::GetDevice().get_pipeline_cache(),
+			1, &state.pipeline_info, nullptr, &m_pipeline
 		)
 	);
-	
+}
+
+VulkanPipeline::VulkanPipeline(const PipelineDesc& desc, DeferredCreation)
+	: m_desc(desc)
+{
+	m_device = VulkanContext::GetDevice().get_device();
+
+	if (validate_desc()) {
+		create_pipeline_layout();
+	}
+}
+
+VulkanPipeline::~VulkanPipeline()
+{
+	// The layouts are owned by the layout cache
+	if (m_pipeline != VK_NULL_HANDLE) {
+		vkDestroyPipeline(m_device, m_pipeline, nullptr);
+	}
+}
+
+std::vector<std::unique_ptr<VulkanPipeline>> VulkanPipeline::CreatePipelines(
+	const std::vector<PipelineDesc>& descs,
+	const ShaderModuleMap& modules
+)
+{
+	std::vector<std::unique_ptr<VulkanPipeline>> pipelines;
+	pipelines.reserve(descs.size());
+
+	// The create states are referenced by pointer, so they must not move
+	std::vector<std::unique_ptr<PipelineCreateState>> states;
+	std::vector<VkGraphicsPipelineCreateInfo> pipeline_infos;
+	std::vector<VulkanPipeline*> created;
+
+	std::vector<VkComputePipelineCreateInfo> compute_infos;
+	std::vector<VulkanPipeline*> created_compute;
+
+	for (const auto& desc : descs)
+	{
+		pipelines.push_back(
+			std::unique_ptr<VulkanPipeline>(new VulkanPipeline(desc, DeferredCreation {}))
+		);
+
+		VulkanPipeline* pipeline = pipelines.back().get();
+		if (pipeline->m_pipelineLayout == VK_NULL_HANDLE) {
+			continue;
+		}
+
+		if (desc.is_compute())
+		{
+			compute_infos.push_back(
+				s_GetComputeCreateInfo(pipeline->m_desc, pipeline->m_pipelineLayout, modules)
+			);
+			created_compute.push_back(pipeline);
+			continue;
+		}
+
+		states.push_back(std::make_unique<PipelineCreateState>());
+		s_FillCreateState(
+			pipeline->m_desc, pipeline->m_pipelineLayout, modules, *states.back()
+		);
+
+		pipeline_infos.push_back(states.back()->pipeline_info);
+		created.push_back(pipeline);
+	}
+
+	if (!pipeline_infos.empty())
+	{
+		std::vector<VkPipeline> handles(pipeline_infos.size(), VK_NULL_HANDLE);
+		VkResult result = vkCreateGraphicsPipelines(
+			VulkanContext::GetDevice().get_device(),
+			VulkanContext::GetDevice().get_pipeline_cache(),
+			VK_SIZE(pipeline_infos), VK_DATA(pipeline_infos), nullptr, VK_DATA(handles)
+		);
+		if (result != VK_SUCCESS) {
+			JDL_ERROR("vkCreateGraphicsPipelines failed with status {}", (int)result);
+		}
+
+		// On failure, the pipelines that could not be created are VK_NULL_HANDLE
+		for (size_t i = 0; i < created.size(); i++) {
+			created[i]->m_pipeline = handles[i];
+		}
+	}
+
+	if (!compute_infos.empty())
+	{
+		std::vector<VkPipeline> handles(compute_infos.size(), VK_NULL_HANDLE);
+		VkResult result = vkCreateComputePipelines(
+			VulkanContext::GetDevice().get_device(),
+			VulkanContext::GetDevice().get_pipeline_cache(),
+			VK_SIZE(compute_infos), VK_DATA(compute_infos), nullptr, VK_DATA(handles)
+		);
+		if (result != VK_SUCCESS) {
+			JDL_ERROR("vkCreateComputePipelines failed with status {}", (int)result);
+		}
+
+		for (size_t i = 0; i < created_compute.size(); i++) {
+			created_compute[i]->m_pipeline = handles[i];
+		}
+	}
+
+	return pipelines;
+}
+
+void VulkanPipeline::swap(VulkanPipeline& other)
+{
+	std::swap(m_pipelineLayout, other.m_pipelineLayout);
+	std::swap(m_layoutDesc, other.m_layoutDesc);
+	std::swap(m_setLayouts, other.m_setLayouts);
+	std::swap(m_pipeline, other.m_pipeline);
+}
+
+bool VulkanPipeline::validate_desc() const
+{
+	const ShaderDesc* vertex_shader = nullptr;
+	for (const auto& shader : m_desc.shaders)
+	{
+		if (shader.shader == nullptr)
+		{
+			JDL_ERROR("Cannot create pipeline: null shader");
+			return false;
+		}
+		if (s_FindEntryPoint(shader) == nullptr)
+		{
+			JDL_ERROR(
+				"Cannot create pipeline: no entry point '{}' for stage {} in shader {}",
+				shader.entry_point, (int)shader.stage, shader.shader->get_name()
+			);
+			return false;
+		}
+		if (shader.stage == ShaderStage::eVertex) {
+			vertex_shader = &shader;
+		}
+	}
+
+	// A compute shader is the only stage of its pipeline
+	bool has_compute = std::any_of(m_desc.shaders.begin(), m_desc.shaders.end(), [](const auto& shader) {
+		return shader.stage == ShaderStage::eCompute;
+	});
+	if (has_compute)
+	{
+		if (!m_desc.is_compute())
+		{
+			JDL_ERROR("Cannot create pipeline: a compute shader cannot be combined with other stages");
+			return false;
+		}
+		return true;
+	}
+
+	if (vertex_shader == nullptr)
+	{
+		JDL_ERROR("Cannot create pipeline: missing vertex shader");
+		return false;
+	}
+
+	// Every vertex input must be fed by an attribute
+	for (const auto& input : vertex_shader->shader->get_reflection().vertex_inputs)
+	{
+		bool has_attribute = std::any_of(
+			m_desc.vertex_attributes.begin(), m_desc.vertex_attributes.end(),
+			[&input](const auto& attribute) { return attribute.location == input.location; }
+		);
+		if (!has_attribute)
+		{
+			JDL_ERROR(
+				"Cannot create pipeline: no vertex attribute for input {} (location {})",
+				input.name, input.location
+			);
+			return false;
+		}
+	}
+	return true;
+}
+
+void VulkanPipeline::create_pipeline_layout()
+{
+	if (!s_BuildLayoutDesc(m_desc, m_layoutDesc)) {
+		return;
+	}
+
+	// Identical layouts are shared between pipelines
+	auto& layout_cache = VulkanContext::GetLayoutCache();
+	m_pipelineLayout = layout_cache.get_pipeline_layout(m_layoutDesc);
+
+	for (const auto& set : m_layoutDesc.sets) {
+		m_setLayouts.push_back(layout_cache.get_descriptor_set_layout(set));
+	}
 }
 
 } // namespace vk
@@ -0,0 +1,168 @@
+#include "vk/vulkan_pipeline_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "utils/hash.hpp"
+#include "utils/logger.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// "JDLC"
+static constexpr uint32_t s_CacheMagic = 0x434c444a;
+static constexpr uint32_t s_CacheVersion = 1;
+
+VulkanPipelineCache::VulkanPipelineCache(
+	VkDevice device,
+	const VkPhysicalDeviceProperties& properties,
+	const std::string& path
+)
+	: m_properties(properties)
+	, m_path(path)
+{
+	m_device = device;
+
+	std::vector<char> initial_data = load();
+
+	VkPipelineCacheCreateInfo create_info {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.initialDataSize = initial_data.size(),
+		.pInitialData = VK_DATA(initial_data)
+	};
+
+	// The driver may still reject data it has written: start from scratch then
+	if (vkCreatePipelineCache(m_device, &create_info, nullptr, &m_cache) != VK_SUCCESS)
+	{
+		JDL_WARN("The pipeline cache {} has been rejected by the driver", m_path);
+
+		create_info.initialDataSize = 0;
+		create_info.pInitialData = nullptr;
+		VK_CALL(vkCreatePipelineCache(m_device, &create_info, nullptr, &m_cache));
+	}
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+	save();
+	vkDestroyPipelineCache(m_device, m_cache, nullptr);
+}
+
+bool VulkanPipelineCache::save() const
+{
+	if (m_path.empty()) {
+		return false;
+	}
+
+	size_t data_size = 0;
+	VK_CALL(vkGetPipelineCacheData(m_device, m_cache, &data_size, nullptr));
+
+	std::vector<char> data(data_size);
+	VK_CALL(vkGetPipelineCacheData(m_device, m_cache, &data_size, VK_DATA(data)));
+	data.resize(data_size);
+
+	FileHeader header = make_header();
+	header.data_size = data_size;
+	header.data_hash = utils::fnv1a_64(data.data(), data_size);
+
+	// Write a temporary file, then replace the cache file with it
+	std::string tmp_path = m_path + ".tmp";
+	{
+		std::ofstream stream(tmp_path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(data.data(), data_size);
+		stream.flush();
+
+		if (!stream)
+		{
+			JDL_ERROR("Failed to write the pipeline cache {}", tmp_path);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tmp_path, m_path, error);
+	if (error)
+	{
+		JDL_ERROR("Failed to replace the pipeline cache {}: {}", m_path, error.message());
+		std::filesystem::remove(tmp_path, error);
+		return false;
+	}
+
+	JDL_INFO("Pipeline cache saved ({} bytes)", data_size);
+	return true;
+}
+
+VulkanPipelineCache::FileHeader VulkanPipelineCache::make_header() const
+{
+	FileHeader header;
+	header.magic = s_CacheMagic;
+	header.version = s_CacheVersion;
+	header.vendor_id = m_properties.vendorID;
+	header.device_id = m_properties.deviceID;
+	header.driver_version = m_properties.driverVersion;
+	std::memcpy(header.uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+	return header;
+}
+
+std::vector<char> VulkanPipelineCache::load() const
+{
+	if (m_path.empty()) {
+		return {};
+	}
+
+	std::ifstream stream(m_path, std::ios::binary | std::ios::ate);
+	if (!stream)
+	{
+		JDL_INFO("No pipeline cache found, pipelines will be compiled from scratch");
+		return {};
+	}
+
+	size_t file_size = stream.tellg();
+	stream.seekg(0);
+
+	FileHeader header;
+	if (file_size < sizeof(header) ||
+		!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		JDL_WARN("The pipeline cache {} is truncated, discarding it", m_path);
+		return {};
+	}
+
+	// Any driver or device change invalidates the cache
+	FileHeader expected = make_header();
+	if (header.magic != expected.magic ||
+		header.version != expected.version ||
+		header.vendor_id != expected.vendor_id ||
+		header.device_id != expected.device_id ||
+		header.driver_version != expected.driver_version ||
+		std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0)
+	{
+		JDL_INFO("The pipeline cache {} was created by another device or driver, discarding it", m_path);
+		return {};
+	}
+
+	if (header.data_size != file_size - sizeof(header))
+	{
+		JDL_WARN("The pipeline cache {} is truncated, discarding it", m_path);
+		return {};
+	}
+
+	std::vector<char> data(header.data_size);
+	if (!stream.read(data.data(), header.data_size) ||
+		utils::fnv1a_64(data.data(), data.size()) != header.data_hash)
+	{
+		JDL_WARN("The pipeline cache {} is corrupted, discarding it", m_path);
+		return {};
+	}
+
+	JDL_INFO("Pipeline cache loaded ({} bytes)", data.size());
+	return data;
+}
+
+} // namespace vk
+} // namespace jdl
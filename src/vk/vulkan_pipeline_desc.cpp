@@ -0,0 +1,79 @@
+#include "vk/vulkan_pipeline_desc.hpp"
+
+#include "resource/shader.hpp"
+
+#include "utils/hash.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+uint64_t PipelineDesc::hash() const
+{
+	using utils::fnv1a_64;
+
+	uint64_t h = utils::s_Fnv1aOffsetBasis;
+
+	// Each list is prefixed by its size so that fields cannot shift into each other
+	h = fnv1a_64(shaders.size(), h);
+	for (const auto& shader : shaders)
+	{
+		h = fnv1a_64(shader.stage, h);
+		h = fnv1a_64(shader.shader != nullptr ? shader.shader->get_name() : "", h);
+		h = fnv1a_64(shader.entry_point, h);
+	}
+
+	h = fnv1a_64(vertex_bindings.size(), h);
+	for (const auto& binding : vertex_bindings)
+	{
+		h = fnv1a_64(binding.binding, h);
+		h = fnv1a_64(binding.stride, h);
+		h = fnv1a_64(binding.input_rate, h);
+	}
+
+	h = fnv1a_64(vertex_attributes.size(), h);
+	for (const auto& attribute : vertex_attributes)
+	{
+		h = fnv1a_64(attribute.location, h);
+		h = fnv1a_64(attribute.binding, h);
+		h = fnv1a_64(attribute.format, h);
+		h = fnv1a_64(attribute.offset, h);
+	}
+	h = fnv1a_64(topology, h);
+
+	h = fnv1a_64(raster.polygon_mode, h);
+	h = fnv1a_64(raster.cull_mode, h);
+	h = fnv1a_64(raster.front_face, h);
+	h = fnv1a_64(raster.depth_bias, h);
+
+	h = fnv1a_64(depth.test, h);
+	h = fnv1a_64(depth.write, h);
+	h = fnv1a_64(depth.compare_op, h);
+
+	h = fnv1a_64(blend.size(), h);
+	for (const auto& state : blend)
+	{
+		h = fnv1a_64(state.enable, h);
+		h = fnv1a_64(state.src_color, h);
+		h = fnv1a_64(state.dst_color, h);
+		h = fnv1a_64(state.color_op, h);
+		h = fnv1a_64(state.src_alpha, h);
+		h = fnv1a_64(state.dst_alpha, h);
+		h = fnv1a_64(state.alpha_op, h);
+		h = fnv1a_64(state.write_mask, h);
+	}
+
+	h = fnv1a_64(color_formats.size(), h);
+	for (VkFormat format : color_formats) {
+		h = fnv1a_64(format, h);
+	}
+	h = fnv1a_64(depth_format, h);
+	h = fnv1a_64(samples, h);
+
+	return h;
+}
+
+} // namespace vk
+} // namespace jdl
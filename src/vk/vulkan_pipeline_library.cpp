@@ -0,0 +1,139 @@
+#include "vk/vulkan_pipeline_library.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanPipeline* VulkanPipelineLibrary::get(const PipelineDesc& desc)
+{
+	return get(std::vector<PipelineDesc> { desc }).front();
+}
+
+std::vector<VulkanPipeline*> VulkanPipelineLibrary::get(
+	const std::vector<PipelineDesc>& descs
+)
+{
+	// Gathers the missing descriptions, without duplicates
+	std::vector<PipelineDesc> missing;
+	{
+		std::lock_guard lock(m_mutex);
+
+		std::unordered_set<PipelineDesc, PipelineDescHasher> seen;
+		for (const auto& desc : descs)
+		{
+			if (m_pipelines.find(desc) == m_pipelines.end() && seen.insert(desc).second) {
+				missing.push_back(desc);
+			}
+		}
+	}
+
+	// Compiles outside of the lock, so lookups of existing pipelines are not blocked
+	if (!missing.empty())
+	{
+		auto created = VulkanPipeline::CreatePipelines(missing);
+
+		std::lock_guard lock(m_mutex);
+		size_t nb_created = 0;
+		for (auto& pipeline : created)
+		{
+			if (!pipeline->is_valid()) {
+				continue;
+			}
+			// Another thread may have created the same pipeline in the meantime
+			PipelineDesc desc = pipeline->get_desc();
+			m_pipelines.try_emplace(std::move(desc), std::move(pipeline));
+			++nb_created;
+		}
+		JDL_INFO("Pipeline library: {} pipeline(s) created", nb_created);
+		if (nb_created < created.size()) {
+			JDL_ERROR("Pipeline library: {} pipeline(s) failed to be created", created.size() - nb_created);
+		}
+	}
+
+	std::vector<VulkanPipeline*> pipelines;
+	pipelines.reserve(descs.size());
+
+	std::lock_guard lock(m_mutex);
+	for (const auto& desc : descs)
+	{
+		auto it = m_pipelines.find(desc);
+		pipelines.push_back(it != m_pipelines.end() ? it->second.get() : nullptr);
+	}
+	return pipelines;
+}
+
+VulkanPipeline* VulkanPipelineLibrary::find(const PipelineDesc& desc) const
+{
+	std::lock_guard lock(m_mutex);
+
+	auto it = m_pipelines.find(desc);
+	return it != m_pipelines.end() ? it->second.get() : nullptr;
+}
+
+std::vector<std::unique_ptr<VulkanPipeline>> VulkanPipelineLibrary::rebuild(
+	const ShaderModuleMap& modules
+) const
+{
+	// Gathers the descriptions using one of the modified shaders
+	std::vector<PipelineDesc> descs;
+	{
+		std::lock_guard lock(m_mutex);
+
+		for (const auto& [desc, pipeline] : m_pipelines)
+		{
+			bool uses_shader = std::any_of(
+				desc.shaders.begin(), desc.shaders.end(),
+				[&modules](const ShaderDesc& shader) { return modules.contains(shader.shader); }
+			);
+			if (uses_shader) {
+				descs.push_back(desc);
+			}
+		}
+	}
+
+	if (descs.empty()) {
+		return {};
+	}
+
+	auto pipelines = VulkanPipeline::CreatePipelines(descs, modules);
+	std::erase_if(pipelines, [](const auto& pipeline) { return !pipeline->is_valid(); });
+
+	JDL_INFO("Pipeline library: {}/{} pipeline(s) rebuilt", pipelines.size(), descs.size());
+	return pipelines;
+}
+
+void VulkanPipelineLibrary::swap_pipelines(std::vector<std::unique_ptr<VulkanPipeline>>& pipelines)
+{
+	std::lock_guard lock(m_mutex);
+
+	for (auto& pipeline : pipelines)
+	{
+		// The pipeline may have been removed meanwhile (cleared library)
+		auto it = m_pipelines.find(pipeline->get_desc());
+		if (it != m_pipelines.end()) {
+			it->second->swap(*pipeline);
+		}
+	}
+}
+
+size_t VulkanPipelineLibrary::get_nb_pipelines() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_pipelines.size();
+}
+
+void VulkanPipelineLibrary::clear()
+{
+	std::lock_guard lock(m_mutex);
+	m_pipelines.clear();
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,427 @@
+#include "vk/vulkan_profiler.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+static constexpr VkQueryPipelineStatisticFlags s_PipelineStatistics = (
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+);
+
+// Number of counters written for each pipeline statistics query
+static constexpr uint32_t s_NbPipelineStatistics = 6;
+
+static std::string s_EscapeJson(const std::string& str)
+{
+	std::string escaped;
+	escaped.reserve(str.size());
+
+	for (char c : str)
+	{
+		switch (c)
+		{
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		case '\r':
+			escaped += "\\r";
+			break;
+		case '\t':
+			escaped += "\\t";
+			break;
+		default:
+			// Other control characters are not allowed in JSON strings
+			if (static_cast<unsigned char>(c) < 0x20) {
+				escaped += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+			}
+			else {
+				escaped.push_back(c);
+			}
+			break;
+		}
+	}
+	return escaped;
+}
+
+VulkanProfiler::VulkanProfiler(
+	uint32_t nb_frames,
+	bool enabled,
+	bool pipeline_statistics,
+	bool secondary_command_buffers
+)
+{
+	const auto& device = VulkanContext::GetDevice();
+	m_device = device.get_device();
+
+	if (!enabled) {
+		return;
+	}
+
+	// Timestamps support on the graphics queue
+	uint32_t nb_queues = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device.get_physical_device(), &nb_queues, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queues(nb_queues);
+	vkGetPhysicalDeviceQueueFamilyProperties(
+		device.get_physical_device(), &nb_queues, VK_DATA(queues)
+	);
+
+	uint32_t valid_bits = queues[device.get_queue_family_indices().graphics].timestampValidBits;
+	if (valid_bits == 0)
+	{
+		JDL_WARN("GPU profiler disabled: timestamps are not supported by the graphics queue");
+		return;
+	}
+
+	m_enabled = true;
+	m_timestampPeriod = device.get_properties().limits.timestampPeriod;
+	m_timestampMask = valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << valid_bits) - 1;
+
+	m_pipelineStatistics = pipeline_statistics;
+	if (m_pipelineStatistics && !device.get_enabled_features().pipelineStatisticsQuery)
+	{
+		JDL_WARN("GPU profiler: pipeline statistics are not supported by the device");
+		m_pipelineStatistics = false;
+	}
+	// The statistics queries stay active while the secondary command buffers execute
+	if (m_pipelineStatistics && secondary_command_buffers && !device.get_enabled_features().inheritedQueries)
+	{
+		JDL_WARN("GPU profiler: pipeline statistics are not supported with secondary command buffers");
+		m_pipelineStatistics = false;
+	}
+
+	m_frames.resize(nb_frames);
+	for (auto& frame : m_frames)
+	{
+		VkQueryPoolCreateInfo timestamps_info {
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = 2 * s_MaxScopes
+		};
+		VK_CALL(vkCreateQueryPool(m_device, &timestamps_info, nullptr, &frame.timestamps));
+
+		if (m_pipelineStatistics)
+		{
+			VkQueryPoolCreateInfo statistics_info {
+				.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+				.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+				.queryCount = s_MaxScopes,
+				.pipelineStatistics = s_PipelineStatistics
+			};
+			VK_CALL(vkCreateQueryPool(m_device, &statistics_info, nullptr, &frame.statistics));
+		}
+	}
+}
+
+VulkanProfiler::~VulkanProfiler()
+{
+	for (const auto& frame : m_frames)
+	{
+		vkDestroyQueryPool(m_device, frame.timestamps, nullptr);
+		if (frame.statistics != VK_NULL_HANDLE) {
+			vkDestroyQueryPool(m_device, frame.statistics, nullptr);
+		}
+	}
+}
+
+VkQueryPipelineStatisticFlags VulkanProfiler::get_pipeline_statistics_flags() const
+{
+	return m_enabled && m_pipelineStatistics ? s_PipelineStatistics : 0;
+}
+
+void VulkanProfiler::begin_frame(VulkanCommandBuffer& command_buffer, uint32_t frame_index)
+{
+	if (!m_enabled) {
+		return;
+	}
+
+	m_currentFrame = &m_frames[frame_index];
+	m_openScopes.clear();
+
+	// The frame fence has been waited: the previous results are available
+	collect_results(*m_currentFrame);
+
+	vkCmdResetQueryPool(command_buffer.get(), m_currentFrame->timestamps, 0, 2 * s_MaxScopes);
+	if (m_currentFrame->statistics != VK_NULL_HANDLE) {
+		vkCmdResetQueryPool(command_buffer.get(), m_currentFrame->statistics, 0, s_MaxScopes);
+	}
+}
+
+void VulkanProfiler::begin_scope(VulkanCommandBuffer& command_buffer, const char* name)
+{
+	if (!m_enabled || m_currentFrame == nullptr) {
+		return;
+	}
+	if (m_currentFrame->records.size() == s_MaxScopes)
+	{
+		// Pushed anyway, so that the matching end_scope() does not close the
+		// enclosing scope
+		JDL_WARN("GPU profiler: too many scopes in a single frame, {} ignored", name);
+		m_openScopes.push_back(s_IgnoredScope);
+		return;
+	}
+
+	ScopeRecord record {
+		.scope = get_scope_index(name),
+		.query = 2 * static_cast<uint32_t>(m_currentFrame->records.size())
+	};
+
+	vkCmdWriteTimestamp2(
+		command_buffer.get(),
+		VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+		m_currentFrame->timestamps,
+		record.query
+	);
+
+	// Queries of the same type cannot be nested: only top-level scopes get statistics
+	if (m_currentFrame->statistics != VK_NULL_HANDLE && m_openScopes.empty())
+	{
+		record.statistics_query = m_currentFrame->nb_statistics++;
+		vkCmdBeginQuery(
+			command_buffer.get(), m_currentFrame->statistics, record.statistics_query, 0
+		);
+	}
+
+	m_openScopes.push_back(m_currentFrame->records.size());
+	m_currentFrame->records.push_back(record);
+}
+
+void VulkanProfiler::end_scope(VulkanCommandBuffer& command_buffer)
+{
+	if (!m_enabled || m_currentFrame == nullptr || m_openScopes.empty()) {
+		return;
+	}
+
+	size_t record_index = m_openScopes.back();
+	m_openScopes.pop_back();
+	if (record_index == s_IgnoredScope) {
+		return;
+	}
+	const ScopeRecord& record = m_currentFrame->records[record_index];
+
+	if (record.statistics_query >= 0)
+	{
+		vkCmdEndQuery(
+			command_buffer.get(), m_currentFrame->statistics, record.statistics_query
+		);
+	}
+
+	vkCmdWriteTimestamp2(
+		command_buffer.get(),
+		VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+		m_currentFrame->timestamps,
+		record.query + 1
+	);
+}
+
+std::vector<ProfilerScopeStats> VulkanProfiler::get_stats() const
+{
+	std::vector<ProfilerScopeStats> stats;
+	stats.reserve(m_scopes.size());
+
+	for (const auto& scope : m_scopes)
+	{
+		ProfilerScopeStats scope_stats;
+		scope_stats.name = scope.name;
+		scope_stats.nb_samples = scope.samples.size();
+		scope_stats.has_pipeline_statistics = scope.has_pipeline_statistics;
+		scope_stats.pipeline_statistics = scope.pipeline_statistics;
+
+		if (!scope.samples.empty())
+		{
+			size_t last = (scope.next_sample + scope.samples.size() - 1) % scope.samples.size();
+			scope_stats.last_ms = scope.samples[last];
+
+			std::vector<double> sorted = scope.samples;
+			std::sort(sorted.begin(), sorted.end());
+
+			double total = 0.0;
+			for (double sample : sorted) {
+				total += sample;
+			}
+
+			size_t p99_index = (sorted.size() * 99 + 99) / 100 - 1;
+
+			scope_stats.min_ms = sorted.front();
+			scope_stats.avg_ms = total / sorted.size();
+			scope_stats.p99_ms = sorted[std::min(p99_index, sorted.size() - 1)];
+		}
+		stats.push_back(scope_stats);
+	}
+
+	return stats;
+}
+
+void VulkanProfiler::reset_stats()
+{
+	for (auto& scope : m_scopes)
+	{
+		scope.samples.clear();
+		scope.next_sample = 0;
+		scope.has_pipeline_statistics = false;
+	}
+}
+
+std::string VulkanProfiler::to_json() const
+{
+	std::string json = "{\n  \"scopes\": [";
+
+	auto stats = get_stats();
+	for (size_t i = 0; i < stats.size(); ++i)
+	{
+		const auto& scope = stats[i];
+
+		json += i == 0 ? "\n" : ",\n";
+		json += fmt::format(
+			"    {{\"name\": \"{}\", \"samples\": {}, \"last_ms\": {:.6f}, "
+			"\"min_ms\": {:.6f}, \"avg_ms\": {:.6f}, \"p99_ms\": {:.6f}",
+			s_EscapeJson(scope.name), scope.nb_samples,
+			scope.last_ms, scope.min_ms, scope.avg_ms, scope.p99_ms
+		);
+
+		if (scope.has_pipeline_statistics)
+		{
+			const auto& pipeline = scope.pipeline_statistics;
+			json += fmt::format(
+				", \"pipeline_statistics\": {{\"input_vertices\": {}, "
+				"\"input_primitives\": {}, \"vertex_invocations\": {}, "
+				"\"clipping_invocations\": {}, \"clipping_primitives\": {}, "
+				"\"fragment_invocations\": {}}}",
+				pipeline.input_vertices, pipeline.input_primitives,
+				pipeline.vertex_invocations, pipeline.clipping_invocations,
+				pipeline.clipping_primitives, pipeline.fragment_invocations
+			);
+		}
+		json += "}";
+	}
+
+	json += stats.empty() ? "]\n}\n" : "\n  ]\n}\n";
+	return json;
+}
+
+bool VulkanProfiler::dump_json(const std::string& path) const
+{
+	std::ofstream stream(path, std::ios::trunc);
+	if (!stream)
+	{
+		JDL_ERROR("Failed to write the GPU profiler statistics to {}", path);
+		return false;
+	}
+
+	stream << to_json();
+	return static_cast<bool>(stream);
+}
+
+void VulkanProfiler::collect_results(FrameQueries& frame)
+{
+	if (frame.records.empty()) {
+		return;
+	}
+
+	// Each query result is followed by its availability value
+	uint32_t nb_queries = 2 * static_cast<uint32_t>(frame.records.size());
+	std::vector<uint64_t> timestamps(2 * nb_queries);
+
+	VkResult result = vkGetQueryPoolResults(
+		m_device, frame.timestamps, 0, nb_queries,
+		timestamps.size() * sizeof(uint64_t), VK_DATA(timestamps),
+		2 * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+	);
+
+	std::vector<uint64_t> statistics;
+	if (frame.nb_statistics > 0)
+	{
+		statistics.resize((s_NbPipelineStatistics + 1) * frame.nb_statistics);
+		vkGetQueryPoolResults(
+			m_device, frame.statistics, 0, frame.nb_statistics,
+			statistics.size() * sizeof(uint64_t), VK_DATA(statistics),
+			(s_NbPipelineStatistics + 1) * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+		);
+	}
+
+	if (result == VK_SUCCESS || result == VK_NOT_READY)
+	{
+		for (const auto& record : frame.records)
+		{
+			const uint64_t* begin = &timestamps[2 * record.query];
+			const uint64_t* end = &timestamps[2 * (record.query + 1)];
+
+			// Unavailable results (scope not closed or not executed yet) are skipped
+			if (begin[1] == 0 || end[1] == 0) {
+				continue;
+			}
+
+			uint64_t ticks = ((end[0] & m_timestampMask) - (begin[0] & m_timestampMask)) & m_timestampMask;
+			double duration_ms = ticks * m_timestampPeriod / 1e6;
+
+			auto& scope = m_scopes[record.scope];
+			if (scope.samples.size() < s_HistorySize) {
+				scope.samples.push_back(duration_ms);
+			}
+			else {
+				scope.samples[scope.next_sample] = duration_ms;
+			}
+			scope.next_sample = (scope.next_sample + 1) % s_HistorySize;
+
+			if (record.statistics_query < 0) {
+				continue;
+			}
+
+			const uint64_t* counters = &statistics[(s_NbPipelineStatistics + 1) * record.statistics_query];
+			if (counters[s_NbPipelineStatistics] == 0) {
+				continue;
+			}
+
+			scope.has_pipeline_statistics = true;
+			scope.pipeline_statistics = {
+				.input_vertices = counters[0],
+				.input_primitives = counters[1],
+				.vertex_invocations = counters[2],
+				.clipping_invocations = counters[3],
+				.clipping_primitives = counters[4],
+				.fragment_invocations = counters[5]
+			};
+		}
+	}
+
+	frame.records.clear();
+	frame.nb_statistics = 0;
+}
+
+size_t VulkanProfiler::get_scope_index(const char* name)
+{
+	auto it = m_scopeIndices.find(name);
+	if (it != m_scopeIndices.end()) {
+		return it->second;
+	}
+
+	size_t index = m_scopes.size();
+	m_scopes.push_back({ .name = name });
+	m_scopeIndices[name] = index;
+
+	return index;
+}
+
+} // namespace vk
+} // namespace jdl
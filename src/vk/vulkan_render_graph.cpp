@@ -0,0 +1,862 @@
+#include "vk/vulkan_render_graph.hpp"
+
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+#include "vk/vulkan_profiler.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+struct AccessInfo
+{
+	VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2 access = VK_ACCESS_2_NONE;
+	VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImageUsageFlags image_usage = 0;
+};
+
+static AccessInfo s_GetAccessInfo(RenderGraphAccess access)
+{
+	switch (access)
+	{
+	case RenderGraphAccess::eColorAttachment:
+		return {
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+		};
+	case RenderGraphAccess::eDepthAttachment:
+		return {
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+		};
+	case RenderGraphAccess::eDepthRead:
+		return {
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+		};
+	case RenderGraphAccess::eSampledFragment:
+		return {
+			VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_SAMPLED_BIT
+		};
+	case RenderGraphAccess::eSampledCompute:
+		return {
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_USAGE_SAMPLED_BIT
+		};
+	case RenderGraphAccess::eStorageReadCompute:
+		return {
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_USAGE_STORAGE_BIT
+		};
+	case RenderGraphAccess::eStorageWriteCompute:
+		return {
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_USAGE_STORAGE_BIT
+		};
+	case RenderGraphAccess::eTransferSrc:
+		return {
+			VK_PIPELINE_STAGE_2_COPY_BIT,
+			VK_ACCESS_2_TRANSFER_READ_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		};
+	case RenderGraphAccess::eTransferDst:
+		return {
+			VK_PIPELINE_STAGE_2_COPY_BIT,
+			VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT
+		};
+	case RenderGraphAccess::ePresent:
+		return {
+			VK_PIPELINE_STAGE_2_NONE,
+			VK_ACCESS_2_NONE,
+			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+		};
+	case RenderGraphAccess::eVertexBuffer:
+		return {
+			VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+			VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT
+		};
+	case RenderGraphAccess::eIndexBuffer:
+		return {
+			VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+			VK_ACCESS_2_INDEX_READ_BIT
+		};
+	case RenderGraphAccess::eIndirectBuffer:
+		return {
+			VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+			VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT
+		};
+	case RenderGraphAccess::eUniformBuffer:
+		return {
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_UNIFORM_READ_BIT
+		};
+	case RenderGraphAccess::eStorageBufferRead:
+		return {
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+		};
+	case RenderGraphAccess::eStorageBufferWrite:
+		return {
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+		};
+	case RenderGraphAccess::eHostRead:
+		return {
+			VK_PIPELINE_STAGE_2_HOST_BIT,
+			VK_ACCESS_2_HOST_READ_BIT
+		};
+	case RenderGraphAccess::eNone:
+		break;
+	}
+	return {};
+}
+
+static VkImageAspectFlags s_GetImageAspect(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+static VkDeviceSize s_AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// ---------------------------------------------------------------------------
+// RenderGraphPass
+// ---------------------------------------------------------------------------
+
+RenderGraphPass& RenderGraphPass::write_color(
+	RenderGraphResource image,
+	VkAttachmentLoadOp load_op,
+	VkClearValue clear_value
+)
+{
+	m_colorAttachments.push_back({ image, load_op, clear_value });
+	m_accesses.push_back({
+		image, RenderGraphAccess::eColorAttachment, true, load_op == VK_ATTACHMENT_LOAD_OP_LOAD
+	});
+	return *this;
+}
+
+RenderGraphPass& RenderGraphPass::write_depth(
+	RenderGraphResource image,
+	VkAttachmentLoadOp load_op,
+	float clear_depth
+)
+{
+	VkClearValue clear_value {};
+	clear_value.depthStencil = { clear_depth, 0 };
+
+	m_depthAttachment = { image, load_op, clear_value };
+	m_accesses.push_back({
+		image, RenderGraphAccess::eDepthAttachment, true, load_op == VK_ATTACHMENT_LOAD_OP_LOAD
+	});
+	return *this;
+}
+
+RenderGraphPass& RenderGraphPass::read(RenderGraphResource resource, RenderGraphAccess access)
+{
+	m_accesses.push_back({ resource, access, false, true });
+	return *this;
+}
+
+RenderGraphPass& RenderGraphPass::write(RenderGraphResource resource, RenderGraphAccess access)
+{
+	// Storage and transfer writes may be partial: the previous content is kept
+	m_accesses.push_back({ resource, access, true, true });
+	return *this;
+}
+
+// ---------------------------------------------------------------------------
+// VulkanRenderGraph
+// ---------------------------------------------------------------------------
+
+VulkanRenderGraph::VulkanRenderGraph()
+{
+	m_device = VulkanContext::GetDevice().get_device();
+}
+
+VulkanRenderGraph::~VulkanRenderGraph()
+{
+	destroy_transient_images();
+}
+
+void VulkanRenderGraph::reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_finalTransitions.clear();
+	m_nbActivePasses = 0;
+	m_nbBarriers = 0;
+	m_compiled = false;
+}
+
+RenderGraphResource VulkanRenderGraph::import_image(
+	const std::string& name,
+	VkImage image,
+	VkImageView view,
+	const RenderGraphImageDesc& desc,
+	VkImageLayout initial_layout,
+	RenderGraphAccess final_access
+)
+{
+	Resource resource {
+		.name = name,
+		.type = ResourceType::eImage,
+		.imported = true,
+		.image_desc = desc,
+		.aspect = s_GetImageAspect(desc.format),
+		.image = image,
+		.view = view,
+		.initial_layout = initial_layout,
+		.final_access = final_access
+	};
+	m_resources.push_back(std::move(resource));
+	return { static_cast<uint32_t>(m_resources.size() - 1) };
+}
+
+RenderGraphResource VulkanRenderGraph::import_buffer(
+	const std::string& name,
+	VkBuffer buffer,
+	RenderGraphAccess final_access
+)
+{
+	Resource resource {
+		.name = name,
+		.type = ResourceType::eBuffer,
+		.imported = true,
+		.buffer = buffer,
+		.final_access = final_access
+	};
+	m_resources.push_back(std::move(resource));
+	return { static_cast<uint32_t>(m_resources.size() - 1) };
+}
+
+RenderGraphResource VulkanRenderGraph::create_image(
+	const std::string& name,
+	const RenderGraphImageDesc& desc
+)
+{
+	Resource resource {
+		.name = name,
+		.type = ResourceType::eImage,
+		.imported = false,
+		.image_desc = desc,
+		.aspect = s_GetImageAspect(desc.format)
+	};
+	m_resources.push_back(std::move(resource));
+	return { static_cast<uint32_t>(m_resources.size() - 1) };
+}
+
+RenderGraphPass& VulkanRenderGraph::add_pass(const std::string& name)
+{
+	m_passes.push_back(std::make_unique<RenderGraphPass>());
+	m_passes.back()->m_name = name;
+	return *m_passes.back();
+}
+
+void VulkanRenderGraph::compile()
+{
+	for (const auto& pass : m_passes)
+	{
+		for (const auto& access : pass->m_accesses)
+		{
+			if (access.resource.index >= m_resources.size()) {
+				JDL_FATAL("Render graph pass {} uses an invalid resource", pass->m_name);
+			}
+		}
+	}
+
+	cull_passes();
+	compute_lifetimes();
+	allocate_transient_images();
+	compute_transitions();
+
+	m_compiled = true;
+}
+
+void VulkanRenderGraph::cull_passes()
+{
+	// Walks the passes backwards: a pass is kept if it has side effects or
+	// writes a resource whose current content is needed later. Imported
+	// resources are always needed after the graph.
+	std::vector<bool> needed(m_resources.size());
+	for (size_t i = 0; i < m_resources.size(); i++) {
+		needed[i] = m_resources[i].imported;
+	}
+
+	for (auto it = m_passes.rbegin(); it != m_passes.rend(); ++it)
+	{
+		RenderGraphPass& pass = **it;
+
+		bool alive = pass.m_sideEffects;
+		for (const auto& access : pass.m_accesses) {
+			alive |= access.write && needed[access.resource.index];
+		}
+		pass.m_culled = !alive;
+		if (!alive) {
+			continue;
+		}
+
+		// Fully overwritten resources do not need their previous content
+		for (const auto& access : pass.m_accesses)
+		{
+			if (access.write && !access.preserve) {
+				needed[access.resource.index] = false;
+			}
+		}
+		for (const auto& access : pass.m_accesses)
+		{
+			if (access.preserve) {
+				needed[access.resource.index] = true;
+			}
+		}
+	}
+}
+
+void VulkanRenderGraph::compute_lifetimes()
+{
+	m_nbActivePasses = 0;
+	for (const auto& pass : m_passes)
+	{
+		if (pass->m_culled) {
+			continue;
+		}
+
+		uint32_t pass_index = m_nbActivePasses++;
+		for (const auto& access : pass->m_accesses)
+		{
+			Resource& resource = m_resources[access.resource.index];
+			resource.first_pass = std::min(resource.first_pass, pass_index);
+			resource.last_pass = std::max(resource.last_pass, pass_index);
+			resource.image_usage |= s_GetAccessInfo(access.access).image_usage;
+		}
+	}
+}
+
+void VulkanRenderGraph::allocate_transient_images()
+{
+	// Transient images actually used by the active passes
+	std::vector<TransientImage> images;
+	for (auto& resource : m_resources)
+	{
+		if (resource.imported || resource.first_pass == UINT32_MAX) {
+			continue;
+		}
+
+		resource.transient = static_cast<uint32_t>(images.size());
+		images.push_back({
+			.desc = resource.image_desc,
+			.usage = resource.image_usage,
+			.aspect = resource.aspect,
+			.first_pass = resource.first_pass,
+			.last_pass = resource.last_pass
+		});
+	}
+
+	auto same_layout = [](const TransientImage& a, const TransientImage& b) {
+		return (
+			a.desc.extent.width == b.desc.extent.width &&
+			a.desc.extent.height == b.desc.extent.height &&
+			a.desc.format == b.desc.format &&
+			a.desc.samples == b.desc.samples &&
+			a.usage == b.usage &&
+			a.first_pass == b.first_pass &&
+			a.last_pass == b.last_pass
+		);
+	};
+
+	// The graph usually does not change between frames: keep the images
+	bool reuse = images.size() == m_transientImages.size() && std::equal(
+		images.begin(), images.end(), m_transientImages.begin(), same_layout
+	);
+
+	if (!reuse)
+	{
+		destroy_transient_images();
+		m_transientImages = std::move(images);
+
+		// Creates the images to get their memory requirements
+		uint32_t memory_type_bits = UINT32_MAX;
+		VkDeviceSize alignment = 1;
+		m_transientUnaliasedSize = 0;
+
+		for (auto& transient : m_transientImages)
+		{
+			VkImageCreateInfo image_info {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+				.flags = VK_IMAGE_CREATE_ALIAS_BIT,
+				.imageType = VK_IMAGE_TYPE_2D,
+				.format = transient.desc.format,
+				.extent = { transient.desc.extent.width, transient.desc.extent.height, 1 },
+				.mipLevels = 1,
+				.arrayLayers = 1,
+				.samples = transient.desc.samples,
+				.tiling = VK_IMAGE_TILING_OPTIMAL,
+				.usage = transient.usage,
+				.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+			};
+			VK_CALL(vkCreateImage(m_device, &image_info, nullptr, &transient.image));
+			vkGetImageMemoryRequirements(m_device, transient.image, &transient.requirements);
+
+			memory_type_bits &= transient.requirements.memoryTypeBits;
+			alignment = std::max(alignment, transient.requirements.alignment);
+			m_transientUnaliasedSize += s_AlignUp(
+				transient.requirements.size, transient.requirements.alignment
+			);
+		}
+
+		if (!m_transientImages.empty() && memory_type_bits == 0) {
+			JDL_FATAL("Render graph transient images have no common memory type");
+		}
+
+		// Places the largest images first, each one at the lowest offset which
+		// does not overlap an image alive at the same time
+		std::vector<uint32_t> order(m_transientImages.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+			return m_transientImages[a].requirements.size > m_transientImages[b].requirements.size;
+		});
+
+		VkDeviceSize heap_size = 0;
+		std::vector<uint32_t> placed;
+
+		for (uint32_t index : order)
+		{
+			TransientImage& transient = m_transientImages[index];
+			const VkDeviceSize size = transient.requirements.size;
+			const VkDeviceSize image_alignment = transient.requirements.alignment;
+
+			auto overlaps_in_time = [&transient](const TransientImage& other) {
+				return (
+					transient.first_pass <= other.last_pass &&
+					other.first_pass <= transient.last_pass
+				);
+			};
+
+			// Candidate offsets: the heap start and the end of each placed image
+			std::vector<VkDeviceSize> candidates = { 0 };
+			for (uint32_t other : placed)
+			{
+				const TransientImage& image = m_transientImages[other];
+				candidates.push_back(
+					s_AlignUp(image.offset + image.requirements.size, image_alignment)
+				);
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			VkDeviceSize offset = 0;
+			for (VkDeviceSize candidate : candidates)
+			{
+				bool fits = true;
+				for (uint32_t other : placed)
+				{
+					const TransientImage& image = m_transientImages[other];
+					bool overlaps_in_memory = (
+						candidate < image.offset + image.requirements.size &&
+						image.offset < candidate + size
+					);
+					if (overlaps_in_memory && overlaps_in_time(image))
+					{
+						fits = false;
+						break;
+					}
+				}
+				if (fits)
+				{
+					offset = candidate;
+					break;
+				}
+			}
+
+			transient.offset = offset;
+			heap_size = std::max(heap_size, offset + size);
+			placed.push_back(index);
+		}
+
+		// Finds the images which used the memory of each image before it: they
+		// may cover different parts of it, the first use of the image must
+		// wait for the last use of all of them
+		for (auto& transient : m_transientImages)
+		{
+			transient.aliased.clear();
+			for (uint32_t other = 0; other < m_transientImages.size(); other++)
+			{
+				const TransientImage& image = m_transientImages[other];
+				bool overlaps_in_memory = (
+					transient.offset < image.offset + image.requirements.size &&
+					image.offset < transient.offset + transient.requirements.size
+				);
+				if (overlaps_in_memory && image.last_pass < transient.first_pass) {
+					transient.aliased.push_back(other);
+				}
+			}
+		}
+
+		if (!m_transientImages.empty())
+		{
+			VkMemoryRequirements requirements {
+				.size = heap_size,
+				.alignment = alignment,
+				.memoryTypeBits = memory_type_bits
+			};
+			m_transientMemory = VulkanContext::GetAllocator().allocate(
+				requirements, MemoryUsage::eGpuOnly, false
+			);
+			if (!m_transientMemory.is_valid()) {
+				JDL_FATAL("Failed to allocate the render graph transient memory ({} bytes)", heap_size);
+			}
+		}
+
+		for (auto& transient : m_transientImages)
+		{
+			VK_CALL(
+				vkBindImageMemory(
+					m_device, transient.image,
+					m_transientMemory.memory, m_transientMemory.offset + transient.offset
+				)
+			);
+
+			VkImageViewCreateInfo view_info {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+				.image = transient.image,
+				.viewType = VK_IMAGE_VIEW_TYPE_2D,
+				.format = transient.desc.format,
+				.subresourceRange = {
+					.aspectMask = transient.aspect,
+					.baseMipLevel = 0,
+					.levelCount = 1,
+					.baseArrayLayer = 0,
+					.layerCount = 1
+				}
+			};
+			VK_CALL(vkCreateImageView(m_device, &view_info, nullptr, &transient.view));
+		}
+
+		if (!m_transientImages.empty())
+		{
+			JDL_INFO(
+				"Render graph: {} transient image(s), {} KiB ({} KiB without aliasing)",
+				m_transientImages.size(), heap_size / 1024, m_transientUnaliasedSize / 1024
+			);
+		}
+	}
+
+	for (auto& resource : m_resources)
+	{
+		if (resource.transient != UINT32_MAX)
+		{
+			resource.image = m_transientImages[resource.transient].image;
+			resource.view = m_transientImages[resource.transient].view;
+		}
+	}
+}
+
+void VulkanRenderGraph::destroy_transient_images()
+{
+	for (auto& transient : m_transientImages)
+	{
+		vkDestroyImageView(m_device, transient.view, nullptr);
+		vkDestroyImage(m_device, transient.image, nullptr);
+	}
+	m_transientImages.clear();
+
+	if (m_transientMemory.is_valid()) {
+		VulkanContext::GetAllocator().free(m_transientMemory);
+	}
+	m_transientMemory = {};
+	m_transientUnaliasedSize = 0;
+}
+
+void VulkanRenderGraph::compute_transitions()
+{
+	// Stages and accesses of each transient image during the frame, waited for
+	// by the images aliasing its memory
+	std::vector<ResourceState> transient_uses(m_transientImages.size());
+	std::vector<bool> used(m_resources.size(), false);
+
+	for (auto& pass_ptr : m_passes)
+	{
+		RenderGraphPass& pass = *pass_ptr;
+		pass.m_transitions.clear();
+		if (pass.m_culled) {
+			continue;
+		}
+
+		// Merges the accesses of the pass to the same resource, they are
+		// all synchronized by the same barrier
+		for (const auto& access : pass.m_accesses)
+		{
+			AccessInfo info = s_GetAccessInfo(access.access);
+			auto it = std::find_if(pass.m_transitions.begin(), pass.m_transitions.end(), [&access](const auto& t) {
+				return t.resource == access.resource.index;
+			});
+			if (it == pass.m_transitions.end())
+			{
+				pass.m_transitions.push_back({ access.resource.index, { info.stages, info.access, info.layout } });
+				continue;
+			}
+
+			if (m_resources[it->resource].type == ResourceType::eImage && it->state.layout != info.layout) {
+				JDL_ERROR("Render graph pass {} uses {} with two layouts", pass.m_name, m_resources[it->resource].name);
+			}
+			it->state.stages |= info.stages;
+			it->state.access |= info.access;
+		}
+
+		for (auto& transition : pass.m_transitions)
+		{
+			Resource& resource = m_resources[transition.resource];
+			if (resource.transient != UINT32_MAX)
+			{
+				transient_uses[resource.transient].stages |= transition.state.stages;
+				transient_uses[resource.transient].access |= transition.state.access;
+			}
+			if (used[transition.resource]) {
+				continue;
+			}
+			used[transition.resource] = true;
+			transition.first_use = true;
+
+			if (resource.transient != UINT32_MAX)
+			{
+				// First use of a transient image: its content is discarded
+				// (UNDEFINED layout), but the previous images using its memory
+				// must be finished
+				resource.initial_state = {};
+				for (uint32_t aliased : m_transientImages[resource.transient].aliased)
+				{
+					resource.initial_state.stages |= transient_uses[aliased].stages;
+					resource.initial_state.access |= transient_uses[aliased].access;
+				}
+			}
+			else
+			{
+				// The previous uses of an imported resource are synchronized
+				// by the submission: the layout transition only has to wait
+				// for the stages where the semaphores are waited
+				bool layout_change = resource.type == ResourceType::eImage
+					&& resource.initial_layout != transition.state.layout;
+				resource.initial_state = {
+					layout_change ? transition.state.stages : VK_PIPELINE_STAGE_2_NONE,
+					VK_ACCESS_2_NONE,
+					resource.initial_layout
+				};
+			}
+		}
+
+		// Transient attachments not used by any later pass are not stored
+		pass.m_colorStoreOps.clear();
+		for (const auto& attachment : pass.m_colorAttachments)
+		{
+			const Resource& resource = m_resources[attachment.image.index];
+			bool discard = !resource.imported && resource.last_pass == resource.first_pass;
+			pass.m_colorStoreOps.push_back(
+				discard ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE
+			);
+		}
+		pass.m_depthStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+		if (pass.m_depthAttachment.image.is_valid())
+		{
+			const Resource& resource = m_resources[pass.m_depthAttachment.image.index];
+			if (!resource.imported && resource.last_pass == resource.first_pass) {
+				pass.m_depthStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			}
+		}
+	}
+
+	// Imported resources are left in the state expected after the graph
+	m_finalTransitions.clear();
+	for (uint32_t i = 0; i < m_resources.size(); i++)
+	{
+		const Resource& resource = m_resources[i];
+		if (!resource.imported || !used[i] || resource.final_access == RenderGraphAccess::eNone) {
+			continue;
+		}
+
+		AccessInfo info = s_GetAccessInfo(resource.final_access);
+		m_finalTransitions.push_back({ i, { info.stages, info.access, info.layout } });
+	}
+}
+
+void VulkanRenderGraph::execute(VulkanCommandBuffer& command_buffer, VulkanProfiler* profiler)
+{
+	if (!m_compiled) {
+		JDL_FATAL("The render graph must be compiled before being executed");
+	}
+
+	uint32_t nb_barriers = command_buffer.get_resource_tracker().get_nb_barriers();
+
+	for (auto& pass : m_passes)
+	{
+		if (pass->m_culled) {
+			continue;
+		}
+
+		record_transitions(command_buffer, pass->m_transitions);
+
+		if (profiler != nullptr) {
+			profiler->begin_scope(command_buffer, pass->m_name.c_str());
+		}
+		execute_pass(*pass, command_buffer);
+		if (profiler != nullptr) {
+			profiler->end_scope(command_buffer);
+		}
+	}
+
+	record_transitions(command_buffer, m_finalTransitions);
+
+	m_nbBarriers = command_buffer.get_resource_tracker().get_nb_barriers() - nb_barriers;
+}
+
+void VulkanRenderGraph::record_transitions(
+	VulkanCommandBuffer& command_buffer,
+	const std::vector<RenderGraphPass::Transition>& transitions
+) const
+{
+	for (const auto& transition : transitions)
+	{
+		const Resource& resource = m_resources[transition.resource];
+		if (resource.type == ResourceType::eBuffer)
+		{
+			if (transition.first_use) {
+				command_buffer.set_buffer_state(resource.buffer, resource.initial_state);
+			}
+			command_buffer.transition_buffer(resource.buffer, transition.state);
+			continue;
+		}
+
+		// Graph images have a single mip level and array layer
+		VkImageSubresourceRange range {
+			.aspectMask = resource.aspect,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		};
+		if (transition.first_use) {
+			command_buffer.set_image_state(resource.image, range, resource.initial_state);
+		}
+		command_buffer.transition_image(resource.image, range, transition.state);
+	}
+
+	// One dependency info for all the barriers of the pass
+	command_buffer.flush_barriers();
+}
+
+void VulkanRenderGraph::execute_pass(RenderGraphPass& pass, VulkanCommandBuffer& command_buffer)
+{
+	bool has_depth = pass.m_depthAttachment.image.is_valid();
+	if (pass.m_colorAttachments.empty() && !has_depth)
+	{
+		if (pass.m_execute) {
+			pass.m_execute(command_buffer);
+		}
+		return;
+	}
+
+	// Attachments are bound with dynamic rendering
+	std::vector<VkRenderingAttachmentInfo> color_attachments;
+	for (size_t i = 0; i < pass.m_colorAttachments.size(); i++)
+	{
+		const auto& attachment = pass.m_colorAttachments[i];
+		color_attachments.push_back({
+			.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+			.imageView = m_resources[attachment.image.index].view,
+			.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			.loadOp = attachment.load_op,
+			.storeOp = pass.m_colorStoreOps[i],
+			.clearValue = attachment.clear_value
+		});
+	}
+
+	VkRenderingAttachmentInfo depth_attachment {};
+	if (has_depth)
+	{
+		depth_attachment = {
+			.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+			.imageView = m_resources[pass.m_depthAttachment.image.index].view,
+			.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			.loadOp = pass.m_depthAttachment.load_op,
+			.storeOp = pass.m_depthStoreOp,
+			.clearValue = pass.m_depthAttachment.clear_value
+		};
+	}
+
+	RenderGraphResource first = !pass.m_colorAttachments.empty()
+		? pass.m_colorAttachments.front().image
+		: pass.m_depthAttachment.image;
+	VkExtent2D extent = m_resources[first.index].image_desc.extent;
+
+	VkRenderingInfo rendering_info {
+		.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+		.flags = pass.m_secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0u,
+		.renderArea = {.offset = {0, 0}, .extent = extent},
+		.layerCount = 1,
+		.colorAttachmentCount = VK_SIZE(color_attachments),
+		.pColorAttachments = VK_DATA(color_attachments),
+		.pDepthAttachment = has_depth ? &depth_attachment : nullptr
+	};
+
+	command_buffer.begin_rendering(rendering_info);
+	if (pass.m_execute) {
+		pass.m_execute(command_buffer);
+	}
+	command_buffer.end_rendering();
+}
+
+VkImage VulkanRenderGraph::get_image(RenderGraphResource image) const
+{
+	return m_resources.at(image.index).image;
+}
+
+VkImageView VulkanRenderGraph::get_image_view(RenderGraphResource image) const
+{
+	return m_resources.at(image.index).view;
+}
+
+VkBuffer VulkanRenderGraph::get_buffer(RenderGraphResource buffer) const
+{
+	return m_resources.at(buffer.index).buffer;
+}
+
+} // namespace vk
+} // namespace jdl
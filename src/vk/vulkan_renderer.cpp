@@ -1,32 +1,91 @@
 #include "vk/vulkan_renderer.hpp"
 
+#include "resource/mesh.hpp"
+#include "resource/resource_manager.hpp"
+
 #include "utils/logger.hpp"
 
 #include "vk/vulkan_context.hpp"
 
+#include <algorithm>
+
 
 namespace jdl
 {
 namespace vk
 {
 
-VulkanRenderer::VulkanRenderer()
+// Per-frame constants (FrameConstants in default.slang)
+struct FrameConstants
+{
+    float extent[2];
+    float time;
+    uint32_t frame;
+};
+
+VulkanRenderer::VulkanRenderer(const VulkanRendererSettings& settings)
 {
-    VulkanContext::Init();
+    VulkanContext::Init(settings.context);
     m_device = VulkanContext::GetDevice().get_device();
 
-    create_sync_objects();
-    create_command_buffers();
+    uint32_t nb_frames = settings.nb_frames_in_flight;
+    if (nb_frames == 0 || nb_frames > s_MaxFramesInFlight)
+    {
+        nb_frames = std::clamp(nb_frames, 1u, s_MaxFramesInFlight);
+        JDL_WARN(
+            "Invalid number of frames in flight ({}), using {}",
+            settings.nb_frames_in_flight, nb_frames
+        );
+    }
+
+    if (settings.context.headless) {
+        create_offscreen_target(settings, nb_frames);
+    }
+    else {
+        create_render_finished_semaphores();
+    }
+    create_frames(nb_frames);
+
+    m_frameRing = std::make_unique<VulkanFrameRing>(nb_frames, settings.frame_data_size);
+    m_scene = std::make_unique<VulkanGpuScene>(nb_frames);
+    m_drawQueue = std::make_unique<VulkanDrawQueue>();
+    m_startTime = std::chrono::steady_clock::now();
+
+    if (settings.parallel_recording) {
+        m_parallelRecorder = std::make_unique<VulkanParallelRecorder>(nb_frames);
+    }
+
+    m_profiler = std::make_unique<VulkanProfiler>(
+        nb_frames,
+        settings.gpu_profiling,
+        settings.pipeline_statistics,
+        settings.parallel_recording
+    );
+
+    if (!settings.shader_reload_directory.empty()) {
+        m_shaderReloader = std::make_unique<VulkanShaderReloader>(settings.shader_reload_directory);
+    }
 }
 
 VulkanRenderer::~VulkanRenderer()
 {
-    for (auto i = 0; i < m_imageAcquiredSemaphores.size(); ++i)
+    m_shaderReloader.reset();
+
+    for (auto& frame : m_frames)
     {
-        vkDestroySemaphore(m_device, m_imageAcquiredSemaphores[i], nullptr);
-        vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
-        vkDestroyFence(m_device, m_inFlightFences[i], nullptr);
+        vkDestroySemaphore(m_device, frame.image_acquired, nullptr);
+        vkDestroyFence(m_device, frame.in_flight, nullptr);
     }
+    m_frames.clear();
+    m_drawQueue.reset();
+    m_scene.reset();
+    m_frameRing.reset();
+    m_commandAllocator.reset();
+    m_parallelRecorder.reset();
+    destroy_render_finished_semaphores();
+
+    m_profiler.reset();
+    m_offscreenTarget.reset();
 
     VulkanContext::Destroy();
 }
@@ -40,43 +99,186 @@ void VulkanRenderer::set_background_color(float r, float g, float b, float a)
 }
 
 void VulkanRenderer::render_frame()
+{
+    // Submit the pending uploads and acquire the finished ones
+    VulkanContext::GetUploader().update();
+
+    if (m_offscreenTarget != nullptr) {
+        render_offscreen_frame();
+    }
+    else {
+        render_swapchain_frame();
+    }
+}
+
+void VulkanRenderer::flush_readbacks()
+{
+    if (m_offscreenTarget == nullptr) {
+        return;
+    }
+
+    std::vector<VkFence> fences;
+    fences.reserve(m_frames.size());
+    for (const auto& frame : m_frames) {
+        fences.push_back(frame.in_flight);
+    }
+    VK_CALL(
+        vkWaitForFences(m_device, VK_SIZE(fences), VK_DATA(fences), VK_TRUE, UINT64_MAX)
+    );
+
+    // Deliver the images in submission order: the oldest one is the next to be reused
+    uint32_t nb_frames = get_nb_frames_in_flight();
+    for (uint32_t i = 0; i < nb_frames; ++i) {
+        deliver_readback((m_currentFrame + i) % nb_frames);
+    }
+}
+
+void VulkanRenderer::wait_idle() const
+{
+    auto& device = VulkanContext::GetDevice();
+    device.wait_idle();
+}
+
+void VulkanRenderer::resize_event(const core::ResizeEvent& event)
+{
+    m_framebufferResized = true;
+}
+
+void VulkanRenderer::create_offscreen_target(
+    const VulkanRendererSettings& settings,
+    uint32_t nb_frames
+)
+{
+    // Each frame in flight renders to its own offscreen image
+    m_offscreenTarget = std::make_unique<VulkanOffscreenTarget>(
+        settings.headless_extent,
+        settings.context.headless_format,
+        nb_frames,
+        settings.headless_readback
+    );
+    m_pendingReadbacks.resize(nb_frames, false);
+    m_readbackFrames.resize(nb_frames, 0);
+
+    JDL_INFO(
+        "Vulkan Offscreen Target: OK ({}x{}, {} images)",
+        settings.headless_extent.width,
+        settings.headless_extent.height,
+        nb_frames
+    );
+}
+
+void VulkanRenderer::create_frames(uint32_t nb_frames)
+{
+    auto& device = VulkanContext::GetDevice();
+    m_commandAllocator = std::make_unique<VulkanCommandAllocator>(
+        device.get_queue_family_indices().graphics, nb_frames
+    );
+
+    VkSemaphoreCreateInfo semaphore_info {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+    };
+    VkFenceCreateInfo fence_info {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .flags = VK_FENCE_CREATE_SIGNALED_BIT
+    };
+
+    m_frames.resize(nb_frames);
+    for (auto& frame : m_frames)
+    {
+        VK_CALL(vkCreateSemaphore(m_device, &semaphore_info, nullptr, &frame.image_acquired));
+        VK_CALL(vkCreateFence(m_device, &fence_info, nullptr, &frame.in_flight));
+        frame.render_graph = std::make_unique<VulkanRenderGraph>();
+    }
+
+    JDL_INFO("Vulkan Renderer: {} frame(s) in flight", nb_frames);
+}
+
+void VulkanRenderer::create_render_finished_semaphores()
+{
+    auto nb_images = VulkanContext::GetSwapchain().get_nb_images();
+
+    VkSemaphoreCreateInfo semaphore_info {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+    };
+
+    m_renderFinishedSemaphores.resize(nb_images);
+    for (auto& semaphore : m_renderFinishedSemaphores) {
+        VK_CALL(vkCreateSemaphore(m_device, &semaphore_info, nullptr, &semaphore));
+    }
+}
+
+void VulkanRenderer::destroy_render_finished_semaphores()
+{
+    for (auto semaphore : m_renderFinishedSemaphores) {
+        vkDestroySemaphore(m_device, semaphore, nullptr);
+    }
+    m_renderFinishedSemaphores.clear();
+}
+
+void VulkanRenderer::recreate_swapchain()
+{
+    VulkanContext::RecreateSwapchain();
+
+    // The device is idle: the semaphores can be recreated if the number of
+    // swapchain images has changed
+    if (VulkanContext::GetSwapchain().get_nb_images() != m_renderFinishedSemaphores.size())
+    {
+        destroy_render_finished_semaphores();
+        create_render_finished_semaphores();
+    }
+}
+
+void VulkanRenderer::render_swapchain_frame()
 {
     auto& swapchain = VulkanContext::GetSwapchain();
+    FrameData& frame = m_frames[m_currentFrame];
 
-    VkSemaphore image_acquired = m_imageAcquiredSemaphores[m_currentImage];
-    VkSemaphore render_finished = m_renderFinishedSemaphores[m_currentImage];
-    VkFence in_flight = m_inFlightFences[m_currentImage];
+    VK_CALL(vkWaitForFences(m_device, 1, &frame.in_flight, VK_FALSE, UINT64_MAX));
 
-    VK_CALL(vkWaitForFences(m_device, 1, &in_flight, VK_FALSE, UINT64_MAX));
+    // Frame boundary: the reloaded shaders can be swapped in
+    if (m_shaderReloader != nullptr) {
+        m_shaderReloader->update(m_frameCount, get_nb_frames_in_flight());
+    }
+    VulkanContext::GetBindlessSet().update(m_frameCount, get_nb_frames_in_flight());
+    VulkanContext::GetRetireQueue().update(m_frameCount, get_nb_frames_in_flight());
+    m_scene->update(m_frameCount, get_nb_frames_in_flight());
+
+    // The previous data of this frame in flight has been consumed
+    m_frameRing->begin_frame(m_currentFrame);
 
     uint32_t image_index;
-    VkResult result = swapchain.acquire_image(image_index, image_acquired);
+    VkResult result = swapchain.acquire_image(image_index, frame.image_acquired);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        VulkanContext::RecreateSwapchain();
+        recreate_swapchain();
         return;
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         JDL_FATAL("Failed to acquire an image from the swapchain");
     }
 
-    VK_CALL(vkResetFences(m_device, 1, &in_flight));
+    VK_CALL(vkResetFences(m_device, 1, &frame.in_flight));
 
-    // Record the command buffer
-    VulkanCommandBuffer* command_buffer = m_commandBuffers[m_currentImage].get();
+    // Record the command buffer (the frame command pool is not in use anymore)
+    m_commandAllocator->begin_frame(m_currentFrame);
+    if (m_parallelRecorder != nullptr) {
+        m_parallelRecorder->begin_frame(m_currentFrame);
+    }
+    VulkanCommandBuffer* command_buffer = m_commandAllocator->allocate();
 
     command_buffer->begin();
     record_command_buffer(command_buffer, image_index);
     command_buffer->end();
 
     // Submit the command buffer
+    VkSemaphore render_finished = m_renderFinishedSemaphores[image_index];
     command_buffer->submit(
         VulkanContext::GetDevice().get_graphics_queue(),
-        { image_acquired },
+        { frame.image_acquired },
         { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
         { render_finished },
-        in_flight
+        frame.in_flight
     );
 
     // Present the image to the swapchain
@@ -94,72 +296,85 @@ void VulkanRenderer::render_frame()
     result = vkQueuePresentKHR(present_queue, &present_info);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        VulkanContext::RecreateSwapchain();
+        recreate_swapchain();
     }
     else if (m_framebufferResized)
     {
-        VulkanContext::RecreateSwapchain();
+        recreate_swapchain();
         m_framebufferResized = false;
     }
 
-    m_currentImage = (m_currentImage + 1) % m_inFlightFences.size();
+    m_currentFrame = (m_currentFrame + 1) % get_nb_frames_in_flight();
+    ++m_frameCount;
 }
 
-void VulkanRenderer::wait_idle() const
+void VulkanRenderer::render_offscreen_frame()
 {
-    auto& device = VulkanContext::GetDevice();
-    device.wait_idle();
-}
+    FrameData& frame = m_frames[m_currentFrame];
 
-void VulkanRenderer::resize_event(const core::ResizeEvent& event)
-{
-    m_framebufferResized = true;
-}
+    VK_CALL(vkWaitForFences(m_device, 1, &frame.in_flight, VK_FALSE, UINT64_MAX));
 
-void VulkanRenderer::create_sync_objects()
-{
-    uint32_t nb_images = VulkanContext::GetSwapchain().get_nb_images();
+    // Frame boundary: the reloaded shaders can be swapped in
+    if (m_shaderReloader != nullptr) {
+        m_shaderReloader->update(m_frameCount, get_nb_frames_in_flight());
+    }
+    VulkanContext::GetBindlessSet().update(m_frameCount, get_nb_frames_in_flight());
+    VulkanContext::GetRetireQueue().update(m_frameCount, get_nb_frames_in_flight());
+    m_scene->update(m_frameCount, get_nb_frames_in_flight());
 
-    VkSemaphoreCreateInfo semaphore_info {
-        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
-    };
-    VkFenceCreateInfo fence_info {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT
-    };
+    // The previous data of this frame in flight has been consumed
+    m_frameRing->begin_frame(m_currentFrame);
 
-    m_imageAcquiredSemaphores.resize(nb_images);
-    m_renderFinishedSemaphores.resize(nb_images);
-    m_inFlightFences.resize(nb_images);
+    // The image is not in use anymore: its previous content can be delivered
+    deliver_readback(m_currentFrame);
+
+    VK_CALL(vkResetFences(m_device, 1, &frame.in_flight));
+
+    // Record the command buffer (the frame command pool is not in use anymore)
+    m_commandAllocator->begin_frame(m_currentFrame);
+    if (m_parallelRecorder != nullptr) {
+        m_parallelRecorder->begin_frame(m_currentFrame);
+    }
+    VulkanCommandBuffer* command_buffer = m_commandAllocator->allocate();
 
-    for (uint32_t i = 0; i < nb_images; ++i)
+    command_buffer->begin();
+    record_command_buffer(command_buffer, m_currentFrame);
+    command_buffer->end();
+
+    if (m_offscreenTarget->has_readback())
     {
-        VK_CALL(
-            vkCreateSemaphore(
-                m_device, &semaphore_info, nullptr, &m_imageAcquiredSemaphores[i]
-            )
-        );
-        VK_CALL(
-            vkCreateSemaphore(
-                m_device, &semaphore_info, nullptr, &m_renderFinishedSemaphores[i]
-            )
-        );
-        VK_CALL(vkCreateFence(m_device, &fence_info, nullptr, &m_inFlightFences[i]));
+        m_pendingReadbacks[m_currentFrame] = true;
+        m_readbackFrames[m_currentFrame] = m_frameCount;
     }
+
+    // Submit the command buffer: nothing to wait for, nothing to present
+    command_buffer->submit(
+        VulkanContext::GetDevice().get_graphics_queue(), {}, {}, {}, frame.in_flight
+    );
+
+    m_currentFrame = (m_currentFrame + 1) % get_nb_frames_in_flight();
+    ++m_frameCount;
 }
 
-void VulkanRenderer::create_command_buffers()
+void VulkanRenderer::deliver_readback(uint32_t image_index)
 {
-    auto command_pool = VulkanContext::GetDevice().get_graphics_command_pool();
-    auto nb_buffers = m_imageAcquiredSemaphores.size();
+    if (!m_pendingReadbacks[image_index]) {
+        return;
+    }
+    m_pendingReadbacks[image_index] = false;
 
-    m_commandBuffers.reserve(nb_buffers);
-    for (auto i = 0; i < nb_buffers; ++i)
-    {
-        m_commandBuffers.emplace_back(
-            std::make_unique<VulkanCommandBuffer>(command_pool)
-        );
+    if (!m_readbackCallback) {
+        return;
     }
+
+    ReadbackImage readback {
+        .frame = m_readbackFrames[image_index],
+        .data = m_offscreenTarget->get_readback_data(image_index),
+        .size = m_offscreenTarget->get_readback_size(),
+        .extent = m_offscreenTarget->get_extent(),
+        .format = m_offscreenTarget->get_format()
+    };
+    m_readbackCallback(readback);
 }
 
 void VulkanRenderer::record_command_buffer(
@@ -167,65 +382,175 @@ void VulkanRenderer::record_command_buffer(
     uint32_t image_index
 )
 {
-    auto& swapchain = VulkanContext::GetSwapchain();
-    auto extent = swapchain.get_extent();
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView image_view = VK_NULL_HANDLE;
+    VkExtent2D extent {};
+
+    if (m_offscreenTarget != nullptr)
+    {
+        image = m_offscreenTarget->get_image(image_index);
+        image_view = m_offscreenTarget->get_image_view(image_index);
+        extent = m_offscreenTarget->get_extent();
+    }
+    else
+    {
+        auto& swapchain = VulkanContext::GetSwapchain();
+        image = swapchain.get_image(image_index);
+        image_view = swapchain.get_image_view(image_index);
+        extent = swapchain.get_extent();
+    }
 
-    // Change the image layout for rendering (color attachment)
-    command_buffer->transition_image_layout(
-        swapchain.get_image(image_index),
+    // The graph of this frame in flight is not in use by the GPU anymore
+    VulkanRenderGraph& graph = *m_frames[m_currentFrame].render_graph;
+    graph.reset();
+
+    RenderGraphImageDesc target_desc {
+        .extent = extent,
+        .format = VulkanContext::GetColorFormat()
+    };
+    RenderGraphResource target = graph.import_image(
+        "target",
+        image,
+        image_view,
+        target_desc,
         VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        {},
-        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT
+        m_offscreenTarget == nullptr ? RenderGraphAccess::ePresent : RenderGraphAccess::eNone
     );
 
-    // Start dynamic rendering
-    VkRenderingAttachmentInfo color_attachment {
-        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-        .imageView = swapchain.get_image_view(image_index),
-        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .clearValue = m_clearColor
-    };
-    VkRenderingInfo rendering_info {
-        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
-        .renderArea = {.offset = {0, 0}, .extent = extent},
-        .layerCount = 1,
-        .colorAttachmentCount = 1,
-        .pColorAttachments = &color_attachment
-    };
-    vkCmdBeginRendering(command_buffer->get(), &rendering_info);
+    // Written once, read by every draw of the frame
+    auto time = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_startTime);
+    VulkanFrameRing::Allocation frame_constants = m_frameRing->push_uniform(FrameConstants {
+        .extent = { static_cast<float>(extent.width), static_cast<float>(extent.height) },
+        .time = time.count(),
+        .frame = static_cast<uint32_t>(m_frameCount)
+    });
+
+    // Sort the draws submitted since the previous frame, their instances are
+    // written to the frame ring
+    m_drawQueue->sort(*m_frameRing);
+
+    // The GPU culls the scene and writes its draws before the main pass
+    GpuSceneDraws scene_draws = m_scene->add_cull_pass(graph, m_currentFrame);
+    bool draw_scene = scene_draws.is_valid();
+
+    RenderGraphResource depth = graph.create_image("depth", {
+        .extent = extent,
+        .format = VulkanContext::GetDepthFormat()
+    });
+
+    RenderGraphPass& main_pass = graph.add_pass("main_pass");
+    main_pass.write_color(target, VK_ATTACHMENT_LOAD_OP_CLEAR, m_clearColor);
+    main_pass.write_depth(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, 1.0f);
+    if (draw_scene)
+    {
+        main_pass.read(scene_draws.draws, RenderGraphAccess::eIndirectBuffer)
+            .read(scene_draws.draws, RenderGraphAccess::eStorageBufferRead)
+            .read(scene_draws.counts, RenderGraphAccess::eIndirectBuffer);
+    }
 
-    // Bind the graphics pipeline
-    command_buffer->bind_graphics_pipeline(
-        VulkanContext::GetPipeline().get_pipeline()
-    );
+    if (m_parallelRecorder != nullptr)
+    {
+        // Record the pass contents on the job system threads
+        main_pass.use_secondary_command_buffers();
+        main_pass.set_execute([this, extent, frame_constants, draw_scene](VulkanCommandBuffer& command_buffer) {
+            RenderingFormats formats {
+                .color_formats = { VulkanContext::GetColorFormat() },
+                .depth_format = VulkanContext::GetDepthFormat()
+            };
+            // The scene draws, then ranges of the queued draws, are recorded
+            // by separate jobs and executed in this order
+            std::vector<VulkanParallelRecorder::RecordFunction> functions;
+            if (draw_scene)
+            {
+                functions.push_back([this, extent, frame_constants](VulkanCommandBuffer& secondary) {
+                    record_main_pass(secondary, extent, frame_constants, true, 0, 0);
+                });
+            }
+
+            uint32_t nb_batches = m_drawQueue->get_nb_batches();
+            uint32_t nb_ranges = std::clamp(
+                nb_batches / s_MinBatchesPerRecording, 1u, m_parallelRecorder->get_nb_threads()
+            );
+            for (uint32_t range = 0; range < nb_ranges; ++range)
+            {
+                uint32_t first_batch = static_cast<uint64_t>(nb_batches) * range / nb_ranges;
+                uint32_t last_batch = static_cast<uint64_t>(nb_batches) * (range + 1) / nb_ranges;
+                functions.push_back([this, extent, frame_constants, first_batch, last_batch](VulkanCommandBuffer& secondary) {
+                    record_main_pass(secondary, extent, frame_constants, false, first_batch, last_batch - first_batch);
+                });
+            }
+
+            // Executed inside the "frame" scope and its statistics query
+            auto secondary_buffers = m_parallelRecorder->record(
+                formats, functions, m_profiler->get_pipeline_statistics_flags()
+            );
+            command_buffer.execute_commands(secondary_buffers);
+        });
+    }
+    else
+    {
+        main_pass.set_execute([this, extent, frame_constants, draw_scene](VulkanCommandBuffer& command_buffer) {
+            record_main_pass(
+                command_buffer, extent, frame_constants, draw_scene, 0, m_drawQueue->get_nb_batches()
+            );
+        });
+    }
+
+    if (m_offscreenTarget != nullptr && m_offscreenTarget->has_readback())
+    {
+        // Copy the image to the host-visible readback buffer
+        RenderGraphResource readback = graph.import_buffer(
+            "readback",
+            m_offscreenTarget->get_readback_buffer(image_index),
+            RenderGraphAccess::eHostRead
+        );
+
+        graph.add_pass("readback")
+            .read(target, RenderGraphAccess::eTransferSrc)
+            .write(readback, RenderGraphAccess::eTransferDst)
+            .set_execute([image, extent, this, image_index](VulkanCommandBuffer& command_buffer) {
+                command_buffer.copy_image_to_buffer(
+                    image,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    extent,
+                    m_offscreenTarget->get_readback_buffer(image_index)
+                );
+            });
+    }
+
+    graph.compile();
 
+    m_profiler->begin_frame(*command_buffer, m_currentFrame);
+    m_profiler->begin_scope(*command_buffer, "frame");
+    graph.execute(*command_buffer, m_profiler.get());
+    m_profiler->end_scope(*command_buffer);
+}
+
+void VulkanRenderer::record_main_pass(
+    VulkanCommandBuffer& command_buffer,
+    VkExtent2D extent,
+    const VulkanFrameRing::Allocation& frame_constants,
+    bool draw_scene,
+    uint32_t first_batch,
+    uint32_t nb_batches
+)
+{
     // Set Viewport/Scissor
-    command_buffer->set_viewport({ 0, 0 }, extent, 0.0f, 1.0f);
-    command_buffer->set_scissor({ 0, 0 }, extent);
-
-    // Draw
-    command_buffer->draw(3);
-
-    // End dynamic rendering
-    vkCmdEndRendering(command_buffer->get());
-
-    // Change the image layout for swapchain presentation
-    command_buffer->transition_image_layout(
-        swapchain.get_image(image_index),
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-        {},
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT
-    );
+    command_buffer.set_viewport({ 0, 0 }, extent, 0.0f, 1.0f);
+    command_buffer.set_scissor({ 0, 0 }, extent);
+
+    auto guard = resource::ResourceManager::Pin();
+
+    // Indirect draws of the culled scene (a few draws, whatever the number
+    // of objects), with their own pipelines
+    if (draw_scene) {
+        m_scene->record_draws(command_buffer, m_currentFrame);
+    }
+
+    // Sorted and instanced draws of the CPU
+    if (nb_batches > 0) {
+        m_drawQueue->record(command_buffer, s_MainPass, first_batch, nb_batches, *m_frameRing, frame_constants);
+    }
 }
 
 } // namespace vk
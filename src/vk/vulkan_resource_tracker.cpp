@@ -0,0 +1,304 @@
+#include "vk/vulkan_resource_tracker.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+static constexpr VkAccessFlags2 s_WriteAccessMask = (
+	VK_ACCESS_2_SHADER_WRITE_BIT |
+	VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+	VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_2_TRANSFER_WRITE_BIT |
+	VK_ACCESS_2_HOST_WRITE_BIT |
+	VK_ACCESS_2_MEMORY_WRITE_BIT
+);
+
+void VulkanResourceTracker::reset()
+{
+	m_images.clear();
+	m_buffers.clear();
+	m_batch = {};
+	m_batches.clear();
+	m_nbBarriers = 0;
+	m_nbSkipped = 0;
+}
+
+VulkanResourceTracker::TrackedState VulkanResourceTracker::MakeTrackedState(
+	const ResourceState& state
+)
+{
+	// The declared use is considered as a write: the next use waits for it
+	TrackedState tracked;
+	tracked.layout = state.layout;
+	tracked.write_stages = state.stages;
+	tracked.write_access = state.access & s_WriteAccessMask;
+	tracked.visible_stages = state.stages;
+	tracked.visible_access = state.access & ~s_WriteAccessMask;
+	return tracked;
+}
+
+void VulkanResourceTracker::set_image_state(
+	VkImage image,
+	const VkImageSubresourceRange& range,
+	const ResourceState& state
+)
+{
+	for (uint32_t mip = 0; mip < range.levelCount; mip++)
+	{
+		for (uint32_t layer = 0; layer < range.layerCount; layer++)
+		{
+			SubresourceKey key { image, range.baseMipLevel + mip, range.baseArrayLayer + layer };
+			m_images[key] = MakeTrackedState(state);
+		}
+	}
+}
+
+void VulkanResourceTracker::set_buffer_state(VkBuffer buffer, const ResourceState& state)
+{
+	m_buffers[buffer] = MakeTrackedState(state);
+}
+
+bool VulkanResourceTracker::conflicts(
+	const TrackedState& tracked,
+	const ResourceState& state,
+	bool is_image
+) const
+{
+	if (!tracked.pending) {
+		return false;
+	}
+
+	// A second request on a resource with a pending barrier can only be merged
+	// in the same batch if both are reads in the same layout
+	bool is_write = (state.access & s_WriteAccessMask) != 0;
+	bool layout_change = is_image && tracked.layout != state.layout;
+	bool was_write = tracked.read_stages == VK_PIPELINE_STAGE_2_NONE;
+	return is_write || layout_change || was_write;
+}
+
+bool VulkanResourceTracker::update(
+	TrackedState& tracked,
+	const ResourceState& state,
+	bool is_image,
+	VkPipelineStageFlags2& src_stages,
+	VkAccessFlags2& src_access
+)
+{
+	bool is_write = (state.access & s_WriteAccessMask) != 0;
+	bool layout_change = is_image && tracked.layout != state.layout;
+
+	src_stages = tracked.write_stages | tracked.read_stages;
+	src_access = tracked.write_access;
+
+	bool hazard = false;
+	if (is_write) {
+		// Write after read/write
+		hazard = src_stages != VK_PIPELINE_STAGE_2_NONE;
+	}
+	else {
+		// Read after write, unless already visible to this read
+		hazard = tracked.write_stages != VK_PIPELINE_STAGE_2_NONE && (
+			(state.stages & ~tracked.visible_stages) != 0 ||
+			(state.access & ~tracked.visible_access) != 0
+		);
+		// Only the reads have to wait for the write, but a layout transition
+		// is a write: it must also wait for the reads since the last write
+		if (!layout_change) {
+			src_stages = tracked.write_stages;
+		}
+	}
+	bool barrier = hazard || layout_change;
+
+	if (is_write || layout_change)
+	{
+		// A layout transition behaves as a write, made visible to the requested use
+		tracked.write_stages = is_write ? state.stages : src_stages | state.stages;
+		tracked.write_access = is_write ? state.access & s_WriteAccessMask : tracked.write_access;
+		tracked.read_stages = is_write ? VK_PIPELINE_STAGE_2_NONE : state.stages;
+		tracked.visible_stages = state.stages;
+		tracked.visible_access = state.access & ~s_WriteAccessMask;
+	}
+	else
+	{
+		tracked.read_stages |= state.stages;
+		if (barrier)
+		{
+			tracked.visible_stages |= state.stages;
+			tracked.visible_access |= state.access;
+		}
+	}
+	tracked.layout = state.layout;
+	tracked.pending |= barrier;
+
+	return barrier;
+}
+
+void VulkanResourceTracker::require_image_state(
+	VkImage image,
+	const VkImageSubresourceRange& range,
+	const ResourceState& state
+)
+{
+	if (range.levelCount == VK_REMAINING_MIP_LEVELS || range.layerCount == VK_REMAINING_ARRAY_LAYERS)
+	{
+		JDL_ERROR("Image state tracking requires explicit level and layer counts");
+		return;
+	}
+
+	struct SubresourceBarrier
+	{
+		uint32_t mip_level;
+		uint32_t array_layer;
+		VkImageLayout old_layout;
+		VkPipelineStageFlags2 src_stages;
+		VkAccessFlags2 src_access;
+	};
+	std::vector<SubresourceBarrier> barriers;
+	uint32_t nb_subresources = range.levelCount * range.layerCount;
+
+	bool conflict = false;
+	for (uint32_t mip = 0; mip < range.levelCount && !conflict; mip++)
+	{
+		for (uint32_t layer = 0; layer < range.layerCount && !conflict; layer++)
+		{
+			auto it = m_images.find({ image, range.baseMipLevel + mip, range.baseArrayLayer + layer });
+			conflict = it != m_images.end() && conflicts(it->second, state, true);
+		}
+	}
+	if (conflict) {
+		split_batch();
+	}
+
+	for (uint32_t mip = 0; mip < range.levelCount; mip++)
+	{
+		for (uint32_t layer = 0; layer < range.layerCount; layer++)
+		{
+			SubresourceKey key { image, range.baseMipLevel + mip, range.baseArrayLayer + layer };
+			TrackedState& tracked = m_images[key];
+
+			VkImageLayout old_layout = tracked.layout;
+			VkPipelineStageFlags2 src_stages;
+			VkAccessFlags2 src_access;
+			if (update(tracked, state, true, src_stages, src_access)) {
+				barriers.push_back({ key.mip_level, key.array_layer, old_layout, src_stages, src_access });
+			}
+		}
+	}
+
+	if (barriers.empty())
+	{
+		++m_nbSkipped;
+		return;
+	}
+
+	auto make_barrier = [&](const SubresourceBarrier& b, uint32_t level_count, uint32_t layer_count) {
+		m_batch.image_barriers.push_back({
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			.srcStageMask = b.src_stages,
+			.srcAccessMask = b.src_access,
+			.dstStageMask = state.stages,
+			.dstAccessMask = state.access,
+			.oldLayout = b.old_layout,
+			.newLayout = state.layout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange = {
+				.aspectMask = range.aspectMask,
+				.baseMipLevel = b.mip_level,
+				.levelCount = level_count,
+				.baseArrayLayer = b.array_layer,
+				.layerCount = layer_count
+			}
+		});
+		++m_nbBarriers;
+	};
+
+	// Subresources sharing the same previous state are covered by one barrier
+	bool uniform = barriers.size() == nb_subresources && std::all_of(
+		barriers.begin(), barriers.end(), [&barriers](const SubresourceBarrier& b) {
+			return (
+				b.old_layout == barriers[0].old_layout &&
+				b.src_stages == barriers[0].src_stages &&
+				b.src_access == barriers[0].src_access
+			);
+		}
+	);
+
+	if (uniform) {
+		make_barrier({
+			range.baseMipLevel, range.baseArrayLayer,
+			barriers[0].old_layout, barriers[0].src_stages, barriers[0].src_access
+		}, range.levelCount, range.layerCount);
+	}
+	else
+	{
+		for (const auto& barrier : barriers) {
+			make_barrier(barrier, 1, 1);
+		}
+	}
+}
+
+void VulkanResourceTracker::require_buffer_state(VkBuffer buffer, const ResourceState& state)
+{
+	TrackedState& tracked = m_buffers[buffer];
+	if (conflicts(tracked, state, false)) {
+		split_batch();
+	}
+
+	VkPipelineStageFlags2 src_stages;
+	VkAccessFlags2 src_access;
+	if (!update(tracked, state, false, src_stages, src_access))
+	{
+		++m_nbSkipped;
+		return;
+	}
+
+	m_batch.buffer_barriers.push_back({
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+		.srcStageMask = src_stages,
+		.srcAccessMask = src_access,
+		.dstStageMask = state.stages,
+		.dstAccessMask = state.access,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = buffer,
+		.offset = 0,
+		.size = VK_WHOLE_SIZE
+	});
+	++m_nbBarriers;
+}
+
+void VulkanResourceTracker::split_batch()
+{
+	m_batches.push_back(std::move(m_batch));
+	m_batch = {};
+
+	for (auto& [key, tracked] : m_images) {
+		tracked.pending = false;
+	}
+	for (auto& [buffer, tracked] : m_buffers) {
+		tracked.pending = false;
+	}
+}
+
+std::vector<BarrierBatch> VulkanResourceTracker::flush()
+{
+	if (!m_batch.image_barriers.empty() || !m_batch.buffer_barriers.empty()) {
+		split_batch();
+	}
+
+	std::vector<BarrierBatch> batches = std::move(m_batches);
+	m_batches.clear();
+	return batches;
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,39 @@
+#include "vk/vulkan_retire_queue.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+void VulkanRetireQueue::retire(std::unique_ptr<VulkanBuffer> buffer)
+{
+	if (buffer == nullptr) {
+		return;
+	}
+
+	std::lock_guard lock(m_mutex);
+	m_retired.push_back({std::move(buffer), m_frame});
+}
+
+void VulkanRetireQueue::update(uint64_t frame, uint32_t nb_frames_in_flight)
+{
+	// Destroyed outside of the lock: freeing the memory locks the allocator
+	std::deque<RetiredBuffer> finished;
+	{
+		std::lock_guard lock(m_mutex);
+
+		// Buffers retired after update(F) may be used by the frames up to F,
+		// which are finished once the fence of frame F + nb_frames_in_flight - 1
+		// is waited
+		while (!m_retired.empty() && m_retired.front().frame + nb_frames_in_flight <= frame)
+		{
+			finished.push_back(std::move(m_retired.front()));
+			m_retired.pop_front();
+		}
+		m_frame = frame;
+	}
+}
+
+} // namespace vk
+} // namespace jdl
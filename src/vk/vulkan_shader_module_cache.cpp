@@ -0,0 +1,126 @@
+#include "vk/vulkan_shader_module_cache.hpp"
+
+#include "utils/hash.hpp"
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanShaderModuleCache::VulkanShaderModuleCache()
+{
+	m_device = VulkanContext::GetDevice().get_device();
+}
+
+VulkanShaderModuleCache::~VulkanShaderModuleCache()
+{
+	if (!m_entries.empty()) {
+		JDL_WARN("{} shader module(s) still referenced", m_entries.size());
+	}
+	for (const auto& [hash, entry] : m_entries) {
+		vkDestroyShaderModule(m_device, entry.module, nullptr);
+	}
+}
+
+uint64_t VulkanShaderModuleCache::Hash(const void* code, size_t size)
+{
+	return utils::fnv1a_64(code, size);
+}
+
+VkShaderModule VulkanShaderModuleCache::acquire(uint64_t hash, const void* code, size_t size)
+{
+	{
+		std::lock_guard lock(m_mutex);
+
+		auto it = m_entries.find(hash);
+		if (it != m_entries.end())
+		{
+			if (it->second.size != size) {
+				JDL_FATAL("Shader module hash collision ({:016x})", hash);
+			}
+			++it->second.nb_references;
+			++m_nbHits;
+			return it->second.module;
+		}
+	}
+
+	if (code == nullptr || size == 0 || size % sizeof(uint32_t) != 0)
+	{
+		JDL_ERROR("Invalid SPIR-V code ({} bytes)", size);
+		return VK_NULL_HANDLE;
+	}
+
+	// Created outside of the lock, so other lookups are not blocked
+	VkShaderModuleCreateInfo create_info {};
+	create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	create_info.codeSize = size;
+	create_info.pCode = static_cast<const uint32_t*>(code);
+
+	// Not fatal: a reloaded shader may be broken while being edited
+	VkShaderModule module = VK_NULL_HANDLE;
+	VkResult result = vkCreateShaderModule(m_device, &create_info, nullptr, &module);
+	if (result != VK_SUCCESS)
+	{
+		JDL_ERROR("Failed to create shader module ({})", (int)result);
+		return VK_NULL_HANDLE;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	// Another thread may have created the same module in the meantime
+	auto [it, inserted] = m_entries.try_emplace(hash, Entry { module, size, 0 });
+	if (!inserted)
+	{
+		vkDestroyShaderModule(m_device, module, nullptr);
+		++m_nbHits;
+	}
+	else {
+		m_hashes[module] = hash;
+	}
+
+	++it->second.nb_references;
+	return it->second.module;
+}
+
+void VulkanShaderModuleCache::release(VkShaderModule module)
+{
+	if (module == VK_NULL_HANDLE) {
+		return;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	auto hash = m_hashes.find(module);
+	if (hash == m_hashes.end())
+	{
+		JDL_ERROR("Released shader module is not in the cache");
+		return;
+	}
+
+	auto entry = m_entries.find(hash->second);
+	if (--entry->second.nb_references == 0)
+	{
+		vkDestroyShaderModule(m_device, module, nullptr);
+		m_entries.erase(entry);
+		m_hashes.erase(hash);
+	}
+}
+
+size_t VulkanShaderModuleCache::get_nb_modules() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_entries.size();
+}
+
+uint64_t VulkanShaderModuleCache::get_nb_hits() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_nbHits;
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,256 @@
+#include "vk/vulkan_shader_reloader.hpp"
+
+#include "resource/resource_manager.hpp"
+
+#include "utils/logger.hpp"
+
+#include "vk/vulkan_context.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+namespace jdl
+{
+namespace vk
+{
+
+VulkanShaderReloader::VulkanShaderReloader(const std::string& directory)
+{
+	std::error_code error;
+	m_directory = std::filesystem::weakly_canonical(directory, error);
+
+#ifdef __linux__
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotify < 0)
+	{
+		JDL_WARN("Shader hot reload disabled: inotify is not available");
+		return;
+	}
+
+	// Files are either written in place or renamed over the previous ones
+	int watch = inotify_add_watch(
+		m_inotify, m_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO
+	);
+	if (watch < 0)
+	{
+		JDL_WARN("Shader hot reload disabled: cannot watch {}", directory);
+		close(m_inotify);
+		m_inotify = -1;
+		return;
+	}
+
+	m_thread = std::thread(&VulkanShaderReloader::thread_loop, this);
+	JDL_INFO("Shader hot reload: watching {}", m_directory.string());
+#else
+	JDL_WARN("Shader hot reload is not supported on this platform");
+#endif
+}
+
+VulkanShaderReloader::~VulkanShaderReloader()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_appliedCondition.notify_all();
+
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+
+#ifdef __linux__
+	if (m_inotify >= 0) {
+		close(m_inotify);
+	}
+#endif
+
+	// The GPU is idle: everything can be destroyed
+	if (m_pending.has_value())
+	{
+		for (const auto& reload : m_pending->shaders) {
+			VulkanContext::GetShaderModuleCache().release(reload.module);
+		}
+		m_pending.reset();
+	}
+	for (auto& objects : m_retired) {
+		destroy(objects);
+	}
+	m_retired.clear();
+}
+
+void VulkanShaderReloader::update(uint64_t frame, uint32_t nb_frames_in_flight)
+{
+	// Objects retired before frame F are used by the frames up to F - 1, which
+	// are finished once the fence of frame F + nb_frames_in_flight - 1 is waited
+	std::erase_if(m_retired, [this, frame, nb_frames_in_flight](RetiredObjects& objects) {
+		if (frame + 1 < objects.frame + nb_frames_in_flight) {
+			return false;
+		}
+		destroy(objects);
+		return true;
+	});
+
+	{
+		std::lock_guard lock(m_mutex);
+		if (!m_pending.has_value()) {
+			return;
+		}
+
+		RetiredObjects retired { .frame = frame };
+		for (const auto& reload : m_pending->shaders)
+		{
+			// The shader may have been removed meanwhile
+			resource::Shader* shader = resource::ResourceManager::Get(reload.shader);
+			retired.modules.push_back(
+				shader != nullptr ? shader->swap_module(reload.module, reload.hash) : reload.module
+			);
+		}
+
+		VulkanContext::GetPipelineLibrary().swap_pipelines(m_pending->pipelines);
+		retired.pipelines = std::move(m_pending->pipelines);
+
+		m_retired.push_back(std::move(retired));
+		m_pending.reset();
+	}
+	m_appliedCondition.notify_one();
+}
+
+void VulkanShaderReloader::thread_loop()
+{
+#ifdef __linux__
+	pollfd poll_fd { .fd = m_inotify, .events = POLLIN };
+
+	while (!m_stop)
+	{
+		// Wakes up regularly to check the stop flag
+		if (poll(&poll_fd, 1, 100) <= 0) {
+			continue;
+		}
+
+		std::unordered_set<std::string> files;
+		read_events(files);
+		while (!m_stop && poll(&poll_fd, 1, s_DebounceMs) > 0) {
+			read_events(files);
+		}
+
+		if (!m_stop && !files.empty()) {
+			reload(files);
+		}
+	}
+#endif
+}
+
+void VulkanShaderReloader::read_events(std::unordered_set<std::string>& files)
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+
+	for (;;)
+	{
+		ssize_t size = read(m_inotify, buffer, sizeof(buffer));
+		if (size <= 0) {
+			return;
+		}
+
+		for (ssize_t offset = 0; offset < size;)
+		{
+			const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			if (event->len > 0) {
+				files.insert(event->name);
+			}
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+}
+
+void VulkanShaderReloader::reload(const std::unordered_set<std::string>& files)
+{
+	// Waits for the previous reload to be swapped in
+	{
+		std::unique_lock lock(m_mutex);
+		m_appliedCondition.wait(lock, [this] { return !m_pending.has_value() || m_stop; });
+		if (m_stop) {
+			return;
+		}
+	}
+
+	PendingReload pending;
+	ShaderModuleMap modules;
+
+	// Keeps the shaders alive while their pointers are used
+	auto guard = resource::ResourceManager::Pin();
+
+	for (resource::Shader* shader : resource::ResourceManager::GetAll<resource::Shader>())
+	{
+		if (!shader->is_ready()) {
+			continue;
+		}
+
+		std::error_code error;
+		auto path = std::filesystem::weakly_canonical(shader->get_path(), error);
+		if (path.parent_path() != m_directory || !files.contains(path.filename().string())) {
+			continue;
+		}
+
+		uint64_t hash = 0;
+		resource::ShaderReflection reflection;
+		VkShaderModule module = shader->create_module_from_file(hash, reflection);
+		if (module == VK_NULL_HANDLE)
+		{
+			JDL_WARN("Shader {} not reloaded, keeping the previous version", shader->get_name());
+			continue;
+		}
+		if (hash == shader->get_hash())
+		{
+			// Same code (file touched but not modified)
+			VulkanContext::GetShaderModuleCache().release(module);
+			continue;
+		}
+		if (reflection != shader->get_reflection())
+		{
+			// The pipeline layouts and the bound resources would not match anymore
+			JDL_WARN("Shader {} not reloaded: its interface changed, restart required", shader->get_name());
+			VulkanContext::GetShaderModuleCache().release(module);
+			continue;
+		}
+
+		pending.shaders.push_back({
+			resource::ResourceManager::GetHandle<resource::Shader>(shader->get_name()),
+			module,
+			hash
+		});
+		modules[shader] = module;
+	}
+
+	if (modules.empty()) {
+		return;
+	}
+
+	pending.pipelines = VulkanContext::GetPipelineLibrary().rebuild(modules);
+	JDL_INFO(
+		"Shader hot reload: {} shader(s) and {} pipeline(s) ready",
+		pending.shaders.size(), pending.pipelines.size()
+	);
+
+	std::lock_guard lock(m_mutex);
+	m_pending = std::move(pending);
+}
+
+void VulkanShaderReloader::destroy(RetiredObjects& objects)
+{
+	for (VkShaderModule module : objects.modules) {
+		VulkanContext::GetShaderModuleCache().release(module);
+	}
+	objects.modules.clear();
+	objects.pipelines.clear();
+}
+
+} // namespace vk
+} // namespace jdl
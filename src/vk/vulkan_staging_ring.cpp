@@ -0,0 +1,60 @@
+#include "vk/vulkan_staging_ring.hpp"
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Offsets are aligned on absolute positions: the ring size must be a
+// multiple of any requested alignment
+static constexpr VkDeviceSize s_MaxAlignment = 256;
+
+VulkanStagingRing::VulkanStagingRing(VkDeviceSize size)
+	: m_size((size + s_MaxAlignment - 1) & ~(s_MaxAlignment - 1))
+{
+	m_buffer = std::make_unique<VulkanBuffer>(
+		m_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::eCpuToGpu, true
+	);
+}
+
+VulkanStagingRing::Region VulkanStagingRing::allocate(
+	VkDeviceSize size,
+	VkDeviceSize alignment
+)
+{
+	if (size > m_size || alignment > s_MaxAlignment) {
+		return {};
+	}
+
+	uint64_t head = (m_head + alignment - 1) & ~(alignment - 1);
+
+	// A region never wraps around: skip the end of the ring if needed
+	VkDeviceSize offset = head % m_size;
+	if (offset + size > m_size)
+	{
+		head += m_size - offset;
+		offset = 0;
+	}
+
+	if (head + size - m_tail > m_size) {
+		return {};
+	}
+	m_head = head + size;
+
+	return {
+		.buffer = m_buffer->get(),
+		.offset = offset,
+		.data = static_cast<char*>(m_buffer->get_mapped_data()) + offset
+	};
+}
+
+void VulkanStagingRing::release(uint64_t position)
+{
+	if (position > m_tail) {
+		m_tail = position;
+	}
+}
+
+} // namespace vk
+} // namespace jdl
@@ -0,0 +1,449 @@
+#include "vk/vulkan_uploader.hpp"
+#include "vk/vulkan_context.hpp"
+
+#include "utils/logger.hpp"
+
+#include <cstring>
+
+
+namespace jdl
+{
+namespace vk
+{
+
+// Staging offsets alignment, valid for buffer copies and texel sizes up to 16 bytes
+static constexpr VkDeviceSize s_StagingAlignment = 16;
+
+static VkSemaphore s_CreateTimelineSemaphore(VkDevice device)
+{
+	VkSemaphoreTypeCreateInfo type_info {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		.initialValue = 0
+	};
+	VkSemaphoreCreateInfo semaphore_info {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		.pNext = &type_info
+	};
+
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	VK_CALL(vkCreateSemaphore(device, &semaphore_info, nullptr, &semaphore));
+	return semaphore;
+}
+
+static void s_WaitSemaphore(VkDevice device, VkSemaphore semaphore, uint64_t value)
+{
+	VkSemaphoreWaitInfo wait_info {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.semaphoreCount = 1,
+		.pSemaphores = &semaphore,
+		.pValues = &value
+	};
+	VK_CALL(vkWaitSemaphores(device, &wait_info, UINT64_MAX));
+}
+
+static VkCommandPool s_CreateCommandPool(VkDevice device, uint32_t queue_family)
+{
+	VkCommandPoolCreateInfo create_info {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.queueFamilyIndex = queue_family
+	};
+
+	VkCommandPool pool = VK_NULL_HANDLE;
+	VK_CALL(vkCreateCommandPool(device, &create_info, nullptr, &pool));
+	return pool;
+}
+
+VulkanUploader::VulkanUploader(VkDeviceSize staging_size)
+{
+	const auto& device = VulkanContext::GetDevice();
+	const auto& queue_families = device.get_queue_family_indices();
+
+	m_device = device.get_device();
+	m_transferQueue = device.get_transfer_queue();
+	m_graphicsQueue = device.get_graphics_queue();
+	m_transferFamily = queue_families.transfer;
+	m_graphicsFamily = queue_families.graphics;
+	m_ownershipTransfer = device.has_dedicated_transfer_queue();
+
+	m_transferPool = s_CreateCommandPool(m_device, m_transferFamily);
+	m_transferSemaphore = s_CreateTimelineSemaphore(m_device);
+	if (m_ownershipTransfer)
+	{
+		m_graphicsPool = s_CreateCommandPool(m_device, m_graphicsFamily);
+		m_acquireSemaphore = s_CreateTimelineSemaphore(m_device);
+	}
+
+	m_stagingRing = std::make_unique<VulkanStagingRing>(staging_size);
+}
+
+VulkanUploader::~VulkanUploader()
+{
+	wait_idle();
+
+	m_stagingRing.reset();
+	m_freeTransferCommands.clear();
+	m_freeAcquireCommands.clear();
+
+	vkDestroySemaphore(m_device, m_transferSemaphore, nullptr);
+	vkDestroySemaphore(m_device, m_acquireSemaphore, nullptr);
+	vkDestroyCommandPool(m_device, m_transferPool, nullptr);
+	vkDestroyCommandPool(m_device, m_graphicsPool, nullptr);
+}
+
+UploadToken VulkanUploader::upload_buffer(
+	const VulkanBuffer& dst,
+	const void* data,
+	VkDeviceSize size,
+	VkDeviceSize dst_offset,
+	VkPipelineStageFlags2 dst_stages,
+	VkAccessFlags2 dst_access
+)
+{
+	if (size == 0) {
+		return {};
+	}
+	if (dst_offset + size > dst.get_size()) {
+		JDL_FATAL("Buffer upload out of range ({} + {} > {})", dst_offset, size, dst.get_size());
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	auto staging = allocate_staging(size);
+	std::memcpy(staging.data, data, size);
+
+	VulkanCommandBuffer& commands = get_transfer_commands();
+	commands.copy_buffer(staging.buffer, staging.offset, dst.get(), dst_offset, size);
+
+	VkBufferMemoryBarrier2 barrier {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = dst_stages,
+		.dstAccessMask = dst_access,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = dst.get(),
+		.offset = dst_offset,
+		.size = size
+	};
+
+	if (m_ownershipTransfer)
+	{
+		// The release only makes the writes available, the acquire makes
+		// them visible to the graphics stages
+		barrier.srcQueueFamilyIndex = m_transferFamily;
+		barrier.dstQueueFamilyIndex = m_graphicsFamily;
+
+		VkBufferMemoryBarrier2 release = barrier;
+		release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+		release.dstAccessMask = VK_ACCESS_2_NONE;
+		m_openBatch.buffer_releases.push_back(release);
+
+		VkBufferMemoryBarrier2 acquire = barrier;
+		acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+		acquire.srcAccessMask = VK_ACCESS_2_NONE;
+		m_openBatch.buffer_acquires.push_back(acquire);
+	}
+	else {
+		m_openBatch.buffer_releases.push_back(barrier);
+	}
+
+	return { m_openBatch.value };
+}
+
+UploadToken VulkanUploader::upload_image(
+	const VulkanImage& dst,
+	const void* data,
+	VkDeviceSize size,
+	VkImageLayout final_layout
+)
+{
+	if (size == 0) {
+		return {};
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	auto staging = allocate_staging(size);
+	std::memcpy(staging.data, data, size);
+
+	const VulkanImageInfo& info = dst.get_info();
+	VkImageSubresourceRange range {
+		.aspectMask = info.aspect,
+		.baseMipLevel = 0,
+		.levelCount = info.mip_levels,
+		.baseArrayLayer = 0,
+		.layerCount = info.array_layers
+	};
+
+	VulkanCommandBuffer& commands = get_transfer_commands();
+
+	// The previous content is discarded (first use in the command buffer:
+	// transition from the UNDEFINED layout)
+	commands.transition_image(
+		dst.get(),
+		range,
+		{VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL}
+	);
+
+	commands.copy_buffer_to_image(
+		staging.buffer, staging.offset, dst.get(), info.extent, info.aspect, info.array_layers
+	);
+
+	VkImageMemoryBarrier2 barrier {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.newLayout = final_layout,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = dst.get(),
+		.subresourceRange = range
+	};
+
+	if (m_ownershipTransfer)
+	{
+		// Both sides of the ownership transfer perform the same layout transition
+		barrier.srcQueueFamilyIndex = m_transferFamily;
+		barrier.dstQueueFamilyIndex = m_graphicsFamily;
+
+		VkImageMemoryBarrier2 release = barrier;
+		release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+		release.dstAccessMask = VK_ACCESS_2_NONE;
+		m_openBatch.image_releases.push_back(release);
+
+		VkImageMemoryBarrier2 acquire = barrier;
+		acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+		acquire.srcAccessMask = VK_ACCESS_2_NONE;
+		m_openBatch.image_acquires.push_back(acquire);
+	}
+	else {
+		m_openBatch.image_releases.push_back(barrier);
+	}
+
+	return { m_openBatch.value };
+}
+
+UploadToken VulkanUploader::flush()
+{
+	std::lock_guard lock(m_mutex);
+	return flush_locked();
+}
+
+void VulkanUploader::update()
+{
+	std::lock_guard lock(m_mutex);
+
+	flush_locked();
+	process_batches();
+}
+
+bool VulkanUploader::is_complete(UploadToken token) const
+{
+	if (!token.is_valid()) {
+		return true;
+	}
+	return get_semaphore_value(get_completion_semaphore()) >= token.value;
+}
+
+void VulkanUploader::wait(UploadToken token)
+{
+	if (!token.is_valid()) {
+		return;
+	}
+
+	std::lock_guard lock(m_mutex);
+
+	if (token.value == m_openBatch.value) {
+		flush_locked();
+	}
+	if (token.value >= m_nextValue) {
+		return;
+	}
+
+	// The acquisition can only be submitted once the transfer is done
+	if (m_ownershipTransfer)
+	{
+		s_WaitSemaphore(m_device, m_transferSemaphore, token.value);
+		process_batches();
+	}
+	s_WaitSemaphore(m_device, get_completion_semaphore(), token.value);
+	process_batches();
+}
+
+void VulkanUploader::wait_idle()
+{
+	UploadToken last_token;
+	{
+		std::lock_guard lock(m_mutex);
+		flush_locked();
+		last_token.value = m_nextValue - 1;
+	}
+	wait(last_token);
+}
+
+uint64_t VulkanUploader::get_semaphore_value(VkSemaphore semaphore) const
+{
+	uint64_t value = 0;
+	VK_CALL(vkGetSemaphoreCounterValue(m_device, semaphore, &value));
+	return value;
+}
+
+VulkanCommandBuffer& VulkanUploader::get_transfer_commands()
+{
+	if (m_openBatch.transfer_commands == nullptr)
+	{
+		if (!m_freeTransferCommands.empty())
+		{
+			m_openBatch.transfer_commands = std::move(m_freeTransferCommands.back());
+			m_freeTransferCommands.pop_back();
+		}
+		else {
+			m_openBatch.transfer_commands = std::make_unique<VulkanCommandBuffer>(m_transferPool);
+		}
+
+		m_openBatch.value = m_nextValue;
+		m_openBatch.transfer_commands->begin();
+	}
+	return *m_openBatch.transfer_commands;
+}
+
+VulkanStagingRing::Region VulkanUploader::allocate_staging(VkDeviceSize size)
+{
+	// Reclaim the staging memory of the finished batches first
+	uint64_t completed = get_semaphore_value(get_completion_semaphore());
+	for (const auto& batch : m_submittedBatches)
+	{
+		if (batch.value > completed) {
+			break;
+		}
+		m_stagingRing->release(batch.staging_position);
+	}
+
+	auto region = m_stagingRing->allocate(size, s_StagingAlignment);
+	if (region.is_valid()) {
+		return region;
+	}
+
+	// Nothing can be submitted from here: oversized uploads, or uploads
+	// overflowing the ring, get their own staging buffer
+	auto buffer = std::make_unique<VulkanBuffer>(
+		size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::eCpuToGpu
+	);
+	region = {
+		.buffer = buffer->get(),
+		.offset = 0,
+		.data = buffer->get_mapped_data()
+	};
+	m_openBatch.large_stagings.push_back(std::move(buffer));
+
+	return region;
+}
+
+UploadToken VulkanUploader::flush_locked()
+{
+	if (m_openBatch.transfer_commands == nullptr) {
+		return {};
+	}
+
+	Batch& batch = m_openBatch;
+
+	VulkanCommandBuffer& commands = *batch.transfer_commands;
+	commands.pipeline_barrier(batch.buffer_releases, batch.image_releases);
+	commands.end();
+
+	VkSemaphoreSubmitInfo signal_info {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		.semaphore = m_transferSemaphore,
+		.value = batch.value,
+		.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+	};
+	commands.submit2(m_transferQueue, {}, { signal_info });
+
+	batch.staging_position = m_stagingRing->get_head();
+	batch.buffer_releases.clear();
+	batch.image_releases.clear();
+
+	UploadToken token { batch.value };
+	m_submittedBatches.push_back(std::move(batch));
+
+	m_openBatch = {};
+	++m_nextValue;
+
+	return token;
+}
+
+void VulkanUploader::submit_acquire(Batch& batch)
+{
+	batch.acquire_submitted = true;
+
+	if (!m_freeAcquireCommands.empty())
+	{
+		batch.acquire_commands = std::move(m_freeAcquireCommands.back());
+		m_freeAcquireCommands.pop_back();
+	}
+	else {
+		batch.acquire_commands = std::make_unique<VulkanCommandBuffer>(m_graphicsPool);
+	}
+
+	VulkanCommandBuffer& commands = *batch.acquire_commands;
+	commands.begin();
+	commands.pipeline_barrier(batch.buffer_acquires, batch.image_acquires);
+	commands.end();
+
+	// The transfer is already complete: the graphics queue never waits here
+	VkSemaphoreSubmitInfo wait_info {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		.semaphore = m_transferSemaphore,
+		.value = batch.value,
+		.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+	};
+	VkSemaphoreSubmitInfo signal_info {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		.semaphore = m_acquireSemaphore,
+		.value = batch.value,
+		.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT
+	};
+	commands.submit2(m_graphicsQueue, { wait_info }, { signal_info });
+}
+
+void VulkanUploader::process_batches()
+{
+	// Acquire the resources of the batches whose transfer is done
+	if (m_ownershipTransfer)
+	{
+		uint64_t transferred = get_semaphore_value(m_transferSemaphore);
+		for (auto& batch : m_submittedBatches)
+		{
+			if (batch.value > transferred) {
+				break;
+			}
+			if (!batch.acquire_submitted) {
+				submit_acquire(batch);
+			}
+		}
+	}
+
+	// Recycle the completed batches
+	uint64_t completed = get_semaphore_value(get_completion_semaphore());
+	while (!m_submittedBatches.empty() && m_submittedBatches.front().value <= completed)
+	{
+		Batch& batch = m_submittedBatches.front();
+
+		m_stagingRing->release(batch.staging_position);
+		m_freeTransferCommands.push_back(std::move(batch.transfer_commands));
+		if (batch.acquire_commands != nullptr) {
+			m_freeAcquireCommands.push_back(std::move(batch.acquire_commands));
+		}
+
+		m_submittedBatches.pop_front();
+	}
+}
+
+} // namespace vk
+} // namespace jdl
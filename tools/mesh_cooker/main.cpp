@@ -0,0 +1,221 @@
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "obj_importer.hpp"
+
+#include "core/job_system.hpp"
+
+#include "resource/gltf_reader.hpp"
+#include "resource/mesh_file.hpp"
+
+#include "utils/logger.hpp"
+
+using namespace jdl;
+
+namespace fs = std::filesystem;
+
+
+struct CookOptions
+{
+    fs::path output_directory = ".";
+    // Full precision layout instead of the compact one
+    bool full_precision = false;
+    // Single vertex stream (the compact layout splits the positions)
+    bool interleaved = false;
+    // Cooks the up-to-date meshes again
+    bool force = false;
+};
+
+// Whether an output was cooked after the last modification of its source
+static bool s_IsUpToDate(const fs::path& input, const fs::path& output, const CookOptions& options)
+{
+    std::error_code error;
+    return !options.force && fs::exists(output, error)
+        && fs::last_write_time(output, error) >= fs::last_write_time(input, error) && !error;
+}
+
+static bool s_Write(
+    const fs::path& output,
+    const resource::VertexData& vertices,
+    const std::vector<uint32_t>& indices,
+    const CookOptions& options
+)
+{
+    auto layout = resource::VertexLayout::ForData(vertices, options.full_precision);
+    if (options.interleaved) {
+        layout.streams = resource::VertexStreams::eInterleaved;
+    }
+
+    resource::EncodedMesh mesh;
+    if (!resource::encode_mesh(output.string(), vertices, indices, layout, mesh)) {
+        return false;
+    }
+    if (!resource::write_mesh_file(output.string(), mesh)) {
+        return false;
+    }
+
+    JDL_INFO("Cooked {} ({} vertices, {} triangles)", output.string(), mesh.nb_vertices, mesh.nb_indices / 3);
+    return true;
+}
+
+static bool s_CookObj(const fs::path& input, const CookOptions& options)
+{
+    fs::path output = options.output_directory / input.stem();
+    output += resource::MeshFile::s_Extension;
+    if (s_IsUpToDate(input, output, options))
+    {
+        JDL_INFO("{} is up to date", output.string());
+        return true;
+    }
+
+    resource::VertexData vertices;
+    std::vector<uint32_t> indices;
+    return tools::import_obj(input.string(), vertices, indices) && s_Write(output, vertices, indices, options);
+}
+
+// One mesh file per primitive: <source>_<mesh>_<primitive>, or <source> if
+// the file has a single primitive
+static bool s_CookGltf(const fs::path& input, const CookOptions& options)
+{
+    resource::GltfReader reader;
+    if (!reader.open(input.string())) {
+        return false;
+    }
+
+    const auto& meshes = reader.get_meshes();
+    const auto& primitives = reader.get_primitives();
+    if (primitives.empty())
+    {
+        JDL_ERROR("{}: no geometry", input.string());
+        return false;
+    }
+
+    std::vector<fs::path> outputs(primitives.size());
+    for (size_t mesh = 0; mesh < meshes.size(); ++mesh)
+    {
+        for (uint32_t i = 0; i < meshes[mesh].nb_primitives; ++i)
+        {
+            std::string name = input.stem().string();
+            if (primitives.size() > 1) {
+                name += "_" + std::to_string(mesh) + "_" + std::to_string(i);
+            }
+            fs::path& output = outputs[meshes[mesh].first_primitive + i];
+            output = options.output_directory / name;
+            output += resource::MeshFile::s_Extension;
+        }
+    }
+
+    // The primitives are decoded in parallel too
+    std::atomic<uint32_t> nb_failed = 0;
+    core::JobSystem::Get().parallel_for(static_cast<uint32_t>(primitives.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            if (s_IsUpToDate(input, outputs[i], options))
+            {
+                JDL_INFO("{} is up to date", outputs[i].string());
+                continue;
+            }
+
+            resource::VertexData vertices;
+            std::vector<uint32_t> indices;
+            if (!reader.decode_primitive(i, vertices, indices) || !s_Write(outputs[i], vertices, indices, options)) {
+                nb_failed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return nb_failed == 0;
+}
+
+static bool s_Cook(const fs::path& input, const CookOptions& options)
+{
+    std::string extension = input.extension().string();
+    if (extension == ".obj") {
+        return s_CookObj(input, options);
+    }
+    if (extension == ".gltf" || extension == ".glb") {
+        return s_CookGltf(input, options);
+    }
+
+    JDL_ERROR("{}: unsupported format", input.string());
+    return false;
+}
+
+static void s_PrintUsage()
+{
+    std::cout
+        << "Usage: jdlmeshcooker [options] <sources...>\n"
+        << "Cooks OBJ and glTF (.gltf, .glb) meshes into memory-mappable mesh files (.jmesh)\n"
+        << "  -o <directory>   Output directory (default: current directory)\n"
+        << "  --full           Full precision vertices (default: compact)\n"
+        << "  --interleaved    Single vertex stream (default: split positions)\n"
+        << "  --force          Cooks the up-to-date meshes again\n";
+}
+
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        utils::Logger::Init();
+
+        CookOptions options;
+        std::vector<fs::path> inputs;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "-o" && i + 1 < argc) {
+                options.output_directory = argv[++i];
+            }
+            else if (arg == "--full") {
+                options.full_precision = true;
+            }
+            else if (arg == "--interleaved") {
+                options.interleaved = true;
+            }
+            else if (arg == "--force") {
+                options.force = true;
+            }
+            else if (arg == "-h" || arg == "--help") {
+                s_PrintUsage();
+                return EXIT_SUCCESS;
+            }
+            else {
+                inputs.push_back(arg);
+            }
+        }
+
+        if (inputs.empty())
+        {
+            s_PrintUsage();
+            return EXIT_FAILURE;
+        }
+        fs::create_directories(options.output_directory);
+
+        // One job per source, the meshes are independent
+        core::JobSystem job_system;
+        std::atomic<uint32_t> nb_failed = 0;
+        job_system.parallel_for(static_cast<uint32_t>(inputs.size()), 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                if (!s_Cook(inputs[i], options)) {
+                    nb_failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        if (nb_failed > 0)
+        {
+            JDL_ERROR("{} of {} sources failed to cook", nb_failed.load(), inputs.size());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,257 @@
+#include "obj_importer.hpp"
+
+#include "utils/hash.hpp"
+#include "utils/logger.hpp"
+#include "utils/mapped_file.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+
+namespace jdl
+{
+namespace tools
+{
+
+// Position/texcoord/normal indices of a face corner (-1: missing)
+struct Corner
+{
+    int32_t position = -1;
+    int32_t texcoord = -1;
+    int32_t normal = -1;
+
+    bool operator==(const Corner&) const = default;
+};
+
+struct CornerHash
+{
+    size_t operator()(const Corner& corner) const {
+        return static_cast<size_t>(utils::fnv1a_64(&corner, sizeof(Corner)));
+    }
+};
+
+static bool s_IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static std::string_view s_NextToken(std::string_view& line)
+{
+    size_t begin = 0;
+    while (begin < line.size() && s_IsSpace(line[begin])) {
+        ++begin;
+    }
+    size_t end = begin;
+    while (end < line.size() && !s_IsSpace(line[end])) {
+        ++end;
+    }
+
+    std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return token;
+}
+
+// Reads up to max_count floats, returns the number read
+static size_t s_ParseFloats(std::string_view line, float* values, size_t max_count)
+{
+    size_t count = 0;
+    for (; count < max_count; ++count)
+    {
+        std::string_view token = s_NextToken(line);
+        if (token.empty() || std::from_chars(token.data(), token.data() + token.size(), values[count]).ec != std::errc()) {
+            break;
+        }
+    }
+    return count;
+}
+
+// Resolves a 1-based (or negative, relative to the end) OBJ index
+static bool s_ParseIndex(std::string_view token, size_t nb_elements, int32_t& index)
+{
+    int64_t value = 0;
+    if (token.empty() || std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc()) {
+        return false;
+    }
+
+    int64_t resolved = value < 0 ? static_cast<int64_t>(nb_elements) + value : value - 1;
+    if (resolved < 0 || resolved >= static_cast<int64_t>(nb_elements)) {
+        return false;
+    }
+    index = static_cast<int32_t>(resolved);
+    return true;
+}
+
+// Parses v, v/vt, v//vn or v/vt/vn
+static bool s_ParseCorner(
+    std::string_view token,
+    size_t nb_positions,
+    size_t nb_texcoords,
+    size_t nb_normals,
+    Corner& corner
+)
+{
+    size_t first_slash = token.find('/');
+    if (!s_ParseIndex(token.substr(0, first_slash), nb_positions, corner.position)) {
+        return false;
+    }
+    if (first_slash == std::string_view::npos) {
+        return true;
+    }
+
+    token.remove_prefix(first_slash + 1);
+    size_t second_slash = token.find('/');
+    std::string_view texcoord = token.substr(0, second_slash);
+    if (!texcoord.empty() && !s_ParseIndex(texcoord, nb_texcoords, corner.texcoord)) {
+        return false;
+    }
+    if (second_slash == std::string_view::npos) {
+        return true;
+    }
+    return s_ParseIndex(token.substr(second_slash + 1), nb_normals, corner.normal);
+}
+
+bool import_obj(
+    const std::string& path,
+    resource::VertexData& vertices,
+    std::vector<uint32_t>& indices
+)
+{
+    utils::MappedFile file;
+    if (!file.open(path))
+    {
+        JDL_ERROR("Failed to read {}", path);
+        return false;
+    }
+
+    // OBJ attributes, indexed separately by the faces
+    std::vector<float> positions;
+    std::vector<float> colors;
+    std::vector<float> texcoords;
+    std::vector<float> normals;
+
+    std::unordered_map<Corner, uint32_t, CornerHash> corner_vertices;
+    std::vector<Corner> corners;
+    std::vector<uint32_t> face;
+
+    auto add_vertex = [&](const Corner& corner) {
+        auto [it, inserted] = corner_vertices.try_emplace(corner, static_cast<uint32_t>(corners.size()));
+        if (inserted) {
+            corners.push_back(corner);
+        }
+        return it->second;
+    };
+
+    std::string_view content(reinterpret_cast<const char*>(file.get_data()), file.get_size());
+    size_t line_number = 0;
+    while (!content.empty())
+    {
+        size_t end = content.find('\n');
+        std::string_view line = content.substr(0, end);
+        content.remove_prefix(end == std::string_view::npos ? content.size() : end + 1);
+        ++line_number;
+
+        std::string_view keyword = s_NextToken(line);
+        if (keyword == "v")
+        {
+            // Optional vertex colors after the position (common extension)
+            float values[7] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+            size_t count = s_ParseFloats(line, values, 6);
+            if (count < 3)
+            {
+                JDL_ERROR("{}:{}: invalid position", path, line_number);
+                return false;
+            }
+            positions.insert(positions.end(), values, values + 3);
+            if (count == 6 || !colors.empty())
+            {
+                // Earlier vertices without colors are white
+                colors.resize((positions.size() / 3 - 1) * 4, 1.0f);
+                colors.insert(colors.end(), values + 3, values + 7);
+            }
+        }
+        else if (keyword == "vt")
+        {
+            float values[2] = {};
+            if (s_ParseFloats(line, values, 2) < 1)
+            {
+                JDL_ERROR("{}:{}: invalid texture coordinates", path, line_number);
+                return false;
+            }
+            texcoords.push_back(values[0]);
+            texcoords.push_back(1.0f - values[1]);
+        }
+        else if (keyword == "vn")
+        {
+            float values[3] = {};
+            if (s_ParseFloats(line, values, 3) < 3)
+            {
+                JDL_ERROR("{}:{}: invalid normal", path, line_number);
+                return false;
+            }
+            normals.insert(normals.end(), values, values + 3);
+        }
+        else if (keyword == "f")
+        {
+            face.clear();
+            for (std::string_view token = s_NextToken(line); !token.empty(); token = s_NextToken(line))
+            {
+                Corner corner;
+                if (!s_ParseCorner(token, positions.size() / 3, texcoords.size() / 2, normals.size() / 3, corner))
+                {
+                    JDL_ERROR("{}:{}: invalid face", path, line_number);
+                    return false;
+                }
+                face.push_back(add_vertex(corner));
+            }
+
+            for (size_t i = 2; i < face.size(); ++i) {
+                indices.insert(indices.end(), { face[0], face[i - 1], face[i] });
+            }
+        }
+    }
+
+    if (indices.empty())
+    {
+        JDL_ERROR("{}: no faces", path);
+        return false;
+    }
+
+    // Attributes missing from any corner are dropped for the whole mesh
+    bool has_texcoords = std::all_of(corners.begin(), corners.end(), [](const Corner& c) { return c.texcoord >= 0; });
+    bool has_normals = std::all_of(corners.begin(), corners.end(), [](const Corner& c) { return c.normal >= 0; });
+    bool has_colors = !colors.empty();
+    if (has_colors) {
+        colors.resize(positions.size() / 3 * 4, 1.0f);
+    }
+
+    size_t nb_vertices = corners.size();
+    vertices.positions.reserve(nb_vertices * 3);
+    vertices.normals.reserve(has_normals ? nb_vertices * 3 : 0);
+    vertices.texcoords.reserve(has_texcoords ? nb_vertices * 2 : 0);
+    vertices.colors.reserve(has_colors ? nb_vertices * 4 : 0);
+
+    for (const Corner& corner : corners)
+    {
+        auto append = [](std::vector<float>& dst, const std::vector<float>& src, int32_t index, size_t count) {
+            auto begin = src.begin() + static_cast<size_t>(index) * count;
+            dst.insert(dst.end(), begin, begin + count);
+        };
+
+        append(vertices.positions, positions, corner.position, 3);
+        if (has_normals) {
+            append(vertices.normals, normals, corner.normal, 3);
+        }
+        if (has_texcoords) {
+            append(vertices.texcoords, texcoords, corner.texcoord, 2);
+        }
+        if (has_colors) {
+            append(vertices.colors, colors, corner.position, 4);
+        }
+    }
+    return true;
+}
+
+} // namespace tools
+} // namespace jdl
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "resource/vertex_layout.hpp"
+
+#include <string>
+
+
+namespace jdl
+{
+namespace tools
+{
+
+/**
+ * @brief Imports a Wavefront OBJ file as a single mesh: every face of every
+ * object is triangulated (fan) and the position/texcoord/normal triplets are
+ * deduplicated into indexed vertices. Texture coordinates are flipped to the
+ * Vulkan convention (origin at the top left). Materials are ignored.
+ * @param path OBJ file path.
+ * @param vertices Receives the vertices.
+ * @param indices Receives the triangle list indices.
+ * @return Whether the file has been imported or not.
+ */
+bool import_obj(
+    const std::string& path,
+    resource::VertexData& vertices,
+    std::vector<uint32_t>& indices
+);
+
+} // namespace tools
+} // namespace jdl